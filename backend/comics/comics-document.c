@@ -45,13 +45,27 @@ struct _ComicsDocumentClass
 	EvDocumentClass parent_class;
 };
 
+/* Index of the pages, built in a single pass over the archive when
+ * loading, so that sizes don't need the archive and rendering a page
+ * can seek straight to its entry.
+ */
+typedef struct _ComicsPage
+{
+	gchar  *name;
+	gchar  *collate_key;
+	gint64  position;
+	gint64  size;
+	gint    width;
+	gint    height;
+} ComicsPage;
+
 struct _ComicsDocument
 {
 	EvDocument     parent_instance;
 	EvArchive     *archive;
 	gchar         *archive_path;
 	gchar         *archive_uri;
-	GPtrArray     *page_names;
+	GPtrArray     *pages;
 };
 
 static GSList* get_supported_image_extensions (void);
@@ -98,6 +112,81 @@ is_apple_double (const char *name)
 	return ret;
 }
 
+static void
+comics_page_free (ComicsPage *page)
+{
+	g_free (page->name);
+	g_free (page->collate_key);
+	g_slice_free (ComicsPage, page);
+}
+
+typedef struct {
+	gboolean got_info;
+	int height;
+	int width;
+} PixbufInfo;
+
+static void
+get_page_size_prepared_cb (GdkPixbufLoader *loader,
+			   int              width,
+			   int              height,
+			   PixbufInfo      *info)
+{
+	info->got_info = TRUE;
+	info->height = height;
+	info->width = width;
+}
+
+/* Reads the current entry until the image loader knows its size */
+static gboolean
+comics_document_read_entry_size (ComicsDocument *comics_document,
+				 gint64          size,
+				 gint           *width,
+				 gint           *height)
+{
+	GdkPixbufLoader *loader;
+	PixbufInfo info;
+	char buf[BLOCK_SIZE];
+	gssize read;
+	gint64 left;
+	GError *error = NULL;
+
+	loader = gdk_pixbuf_loader_new ();
+	info.got_info = FALSE;
+	g_signal_connect (loader, "size-prepared",
+			  G_CALLBACK (get_page_size_prepared_cb),
+			  &info);
+
+	left = size;
+	read = ev_archive_read_data (comics_document->archive, buf,
+				     MIN(BLOCK_SIZE, left), &error);
+	while (read > 0 && !info.got_info) {
+		if (!gdk_pixbuf_loader_write (loader, (guchar *) buf, read, &error)) {
+			read = -1;
+			break;
+		}
+		left -= read;
+		read = ev_archive_read_data (comics_document->archive, buf,
+					     MIN(BLOCK_SIZE, left), &error);
+	}
+	if (read < 0) {
+		g_debug ("Error reading '%s' in archive: %s",
+			 ev_archive_get_entry_pathname (comics_document->archive),
+			 error->message);
+		g_error_free (error);
+	}
+
+	gdk_pixbuf_loader_close (loader, NULL);
+	g_object_unref (loader);
+
+	if (info.got_info) {
+		*width = info.width;
+		*height = info.height;
+	}
+
+	return info.got_info;
+}
+
 static GPtrArray *
 comics_document_list (ComicsDocument  *comics_document,
 		      GError         **error)
@@ -122,10 +211,11 @@ comics_document_list (ComicsDocument  *comics_document,
 	supported_extensions = get_supported_image_extensions ();
 
 	has_encrypted_files = FALSE;
-	array = g_ptr_array_sized_new (64);
+	array = g_ptr_array_new_with_free_func ((GDestroyNotify) comics_page_free);
 
 	while (1) {
 		const char *name;
+		ComicsPage *page;
 
 		if (!ev_archive_read_next_header (comics_document->archive, error)) {
 			if (*error != NULL) {
@@ -162,7 +252,18 @@ comics_document_list (ComicsDocument  *comics_document,
 		}
 
 		g_debug ("Adding '%s' to the list of files in the comics", name);
-		g_ptr_array_add (array, g_strdup (name));
+		page = g_slice_new0 (ComicsPage);
+		page->name = g_strdup (name);
+		page->collate_key = g_utf8_collate_key_for_filename (name, -1);
+		page->position = ev_archive_get_entry_position (comics_document->archive);
+		page->size = ev_archive_get_entry_size (comics_document->archive);
+		/* The size is read from the image header now that we are
+		 * at its entry, it's computed again when rendering if the
+		 * header couldn't be parsed */
+		if (!comics_document_read_entry_size (comics_document, page->size,
+						      &page->width, &page->height))
+			page->width = page->height = -1;
+		g_ptr_array_add (array, page);
 	}
 
 	if (array->len == 0) {
@@ -227,21 +328,13 @@ comics_check_decompress_support	(gchar          *mime_type,
 }
 
 static int
-sort_page_names (gconstpointer a,
-                 gconstpointer b)
+sort_pages (gconstpointer a,
+            gconstpointer b)
 {
-  gchar *temp1, *temp2;
-  gint ret;
-
-  temp1 = g_utf8_collate_key_for_filename (* (const char **) a, -1);
-  temp2 = g_utf8_collate_key_for_filename (* (const char **) b, -1);
-
-  ret = strcmp (temp1, temp2);
-
-  g_free (temp1);
-  g_free (temp2);
+  const ComicsPage *page1 = * (const ComicsPage **) a;
+  const ComicsPage *page2 = * (const ComicsPage **) b;
 
-  return ret;
+  return strcmp (page1->collate_key, page2->collate_key);
 }
 
 static gboolean
@@ -278,12 +371,12 @@ comics_document_load (EvDocument *document,
 	g_free (mime_type);
 
 	/* Get list of files in archive */
-	comics_document->page_names = comics_document_list (comics_document, error);
-	if (!comics_document->page_names)
+	comics_document->pages = comics_document_list (comics_document, error);
+	if (!comics_document->pages)
 		return FALSE;
 
         /* Now sort the pages */
-        g_ptr_array_sort (comics_document->page_names, sort_page_names);
+        g_ptr_array_sort (comics_document->pages, sort_pages);
 
 	return TRUE;
 }
@@ -303,27 +396,26 @@ comics_document_get_n_pages (EvDocument *document)
 {
 	ComicsDocument *comics_document = COMICS_DOCUMENT (document);
 
-        if (comics_document->page_names == NULL)
+        if (comics_document->pages == NULL)
                 return 0;
 
-	return comics_document->page_names->len;
+	return comics_document->pages->len;
 }
 
-typedef struct {
-	gboolean got_info;
-	int height;
-	int width;
-} PixbufInfo;
-
-static void
-get_page_size_prepared_cb (GdkPixbufLoader *loader,
-			   int              width,
-			   int              height,
-			   PixbufInfo      *info)
+static gboolean
+comics_document_seek_page (ComicsDocument *comics_document,
+			   ComicsPage     *page)
 {
-	info->got_info = TRUE;
-	info->height = height;
-	info->width = width;
+	GError *error = NULL;
+
+	if (!ev_archive_seek_entry (comics_document->archive, page->position, &error)) {
+		g_warning ("Fatal error seeking '%s' in archive: %s", page->name, error->message);
+		g_error_free (error);
+		ev_archive_reset (comics_document->archive);
+		return FALSE;
+	}
+
+	return TRUE;
 }
 
 static void
@@ -332,76 +424,25 @@ comics_document_get_page_size (EvDocument *document,
 			       double     *width,
 			       double     *height)
 {
-	GdkPixbufLoader *loader;
 	ComicsDocument *comics_document = COMICS_DOCUMENT (document);
-	const char *page_path;
-	PixbufInfo info;
-	GError *error = NULL;
+	ComicsPage *comics_page;
 
-	if (!ev_archive_open_filename (comics_document->archive, comics_document->archive_path, &error)) {
-		g_warning ("Fatal error opening archive: %s", error->message);
-		g_error_free (error);
-		goto out;
-	}
+	comics_page = g_ptr_array_index (comics_document->pages, page->index);
 
-	loader = gdk_pixbuf_loader_new ();
-	info.got_info = FALSE;
-	g_signal_connect (loader, "size-prepared",
-			  G_CALLBACK (get_page_size_prepared_cb),
-			  &info);
-
-	page_path = g_ptr_array_index (comics_document->page_names, page->index);
-
-	while (1) {
-		const char *name;
-		GError *error = NULL;
-
-		if (!ev_archive_read_next_header (comics_document->archive, &error)) {
-			if (error != NULL) {
-				g_warning ("Fatal error handling archive: %s", error->message);
-				g_error_free (error);
-			}
-			break;
-		}
-
-		name = ev_archive_get_entry_pathname (comics_document->archive);
-		if (g_strcmp0 (name, page_path) == 0) {
-			char buf[BLOCK_SIZE];
-			gssize read;
-			gint64 left;
-
-			left = ev_archive_get_entry_size (comics_document->archive);
-			read = ev_archive_read_data (comics_document->archive, buf,
-						     MIN(BLOCK_SIZE, left), &error);
-			while (read > 0 && !info.got_info) {
-				if (!gdk_pixbuf_loader_write (loader, (guchar *) buf, read, &error)) {
-					read = -1;
-					break;
-				}
-				left -= read;
-				read = ev_archive_read_data (comics_document->archive, buf,
-							     MIN(BLOCK_SIZE, left), &error);
-			}
-			if (read < 0) {
-				g_warning ("Fatal error reading '%s' in archive: %s", name, error->message);
-				g_error_free (error);
-			}
-			break;
-		}
+	/* The header couldn't be parsed when listing the archive */
+	if (comics_page->width < 0 &&
+	    comics_document_seek_page (comics_document, comics_page)) {
+		comics_document_read_entry_size (comics_document, comics_page->size,
+						 &comics_page->width, &comics_page->height);
 	}
 
-	gdk_pixbuf_loader_close (loader, NULL);
-	g_object_unref (loader);
-
-	if (info.got_info) {
-		if (width)
-			*width = info.width;
-		if (height)
-			*height = info.height;
-	}
+	if (comics_page->width < 0)
+		return;
 
-out:
-	ev_archive_reset (comics_document->archive);
+	if (width)
+		*width = comics_page->width;
+	if (height)
+		*height = comics_page->height;
 }
 
 static void
@@ -416,78 +457,56 @@ render_pixbuf_size_prepared_cb (GdkPixbufLoader *loader,
 	gdk_pixbuf_loader_set_size (loader, scaled_width, scaled_height);
 }
 
+/* Decodes the page scaled, the rotation is applied when converting it
+ * to a surface */
 static GdkPixbuf *
 comics_document_render_pixbuf (EvDocument      *document,
 			       EvRenderContext *rc)
 {
 	GdkPixbufLoader *loader;
-	GdkPixbuf *tmp_pixbuf;
-	GdkPixbuf *rotated_pixbuf = NULL;
+	GdkPixbuf *pixbuf;
 	ComicsDocument *comics_document = COMICS_DOCUMENT (document);
-	const char *page_path;
+	ComicsPage *comics_page;
+	char *buf;
+	gssize read;
+	gint64 left;
 	GError *error = NULL;
 
-	if (!ev_archive_open_filename (comics_document->archive, comics_document->archive_path, &error)) {
-		g_warning ("Fatal error opening archive: %s", error->message);
-		g_error_free (error);
-		goto out;
-	}
+	comics_page = g_ptr_array_index (comics_document->pages, rc->page->index);
+	if (!comics_document_seek_page (comics_document, comics_page))
+		return NULL;
 
 	loader = gdk_pixbuf_loader_new ();
 	g_signal_connect (loader, "size-prepared",
 			  G_CALLBACK (render_pixbuf_size_prepared_cb),
 			  rc);
 
-	page_path = g_ptr_array_index (comics_document->page_names, rc->page->index);
-
-	while (1) {
-		const char *name;
-
-		if (!ev_archive_read_next_header (comics_document->archive, &error)) {
-			if (error != NULL) {
-				g_warning ("Fatal error handling archive: %s", error->message);
-				g_error_free (error);
-			}
-			break;
-		}
-
-		name = ev_archive_get_entry_pathname (comics_document->archive);
-		if (g_strcmp0 (name, page_path) == 0) {
-			size_t size = ev_archive_get_entry_size (comics_document->archive);
-			char *buf;
-			ssize_t read;
-
-			buf = g_malloc (size);
-			read = ev_archive_read_data (comics_document->archive, buf, size, &error);
-			if (read <= 0) {
-				if (read < 0) {
-					g_warning ("Fatal error reading '%s' in archive: %s", name, error->message);
-					g_error_free (error);
-				} else {
-					g_warning ("Read an empty file from the archive");
-				}
-			} else {
-				gdk_pixbuf_loader_write (loader, (guchar *) buf, size, NULL);
-			}
-			g_free (buf);
-			gdk_pixbuf_loader_close (loader, NULL);
-			break;
-		}
+	buf = g_malloc (comics_page->size);
+	left = comics_page->size;
+	do {
+		read = ev_archive_read_data (comics_document->archive,
+					     buf + (comics_page->size - left), left, &error);
+		if (read > 0)
+			left -= read;
+	} while (read > 0 && left > 0);
+
+	if (read < 0) {
+		g_warning ("Fatal error reading '%s' in archive: %s", comics_page->name, error->message);
+		g_error_free (error);
+	} else if (left == comics_page->size) {
+		g_warning ("Read an empty file from the archive");
+	} else {
+		gdk_pixbuf_loader_write (loader, (guchar *) buf, comics_page->size - left, NULL);
 	}
+	g_free (buf);
+	gdk_pixbuf_loader_close (loader, NULL);
 
-	tmp_pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
-	if (tmp_pixbuf) {
-		if ((rc->rotation % 360) == 0)
-			rotated_pixbuf = g_object_ref (tmp_pixbuf);
-		else
-			rotated_pixbuf = gdk_pixbuf_rotate_simple (tmp_pixbuf,
-								   360 - rc->rotation);
-	}
+	pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+	if (pixbuf)
+		g_object_ref (pixbuf);
 	g_object_unref (loader);
 
-out:
-	ev_archive_reset (comics_document->archive);
-	return rotated_pixbuf;
+	return pixbuf;
 }
 
 static cairo_surface_t *
@@ -498,7 +517,10 @@ comics_document_render (EvDocument      *document,
 	cairo_surface_t *surface;
 
 	pixbuf = comics_document_render_pixbuf (document, rc);
-	surface = ev_document_misc_surface_from_pixbuf (pixbuf);
+	if (!pixbuf)
+		return NULL;
+
+	surface = ev_document_misc_surface_from_pixbuf_rotated (pixbuf, rc->rotation % 360);
 	g_object_unref (pixbuf);
 
 	return surface;
@@ -509,10 +531,8 @@ comics_document_finalize (GObject *object)
 {
 	ComicsDocument *comics_document = COMICS_DOCUMENT (object);
 
-	if (comics_document->page_names) {
-                g_ptr_array_foreach (comics_document->page_names, (GFunc) g_free, NULL);
-                g_ptr_array_free (comics_document->page_names, TRUE);
-	}
+	if (comics_document->pages)
+		g_ptr_array_free (comics_document->pages, TRUE);
 
 	g_clear_object (&comics_document->archive);
 	g_free (comics_document->archive_path);
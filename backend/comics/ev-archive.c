@@ -30,10 +30,14 @@
 struct _EvArchive {
 	GObject parent_instance;
 	EvArchiveType type;
+	char *path;
 
 	/* libarchive */
 	struct archive *libar;
 	struct archive_entry *libar_entry;
+	/* Index of the current entry, and whether its data was read */
+	gint64 libar_entry_index;
+	gboolean libar_entry_read;
 
 	/* unarr */
 	ar_stream *unarr_stream;
@@ -61,6 +65,8 @@ ev_archive_finalize (GObject *object)
 		break;
 	}
 
+	g_free (archive->path);
+
 	G_OBJECT_CLASS (ev_archive_parent_class)->finalize (object);
 }
 
@@ -135,6 +141,11 @@ ev_archive_open_filename (EvArchive   *archive,
 	g_return_val_if_fail (archive->type != EV_ARCHIVE_TYPE_NONE, FALSE);
 	g_return_val_if_fail (path != NULL, FALSE);
 
+	if (archive->path != path) {
+		g_free (archive->path);
+		archive->path = g_strdup (path);
+	}
+
 	switch (archive->type) {
 	case EV_ARCHIVE_TYPE_NONE:
 		g_assert_not_reached ();
@@ -155,6 +166,10 @@ ev_archive_open_filename (EvArchive   *archive,
 	case EV_ARCHIVE_TYPE_ZIP:
 	case EV_ARCHIVE_TYPE_7Z:
 	case EV_ARCHIVE_TYPE_TAR:
+		archive->libar_entry = NULL;
+		archive->libar_entry_index = -1;
+		archive->libar_entry_read = FALSE;
+
 		r = archive_read_open_filename (archive->libar, path, BUFFER_SIZE);
 		if (r != ARCHIVE_OK) {
 			g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -190,6 +205,8 @@ libarchive_read_next_header (EvArchive *archive,
 
 		g_debug ("At header for file '%s'", archive_entry_pathname (archive->libar_entry));
 
+		archive->libar_entry_index++;
+		archive->libar_entry_read = FALSE;
 		break;
 	}
 
@@ -311,6 +328,7 @@ ev_archive_read_data (EvArchive *archive,
 	case EV_ARCHIVE_TYPE_7Z:
 	case EV_ARCHIVE_TYPE_TAR:
 		g_return_val_if_fail (archive->libar_entry != NULL, -1);
+		archive->libar_entry_read = TRUE;
 		r = archive_read_data (archive->libar, buf, count);
 		if (r < 0) {
 			g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
@@ -337,6 +355,7 @@ ev_archive_reset (EvArchive *archive)
 	case EV_ARCHIVE_TYPE_7Z:
 	case EV_ARCHIVE_TYPE_TAR:
 		g_clear_pointer (&archive->libar, archive_free);
+		archive->libar_entry = NULL;
 		libarchive_set_archive_type (archive, archive->type);
 		break;
 	default:
@@ -344,6 +363,95 @@ ev_archive_reset (EvArchive *archive)
 	}
 }
 
+/* Returns an opaque position for the current entry, which can be passed
+ * to ev_archive_seek_entry() to go back to it without scanning the
+ * archive from the start.
+ */
+gint64
+ev_archive_get_entry_position (EvArchive *archive)
+{
+	g_return_val_if_fail (EV_IS_ARCHIVE (archive), -1);
+	g_return_val_if_fail (archive->type != EV_ARCHIVE_TYPE_NONE, -1);
+
+	switch (archive->type) {
+	case EV_ARCHIVE_TYPE_RAR:
+		g_return_val_if_fail (archive->unarr != NULL, -1);
+		return ar_entry_get_offset (archive->unarr);
+	case EV_ARCHIVE_TYPE_NONE:
+		g_assert_not_reached ();
+	case EV_ARCHIVE_TYPE_ZIP:
+	case EV_ARCHIVE_TYPE_7Z:
+	case EV_ARCHIVE_TYPE_TAR:
+		g_return_val_if_fail (archive->libar_entry != NULL, -1);
+		return archive->libar_entry_index;
+	}
+
+	return -1;
+}
+
+static gboolean
+libarchive_seek_entry (EvArchive *archive,
+		       gint64     position,
+		       GError   **error)
+{
+	/* libarchive can only read forward, so the archive is reopened
+	 * when going back, or to read the current entry again. Going
+	 * forward skips the data of the entries in between without
+	 * decompressing it. */
+	if (archive->libar_entry == NULL ||
+	    position < archive->libar_entry_index ||
+	    (position == archive->libar_entry_index && archive->libar_entry_read)) {
+		ev_archive_reset (archive);
+		if (!ev_archive_open_filename (archive, archive->path, error))
+			return FALSE;
+	}
+
+	while (archive->libar_entry_index < position) {
+		if (!libarchive_read_next_header (archive, error)) {
+			if (error && *error == NULL)
+				g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+						     "Entry not found in archive");
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+gboolean
+ev_archive_seek_entry (EvArchive *archive,
+		       gint64     position,
+		       GError   **error)
+{
+	g_return_val_if_fail (EV_IS_ARCHIVE (archive), FALSE);
+	g_return_val_if_fail (archive->type != EV_ARCHIVE_TYPE_NONE, FALSE);
+	g_return_val_if_fail (archive->path != NULL, FALSE);
+	g_return_val_if_fail (position >= 0, FALSE);
+
+	switch (archive->type) {
+	case EV_ARCHIVE_TYPE_RAR:
+		if (archive->unarr == NULL &&
+		    !ev_archive_open_filename (archive, archive->path, error))
+			return FALSE;
+		/* unarr keeps the state of the decompressor of solid
+		 * archives, and only restarts it when going back */
+		if (!ar_parse_entry_at (archive->unarr, position)) {
+			g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+					     "Error seeking RAR entry");
+			return FALSE;
+		}
+		return TRUE;
+	case EV_ARCHIVE_TYPE_NONE:
+		g_assert_not_reached ();
+	case EV_ARCHIVE_TYPE_ZIP:
+	case EV_ARCHIVE_TYPE_7Z:
+	case EV_ARCHIVE_TYPE_TAR:
+		return libarchive_seek_entry (archive, position, error);
+	}
+
+	return FALSE;
+}
+
 static void
 ev_archive_init (EvArchive *archive)
 {
@@ -47,6 +47,10 @@ gboolean       ev_archive_read_next_header   (EvArchive     *archive,
 const char    *ev_archive_get_entry_pathname (EvArchive     *archive);
 gint64         ev_archive_get_entry_size     (EvArchive     *archive);
 gboolean       ev_archive_get_entry_is_encrypted (EvArchive *archive);
+gint64         ev_archive_get_entry_position (EvArchive     *archive);
+gboolean       ev_archive_seek_entry         (EvArchive     *archive,
+					      gint64         position,
+					      GError       **error);
 gssize         ev_archive_read_data          (EvArchive     *archive,
 					      void          *buf,
 					      gsize          count,
@@ -0,0 +1,311 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <archive.h>
+#include <archive_entry.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gstdio.h>
+
+#include "ev-archive.h"
+
+#define DEFAULT_N_ENTRIES 1000
+#define BLOCK_SIZE 10240
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Times reading every entry of an archive, scanning the archive for each entry\n"
+		 "  or seeking to the entry from an index built in one pass\n");
+	g_print ("Usage: %s [n-entries]\n", prog);
+	g_print ("       %s archive-type filename\n", prog);
+	g_print ("Without a filename, zip, 7z and tar archives of n-entries (default %d) PNG files\n"
+		 "are generated. Where archive-type is one of rar, zip, 7z or tar\n", DEFAULT_N_ENTRIES);
+}
+
+static EvArchiveType
+str_to_archive_type (const char *str)
+{
+	g_return_val_if_fail (str != NULL, EV_ARCHIVE_TYPE_NONE);
+
+	if (g_strcmp0 (str, "rar") == 0)
+		return EV_ARCHIVE_TYPE_RAR;
+	if (g_strcmp0 (str, "zip") == 0)
+		return EV_ARCHIVE_TYPE_ZIP;
+	if (g_strcmp0 (str, "7z") == 0)
+		return EV_ARCHIVE_TYPE_7Z;
+	if (g_strcmp0 (str, "tar") == 0)
+		return EV_ARCHIVE_TYPE_TAR;
+
+	g_warning ("Archive type '%s' not supported", str);
+	return EV_ARCHIVE_TYPE_NONE;
+}
+
+static gboolean
+write_archive (const char *path,
+	       const char *format,
+	       guint       n_entries)
+{
+	struct archive *ar;
+	GdkPixbuf      *pixbuf;
+	gchar          *png;
+	gsize           png_size;
+	guint           i;
+	int             r;
+
+	pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 600, 900);
+	gdk_pixbuf_fill (pixbuf, 0x336699ff);
+	if (!gdk_pixbuf_save_to_buffer (pixbuf, &png, &png_size, "png", NULL, NULL)) {
+		g_object_unref (pixbuf);
+		return FALSE;
+	}
+	g_object_unref (pixbuf);
+
+	ar = archive_write_new ();
+	r = archive_write_set_format_by_name (ar, format);
+	if (r == ARCHIVE_OK)
+		r = archive_write_open_filename (ar, path);
+	if (r != ARCHIVE_OK) {
+		g_warning ("Failed to write %s archive: %s", format, archive_error_string (ar));
+		archive_write_free (ar);
+		g_free (png);
+		return FALSE;
+	}
+
+	for (i = 0; i < n_entries; i++) {
+		struct archive_entry *entry;
+		gchar                *name;
+
+		name = g_strdup_printf ("page-%04u.png", i);
+		entry = archive_entry_new ();
+		archive_entry_set_pathname (entry, name);
+		archive_entry_set_filetype (entry, AE_IFREG);
+		archive_entry_set_perm (entry, 0644);
+		archive_entry_set_size (entry, png_size);
+		archive_write_header (ar, entry);
+		archive_write_data (ar, png, png_size);
+		archive_entry_free (entry);
+		g_free (name);
+	}
+
+	archive_write_close (ar);
+	archive_write_free (ar);
+	g_free (png);
+
+	return TRUE;
+}
+
+static gboolean
+read_entry (EvArchive *ar)
+{
+	char    buf[BLOCK_SIZE];
+	gint64  left;
+	gssize  read;
+	GError *error = NULL;
+
+	left = ev_archive_get_entry_size (ar);
+	while (left > 0) {
+		read = ev_archive_read_data (ar, buf, MIN (BLOCK_SIZE, left), &error);
+		if (read <= 0) {
+			if (error) {
+				g_warning ("Failed to read '%s': %s",
+					   ev_archive_get_entry_pathname (ar), error->message);
+				g_error_free (error);
+			}
+			return FALSE;
+		}
+		left -= read;
+	}
+
+	return TRUE;
+}
+
+/* What the comics backend used to do: reopen the archive and scan the
+ * headers for every entry */
+static gdouble
+time_rescan (EvArchive  *ar,
+	     const char *path,
+	     guint       n_entries)
+{
+	GTimer *timer;
+	gdouble elapsed;
+	guint   i;
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < n_entries; i++) {
+		guint n = 0;
+
+		if (!ev_archive_open_filename (ar, path, NULL))
+			break;
+
+		while (ev_archive_read_next_header (ar, NULL)) {
+			if (n++ == i) {
+				read_entry (ar);
+				break;
+			}
+		}
+		ev_archive_reset (ar);
+	}
+
+	g_timer_stop (timer);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	return elapsed;
+}
+
+static gdouble
+time_index (EvArchive  *ar,
+	    gint64     *positions,
+	    guint       n_entries,
+	    gboolean    backwards)
+{
+	GTimer *timer;
+	gdouble elapsed;
+	guint   i;
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < n_entries; i++) {
+		guint   entry = backwards ? n_entries - i - 1 : i;
+		GError *error = NULL;
+
+		if (!ev_archive_seek_entry (ar, positions[entry], &error)) {
+			g_warning ("Failed to seek entry %u: %s", entry, error->message);
+			g_error_free (error);
+			break;
+		}
+		read_entry (ar);
+	}
+	ev_archive_reset (ar);
+
+	g_timer_stop (timer);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	return elapsed;
+}
+
+static gboolean
+time_archive (const char    *label,
+	      EvArchiveType  ar_type,
+	      const char    *path)
+{
+	EvArchive *ar;
+	GArray    *positions;
+	GTimer    *timer;
+	gdouble    list_time;
+	GError    *error = NULL;
+
+	ar = ev_archive_new ();
+	ev_archive_set_archive_type (ar, ar_type);
+
+	/* Build the index in one pass */
+	timer = g_timer_new ();
+	if (!ev_archive_open_filename (ar, path, &error)) {
+		g_warning ("Failed to open '%s': %s", path, error->message);
+		g_error_free (error);
+		g_timer_destroy (timer);
+		g_object_unref (ar);
+		return FALSE;
+	}
+
+	positions = g_array_new (FALSE, FALSE, sizeof (gint64));
+	while (ev_archive_read_next_header (ar, NULL)) {
+		gint64 position = ev_archive_get_entry_position (ar);
+
+		g_array_append_val (positions, position);
+	}
+	ev_archive_reset (ar);
+	g_timer_stop (timer);
+	list_time = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	g_print ("%s\t%u\t%.3f\t%.3f\t%.3f\t%.3f\n",
+		 label, positions->len, list_time,
+		 time_rescan (ar, path, positions->len),
+		 time_index (ar, (gint64 *) positions->data, positions->len, FALSE),
+		 time_index (ar, (gint64 *) positions->data, positions->len, TRUE));
+
+	g_array_free (positions, TRUE);
+	g_object_unref (ar);
+
+	return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct {
+		const char   *format;
+		EvArchiveType type;
+	} formats[] = {
+		{ "zip", EV_ARCHIVE_TYPE_ZIP },
+		{ "7zip", EV_ARCHIVE_TYPE_7Z },
+		{ "ustar", EV_ARCHIVE_TYPE_TAR }
+	};
+	guint  n_entries = DEFAULT_N_ENTRIES;
+	gchar *tmp_dir;
+	guint  i;
+	int    retval = 0;
+
+	if (argc > 3 || (argc == 2 && atoi (argv[1]) <= 0)) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	g_print ("FORMAT\tENTRIES\tINDEX\tRESCAN\tSEEK\tSEEK-BACK (seconds)\n");
+
+	if (argc == 3) {
+		EvArchiveType ar_type = str_to_archive_type (argv[1]);
+
+		if (ar_type == EV_ARCHIVE_TYPE_NONE)
+			return 1;
+
+		return time_archive (argv[1], ar_type, argv[2]) ? 0 : 1;
+	}
+
+	if (argc == 2)
+		n_entries = atoi (argv[1]);
+
+	tmp_dir = g_dir_make_tmp ("test-ev-archive-index-XXXXXX", NULL);
+	if (!tmp_dir) {
+		g_warning ("Failed to create temporary directory");
+		return 1;
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+		gchar *path;
+
+		path = g_build_filename (tmp_dir, formats[i].format, NULL);
+		if (!write_archive (path, formats[i].format, n_entries) ||
+		    !time_archive (formats[i].format, formats[i].type, path))
+			retval = 1;
+		g_unlink (path);
+		g_free (path);
+	}
+
+	g_rmdir (tmp_dir);
+	g_free (tmp_dir);
+
+	return retval;
+}
@@ -550,6 +550,14 @@ djvu_document_finalize (GObject *object)
 	G_OBJECT_CLASS (djvu_document_parent_class)->finalize (object);
 }
 
+/* Every instance opens its own ddjvu context, so a copy loaded from
+ * the same file can be used from another thread. */
+static gboolean
+djvu_document_supports_worker_copies (EvDocument *document)
+{
+	return TRUE;
+}
+
 static void
 djvu_document_class_init (DjvuDocumentClass *klass)
 {
@@ -566,6 +574,7 @@ djvu_document_class_init (DjvuDocumentClass *klass)
 	ev_document_class->render = djvu_document_render;
 	ev_document_class->get_thumbnail = djvu_document_get_thumbnail;
 	ev_document_class->get_thumbnail_surface = djvu_document_get_thumbnail_surface;
+	ev_document_class->supports_worker_copies = djvu_document_supports_worker_copies;
 }
 
 static gchar *
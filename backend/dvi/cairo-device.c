@@ -54,7 +54,10 @@ dvi_cairo_draw_glyph (DviContext  *dvi,
 
 	cairo_device = (DviCairoDevice *) dvi->device.device_data;
 
-	glyph = &ch->grey;
+	/* Owned by the glyph cache, shared with other contexts */
+	glyph = dvi->curr_glyph;
+	if (!glyph)
+		return;
 
 	isbox = (glyph->data == NULL ||
 	         (dvi->params.flags & MDVI_PARAM_CHARBOXES) ||
@@ -126,6 +129,10 @@ dvi_cairo_draw_rule (DviContext *dvi,
 }
 
 #ifdef HAVE_SPECTRE
+/* Contexts render pages in parallel, but only one ghostscript
+ * instance can run at a time */
+static GMutex spectre_mutex;
+
 static void
 dvi_cairo_draw_ps (DviContext *dvi,
 		   const char *filename,
@@ -145,10 +152,13 @@ dvi_cairo_draw_ps (DviContext *dvi,
 
 	cairo_device = (DviCairoDevice *) dvi->device.device_data;
 
+	g_mutex_lock (&spectre_mutex);
+
 	psdoc = spectre_document_new ();
 	spectre_document_load (psdoc, filename);
 	if (spectre_document_status (psdoc)) {
 		spectre_document_free (psdoc);
+		g_mutex_unlock (&spectre_mutex);
 		return;
 	}
 
@@ -164,6 +174,8 @@ dvi_cairo_draw_ps (DviContext *dvi,
 	spectre_render_context_free (rc);
 	spectre_document_free (psdoc);
 
+	g_mutex_unlock (&spectre_mutex);
+
 	if (status) {
 		g_warning ("Error rendering PS document %s: %s\n",
 			   filename, spectre_status_to_string (status));
@@ -320,7 +332,8 @@ mdvi_cairo_device_get_surface (DviDevice *device)
 }
 
 void
-mdvi_cairo_device_render (DviContext* dvi)
+mdvi_cairo_device_render (DviContext      *dvi,
+			  EvRenderContext *rc)
 {
 	DviCairoDevice  *cairo_device;
 	gint             page_width;
@@ -335,8 +348,9 @@ mdvi_cairo_device_render (DviContext* dvi)
 	page_width = dvi->dvi_page_w * dvi->params.conv + 2 * cairo_device->xmargin;
 	page_height = dvi->dvi_page_h * dvi->params.vconv + 2 * cairo_device->ymargin;
 
-	surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
-                                              page_width, page_height);
+	/* Painted white below */
+	surface = ev_render_context_create_surface (rc, CAIRO_FORMAT_ARGB32,
+						    page_width, page_height);
 
 	cairo_device->cr = cairo_create (surface);
         cairo_surface_destroy (surface);
@@ -26,11 +26,13 @@
 #include "ev-file-helpers.h"
 
 #include "mdvi.h"
+#include "dviopcodes.h"
 #include "fonts.h"
 #include "color.h"
 #include "cairo-device.h"
 
 #include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
 #include <ctype.h>
 #ifdef G_OS_WIN32
 # define WIFEXITED(x) ((x) != 3)
@@ -39,7 +41,13 @@
 # include <sys/wait.h>
 #endif
 #include <stdlib.h>
+#include <string.h>
 
+/* The opcode and the counts and pointer that start a page */
+#define DVI_BOP_SIZE 45
+
+/* Protects the fonts and glyph cache all the contexts share, and the
+ * contexts waiting to render a page */
 static GMutex dvi_context_mutex;
 
 enum {
@@ -57,6 +65,8 @@ struct _DviDocument
 	EvDocument parent_instance;
 
 	DviContext *context;
+	/* Idle contexts for rendering, so pages render in parallel */
+	GSList *render_contexts;
 	DviPageSpec *spec;
 	DviParams *params;
 	
@@ -66,6 +76,9 @@ struct _DviDocument
 	
 	gchar *uri;
 
+	/* Page fingerprints, computed when loading */
+	gchar **fingerprints;
+
 	/* PDF exporter */
 	gchar		 *exporter_filename;
 	GString 	 *exporter_opts;
@@ -83,6 +96,251 @@ EV_BACKEND_REGISTER_WITH_CODE (DviDocument, dvi_document,
       EV_BACKEND_IMPLEMENT_INTERFACE (EV_TYPE_FILE_EXPORTER, dvi_document_file_exporter_iface_init);
      });
 
+static guint32
+dvi_get_uint32 (const guchar *data)
+{
+	return ((guint32) data[0] << 24) | ((guint32) data[1] << 16) |
+		((guint32) data[2] << 8) | (guint32) data[3];
+}
+
+/* Reads the @size bytes big endian parameter of a command */
+static gsize
+dvi_get_param (const guchar *data,
+	       gsize         size)
+{
+	gsize value = 0;
+	gsize i;
+
+	for (i = 0; i < size; i++)
+		value = (value << 8) | data[i];
+
+	return value;
+}
+
+/* Whether the commands of a page, up to its eop, draw files other than
+ * the DVI file, the figures of psfile specials, whose changes the
+ * fingerprint of the page would miss. Pages that can't be parsed are
+ * taken as drawing some.
+ */
+static gboolean
+dvi_page_has_external_files (const guchar *data,
+			     gsize         length)
+{
+	gsize pos = 0;
+
+	while (pos < length) {
+		guint op = data[pos++];
+		gsize size;
+
+		if (op <= DVI_SET_CHAR_MAX ||
+		    (op >= DVI_FNT_NUM0 && op <= DVI_FNT_NUM_MAX))
+			size = 0;
+		else if (op >= DVI_SET1 && op <= DVI_SET4)
+			size = op - DVI_SET1 + 1;
+		else if (op >= DVI_PUT1 && op <= DVI_PUT4)
+			size = op - DVI_PUT1 + 1;
+		else if (op >= DVI_RIGHT1 && op <= DVI_RIGHT4)
+			size = op - DVI_RIGHT1 + 1;
+		else if (op >= DVI_W1 && op <= DVI_W4)
+			size = op - DVI_W1 + 1;
+		else if (op >= DVI_X1 && op <= DVI_X4)
+			size = op - DVI_X1 + 1;
+		else if (op >= DVI_DOWN1 && op <= DVI_DOWN4)
+			size = op - DVI_DOWN1 + 1;
+		else if (op >= DVI_Y1 && op <= DVI_Y4)
+			size = op - DVI_Y1 + 1;
+		else if (op >= DVI_Z1 && op <= DVI_Z4)
+			size = op - DVI_Z1 + 1;
+		else if (op >= DVI_FNT1 && op <= DVI_FNT4)
+			size = op - DVI_FNT1 + 1;
+		else if (op == DVI_SET_RULE || op == DVI_PUT_RULE)
+			size = 8;
+		else if (op == DVI_EOP)
+			return FALSE;
+		else if (op == DVI_NOOP || op == DVI_PUSH || op == DVI_POP ||
+			 op == DVI_W0 || op == DVI_X0 || op == DVI_Y0 || op == DVI_Z0)
+			size = 0;
+		else if (op >= DVI_XXX1 && op <= DVI_XXX4) {
+			gsize  k_size = op - DVI_XXX1 + 1;
+			gsize  k;
+			gchar *special;
+
+			if (k_size > length - pos)
+				return TRUE;
+			k = dvi_get_param (data + pos, k_size);
+			if (k > length - pos - k_size)
+				return TRUE;
+
+			/* Matched like mdvi_do_special() does */
+			special = g_strndup ((const gchar *) data + pos + k_size, k);
+			g_strchug (special);
+			if (g_ascii_strncasecmp (special, "psfile", 6) == 0) {
+				g_free (special);
+				return TRUE;
+			}
+			g_free (special);
+
+			size = k_size + k;
+		} else if (op >= DVI_FNT_DEF1 && op <= DVI_FNT_DEF4) {
+			gsize k_size = op - DVI_FNT_DEF1 + 1;
+
+			/* k, checksum, scale, design size, area and name lengths */
+			if (k_size + 14 > length - pos)
+				return TRUE;
+			size = k_size + 14 + data[pos + k_size + 12] + data[pos + k_size + 13];
+		} else {
+			return TRUE;
+		}
+
+		if (size > length - pos)
+			return TRUE;
+		pos += size;
+	}
+
+	return TRUE;
+}
+
+/* A page renders the same as long as its commands and the fonts they use
+ * don't change, so its fingerprint is a hash of the bytes between its bop
+ * header, which has the page counts and a pointer to the previous page, and
+ * the next page, plus everything the commands depend on that's defined
+ * elsewhere in the file. Moving a page doesn't change its fingerprint.
+ * Pages drawing figures from other files get an empty fingerprint, they
+ * are not fingerprinted.
+ */
+static gchar **
+dvi_document_compute_fingerprints (DviDocument *dvi_document)
+{
+	DviContext  *context = dvi_document->context;
+	GChecksum   *common, *checksum;
+	DviFontRef  *ref;
+	guchar      *data;
+	gsize        length, post, end;
+	gchar      **fingerprints;
+	gint         i;
+	GStatBuf     buf;
+
+	if (!g_file_get_contents (context->filename, (gchar **) &data, &length, NULL))
+		return NULL;
+
+	/* The file changed again since the context was created */
+	if (g_stat (context->filename, &buf) != 0 || (Ulong) buf.st_mtime != context->modtime) {
+		g_free (data);
+		return NULL;
+	}
+
+	/* The postamble is pointed to from the end of the file,
+	 * after its identification byte and the trailer */
+	end = length;
+	while (end > 0 && data[end - 1] == DVI_TRAILER)
+		end--;
+	if (end < 6 || data[end - 6] != DVI_POST_POST ||
+	    (post = dvi_get_uint32 (data + end - 5)) >= length) {
+		g_free (data);
+		return NULL;
+	}
+
+	common = g_checksum_new (G_CHECKSUM_SHA1);
+	g_checksum_update (common, (const guchar *) &context->num, sizeof (context->num));
+	g_checksum_update (common, (const guchar *) &context->den, sizeof (context->den));
+	g_checksum_update (common, (const guchar *) &context->dvimag, sizeof (context->dvimag));
+	g_checksum_update (common, (const guchar *) &dvi_document->base_width, sizeof (gdouble));
+	g_checksum_update (common, (const guchar *) &dvi_document->base_height, sizeof (gdouble));
+	for (ref = context->fonts; ref; ref = ref->next) {
+		g_checksum_update (common, (const guchar *) &ref->fontid, sizeof (ref->fontid));
+		g_checksum_update (common, (const guchar *) &ref->ref->checksum, sizeof (ref->ref->checksum));
+		g_checksum_update (common, (const guchar *) &ref->ref->scale, sizeof (ref->ref->scale));
+		g_checksum_update (common, (const guchar *) &ref->ref->design, sizeof (ref->ref->design));
+		g_checksum_update (common, (const guchar *) ref->ref->fontname, -1);
+	}
+
+	fingerprints = g_new0 (gchar *, context->npages + 1);
+	for (i = 0; i < context->npages; i++) {
+		gsize start = context->pagemap[i][0] + DVI_BOP_SIZE;
+		gsize page_end = i + 1 < context->npages ? (gsize) context->pagemap[i + 1][0] : post;
+
+		if (start > page_end || page_end > length)
+			break;
+
+		if (dvi_page_has_external_files (data + start, page_end - start)) {
+			fingerprints[i] = g_strdup ("");
+			continue;
+		}
+
+		checksum = g_checksum_copy (common);
+		g_checksum_update (checksum, data + start, page_end - start);
+		fingerprints[i] = g_strdup (g_checksum_get_string (checksum));
+		g_checksum_free (checksum);
+	}
+	g_checksum_free (common);
+	g_free (data);
+
+	/* Pages out of order, don't trust any fingerprint */
+	if (i < context->npages)
+		g_clear_pointer (&fingerprints, g_strfreev);
+
+	return fingerprints;
+}
+
+static void
+dvi_fonts_lock (void)
+{
+	g_mutex_lock (&dvi_context_mutex);
+}
+
+static void
+dvi_fonts_unlock (void)
+{
+	g_mutex_unlock (&dvi_context_mutex);
+}
+
+/* Must be called with dvi_context_mutex held */
+static void
+dvi_document_free_render_contexts (DviDocument *dvi_document)
+{
+	GSList *l;
+
+	for (l = dvi_document->render_contexts; l; l = g_slist_next (l)) {
+		DviContext *context = (DviContext *) l->data;
+
+		mdvi_cairo_device_free (&context->device);
+		mdvi_destroy_context (context);
+	}
+	g_slist_free (dvi_document->render_contexts);
+	dvi_document->render_contexts = NULL;
+}
+
+static DviContext *
+dvi_document_get_render_context (DviDocument *dvi_document)
+{
+	DviContext *context;
+
+	g_mutex_lock (&dvi_context_mutex);
+	if (dvi_document->render_contexts) {
+		context = (DviContext *) dvi_document->render_contexts->data;
+		dvi_document->render_contexts = g_slist_delete_link (dvi_document->render_contexts,
+								     dvi_document->render_contexts);
+	} else {
+		/* The fonts are shared with the other contexts */
+		context = mdvi_init_context (dvi_document->params, dvi_document->spec,
+					     dvi_document->context->filename);
+		if (context)
+			mdvi_cairo_device_init (&context->device);
+	}
+	g_mutex_unlock (&dvi_context_mutex);
+
+	return context;
+}
+
+static void
+dvi_document_release_render_context (DviDocument *dvi_document,
+				     DviContext  *context)
+{
+	g_mutex_lock (&dvi_context_mutex);
+	dvi_document->render_contexts = g_slist_prepend (dvi_document->render_contexts, context);
+	g_mutex_unlock (&dvi_context_mutex);
+}
+
 static gboolean
 dvi_document_load (EvDocument  *document,
 		   const char  *uri,
@@ -96,6 +354,7 @@ dvi_document_load (EvDocument  *document,
         	return FALSE;
 	
 	g_mutex_lock (&dvi_context_mutex);
+	dvi_document_free_render_contexts (dvi_document);
 	if (dvi_document->context)
 		mdvi_destroy_context (dvi_document->context);
 
@@ -122,6 +381,9 @@ dvi_document_load (EvDocument  *document,
 	
 	g_free (dvi_document->uri);
 	dvi_document->uri = g_strdup (uri);
+
+	g_strfreev (dvi_document->fingerprints);
+	dvi_document->fingerprints = dvi_document_compute_fingerprints (dvi_document);
 	
 	return TRUE;
 }
@@ -164,41 +426,40 @@ dvi_document_render (EvDocument      *document,
 	cairo_surface_t *surface;
 	cairo_surface_t *rotated_surface;
 	DviDocument *dvi_document = DVI_DOCUMENT(document);
+	DviContext *context;
 	gdouble xscale, yscale;
 	gint required_width, required_height;
 	gint proposed_width, proposed_height;
 	gint xmargin = 0, ymargin = 0;
 
-	/* We should protect our context since it's not 
-	 * thread safe. The work to the future - 
-	 * let context render page independently
-	 */
-	g_mutex_lock (&dvi_context_mutex);
+	context = dvi_document_get_render_context (dvi_document);
+	if (!context)
+		return NULL;
 	
-	mdvi_setpage (dvi_document->context, rc->page->index);
+	mdvi_setpage (context, rc->page->index);
 	
 	ev_render_context_compute_scales (rc, dvi_document->base_width, dvi_document->base_height,
 					  &xscale, &yscale);
-	mdvi_set_shrink (dvi_document->context, 
+	mdvi_set_shrink (context, 
 			 (int)((dvi_document->params->hshrink - 1) / xscale) + 1,
 			 (int)((dvi_document->params->vshrink - 1) / yscale) + 1);
 
 	ev_render_context_compute_scaled_size (rc, dvi_document->base_width, dvi_document->base_height,
 					       &required_width, &required_height);
-	proposed_width = dvi_document->context->dvi_page_w * dvi_document->context->params.conv;
-	proposed_height = dvi_document->context->dvi_page_h * dvi_document->context->params.vconv;
+	proposed_width = context->dvi_page_w * context->params.conv;
+	proposed_height = context->dvi_page_h * context->params.vconv;
 	
 	if (required_width >= proposed_width)
 	    xmargin = (required_width - proposed_width) / 2;
 	if (required_height >= proposed_height)
 	    ymargin = (required_height - proposed_height) / 2;
 	    
-	mdvi_cairo_device_set_margins (&dvi_document->context->device, xmargin, ymargin);
-	mdvi_cairo_device_set_scale (&dvi_document->context->device, xscale, yscale);
-	mdvi_cairo_device_render (dvi_document->context);
-	surface = mdvi_cairo_device_get_surface (&dvi_document->context->device);
+	mdvi_cairo_device_set_margins (&context->device, xmargin, ymargin);
+	mdvi_cairo_device_set_scale (&context->device, xscale, yscale);
+	mdvi_cairo_device_render (context, rc);
+	surface = mdvi_cairo_device_get_surface (&context->device);
 
-	g_mutex_unlock (&dvi_context_mutex);
+	dvi_document_release_render_context (dvi_document, context);
 
 	rotated_surface = ev_document_misc_surface_rotate_and_scale (surface,
 								     required_width,
@@ -209,12 +470,26 @@ dvi_document_render (EvDocument      *document,
 	return rotated_surface;
 }
 
+static gchar *
+dvi_document_get_page_fingerprint (EvDocument *document,
+				   EvPage     *page)
+{
+	DviDocument *dvi_document = DVI_DOCUMENT (document);
+
+	if (!dvi_document->fingerprints ||
+	    dvi_document->fingerprints[page->index][0] == '\0')
+		return NULL;
+
+	return g_strdup (dvi_document->fingerprints[page->index]);
+}
+
 static void
 dvi_document_finalize (GObject *object)
 {	
 	DviDocument *dvi_document = DVI_DOCUMENT(object);
 	
 	g_mutex_lock (&dvi_context_mutex);
+	dvi_document_free_render_contexts (dvi_document);
 	if (dvi_document->context) {
 		mdvi_cairo_device_free (&dvi_document->context->device);
 		mdvi_destroy_context (dvi_document->context);
@@ -231,6 +506,7 @@ dvi_document_finalize (GObject *object)
 		g_string_free (dvi_document->exporter_opts, TRUE);
 
         g_free (dvi_document->uri);
+	g_strfreev (dvi_document->fingerprints);
 		
 	G_OBJECT_CLASS (dvi_document_parent_class)->finalize (object);
 }
@@ -241,6 +517,15 @@ dvi_document_support_synctex (EvDocument *document)
 	return TRUE;
 }
 
+/* Each page is rendered by its own context, and mdvi calls
+ * dvi_fonts_lock() around everything the contexts share.
+ */
+static gboolean
+dvi_document_is_thread_safe (EvDocument *document)
+{
+	return TRUE;
+}
+
 static void
 dvi_document_class_init (DviDocumentClass *klass)
 {
@@ -256,13 +541,16 @@ dvi_document_class_init (DviDocumentClass *klass)
 
 	mdvi_register_special ("Color", "color", NULL, dvi_document_do_color_special, 1);
 	mdvi_register_fonts ();
+	mdvi_set_font_lock (dvi_fonts_lock, dvi_fonts_unlock);
 
 	ev_document_class->load = dvi_document_load;
 	ev_document_class->save = dvi_document_save;
 	ev_document_class->get_n_pages = dvi_document_get_n_pages;
 	ev_document_class->get_page_size = dvi_document_get_page_size;
 	ev_document_class->render = dvi_document_render;
+	ev_document_class->get_page_fingerprint = dvi_document_get_page_fingerprint;
 	ev_document_class->support_synctex = dvi_document_support_synctex;
+	ev_document_class->is_thread_safe = dvi_document_is_thread_safe;
 }
 
 /* EvFileExporterIface */
@@ -53,6 +53,9 @@
 /* default gamma correction */
 #define MDVI_DEFAULT_GAMMA	1.0
 
+/* memory used by the cache of shrunk glyphs */
+#define MDVI_GLYPH_CACHE_SIZE	(16 * 1024 * 1024)
+
 /* default window geometry */
 #define MDVI_GEOMETRY	NULL
 
@@ -542,6 +542,7 @@ int mdvi_configure(DviContext *dvi, DviParamCode option, ...)
 	va_list	ap;
 	int	reset_all;
 	int	reset_font;
+	int	status;
 	DviParams np;
 	
 	va_start(ap, option);
@@ -564,15 +565,12 @@ int mdvi_configure(DviContext *dvi, DviParamCode option, ...)
 			break;
 		case MDVI_SET_SHRINK:
 			np.hshrink = np.vshrink = va_arg(ap, Uint);
-			reset_font = MDVI_FONTSEL_GREY|MDVI_FONTSEL_BITMAP;
 			break;
 		case MDVI_SET_XSHRINK:
 			np.hshrink = va_arg(ap, Uint);
-			reset_font = MDVI_FONTSEL_GREY|MDVI_FONTSEL_BITMAP;
 			break;
 		case MDVI_SET_YSHRINK:
 			np.vshrink = va_arg(ap, Uint);
-			reset_font = MDVI_FONTSEL_GREY|MDVI_FONTSEL_BITMAP;
 			break;
 		case MDVI_SET_ORIENTATION:
 			np.orientation = va_arg(ap, DviOrientation);
@@ -580,11 +578,9 @@ int mdvi_configure(DviContext *dvi, DviParamCode option, ...)
 			break;
 		case MDVI_SET_GAMMA:
 			np.gamma = va_arg(ap, double);
-			reset_font = MDVI_FONTSEL_GREY;
 			break;
 		case MDVI_SET_DENSITY:
 			np.density = va_arg(ap, Uint);
-			reset_font = MDVI_FONTSEL_BITMAP;
 			break;
 		case MDVI_SET_MAGNIFICATION:
 			np.mag = va_arg(ap, double);
@@ -601,11 +597,9 @@ int mdvi_configure(DviContext *dvi, DviParamCode option, ...)
 			break;
 		case MDVI_SET_FOREGROUND:
 			np.fg = va_arg(ap, Ulong);
-			reset_font = MDVI_FONTSEL_GREY;
 			break;
 		case MDVI_SET_BACKGROUND:
 			np.bg = va_arg(ap, Ulong);
-			reset_font = MDVI_FONTSEL_GREY;
 			break;
 		default:
 			break;
@@ -633,8 +627,12 @@ int mdvi_configure(DviContext *dvi, DviParamCode option, ...)
 	 * the DVI file again from scratch.
 	 */
 
-	if(reset_all)
-		return (mdvi_reload(dvi, &np) == 0);
+	if(reset_all) {
+		font_lock();
+		status = mdvi_reload(dvi, &np);
+		font_unlock();
+		return (status == 0);
+	}
 
 	if(np.hshrink != dvi->params.hshrink) {
 		np.conv = dvi->dviconv;
@@ -647,8 +645,14 @@ int mdvi_configure(DviContext *dvi, DviParamCode option, ...)
 			np.vconv /= np.vshrink;
 	}
 
+	/* 
+	 * The shrunk glyphs are cached by shrinking factor, density, gamma
+	 * and colors, so only a new orientation makes us reset the fonts.
+	 */
 	if(reset_font) {
+		font_lock();
 		font_reset_chain_glyphs(&dvi->device, dvi->fonts, reset_font);
+		font_unlock();
 	}
 	dvi->params = np;	
 	if((reset_font & MDVI_FONTSEL_GLYPH) && dvi->device.refresh) {
@@ -1020,7 +1024,9 @@ again:
 	
 	/* check if we need to reload the file */
 	if(!reloaded && get_mtime(fileno(dvi->in)) > dvi->modtime) {
+		font_lock();
 		mdvi_reload(dvi, &dvi->params);
+		font_unlock();
 		/* we have to reopen the file, again */
 		reloaded = 1;
 		goto again;
@@ -1091,6 +1097,7 @@ again:
 		if(dvi_commands[op](dvi, op) < 0)
 			break;
 	}
+	font_release_glyph(dvi);
 	
 	fflush(stdout);
 	fflush(stderr);
@@ -1190,10 +1197,8 @@ static void draw_box(DviContext *dvi, DviFontChar *ch)
 	DviGlyph *glyph = NULL;
 	int	x, y, w, h;
 		
-	if(!MDVI_GLYPH_UNSET(ch->shrunk.data))
-		glyph = &ch->shrunk;
-	else if(!MDVI_GLYPH_UNSET(ch->grey.data))
-		glyph = &ch->grey;
+	if(dvi->curr_glyph)
+		glyph = dvi->curr_glyph;
 	else if(!MDVI_GLYPH_UNSET(ch->glyph.data))
 		glyph = &ch->glyph;
 	if(glyph == NULL)
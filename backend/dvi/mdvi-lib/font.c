@@ -32,6 +32,208 @@ extern void vf_free_macros(DviFont *);
 #define TYPENAME(font)	\
 	((font)->finfo ? (font)->finfo->name : "none")
 
+/*
+ * Contexts rendering at different shrinking factors share the fonts, so
+ * instead of keeping one shrunk copy of each glyph in its DviFontChar, we
+ * keep the shrunk glyphs here, keyed by everything they are computed from.
+ * The least recently used ones are dropped when the cache grows over
+ * MDVI_GLYPH_CACHE_SIZE, except for those a context is drawing (pinned).
+ */
+typedef struct _GlyphEntry GlyphEntry;
+
+struct _GlyphEntry {
+	GlyphEntry *next;	/* LRU list, most recently used last */
+	GlyphEntry *prev;
+	GlyphEntry *chain;	/* next entry in the same bucket */
+	DviFont	*font;		/* NULL once flushed while pinned */
+	int	code;
+	int	kind;		/* MDVI_FONTSEL_BITMAP, _GREY, or 0 for a box */
+	int	hshrink;
+	int	vshrink;
+	int	density;
+	double	gamma;
+	Ulong	fg;
+	Ulong	bg;
+	Uint	bucket;
+	int	pins;
+	size_t	size;
+	DviFreeImage free_image;
+	DviGlyph glyph;
+};
+
+#define GLYPH_CACHE_BUCKETS	4096
+
+static GlyphEntry *glyph_cache[GLYPH_CACHE_BUCKETS];
+static ListHead glyph_lru;
+static size_t	glyph_cache_size;
+
+static DviLockFunc font_lock_func;
+static DviLockFunc font_unlock_func;
+
+void	mdvi_set_font_lock(DviLockFunc lock, DviLockFunc unlock)
+{
+	font_lock_func = lock;
+	font_unlock_func = unlock;
+}
+
+void	font_lock(void)
+{
+	if(font_lock_func)
+		font_lock_func();
+}
+
+void	font_unlock(void)
+{
+	if(font_unlock_func)
+		font_unlock_func();
+}
+
+static Uint glyph_hash(DviFont *font, int code, int hs, int vs)
+{
+	Ulong	h;
+
+	h = (Ulong)font >> 4;
+	h = h * 31 + code;
+	h = h * 31 + hs;
+	h = h * 31 + vs;
+	return (Uint)(h % GLYPH_CACHE_BUCKETS);
+}
+
+static void glyph_entry_destroy(GlyphEntry *entry)
+{
+	GlyphEntry **ptr;
+
+	for(ptr = &glyph_cache[entry->bucket]; *ptr; ptr = &(*ptr)->chain) {
+		if(*ptr == entry) {
+			*ptr = entry->chain;
+			break;
+		}
+	}
+	listh_remove(&glyph_lru, LIST(entry));
+	glyph_cache_size -= entry->size;
+	if(MDVI_GLYPH_NONEMPTY(entry->glyph.data)) {
+		if(entry->free_image)
+			entry->free_image(entry->glyph.data);
+		else
+			bitmap_destroy((BITMAP *)entry->glyph.data);
+	}
+	mdvi_free(entry);
+}
+
+static void glyph_cache_trim(size_t max_size)
+{
+	GlyphEntry *entry, *next;
+
+	for(entry = (GlyphEntry *)glyph_lru.head;
+	    entry && glyph_cache_size > max_size; entry = next) {
+		next = entry->next;
+		if(!entry->pins)
+			glyph_entry_destroy(entry);
+	}
+}
+
+/* drop all the shrunk glyphs of a font */
+static void glyph_cache_flush_font(DviFont *font)
+{
+	GlyphEntry *entry, *next;
+
+	for(entry = (GlyphEntry *)glyph_lru.head; entry; entry = next) {
+		next = entry->next;
+		if(entry->font != font)
+			continue;
+		/* a context is drawing it, it goes away when released */
+		if(entry->pins)
+			entry->font = NULL;
+		else
+			glyph_entry_destroy(entry);
+	}
+}
+
+/* returns the shrunk glyph for the current parameters, pinned */
+static GlyphEntry *glyph_cache_lookup(DviContext *dvi, DviFont *font,
+	DviFontChar *ch, int code, int kind)
+{
+	GlyphEntry *entry;
+	int	hs, vs;
+	Uint	bucket;
+
+	hs = dvi->params.hshrink;
+	vs = dvi->params.vshrink;
+	bucket = glyph_hash(font, code, hs, vs);
+	for(entry = glyph_cache[bucket]; entry; entry = entry->chain) {
+		if(entry->font == font && entry->code == code &&
+		   entry->kind == kind &&
+		   entry->hshrink == hs && entry->vshrink == vs &&
+		   entry->density == dvi->params.density &&
+		   (kind != MDVI_FONTSEL_GREY ||
+		    (entry->fg == dvi->curr_fg && entry->bg == dvi->curr_bg &&
+		     entry->gamma == dvi->params.gamma)))
+			break;
+	}
+	if(entry) {
+		listh_remove(&glyph_lru, LIST(entry));
+		listh_append(&glyph_lru, LIST(entry));
+		entry->pins++;
+		return entry;
+	}
+
+	entry = xalloc(GlyphEntry);
+	memzero(entry, sizeof(GlyphEntry));
+	entry->font = font;
+	entry->code = code;
+	entry->kind = kind;
+	entry->hshrink = hs;
+	entry->vshrink = vs;
+	entry->density = dvi->params.density;
+	entry->gamma = dvi->params.gamma;
+	entry->fg = dvi->curr_fg;
+	entry->bg = dvi->curr_bg;
+	entry->bucket = bucket;
+	entry->pins = 1;
+	entry->size = sizeof(GlyphEntry);
+	if(kind == MDVI_FONTSEL_GREY) {
+		font->finfo->shrink1(dvi, font, ch, &entry->glyph);
+		entry->free_image = dvi->device.free_image;
+		/* the device images are 32 bits per pixel */
+		entry->size += entry->glyph.w * entry->glyph.h * 4;
+	} else if(kind == MDVI_FONTSEL_BITMAP) {
+		font->finfo->shrink0(dvi, font, ch, &entry->glyph);
+		if(MDVI_GLYPH_NONEMPTY(entry->glyph.data))
+			entry->size += ((BITMAP *)entry->glyph.data)->stride * 
+				entry->glyph.h;
+	} else
+		mdvi_shrink_box(dvi, font, ch, &entry->glyph);
+
+	entry->chain = glyph_cache[bucket];
+	glyph_cache[bucket] = entry;
+	listh_append(&glyph_lru, LIST(entry));
+	glyph_cache_size += entry->size;
+	glyph_cache_trim(MDVI_GLYPH_CACHE_SIZE);
+
+	return entry;
+}
+
+static void glyph_cache_release(DviContext *dvi)
+{
+	GlyphEntry *entry = (GlyphEntry *)dvi->curr_glyph_entry;
+
+	dvi->curr_glyph = NULL;
+	dvi->curr_glyph_entry = NULL;
+	if(entry && --entry->pins == 0 && entry->font == NULL)
+		glyph_entry_destroy(entry);
+}
+
+void	font_release_glyph(DviContext *dvi)
+{
+	if(dvi->curr_glyph_entry == NULL) {
+		dvi->curr_glyph = NULL;
+		return;
+	}
+	font_lock();
+	glyph_cache_release(dvi);
+	font_unlock();
+}
+
 int	font_reopen(DviFont *font)
 {
 	if(font->in)
@@ -346,53 +548,56 @@ static int load_one_glyph(DviContext *dvi, DviFont *font, int code)
 DviFontChar *font_get_glyph(DviContext *dvi, DviFont *font, int code)
 {
 	DviFontChar *ch;
+	GlyphEntry *entry;
+	int	kind;
 
+	font_lock();
+	glyph_cache_release(dvi);
 again:
 	/* if we have not loaded the font yet, do so now */
-	if(!font->chars && load_font_file(&dvi->params, font) < 0)
-		return NULL;
+	if(!font->chars && load_font_file(&dvi->params, font) < 0) {
+		ch = NULL;
+		goto done;
+	}
 	
 	/* get the unscaled glyph, maybe loading it from disk */
 	ch = FONTCHAR(font, code);
-	if(!ch || !glyph_present(ch))
-		return NULL;
+	if(!ch || !glyph_present(ch)) {
+		ch = NULL;
+		goto done;
+	}
 	if(!ch->loaded && load_one_glyph(dvi, font, code) == -1) {
 		if(font->chars == NULL) {
 			/* we need to try another font class */
 			goto again;
 		}
-		return NULL;
+		ch = NULL;
+		goto done;
 	}
 	/* yes, we have to do this again */
 	ch = FONTCHAR(font, code);
 
-	/* Got the glyph. If we also have the right scaled glyph, do no more */
+	/* Got the glyph. If it doesn't need to be shrunk, do no more.
+	 * Antialiased devices draw images, so those are always made */
 	if(!ch->width || !ch->height ||
 	   font->finfo->getglyph == NULL ||
-	   (dvi->params.hshrink == 1 && dvi->params.vshrink == 1))
-		return ch;
+	   (dvi->params.hshrink == 1 && dvi->params.vshrink == 1 &&
+	    !MDVI_ENABLED(dvi, MDVI_PARAM_ANTIALIASED)))
+		goto done;
 	
 	/* If the glyph is empty, we just need to shrink the box */
-	if(ch->missing || MDVI_GLYPH_ISEMPTY(ch->glyph.data)) {
-		if(MDVI_GLYPH_UNSET(ch->shrunk.data))
-			mdvi_shrink_box(dvi, font, ch, &ch->shrunk);
-		return ch;
-	} else if(MDVI_ENABLED(dvi, MDVI_PARAM_ANTIALIASED)) {
-		if(ch->grey.data && 
-		   !MDVI_GLYPH_ISEMPTY(ch->grey.data) &&
-		   ch->fg == dvi->curr_fg && 
-		   ch->bg == dvi->curr_bg)
-		   	return ch;
-		if(ch->grey.data &&
-		   !MDVI_GLYPH_ISEMPTY(ch->grey.data)) {
-			if(dvi->device.free_image)
-				dvi->device.free_image(ch->grey.data);
-			ch->grey.data = NULL;
-		}
-		font->finfo->shrink1(dvi, font, ch, &ch->grey);
-	} else if(!ch->shrunk.data)
-		font->finfo->shrink0(dvi, font, ch, &ch->shrunk);
-
+	if(ch->missing || MDVI_GLYPH_ISEMPTY(ch->glyph.data))
+		kind = 0;
+	else if(MDVI_ENABLED(dvi, MDVI_PARAM_ANTIALIASED))
+		kind = MDVI_FONTSEL_GREY;
+	else
+		kind = MDVI_FONTSEL_BITMAP;
+	entry = glyph_cache_lookup(dvi, font, ch, code, kind);
+	dvi->curr_glyph = &entry->glyph;
+	dvi->curr_glyph_entry = entry;
+
+done:
+	font_unlock();
 	return ch;
 }
 
@@ -427,6 +632,8 @@ void	font_reset_font_glyphs(DviDevice *dev, DviFont *font, int what)
 	
 	if(what & MDVI_FONTSEL_GLYPH)
 		what |= MDVI_FONTSEL_BITMAP|MDVI_FONTSEL_GREY;	
+	if(what & (MDVI_FONTSEL_BITMAP|MDVI_FONTSEL_GREY))
+		glyph_cache_flush_font(font);
 	if(font->subfonts) {
 		DviFontRef *ref;
 		
@@ -50,6 +50,7 @@ typedef struct _DviFontClass DviFontClass;
 
 typedef void (*DviFreeFunc) __PROTO((void *));
 typedef void (*DviFree2Func) __PROTO((void *, void *));
+typedef void (*DviLockFunc) __PROTO((void));
 
 typedef Ulong	DviColor;
 
@@ -391,6 +392,8 @@ struct _DviContext {
 	DviDevice device;	/* device-specific routines */
 	Ulong	curr_fg;	/* rendering color */
 	Ulong	curr_bg;
+	DviGlyph *curr_glyph;	/* shrunk glyph of the current character */
+	void	*curr_glyph_entry; /* glyph cache entry holding it */
 
 	DviColorPair *color_stack;
 	int	color_top;
@@ -588,6 +591,14 @@ extern int font_reopen __PROTO((DviFont *));
 /* reads a glyph from a font, and makes all necessary transformations */
 extern DviFontChar* font_get_glyph __PROTO((DviContext *, DviFont *, int));
 
+/* lets the glyph cache drop the shrunk glyph of the current character */
+extern void font_release_glyph __PROTO((DviContext *));
+
+/* serialize access to the fonts, which all contexts share */
+extern void mdvi_set_font_lock __PROTO((DviLockFunc, DviLockFunc));
+extern void font_lock __PROTO((void));
+extern void font_unlock __PROTO((void));
+
 /* transform a glyph according to the given orientation */
 extern void font_transform_glyph __PROTO((DviOrientation, DviGlyph *));
 
@@ -389,9 +389,26 @@ pdf_page_render (PopplerPage     *page,
 	double page_width, page_height;
 	double xscale, yscale;
 
-	surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
-					      width, height);
-	cr = cairo_create (surface);
+	if (rc->has_area) {
+		/* Only render the requested area of the page, the
+		 * transformation below is still computed for the whole page.
+		 */
+		surface = ev_render_context_create_surface (rc, CAIRO_FORMAT_ARGB32,
+							    rc->area.width, rc->area.height);
+		cr = cairo_create (surface);
+		cairo_translate (cr, -rc->area.x, -rc->area.y);
+	} else {
+		surface = ev_render_context_create_surface (rc, CAIRO_FORMAT_ARGB32,
+							    width, height);
+		cr = cairo_create (surface);
+	}
+
+	/* The pixels may be the ones of a page rendered before, the page
+	 * is rendered on a transparent surface and the white background is
+	 * painted under it then */
+	cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+	cairo_paint (cr);
+	cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
 
 	switch (rc->rotation) {
 	        case 90:
@@ -482,32 +499,29 @@ pdf_document_get_thumbnail (EvDocument      *document,
 
 	surface = poppler_page_get_thumbnail (poppler_page);
 	if (surface) {
-		pixbuf = ev_document_misc_pixbuf_from_surface (surface);
-		cairo_surface_destroy (surface);
-	}
-
-	if (pixbuf != NULL) {
 		int thumb_width = (rc->rotation == 90 || rc->rotation == 270) ?
-			gdk_pixbuf_get_height (pixbuf) :
-			gdk_pixbuf_get_width (pixbuf);
+			cairo_image_surface_get_height (surface) :
+			cairo_image_surface_get_width (surface);
 
+		/* Rotated before the conversion, only when the provided
+		 * thumbnail has the right size */
 		if (thumb_width == width) {
-			GdkPixbuf *rotated_pixbuf;
+			cairo_surface_t *rotated_surface;
 
-			rotated_pixbuf = gdk_pixbuf_rotate_simple (pixbuf,
-								   (GdkPixbufRotation) (360 - rc->rotation));
-			g_object_unref (pixbuf);
-			pixbuf = rotated_pixbuf;
-		} else {
-			/* The provided thumbnail has a different size */
-			g_object_unref (pixbuf);
-			pixbuf = make_thumbnail_for_page (poppler_page, rc, width, height);
+			rotated_surface = ev_document_misc_surface_rotate_and_scale (surface,
+										     cairo_image_surface_get_width (surface),
+										     cairo_image_surface_get_height (surface),
+										     rc->rotation);
+			pixbuf = ev_document_misc_pixbuf_from_surface (rotated_surface);
+			cairo_surface_destroy (rotated_surface);
 		}
-	} else {
-		/* There is no provided thumbnail. We need to make one. */
-		pixbuf = make_thumbnail_for_page (poppler_page, rc, width, height);
+		cairo_surface_destroy (surface);
 	}
 
+	/* There is no provided thumbnail of the right size. We need to make one. */
+	if (!pixbuf)
+		pixbuf = make_thumbnail_for_page (poppler_page, rc, width, height);
+
 	return pixbuf;
 }
 
@@ -539,7 +553,11 @@ pdf_document_get_thumbnail_surface (EvDocument      *document,
 		if (surface_width == width) {
 			cairo_surface_t *rotated_surface;
 
-			rotated_surface = ev_document_misc_surface_rotate_and_scale (surface, width, height, rc->rotation);
+			/* Only rotated, the size is the one before the rotation */
+			rotated_surface = ev_document_misc_surface_rotate_and_scale (surface,
+										     cairo_image_surface_get_width (surface),
+										     cairo_image_surface_get_height (surface),
+										     rc->rotation);
 			cairo_surface_destroy (surface);
 			return rotated_surface;
 		} else {
@@ -967,6 +985,20 @@ pdf_document_support_synctex (EvDocument *document)
 	return TRUE;
 }
 
+static gboolean
+pdf_document_supports_render_area (EvDocument *document)
+{
+	return TRUE;
+}
+
+/* Every instance owns its PopplerDocument, so a copy opened from the
+ * same file can be used from another thread. */
+static gboolean
+pdf_document_supports_worker_copies (EvDocument *document)
+{
+	return TRUE;
+}
+
 static void
 pdf_document_class_init (PdfDocumentClass *klass)
 {
@@ -989,6 +1021,8 @@ pdf_document_class_init (PdfDocumentClass *klass)
 	ev_document_class->get_info = pdf_document_get_info;
 	ev_document_class->get_backend_info = pdf_document_get_backend_info;
 	ev_document_class->support_synctex = pdf_document_support_synctex;
+	ev_document_class->supports_render_area = pdf_document_supports_render_area;
+	ev_document_class->supports_worker_copies = pdf_document_supports_worker_copies;
 }
 
 /* EvDocumentSecurity */
@@ -1249,6 +1283,28 @@ pdf_document_links_has_document_links (EvDocumentLinks *document_links)
 	return TRUE;
 }
 
+/* Outlines of reference manuals have thousands of destinations, getting
+ * a PopplerPage for each of them just for its height is too slow */
+static double
+pdf_document_get_dest_page_height (PdfDocument *pdf_document,
+				   PopplerDest *dest)
+{
+	PopplerPage *poppler_page;
+	gint         page_index = MAX (0, dest->page_num - 1);
+	double       height = 0;
+
+	if (ev_document_lookup_page_size (EV_DOCUMENT (pdf_document), page_index, NULL, &height))
+		return height;
+
+	poppler_page = poppler_document_get_page (pdf_document->document, page_index);
+	if (poppler_page) {
+		poppler_page_get_size (poppler_page, NULL, &height);
+		g_object_unref (poppler_page);
+	}
+
+	return height;
+}
+
 static EvLinkDest *
 ev_link_dest_from_dest (PdfDocument *pdf_document,
 			PopplerDest *dest)
@@ -1260,12 +1316,9 @@ ev_link_dest_from_dest (PdfDocument *pdf_document,
 
 	switch (dest->type) {
 	        case POPPLER_DEST_XYZ: {
-			PopplerPage *poppler_page;
 			double height;
 
-			poppler_page = poppler_document_get_page (pdf_document->document,
-								  MAX (0, dest->page_num - 1));
-			poppler_page_get_size (poppler_page, NULL, &height);
+			height = pdf_document_get_dest_page_height (pdf_document, dest);
 			ev_dest = ev_link_dest_new_xyz (dest->page_num - 1,
 							dest->left,
 							height - MIN (height, dest->top),
@@ -1273,7 +1326,6 @@ ev_link_dest_from_dest (PdfDocument *pdf_document,
 							dest->change_left,
 							dest->change_top,
 							dest->change_zoom);
-			g_object_unref (poppler_page);
 		}
 			break;
 	        case POPPLER_DEST_FITB:
@@ -1282,16 +1334,12 @@ ev_link_dest_from_dest (PdfDocument *pdf_document,
 			break;
 		case POPPLER_DEST_FITBH:
 	        case POPPLER_DEST_FITH: {
-			PopplerPage *poppler_page;
 			double height;
 
-			poppler_page = poppler_document_get_page (pdf_document->document,
-								  MAX (0, dest->page_num - 1));
-			poppler_page_get_size (poppler_page, NULL, &height);
+			height = pdf_document_get_dest_page_height (pdf_document, dest);
 			ev_dest = ev_link_dest_new_fith (dest->page_num - 1,
 							 height - MIN (height, dest->top),
 							 dest->change_top);
-			g_object_unref (poppler_page);
 		}
 			break;
 		case POPPLER_DEST_FITBV:
@@ -1301,12 +1349,9 @@ ev_link_dest_from_dest (PdfDocument *pdf_document,
 							 dest->change_left);
 			break;
 	        case POPPLER_DEST_FITR: {
-			PopplerPage *poppler_page;
 			double height;
 
-			poppler_page = poppler_document_get_page (pdf_document->document,
-								  MAX (0, dest->page_num - 1));
-			poppler_page_get_size (poppler_page, NULL, &height);
+			height = pdf_document_get_dest_page_height (pdf_document, dest);
 			/* for evince we ensure that bottom <= top and left <= right */
 			/* also evince has its origin in the top left, so we invert the y axis. */
 			ev_dest = ev_link_dest_new_fitr (dest->page_num - 1,
@@ -1314,7 +1359,6 @@ ev_link_dest_from_dest (PdfDocument *pdf_document,
 							 height - MIN (height, MIN (dest->bottom, dest->top)),
 							 MAX (dest->left, dest->right),
 							 height - MIN (height, MAX (dest->bottom, dest->top)));
-			g_object_unref (poppler_page);
 		}
 			break;
 	        case POPPLER_DEST_NAMED:
@@ -1871,27 +1915,20 @@ pdf_document_file_exporter_begin_page (EvFileExporter *exporter)
 #endif /* HAVE_CAIRO_PRINT */
 }
 
+#ifdef HAVE_CAIRO_PRINT
+/* Places the next page on the sheet, with the cairo state saved until
+ * pdf_print_context_page_done() */
 static void
-pdf_document_file_exporter_do_page (EvFileExporter  *exporter,
-				    EvRenderContext *rc)
+pdf_print_context_place_page (PdfPrintContext *ctx,
+			      PopplerPage     *poppler_page)
 {
-	PdfDocument *pdf_document = PDF_DOCUMENT (exporter);
-	PdfPrintContext *ctx = pdf_document->print_ctx;
-	PopplerPage *poppler_page;
-#ifdef HAVE_CAIRO_PRINT
 	gdouble  page_width, page_height;
 	gint     x, y;
 	gboolean rotate;
 	gdouble  width, height;
 	gdouble  pwidth, pheight;
 	gdouble  xscale, yscale;
-#endif
-
-	g_return_if_fail (pdf_document->print_ctx != NULL);
 
-	poppler_page = POPPLER_PAGE (rc->page->backend_page);
-	
-#ifdef HAVE_CAIRO_PRINT
 	x = (ctx->pages_printed % ctx->pages_per_sheet) % ctx->pages_x;
 	y = (ctx->pages_printed % ctx->pages_per_sheet) / ctx->pages_x;
 	poppler_page_get_size (poppler_page, &page_width, &page_height);
@@ -1965,18 +2002,81 @@ pdf_document_file_exporter_do_page (EvFileExporter  *exporter,
 			 x * (rotate ? pheight : pwidth),
 			 y * (rotate ? pwidth : pheight));
 	cairo_scale (ctx->cr, xscale, yscale);
+}
 
-	poppler_page_render_for_printing (poppler_page, ctx->cr);
-
+static void
+pdf_print_context_page_done (PdfPrintContext *ctx)
+{
 	ctx->pages_printed++;
 			
 	cairo_restore (ctx->cr);
+}
+#endif /* HAVE_CAIRO_PRINT */
+
+static void
+pdf_document_file_exporter_do_page (EvFileExporter  *exporter,
+				    EvRenderContext *rc)
+{
+	PdfDocument *pdf_document = PDF_DOCUMENT (exporter);
+	PdfPrintContext *ctx = pdf_document->print_ctx;
+	PopplerPage *poppler_page;
+
+	g_return_if_fail (pdf_document->print_ctx != NULL);
+
+	poppler_page = POPPLER_PAGE (rc->page->backend_page);
+	
+#ifdef HAVE_CAIRO_PRINT
+	pdf_print_context_place_page (ctx, poppler_page);
+	poppler_page_render_for_printing (poppler_page, ctx->cr);
+	pdf_print_context_page_done (ctx);
 #else /* HAVE_CAIRO_PRINT */
 	if (ctx->format == EV_FILE_FORMAT_PS)
 		poppler_page_render_to_ps (poppler_page, ctx->ps_file);
 #endif /* HAVE_CAIRO_PRINT */
 }
 
+#ifdef HAVE_CAIRO_PRINT
+/* Records the drawing of the page, so that the expensive part of printing
+ * it can run in parallel with the export of the previous pages */
+static cairo_surface_t *
+pdf_document_file_exporter_render_page (EvFileExporter  *exporter,
+					EvRenderContext *rc)
+{
+	PopplerPage      *poppler_page;
+	cairo_surface_t  *surface;
+	cairo_rectangle_t extents;
+	cairo_t          *cr;
+
+	poppler_page = POPPLER_PAGE (rc->page->backend_page);
+
+	extents.x = extents.y = 0;
+	poppler_page_get_size (poppler_page, &extents.width, &extents.height);
+	surface = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, &extents);
+
+	cr = cairo_create (surface);
+	poppler_page_render_for_printing (poppler_page, cr);
+	cairo_destroy (cr);
+
+	return surface;
+}
+
+static void
+pdf_document_file_exporter_do_rendered_page (EvFileExporter  *exporter,
+					     EvRenderContext *rc,
+					     cairo_surface_t *surface)
+{
+	PdfDocument *pdf_document = PDF_DOCUMENT (exporter);
+	PdfPrintContext *ctx = pdf_document->print_ctx;
+
+	g_return_if_fail (pdf_document->print_ctx != NULL);
+
+	pdf_print_context_place_page (ctx, POPPLER_PAGE (rc->page->backend_page));
+	cairo_set_source_surface (ctx->cr, surface, 0, 0);
+	cairo_paint (ctx->cr);
+	pdf_print_context_page_done (ctx);
+}
+#endif /* HAVE_CAIRO_PRINT */
+
 static void
 pdf_document_file_exporter_end_page (EvFileExporter *exporter)
 {
@@ -2027,6 +2127,10 @@ pdf_document_file_exporter_iface_init (EvFileExporterInterface *iface)
 	iface->end_page = pdf_document_file_exporter_end_page;
         iface->end = pdf_document_file_exporter_end;
 	iface->get_capabilities = pdf_document_file_exporter_get_capabilities;
+#ifdef HAVE_CAIRO_PRINT
+	iface->render_page = pdf_document_file_exporter_render_page;
+	iface->do_rendered_page = pdf_document_file_exporter_do_rendered_page;
+#endif
 }
 
 /* EvDocumentPrint */
@@ -3061,6 +3165,13 @@ annot_set_unique_name (EvAnnotation *annot)
 	g_free (name);
 }
 
+static void
+annots_mapping_list_free (EvMappingList *mapping_list)
+{
+	if (mapping_list)
+		ev_mapping_list_unref (mapping_list);
+}
+
 static void
 annot_area_changed_cb (EvAnnotation *annot,
 		       GParamSpec   *spec,
@@ -3085,11 +3196,19 @@ pdf_document_annotations_get_annotations (EvDocumentAnnotations *document_annota
 	pdf_document = PDF_DOCUMENT (document_annotations);
 	poppler_page = POPPLER_PAGE (page->backend_page);
 
-	if (pdf_document->annots) {
-		mapping_list = (EvMappingList *)g_hash_table_lookup (pdf_document->annots,
-								     GINT_TO_POINTER (page->index));
-		if (mapping_list)
-			return ev_mapping_list_ref (mapping_list);
+	/* Pages without annotations are in the table too, with no
+	 * mapping list, so that they're not scanned again */
+	if (pdf_document->annots &&
+	    g_hash_table_lookup_extended (pdf_document->annots,
+					  GINT_TO_POINTER (page->index),
+					  NULL, (gpointer *)&mapping_list))
+		return mapping_list ? ev_mapping_list_ref (mapping_list) : NULL;
+
+	if (!pdf_document->annots) {
+		pdf_document->annots = g_hash_table_new_full (g_direct_hash,
+							      g_direct_equal,
+							      (GDestroyNotify)NULL,
+							      (GDestroyNotify)annots_mapping_list_free);
 	}
 
 	annots = poppler_page_get_annot_mapping (poppler_page);
@@ -3141,14 +3260,11 @@ pdf_document_annotations_get_annotations (EvDocumentAnnotations *document_annota
 
 	poppler_page_free_annot_mapping (annots);
 
-	if (!retval)
+	if (!retval) {
+		g_hash_table_insert (pdf_document->annots,
+				     GINT_TO_POINTER (page->index),
+				     NULL);
 		return NULL;
-
-	if (!pdf_document->annots) {
-		pdf_document->annots = g_hash_table_new_full (g_direct_hash,
-							      g_direct_equal,
-							      (GDestroyNotify)NULL,
-							      (GDestroyNotify)ev_mapping_list_unref);
 	}
 
 	mapping_list = ev_mapping_list_new (page->index, g_list_reverse (retval), (GDestroyNotify)g_object_unref);
@@ -3191,7 +3307,7 @@ pdf_document_annotations_remove_annotation (EvDocumentAnnotations *document_anno
                 annot_mapping = ev_mapping_list_find (mapping_list, annot);
                 ev_mapping_list_remove (mapping_list, annot_mapping);
 		if (ev_mapping_list_length (mapping_list) == 0)
-			g_hash_table_remove (pdf_document->annots, GINT_TO_POINTER (page->index));
+			g_hash_table_insert (pdf_document->annots, GINT_TO_POINTER (page->index), NULL);
         }
 
         pdf_document->annots_modified = TRUE;
@@ -3391,7 +3507,7 @@ pdf_document_annotations_add_annotation (EvDocumentAnnotations *document_annotat
 		pdf_document->annots = g_hash_table_new_full (g_direct_hash,
 							      g_direct_equal,
 							      (GDestroyNotify)NULL,
-							      (GDestroyNotify)ev_mapping_list_unref);
+							      (GDestroyNotify)annots_mapping_list_free);
 		mapping_list = NULL;
 	}
 
@@ -3400,6 +3516,7 @@ pdf_document_annotations_add_annotation (EvDocumentAnnotations *document_annotat
 	if (mapping_list) {
 		list = ev_mapping_list_get_list (mapping_list);
 		list = g_list_append (list, annot_mapping);
+		ev_mapping_list_changed (mapping_list);
 	} else {
 		list = g_list_append (list, annot_mapping);
 		mapping_list = ev_mapping_list_new (page->index, list, (GDestroyNotify)g_object_unref);
@@ -3627,6 +3744,16 @@ pdf_document_annotations_save_annotation (EvDocumentAnnotations *document_annota
 		}
 	}
 
+	/* The mapping area was updated by annot_area_changed_cb */
+	if ((mask & EV_ANNOTATIONS_SAVE_AREA) && PDF_DOCUMENT (document_annotations)->annots) {
+		EvMappingList *mapping_list;
+
+		mapping_list = (EvMappingList *)g_hash_table_lookup (PDF_DOCUMENT (document_annotations)->annots,
+								     GINT_TO_POINTER (ev_annotation_get_page_index (annot)));
+		if (mapping_list)
+			ev_mapping_list_changed (mapping_list);
+	}
+
 	PDF_DOCUMENT (document_annotations)->annots_modified = TRUE;
 	ev_document_set_modified (EV_DOCUMENT (document_annotations), TRUE);
 }
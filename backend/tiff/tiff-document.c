@@ -24,6 +24,7 @@
 
 #include <config.h>
 #include <stdio.h>
+#include <string.h>
 #include <glib.h>
 #include <glib/gi18n-lib.h>
 
@@ -45,6 +46,10 @@ struct _TiffDocument
 
   TIFF *tiff;
   gint n_pages;
+  /* Directory of every page, reduced resolution images following a
+   * page in the main chain of directories aren't pages */
+  GArray *page_dirs;
+  gint n_dirs;
   TIFF2PSContext *ps_export_ctx;
   
   gchar *uri;
@@ -156,8 +161,19 @@ tiff_document_get_n_pages (EvDocument  *document)
 	if (tiff_document->n_pages == -1) {
 		push_handlers ();
 		tiff_document->n_pages = 0;
-		
+		tiff_document->n_dirs = 0;
+		tiff_document->page_dirs = g_array_new (FALSE, FALSE, sizeof (gint));
+
+		TIFFSetDirectory (tiff_document->tiff, 0);
 		do {
+			guint32 subfile_type = 0;
+			gint    dir = tiff_document->n_dirs++;
+
+			TIFFGetField (tiff_document->tiff, TIFFTAG_SUBFILETYPE, &subfile_type);
+			if ((subfile_type & FILETYPE_REDUCEDIMAGE) && tiff_document->n_pages > 0)
+				continue;
+
+			g_array_append_val (tiff_document->page_dirs, dir);
 			tiff_document->n_pages ++;
 		}
 		while (TIFFReadDirectory (tiff_document->tiff));
@@ -167,6 +183,20 @@ tiff_document_get_n_pages (EvDocument  *document)
 	return tiff_document->n_pages;
 }
 
+static gboolean
+tiff_document_set_page (TiffDocument *tiff_document,
+			gint          page)
+{
+	if (tiff_document->n_pages == -1)
+		tiff_document_get_n_pages (EV_DOCUMENT (tiff_document));
+
+	if (page < 0 || page >= tiff_document->n_pages)
+		return FALSE;
+
+	return TIFFSetDirectory (tiff_document->tiff,
+				 g_array_index (tiff_document->page_dirs, gint, page)) == 1;
+}
+
 static void
 tiff_document_get_resolution (TiffDocument *tiff_document,
 			      gfloat       *x_res,
@@ -205,7 +235,7 @@ tiff_document_get_page_size (EvDocument *document,
 	g_return_if_fail (tiff_document->tiff != NULL);
 	
 	push_handlers ();
-	if (TIFFSetDirectory (tiff_document->tiff, page->index) != 1) {
+	if (!tiff_document_set_page (tiff_document, page->index)) {
 		pop_handlers ();
 		return;
 	}
@@ -221,58 +251,395 @@ tiff_document_get_page_size (EvDocument *document,
 	pop_handlers ();
 }
 
+/* Rows are decoded in chunks of at most this size when downscaling */
+#define MAX_CHUNK_SIZE (16 * 1024 * 1024)
+
+/* Converts the packed ABGR pixels returned by libtiff to the ARGB
+ * expected by cairo. The loop has no branches nor byte accesses so
+ * that the compiler vectorizes it.
+ */
+static void
+tiff_abgr_to_argb (guint32 *pixels,
+		   gsize    n_pixels)
+{
+	gsize i;
+
+	for (i = 0; i < n_pixels; i++) {
+		guint32 p = pixels[i];
+
+		pixels[i] = (p & 0xff00ff00) | ((p & 0xff) << 16) | ((p >> 16) & 0xff);
+	}
+}
+
+/* Box filter downscaling the image as its rows are decoded, so that
+ * only the destination surface and a chunk of rows are in memory.
+ * The rows are stored rotated, so that the surface is the rendered page.
+ */
+typedef struct {
+	guint32          src_width;
+	guint32          src_height;
+	gint             dst_width;
+	gint             dst_height;
+	gint             rotation;
+
+	guint           *x_map;
+	guint           *x_count;
+	guint64         *sums;
+	gint             dst_row;
+	guint            n_rows;
+
+	cairo_surface_t *surface;
+} TiffScaler;
+
+static TiffScaler *
+tiff_scaler_new (EvRenderContext *rc,
+		 guint32          src_width,
+		 guint32          src_height,
+		 gint             dst_width,
+		 gint             dst_height)
+{
+	TiffScaler *scaler;
+	guint32     x;
+
+	scaler = g_slice_new0 (TiffScaler);
+	scaler->src_width = src_width;
+	scaler->src_height = src_height;
+	scaler->dst_width = dst_width;
+	scaler->dst_height = dst_height;
+	scaler->rotation = rc->rotation;
+	/* Every pixel is written by tiff_scaler_flush_row() */
+	if (rc->rotation == 90 || rc->rotation == 270)
+		scaler->surface = ev_render_context_create_surface (rc, CAIRO_FORMAT_RGB24,
+								    dst_height, dst_width);
+	else
+		scaler->surface = ev_render_context_create_surface (rc, CAIRO_FORMAT_RGB24,
+								    dst_width, dst_height);
+	scaler->x_map = g_new (guint, src_width);
+	scaler->x_count = g_new0 (guint, dst_width);
+	scaler->sums = g_new0 (guint64, dst_width * 3);
+
+	for (x = 0; x < src_width; x++) {
+		scaler->x_map[x] = (guint64) x * dst_width / src_width;
+		scaler->x_count[scaler->x_map[x]]++;
+	}
+
+	return scaler;
+}
+
+static void
+tiff_scaler_flush_row (TiffScaler *scaler)
+{
+	guint32 *dst;
+	gssize   step;
+	gint     stride;
+	gint     row = scaler->dst_row;
+	gint     x;
+
+	if (scaler->n_rows == 0)
+		return;
+
+	cairo_surface_flush (scaler->surface);
+	dst = (guint32 *) cairo_image_surface_get_data (scaler->surface);
+	stride = cairo_image_surface_get_stride (scaler->surface) / 4;
+
+	/* Where the pixel (0, row) goes, and the offset to (x + 1, row) */
+	switch (scaler->rotation) {
+	case 90:
+		dst += scaler->dst_height - 1 - row;
+		step = stride;
+		break;
+	case 180:
+		dst += (scaler->dst_height - 1 - row) * stride + scaler->dst_width - 1;
+		step = -1;
+		break;
+	case 270:
+		dst += (scaler->dst_width - 1) * stride + row;
+		step = -stride;
+		break;
+	default:
+		dst += row * stride;
+		step = 1;
+	}
+
+	for (x = 0; x < scaler->dst_width; x++, dst += step) {
+		guint64 n = (guint64) scaler->x_count[x] * scaler->n_rows;
+		guint64 *sum = scaler->sums + x * 3;
+
+		*dst = 0xff000000 |
+			((sum[0] / n) << 16) |
+			((sum[1] / n) << 8) |
+			(sum[2] / n);
+	}
+	cairo_surface_mark_dirty (scaler->surface);
+
+	memset (scaler->sums, 0, sizeof (guint64) * scaler->dst_width * 3);
+	scaler->n_rows = 0;
+}
+
+/* Adds the source row @y, in the packed ABGR format of libtiff */
+static void
+tiff_scaler_add_row (TiffScaler    *scaler,
+		     guint32        y,
+		     const guint32 *row)
+{
+	gint    dst_row;
+	guint32 x;
+
+	dst_row = (guint64) y * scaler->dst_height / scaler->src_height;
+	if (dst_row != scaler->dst_row) {
+		tiff_scaler_flush_row (scaler);
+		scaler->dst_row = dst_row;
+	}
+
+	for (x = 0; x < scaler->src_width; x++) {
+		guint64 *sum = scaler->sums + scaler->x_map[x] * 3;
+
+		sum[0] += TIFFGetR (row[x]);
+		sum[1] += TIFFGetG (row[x]);
+		sum[2] += TIFFGetB (row[x]);
+	}
+	scaler->n_rows++;
+}
+
 static cairo_surface_t *
-tiff_document_render (EvDocument      *document,
-		      EvRenderContext *rc)
+tiff_scaler_finish (TiffScaler *scaler)
 {
-	TiffDocument *tiff_document = TIFF_DOCUMENT (document);
-	int width, height;
-	int scaled_width, scaled_height;
-	float x_res, y_res;
-	gint rowstride, bytes;
-	guchar *pixels = NULL;
-	guchar *p;
-	int orientation;
 	cairo_surface_t *surface;
-	cairo_surface_t *rotated_surface;
-	static const cairo_user_data_key_t key;
-	
-	g_return_val_if_fail (TIFF_IS_DOCUMENT (document), NULL);
-	g_return_val_if_fail (tiff_document->tiff != NULL, NULL);
-  
-	push_handlers ();
-	if (TIFFSetDirectory (tiff_document->tiff, rc->page->index) != 1) {
-		pop_handlers ();
-		g_warning("Failed to select page %d", rc->page->index);
-		return NULL;
+
+	tiff_scaler_flush_row (scaler);
+	surface = scaler->surface;
+
+	g_free (scaler->x_map);
+	g_free (scaler->x_count);
+	g_free (scaler->sums);
+	g_slice_free (TiffScaler, scaler);
+
+	return surface;
+}
+
+static void
+tiff_scaler_free (TiffScaler *scaler)
+{
+	cairo_surface_destroy (tiff_scaler_finish (scaler));
+}
+
+/* Tiles and strips are decoded by libtiff bottom to top */
+static gboolean
+tiff_document_scale_tiles (TIFF       *tiff,
+			   TiffScaler *scaler)
+{
+	guint32  tile_width, tile_height;
+	guint32 *tile, *rows;
+	guint32  x, y, row;
+
+	TIFFGetField (tiff, TIFFTAG_TILEWIDTH, &tile_width);
+	TIFFGetField (tiff, TIFFTAG_TILELENGTH, &tile_height);
+	if (tile_width == 0 || tile_height == 0 ||
+	    (gsize) tile_height * scaler->src_width > MAX_CHUNK_SIZE / 4)
+		return FALSE;
+
+	tile = g_try_new (guint32, (gsize) tile_width * tile_height);
+	rows = g_try_new (guint32, (gsize) tile_height * scaler->src_width);
+	if (!tile || !rows) {
+		g_free (tile);
+		g_free (rows);
+		return FALSE;
 	}
 
-	if (!TIFFGetField (tiff_document->tiff, TIFFTAG_IMAGEWIDTH, &width)) {
-		pop_handlers ();
-		g_warning("Failed to read image width");
-		return NULL;
+	for (y = 0; y < scaler->src_height; y += tile_height) {
+		guint32 n_rows = MIN (tile_height, scaler->src_height - y);
+
+		for (x = 0; x < scaler->src_width; x += tile_width) {
+			guint32 n_cols = MIN (tile_width, scaler->src_width - x);
+
+			if (!TIFFReadRGBATile (tiff, x, y, tile)) {
+				g_free (tile);
+				g_free (rows);
+				return FALSE;
+			}
+
+			for (row = 0; row < n_rows; row++) {
+				memcpy (rows + row * scaler->src_width + x,
+					tile + (tile_height - row - 1) * tile_width,
+					n_cols * 4);
+			}
+		}
+
+		for (row = 0; row < n_rows; row++)
+			tiff_scaler_add_row (scaler, y + row, rows + row * scaler->src_width);
 	}
 
-	if (! TIFFGetField (tiff_document->tiff, TIFFTAG_IMAGELENGTH, &height)) {
-		pop_handlers ();
-		g_warning("Failed to read image height");
-		return NULL;
+	g_free (tile);
+	g_free (rows);
+
+	return TRUE;
+}
+
+static gboolean
+tiff_document_scale_strips (TIFF       *tiff,
+			    TiffScaler *scaler)
+{
+	guint32  rows_per_strip;
+	guint32 *strip;
+	guint32  y, row;
+
+	if (!TIFFGetFieldDefaulted (tiff, TIFFTAG_ROWSPERSTRIP, &rows_per_strip))
+		return FALSE;
+	rows_per_strip = MIN (rows_per_strip, scaler->src_height);
+	if (rows_per_strip == 0 ||
+	    (gsize) rows_per_strip * scaler->src_width > MAX_CHUNK_SIZE / 4)
+		return FALSE;
+
+	strip = g_try_new (guint32, (gsize) rows_per_strip * scaler->src_width);
+	if (!strip)
+		return FALSE;
+
+	for (y = 0; y < scaler->src_height; y += rows_per_strip) {
+		guint32 n_rows = MIN (rows_per_strip, scaler->src_height - y);
+
+		if (!TIFFReadRGBAStrip (tiff, y, strip)) {
+			g_free (strip);
+			return FALSE;
+		}
+
+		for (row = 0; row < n_rows; row++) {
+			tiff_scaler_add_row (scaler, y + row,
+					     strip + (n_rows - row - 1) * scaler->src_width);
+		}
 	}
 
-	if (! TIFFGetField (tiff_document->tiff, TIFFTAG_ORIENTATION, &orientation)) {
-		orientation = ORIENTATION_TOPLEFT;
+	g_free (strip);
+
+	return TRUE;
+}
+
+/* Images stored in a single big strip, as most scans are, are decoded
+ * a scanline at a time. Only the common gray, bilevel and RGB layouts
+ * are handled here.
+ */
+static gboolean
+tiff_document_scale_scanlines (TIFF       *tiff,
+			       TiffScaler *scaler)
+{
+	guint16  photometric, bits_per_sample, samples_per_pixel, planar_config;
+	guchar  *scanline;
+	guint32 *row;
+	guint32  x, y;
+
+	TIFFGetFieldDefaulted (tiff, TIFFTAG_PHOTOMETRIC, &photometric);
+	TIFFGetFieldDefaulted (tiff, TIFFTAG_BITSPERSAMPLE, &bits_per_sample);
+	TIFFGetFieldDefaulted (tiff, TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+	TIFFGetFieldDefaulted (tiff, TIFFTAG_PLANARCONFIG, &planar_config);
+
+	if (planar_config != PLANARCONFIG_CONTIG)
+		return FALSE;
+
+	switch (photometric) {
+	case PHOTOMETRIC_MINISWHITE:
+	case PHOTOMETRIC_MINISBLACK:
+		if (samples_per_pixel != 1 || (bits_per_sample != 1 && bits_per_sample != 8))
+			return FALSE;
+		break;
+	case PHOTOMETRIC_RGB:
+		if ((samples_per_pixel != 3 && samples_per_pixel != 4) || bits_per_sample != 8)
+			return FALSE;
+		break;
+	default:
+		return FALSE;
 	}
 
-	tiff_document_get_resolution (tiff_document, &x_res, &y_res);
-	
-	pop_handlers ();
-  
-	/* Sanity check the doc */
-	if (width <= 0 || height <= 0) {
-		g_warning("Invalid width or height.");
+	scanline = g_try_malloc (TIFFScanlineSize (tiff));
+	row = g_try_new (guint32, scaler->src_width);
+	if (!scanline || !row) {
+		g_free (scanline);
+		g_free (row);
+		return FALSE;
+	}
+
+	for (y = 0; y < scaler->src_height; y++) {
+		if (TIFFReadScanline (tiff, scanline, y, 0) < 0) {
+			g_free (scanline);
+			g_free (row);
+			return FALSE;
+		}
+
+		if (photometric == PHOTOMETRIC_RGB) {
+			for (x = 0; x < scaler->src_width; x++) {
+				const guchar *p = scanline + x * samples_per_pixel;
+
+				row[x] = 0xff000000 | (p[2] << 16) | (p[1] << 8) | p[0];
+			}
+		} else {
+			guchar invert = photometric == PHOTOMETRIC_MINISWHITE ? 0xff : 0;
+
+			for (x = 0; x < scaler->src_width; x++) {
+				guchar v;
+
+				if (bits_per_sample == 1)
+					v = (scanline[x >> 3] & (0x80 >> (x & 7))) ? 0xff : 0;
+				else
+					v = scanline[x];
+				v ^= invert;
+				row[x] = 0xff000000 | (v << 16) | (v << 8) | v;
+			}
+		}
+
+		tiff_scaler_add_row (scaler, y, row);
+	}
+
+	g_free (scanline);
+	g_free (row);
+
+	return TRUE;
+}
+
+/* Decodes the current directory straight to the output size and
+ * rotation, without the full resolution image in memory.
+ */
+static cairo_surface_t *
+tiff_document_decode_scaled (TIFF            *tiff,
+			     EvRenderContext *rc,
+			     guint32          width,
+			     guint32          height,
+			     gint             scaled_width,
+			     gint             scaled_height)
+{
+	TiffScaler *scaler;
+	gboolean    retval;
+
+	scaler = tiff_scaler_new (rc, width, height, scaled_width, scaled_height);
+
+	if (TIFFIsTiled (tiff)) {
+		retval = tiff_document_scale_tiles (tiff, scaler);
+	} else {
+		guint32 rows_per_strip = height;
+
+		TIFFGetFieldDefaulted (tiff, TIFFTAG_ROWSPERSTRIP, &rows_per_strip);
+		if ((gsize) MIN (rows_per_strip, height) * width <= MAX_CHUNK_SIZE / 4)
+			retval = tiff_document_scale_strips (tiff, scaler);
+		else
+			retval = tiff_document_scale_scanlines (tiff, scaler);
+	}
+
+	if (!retval) {
+		tiff_scaler_free (scaler);
 		return NULL;
 	}
 
+	return tiff_scaler_finish (scaler);
+}
+
+static cairo_surface_t *
+tiff_document_decode (TIFF            *tiff,
+		      EvRenderContext *rc,
+		      guint32          width,
+		      guint32          height,
+		      int              orientation)
+{
+	gint rowstride, bytes;
+	guchar *pixels;
+	cairo_surface_t *surface;
+
 	rowstride = cairo_format_stride_for_width (CAIRO_FORMAT_RGB24, width);
 	if (rowstride / 4 != width) {
 		g_warning("Overflow while rendering document.");
@@ -286,124 +653,210 @@ tiff_document_render (EvDocument      *document,
 		return NULL;
 	}
 	bytes = height * rowstride;
-	
-	pixels = g_try_malloc (bytes);
-	if (!pixels) {
+
+	/* The surface is usually scaled or rotated into the rendered one,
+	 * its pixels are reused by the next pages */
+	surface = ev_render_context_create_surface (rc, CAIRO_FORMAT_RGB24, width, height);
+	if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS) {
 		g_warning("Failed to allocate memory for rendering.");
+		cairo_surface_destroy (surface);
+		return NULL;
+	}
+
+	cairo_surface_flush (surface);
+	pixels = cairo_image_surface_get_data (surface);
+	/* The pixels left behind by a failed read could be the ones of
+	 * another page, drawn by the last user of the surface */
+	if (!TIFFReadRGBAImageOriented (tiff,
+					width, height,
+					(uint32 *)pixels,
+					orientation, 0)) {
+		g_warning ("Failed to decode the page.");
+		cairo_surface_destroy (surface);
 		return NULL;
 	}
-	
-	surface = cairo_image_surface_create_for_data (pixels,
-						       CAIRO_FORMAT_RGB24,
-						       width, height,
-						       rowstride);
-	cairo_surface_set_user_data (surface, &key,
-				     pixels, (cairo_destroy_func_t)g_free);
-
-	TIFFReadRGBAImageOriented (tiff_document->tiff,
-				   width, height,
-				   (uint32 *)pixels,
-				   orientation, 0);
-	pop_handlers ();
 
 	/* Convert the format returned by libtiff to
 	* what cairo expects
 	*/
-	p = pixels;
-	while (p < pixels + bytes) {
-		guint32 *pixel = (guint32*)p;
-		guint8 r = TIFFGetR(*pixel);
-		guint8 g = TIFFGetG(*pixel);
-		guint8 b = TIFFGetB(*pixel);
-		guint8 a = TIFFGetA(*pixel);
+	tiff_abgr_to_argb ((guint32 *) pixels, bytes / 4);
+	cairo_surface_mark_dirty (surface);
+
+	return surface;
+}
+
+/* Makes the smallest reduced resolution image of the current page
+ * that is still at least @min_width x @min_height, either a SubIFD or
+ * a reduced image following the page, the current directory.
+ */
+static void
+tiff_document_set_reduced_image (TiffDocument *tiff_document,
+				 gint          page,
+				 guint32       min_width,
+				 guint32       min_height,
+				 guint32      *width,
+				 guint32      *height)
+{
+	TIFF    *tiff = tiff_document->tiff;
+	guint16  n_subifds = 0;
+	toff_t  *subifds = NULL;
+	toff_t   best_subifd = 0;
+	gint     best_dir = -1;
+	guint32  best_width = *width;
+	gint     dir, last_dir;
+	guint    i;
+
+	if (TIFFGetField (tiff, TIFFTAG_SUBIFD, &n_subifds, &subifds) && n_subifds > 0)
+		subifds = g_memdup (subifds, n_subifds * sizeof (toff_t));
+	else
+		n_subifds = 0;
+
+	for (i = 0; i < n_subifds; i++) {
+		guint32 w, h;
+
+		if (!TIFFSetSubDirectory (tiff, subifds[i]) ||
+		    !TIFFGetField (tiff, TIFFTAG_IMAGEWIDTH, &w) ||
+		    !TIFFGetField (tiff, TIFFTAG_IMAGELENGTH, &h))
+			continue;
 
-		*pixel = (a << 24) | (r << 16) | (g << 8) | b;
+		if (w >= min_width && h >= min_height && w < best_width) {
+			best_subifd = subifds[i];
+			best_width = w;
+		}
+	}
+	g_free (subifds);
+
+	dir = g_array_index (tiff_document->page_dirs, gint, page);
+	last_dir = page + 1 < tiff_document->n_pages ?
+		g_array_index (tiff_document->page_dirs, gint, page + 1) - 1 :
+		tiff_document->n_dirs - 1;
+
+	for (dir = dir + 1; dir <= last_dir; dir++) {
+		guint32 w, h;
+
+		if (TIFFSetDirectory (tiff, dir) != 1 ||
+		    !TIFFGetField (tiff, TIFFTAG_IMAGEWIDTH, &w) ||
+		    !TIFFGetField (tiff, TIFFTAG_IMAGELENGTH, &h))
+			continue;
 
-		p += 4;
+		if (w >= min_width && h >= min_height && w < best_width) {
+			best_dir = dir;
+			best_subifd = 0;
+			best_width = w;
+		}
 	}
 
-	ev_render_context_compute_scaled_size (rc, width, height * (x_res / y_res),
-					       &scaled_width, &scaled_height);
-	rotated_surface = ev_document_misc_surface_rotate_and_scale (surface,
-								     scaled_width, scaled_height,
-								     rc->rotation);
-	cairo_surface_destroy (surface);
-	
-	return rotated_surface;
+	if (best_dir != -1)
+		TIFFSetDirectory (tiff, best_dir);
+	else if (best_subifd != 0)
+		TIFFSetSubDirectory (tiff, best_subifd);
+	else
+		tiff_document_set_page (tiff_document, page);
+
+	TIFFGetField (tiff, TIFFTAG_IMAGEWIDTH, width);
+	TIFFGetField (tiff, TIFFTAG_IMAGELENGTH, height);
 }
 
-static GdkPixbuf *
-tiff_document_get_thumbnail (EvDocument      *document,
-			     EvRenderContext *rc)
+static cairo_surface_t *
+tiff_document_render (EvDocument      *document,
+		      EvRenderContext *rc)
 {
 	TiffDocument *tiff_document = TIFF_DOCUMENT (document);
-	int width, height;
+	guint32 width, height;
 	int scaled_width, scaled_height;
 	float x_res, y_res;
-	gint rowstride, bytes;
-	guchar *pixels = NULL;
-	GdkPixbuf *pixbuf;
-	GdkPixbuf *scaled_pixbuf;
-	GdkPixbuf *rotated_pixbuf;
+	int orientation;
+	cairo_surface_t *surface;
+	cairo_surface_t *rotated_surface;
 	
+	g_return_val_if_fail (TIFF_IS_DOCUMENT (document), NULL);
+	g_return_val_if_fail (tiff_document->tiff != NULL, NULL);
+  
 	push_handlers ();
-	if (TIFFSetDirectory (tiff_document->tiff, rc->page->index) != 1) {
+	if (!tiff_document_set_page (tiff_document, rc->page->index)) {
 		pop_handlers ();
+		g_warning("Failed to select page %d", rc->page->index);
 		return NULL;
 	}
 
 	if (!TIFFGetField (tiff_document->tiff, TIFFTAG_IMAGEWIDTH, &width)) {
 		pop_handlers ();
+		g_warning("Failed to read image width");
 		return NULL;
 	}
 
 	if (! TIFFGetField (tiff_document->tiff, TIFFTAG_IMAGELENGTH, &height)) {
 		pop_handlers ();
+		g_warning("Failed to read image height");
 		return NULL;
 	}
 
+	if (! TIFFGetField (tiff_document->tiff, TIFFTAG_ORIENTATION, &orientation)) {
+		orientation = ORIENTATION_TOPLEFT;
+	}
+
 	tiff_document_get_resolution (tiff_document, &x_res, &y_res);
-	
-	pop_handlers ();
   
 	/* Sanity check the doc */
-	if (width <= 0 || height <= 0)
-		return NULL;                
-
-	if (width >= INT_MAX / 4)
-		/* overflow */
-		return NULL;                
-	rowstride = width * 4;
-        
-	if (height >= INT_MAX / rowstride)
-		/* overflow */
-		return NULL;                
-	bytes = height * rowstride;
-	
-	pixels = g_try_malloc (bytes);
-	if (!pixels)
+	if (width == 0 || height == 0) {
+		pop_handlers ();
+		g_warning("Invalid width or height.");
 		return NULL;
-	
-	pixbuf = gdk_pixbuf_new_from_data (pixels, GDK_COLORSPACE_RGB, TRUE, 8, 
-					   width, height, rowstride,
-					   (GdkPixbufDestroyNotify) g_free, NULL);
-	TIFFReadRGBAImageOriented (tiff_document->tiff,
-				   width, height,
-				   (uint32 *)pixels,
-				   ORIENTATION_TOPLEFT, 0);
-	pop_handlers ();
+	}
 
 	ev_render_context_compute_scaled_size (rc, width, height * (x_res / y_res),
 					       &scaled_width, &scaled_height);
-	scaled_pixbuf = gdk_pixbuf_scale_simple (pixbuf,
-						 scaled_width, scaled_height,
-						 GDK_INTERP_BILINEAR);
-	g_object_unref (pixbuf);
-	
-	rotated_pixbuf = gdk_pixbuf_rotate_simple (scaled_pixbuf, 360 - rc->rotation);
-	g_object_unref (scaled_pixbuf);
+
+	/* Use a stored reduced resolution image when there's one big
+	 * enough, and scale while decoding when downscaling a lot */
+	if (scaled_width < width || scaled_height < height * (x_res / y_res)) {
+		tiff_document_set_reduced_image (tiff_document, rc->page->index,
+						 scaled_width, scaled_height * (y_res / x_res),
+						 &width, &height);
+	}
+
+	/* The scaler maps the decoded rows, so every output row needs two
+	 * of them whatever the aspect correction */
+	if (orientation == ORIENTATION_TOPLEFT &&
+	    scaled_width > 0 && scaled_height > 0 &&
+	    scaled_width * 2 <= width && scaled_height * 2 <= height) {
+		surface = tiff_document_decode_scaled (tiff_document->tiff, rc, width, height,
+						       scaled_width, scaled_height);
+		if (surface) {
+			pop_handlers ();
+			return surface;
+		}
+	}
+
+	surface = tiff_document_decode (tiff_document->tiff, rc, width, height, orientation);
+	pop_handlers ();
+
+	if (!surface)
+		return NULL;
+
+	rotated_surface = ev_document_misc_surface_rotate_and_scale (surface,
+								     scaled_width, scaled_height,
+								     rc->rotation);
+	cairo_surface_destroy (surface);
 	
-	return rotated_pixbuf;
+	return rotated_surface;
+}
+
+static GdkPixbuf *
+tiff_document_get_thumbnail (EvDocument      *document,
+			     EvRenderContext *rc)
+{
+	cairo_surface_t *surface;
+	GdkPixbuf       *pixbuf;
+
+	surface = tiff_document_render (document, rc);
+	if (!surface)
+		return NULL;
+
+	pixbuf = ev_document_misc_pixbuf_from_surface (surface);
+	cairo_surface_destroy (surface);
+
+	return pixbuf;
 }
 
 static gchar *
@@ -413,7 +866,8 @@ tiff_document_get_page_label (EvDocument *document,
 	TiffDocument *tiff_document = TIFF_DOCUMENT (document);
 	static gchar *label;
 
-	if (TIFFGetField (tiff_document->tiff, TIFFTAG_PAGENAME, &label) &&
+	if (tiff_document_set_page (tiff_document, page->index) &&
+	    TIFFGetField (tiff_document->tiff, TIFFTAG_PAGENAME, &label) &&
 	    g_utf8_validate (label, -1, NULL)) {
 		return g_strdup (label);
 	}
@@ -430,6 +884,8 @@ tiff_document_finalize (GObject *object)
 		TIFFClose (tiff_document->tiff);
 	if (tiff_document->uri)
 		g_free (tiff_document->uri);
+	if (tiff_document->page_dirs)
+		g_array_free (tiff_document->page_dirs, TRUE);
 
 	G_OBJECT_CLASS (tiff_document_parent_class)->finalize (object);
 }
@@ -468,7 +924,7 @@ tiff_document_file_exporter_do_page (EvFileExporter *exporter, EvRenderContext *
 
 	if (document->ps_export_ctx == NULL)
 		return;
-	if (TIFFSetDirectory (document->tiff, rc->page->index) != 1)
+	if (!tiff_document_set_page (document, rc->page->index))
 		return;
 	tiff2ps_process_page (document->ps_export_ctx, document->tiff,
 			      0, 0, 0, 0, 0);
@@ -0,0 +1,407 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include "ev-cached-stream.h"
+
+/* Every fetch costs a round trip to the server, so blocks read one
+ * after the other make the next fetches bigger, up to MAX_READ_AHEAD
+ * blocks. Reads at random positions, like the objects of a page
+ * referenced from the cross reference table, fetch a single block.
+ */
+#define BLOCK_SIZE     (64 * 1024)
+#define MAX_READ_AHEAD 16
+
+typedef struct {
+	guint   index;
+	gsize   length;
+	guint8 *data;
+	GList   link;
+} Block;
+
+struct _EvCachedStream {
+	GInputStream parent;
+
+	GInputStream *base;
+	goffset       size;
+	goffset       offset;
+
+	/* Serializes the reads, the base stream has a single position */
+	GMutex        mutex;
+
+	GHashTable   *blocks;
+	GQueue        lru;
+	gsize         cache_size;
+	gsize         max_cache_size;
+
+	guint         next_block;
+	guint         read_ahead;
+
+	guint64       bytes_fetched;
+	guint         n_fetches;
+};
+
+struct _EvCachedStreamClass {
+	GInputStreamClass parent_class;
+};
+
+static void ev_cached_stream_seekable_iface_init (GSeekableIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (EvCachedStream, ev_cached_stream, G_TYPE_INPUT_STREAM,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_SEEKABLE,
+						ev_cached_stream_seekable_iface_init))
+
+static void
+block_free (Block *block)
+{
+	g_free (block->data);
+	g_slice_free (Block, block);
+}
+
+static void
+ev_cached_stream_finalize (GObject *object)
+{
+	EvCachedStream *stream = EV_CACHED_STREAM (object);
+
+	g_hash_table_destroy (stream->blocks);
+	g_object_unref (stream->base);
+	g_mutex_clear (&stream->mutex);
+
+	G_OBJECT_CLASS (ev_cached_stream_parent_class)->finalize (object);
+}
+
+static void
+ev_cached_stream_evict (EvCachedStream *stream)
+{
+	while (stream->cache_size > stream->max_cache_size) {
+		GList *link = g_queue_peek_tail_link (&stream->lru);
+		Block *block;
+
+		if (!link || link == g_queue_peek_head_link (&stream->lru))
+			break;
+
+		block = link->data;
+		g_queue_unlink (&stream->lru, link);
+		stream->cache_size -= block->length;
+		g_hash_table_remove (stream->blocks, GUINT_TO_POINTER (block->index));
+	}
+}
+
+/* Must be called with the mutex held */
+static Block *
+ev_cached_stream_get_block (EvCachedStream *stream,
+			    guint           index,
+			    GCancellable   *cancellable,
+			    GError        **error)
+{
+	Block   *block;
+	Block   *first = NULL;
+	goffset  start;
+	guint    n_blocks, n_blocks_total, i;
+
+	block = g_hash_table_lookup (stream->blocks, GUINT_TO_POINTER (index));
+	if (block) {
+		g_queue_unlink (&stream->lru, &block->link);
+		g_queue_push_head_link (&stream->lru, &block->link);
+
+		return block;
+	}
+
+	if (index == stream->next_block)
+		stream->read_ahead = MIN (stream->read_ahead * 2, MAX_READ_AHEAD);
+	else
+		stream->read_ahead = 1;
+
+	/* A run of missing blocks in one request */
+	n_blocks_total = (stream->size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	for (n_blocks = 1; n_blocks < stream->read_ahead && index + n_blocks < n_blocks_total; n_blocks++) {
+		if (g_hash_table_contains (stream->blocks, GUINT_TO_POINTER (index + n_blocks)))
+			break;
+	}
+
+	start = (goffset) index * BLOCK_SIZE;
+	if (!g_seekable_seek (G_SEEKABLE (stream->base), start, G_SEEK_SET, cancellable, error))
+		return NULL;
+
+	stream->n_fetches++;
+	for (i = 0; i < n_blocks; i++) {
+		gsize length, n_read;
+
+		length = MIN (BLOCK_SIZE, stream->size - (start + (goffset) i * BLOCK_SIZE));
+
+		block = g_slice_new0 (Block);
+		block->index = index + i;
+		block->data = g_malloc (length);
+		block->link.data = block;
+		if (!g_input_stream_read_all (stream->base, block->data, length,
+					      &n_read, cancellable, first ? NULL : error) ||
+		    n_read < length) {
+			block_free (block);
+			if (!first && n_read < length && error && !*error) {
+				g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+						     "Unexpected end of file");
+			}
+			/* The blocks already read are still good */
+			break;
+		}
+
+		block->length = length;
+		g_hash_table_insert (stream->blocks, GUINT_TO_POINTER (block->index), block);
+		g_queue_push_head_link (&stream->lru, &block->link);
+		stream->cache_size += length;
+		stream->bytes_fetched += length;
+
+		if (!first)
+			first = block;
+	}
+
+	if (!first)
+		return NULL;
+
+	stream->next_block = index + i;
+
+	/* The first block is the one wanted now */
+	g_queue_unlink (&stream->lru, &first->link);
+	g_queue_push_head_link (&stream->lru, &first->link);
+	ev_cached_stream_evict (stream);
+
+	return first;
+}
+
+static gssize
+ev_cached_stream_read (GInputStream *input_stream,
+		       void         *buffer,
+		       gsize         count,
+		       GCancellable *cancellable,
+		       GError      **error)
+{
+	EvCachedStream *stream = EV_CACHED_STREAM (input_stream);
+	gsize           n_read = 0;
+	GError         *err = NULL;
+
+	g_mutex_lock (&stream->mutex);
+
+	if (stream->offset >= stream->size) {
+		g_mutex_unlock (&stream->mutex);
+		return 0;
+	}
+
+	count = MIN (count, stream->size - stream->offset);
+	while (n_read < count) {
+		Block *block;
+		gsize  block_offset, length;
+
+		block = ev_cached_stream_get_block (stream, stream->offset / BLOCK_SIZE,
+						    cancellable, &err);
+		if (!block)
+			break;
+
+		block_offset = stream->offset % BLOCK_SIZE;
+		length = MIN (block->length - block_offset, count - n_read);
+		memcpy ((guint8 *) buffer + n_read, block->data + block_offset, length);
+		stream->offset += length;
+		n_read += length;
+	}
+
+	g_mutex_unlock (&stream->mutex);
+
+	/* A short read, the error comes with the next one */
+	if (err && n_read > 0) {
+		g_error_free (err);
+		return n_read;
+	}
+
+	if (err) {
+		g_propagate_error (error, err);
+		return -1;
+	}
+
+	return n_read;
+}
+
+static gboolean
+ev_cached_stream_close (GInputStream *input_stream,
+			GCancellable *cancellable,
+			GError      **error)
+{
+	EvCachedStream *stream = EV_CACHED_STREAM (input_stream);
+
+	return g_input_stream_close (stream->base, cancellable, error);
+}
+
+static void
+ev_cached_stream_init (EvCachedStream *stream)
+{
+	g_mutex_init (&stream->mutex);
+	stream->blocks = g_hash_table_new_full (NULL, NULL, NULL,
+						(GDestroyNotify) block_free);
+	g_queue_init (&stream->lru);
+	stream->read_ahead = 1;
+}
+
+static void
+ev_cached_stream_class_init (EvCachedStreamClass *klass)
+{
+	GObjectClass      *object_class = G_OBJECT_CLASS (klass);
+	GInputStreamClass *stream_class = G_INPUT_STREAM_CLASS (klass);
+
+	object_class->finalize = ev_cached_stream_finalize;
+
+	stream_class->read_fn = ev_cached_stream_read;
+	stream_class->close_fn = ev_cached_stream_close;
+}
+
+static goffset
+ev_cached_stream_tell (GSeekable *seekable)
+{
+	EvCachedStream *stream = EV_CACHED_STREAM (seekable);
+	goffset         offset;
+
+	g_mutex_lock (&stream->mutex);
+	offset = stream->offset;
+	g_mutex_unlock (&stream->mutex);
+
+	return offset;
+}
+
+static gboolean
+ev_cached_stream_can_seek (GSeekable *seekable)
+{
+	return TRUE;
+}
+
+static gboolean
+ev_cached_stream_seek (GSeekable    *seekable,
+		       goffset       offset,
+		       GSeekType     type,
+		       GCancellable *cancellable,
+		       GError      **error)
+{
+	EvCachedStream *stream = EV_CACHED_STREAM (seekable);
+	goffset         position;
+
+	g_mutex_lock (&stream->mutex);
+
+	switch (type) {
+	case G_SEEK_CUR:
+		position = stream->offset + offset;
+		break;
+	case G_SEEK_END:
+		position = stream->size + offset;
+		break;
+	case G_SEEK_SET:
+	default:
+		position = offset;
+		break;
+	}
+
+	if (position < 0 || position > stream->size) {
+		g_mutex_unlock (&stream->mutex);
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+				     "Invalid seek request");
+		return FALSE;
+	}
+
+	/* Nothing is fetched until something is read */
+	stream->offset = position;
+	g_mutex_unlock (&stream->mutex);
+
+	return TRUE;
+}
+
+static gboolean
+ev_cached_stream_can_truncate (GSeekable *seekable)
+{
+	return FALSE;
+}
+
+static gboolean
+ev_cached_stream_truncate (GSeekable    *seekable,
+			   goffset       offset,
+			   GCancellable *cancellable,
+			   GError      **error)
+{
+	g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			     "Cannot truncate a cached stream");
+	return FALSE;
+}
+
+static void
+ev_cached_stream_seekable_iface_init (GSeekableIface *iface)
+{
+	iface->tell = ev_cached_stream_tell;
+	iface->can_seek = ev_cached_stream_can_seek;
+	iface->seek = ev_cached_stream_seek;
+	iface->can_truncate = ev_cached_stream_can_truncate;
+	iface->truncate_fn = ev_cached_stream_truncate;
+}
+
+/*
+ * _ev_cached_stream_new:
+ * @base: a seekable #GInputStream
+ * @size: the size of @base
+ * @max_cache_size: the most bytes of @base kept in memory
+ *
+ * Returns: (transfer full): a new stream reading @base through a cache
+ */
+GInputStream *
+_ev_cached_stream_new (GInputStream *base,
+		       goffset       size,
+		       gsize         max_cache_size)
+{
+	EvCachedStream *stream;
+
+	g_return_val_if_fail (G_IS_SEEKABLE (base), NULL);
+	g_return_val_if_fail (size >= 0, NULL);
+
+	stream = g_object_new (EV_TYPE_CACHED_STREAM, NULL);
+	stream->base = g_object_ref (base);
+	stream->size = size;
+	/* At least what a single fetch reads */
+	stream->max_cache_size = MAX (max_cache_size, MAX_READ_AHEAD * BLOCK_SIZE);
+
+	return G_INPUT_STREAM (stream);
+}
+
+guint64
+_ev_cached_stream_get_bytes_fetched (EvCachedStream *stream)
+{
+	guint64 bytes_fetched;
+
+	g_mutex_lock (&stream->mutex);
+	bytes_fetched = stream->bytes_fetched;
+	g_mutex_unlock (&stream->mutex);
+
+	return bytes_fetched;
+}
+
+guint
+_ev_cached_stream_get_n_fetches (EvCachedStream *stream)
+{
+	guint n_fetches;
+
+	g_mutex_lock (&stream->mutex);
+	n_fetches = stream->n_fetches;
+	g_mutex_unlock (&stream->mutex);
+
+	return n_fetches;
+}
@@ -0,0 +1,49 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#if !defined (EVINCE_COMPILATION)
+#error "This is a private header."
+#endif
+
+#ifndef EV_CACHED_STREAM_H
+#define EV_CACHED_STREAM_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define EV_TYPE_CACHED_STREAM (ev_cached_stream_get_type ())
+#define EV_CACHED_STREAM(o)   (G_TYPE_CHECK_INSTANCE_CAST ((o), EV_TYPE_CACHED_STREAM, EvCachedStream))
+
+typedef struct _EvCachedStream      EvCachedStream;
+typedef struct _EvCachedStreamClass EvCachedStreamClass;
+
+/* A seekable stream reading a slow seekable stream, a remote file
+ * usually, by blocks fetched on demand and kept in memory */
+GType         ev_cached_stream_get_type            (void) G_GNUC_CONST;
+
+GInputStream *_ev_cached_stream_new                (GInputStream   *base,
+						    goffset         size,
+						    gsize           max_cache_size);
+guint64       _ev_cached_stream_get_bytes_fetched  (EvCachedStream *stream);
+guint         _ev_cached_stream_get_n_fetches      (EvCachedStream *stream);
+
+G_END_DECLS
+
+#endif /* !EV_CACHED_STREAM_H */
@@ -47,13 +47,15 @@ static EvProfileSection ev_profile = EV_NO_PROFILE;
 static EvDebugBorders ev_debug_borders = EV_DEBUG_BORDER_NONE;
 
 static GHashTable *timers = NULL;
+static GMutex      timers_mutex;
 
 static void
 debug_init (void)
 {
         const GDebugKey keys[] = {
                 { "jobs",    EV_DEBUG_JOBS         },
-                { "borders", EV_DEBUG_SHOW_BORDERS }
+                { "borders", EV_DEBUG_SHOW_BORDERS },
+                { "memory",  EV_DEBUG_MEMORY       }
         };
         const GDebugKey border_keys[] = {
                 { "chars",      EV_DEBUG_BORDER_CHARS      },
@@ -148,13 +150,17 @@ ev_profiler_start (EvProfileSection section,
 		name = g_strdup_vprintf (format, args);
 		va_end (args);
 
+		/* Profiled jobs run in several scheduler threads */
+		g_mutex_lock (&timers_mutex);
 		timer = g_hash_table_lookup (timers, name);
 		if (!timer) {
 			timer = g_timer_new ();
-			g_hash_table_insert (timers, g_strdup (name), timer);
+			g_hash_table_insert (timers, name, timer);
 		} else {
 			g_timer_start (timer);
+			g_free (name);
 		}
+		g_mutex_unlock (&timers_mutex);
 	}
 }
 
@@ -175,14 +181,21 @@ ev_profiler_stop (EvProfileSection section,
 		name = g_strdup_vprintf (format, args);
 		va_end (args);
 		
+		g_mutex_lock (&timers_mutex);
 		timer = g_hash_table_lookup (timers, name);
-		if (!timer)
+		if (!timer) {
+			g_mutex_unlock (&timers_mutex);
+			g_free (name);
 			return;
+		}
 		
 		g_timer_stop (timer);
 		seconds = g_timer_elapsed (timer, NULL);
+		g_mutex_unlock (&timers_mutex);
+
 		g_print ("[ %s ] %f s elapsed\n", name, seconds);
 		fflush (stdout);
+		g_free (name);
 	}
 }
 
@@ -0,0 +1,356 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <config.h>
+
+#include <string.h>
+#ifdef HAVE_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+
+#include "ev-decompressor.h"
+
+/* GConverter implementations for the compression formats GIO doesn't
+ * support, gzip is handled by GZlibDecompressor.
+ */
+
+#ifdef HAVE_BZIP2
+#define EV_TYPE_BZIP2_DECOMPRESSOR (ev_bzip2_decompressor_get_type ())
+#define EV_BZIP2_DECOMPRESSOR(o)   (G_TYPE_CHECK_INSTANCE_CAST ((o), EV_TYPE_BZIP2_DECOMPRESSOR, EvBzip2Decompressor))
+
+typedef struct _EvBzip2Decompressor      EvBzip2Decompressor;
+typedef struct _EvBzip2DecompressorClass EvBzip2DecompressorClass;
+
+struct _EvBzip2Decompressor {
+	GObject   parent;
+
+	bz_stream stream;
+	/* Checked by the first conversion, init can't fail */
+	int       init_result;
+	/* bzip2 files can be made of several streams, like the ones
+	 * created by parallel compressors */
+	gboolean  stream_end;
+};
+
+struct _EvBzip2DecompressorClass {
+	GObjectClass parent_class;
+};
+
+static GType ev_bzip2_decompressor_get_type (void) G_GNUC_CONST;
+static void  ev_bzip2_decompressor_iface_init (GConverterIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (EvBzip2Decompressor, ev_bzip2_decompressor, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_CONVERTER,
+						ev_bzip2_decompressor_iface_init))
+
+static void
+ev_bzip2_decompressor_finalize (GObject *object)
+{
+	EvBzip2Decompressor *decompressor = EV_BZIP2_DECOMPRESSOR (object);
+
+	BZ2_bzDecompressEnd (&decompressor->stream);
+
+	G_OBJECT_CLASS (ev_bzip2_decompressor_parent_class)->finalize (object);
+}
+
+static void
+ev_bzip2_decompressor_init (EvBzip2Decompressor *decompressor)
+{
+	decompressor->init_result = BZ2_bzDecompressInit (&decompressor->stream, 0, 0);
+}
+
+static void
+ev_bzip2_decompressor_class_init (EvBzip2DecompressorClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = ev_bzip2_decompressor_finalize;
+}
+
+static void
+ev_bzip2_decompressor_reset (GConverter *converter)
+{
+	EvBzip2Decompressor *decompressor = EV_BZIP2_DECOMPRESSOR (converter);
+
+	BZ2_bzDecompressEnd (&decompressor->stream);
+	memset (&decompressor->stream, 0, sizeof (bz_stream));
+	decompressor->init_result = BZ2_bzDecompressInit (&decompressor->stream, 0, 0);
+	decompressor->stream_end = FALSE;
+}
+
+static GConverterResult
+ev_bzip2_decompressor_convert (GConverter      *converter,
+			       const void      *inbuf,
+			       gsize            inbuf_size,
+			       void            *outbuf,
+			       gsize            outbuf_size,
+			       GConverterFlags  flags,
+			       gsize           *bytes_read,
+			       gsize           *bytes_written,
+			       GError         **error)
+{
+	EvBzip2Decompressor *decompressor = EV_BZIP2_DECOMPRESSOR (converter);
+	int                  res;
+
+	if (decompressor->init_result != BZ_OK) {
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+			     "Failed to initialize the bzip2 decoder: %d",
+			     decompressor->init_result);
+		return G_CONVERTER_ERROR;
+	}
+
+	if (decompressor->stream_end) {
+		if (inbuf_size == 0) {
+			*bytes_read = 0;
+			*bytes_written = 0;
+			return G_CONVERTER_FINISHED;
+		}
+		ev_bzip2_decompressor_reset (converter);
+	}
+
+	decompressor->stream.next_in = (char *) inbuf;
+	decompressor->stream.avail_in = MIN (inbuf_size, G_MAXUINT);
+	decompressor->stream.next_out = outbuf;
+	decompressor->stream.avail_out = MIN (outbuf_size, G_MAXUINT);
+
+	res = BZ2_bzDecompress (&decompressor->stream);
+	switch (res) {
+	case BZ_DATA_ERROR:
+	case BZ_DATA_ERROR_MAGIC:
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+				     "Invalid compressed data");
+		return G_CONVERTER_ERROR;
+	case BZ_MEM_ERROR:
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+				     "Not enough memory");
+		return G_CONVERTER_ERROR;
+	case BZ_OK:
+	case BZ_STREAM_END:
+		break;
+	default:
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+			     "Unexpected bzip2 error %d", res);
+		return G_CONVERTER_ERROR;
+	}
+
+	*bytes_read = MIN (inbuf_size, G_MAXUINT) - decompressor->stream.avail_in;
+	*bytes_written = MIN (outbuf_size, G_MAXUINT) - decompressor->stream.avail_out;
+
+	if (res == BZ_STREAM_END) {
+		decompressor->stream_end = TRUE;
+		if (*bytes_read == inbuf_size && (flags & G_CONVERTER_INPUT_AT_END))
+			return G_CONVERTER_FINISHED;
+		return G_CONVERTER_CONVERTED;
+	}
+
+	if (*bytes_read == 0 && *bytes_written == 0) {
+		if (flags & G_CONVERTER_FLUSH)
+			return G_CONVERTER_FLUSHED;
+
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+				     "Need more input");
+		return G_CONVERTER_ERROR;
+	}
+
+	return G_CONVERTER_CONVERTED;
+}
+
+static void
+ev_bzip2_decompressor_iface_init (GConverterIface *iface)
+{
+	iface->convert = ev_bzip2_decompressor_convert;
+	iface->reset = ev_bzip2_decompressor_reset;
+}
+#endif /* HAVE_BZIP2 */
+
+#ifdef HAVE_LZMA
+#define EV_TYPE_XZ_DECOMPRESSOR (ev_xz_decompressor_get_type ())
+#define EV_XZ_DECOMPRESSOR(o)   (G_TYPE_CHECK_INSTANCE_CAST ((o), EV_TYPE_XZ_DECOMPRESSOR, EvXzDecompressor))
+
+typedef struct _EvXzDecompressor      EvXzDecompressor;
+typedef struct _EvXzDecompressorClass EvXzDecompressorClass;
+
+struct _EvXzDecompressor {
+	GObject     parent;
+
+	lzma_stream stream;
+	/* Checked by the first conversion, init can't fail */
+	lzma_ret    init_result;
+};
+
+struct _EvXzDecompressorClass {
+	GObjectClass parent_class;
+};
+
+static GType ev_xz_decompressor_get_type (void) G_GNUC_CONST;
+static void  ev_xz_decompressor_iface_init (GConverterIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (EvXzDecompressor, ev_xz_decompressor, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_CONVERTER,
+						ev_xz_decompressor_iface_init))
+
+static void
+ev_xz_decompressor_start (EvXzDecompressor *decompressor)
+{
+	lzma_stream stream = LZMA_STREAM_INIT;
+
+	decompressor->stream = stream;
+	decompressor->init_result = lzma_stream_decoder (&decompressor->stream,
+							 UINT64_MAX, LZMA_CONCATENATED);
+}
+
+static void
+ev_xz_decompressor_finalize (GObject *object)
+{
+	EvXzDecompressor *decompressor = EV_XZ_DECOMPRESSOR (object);
+
+	lzma_end (&decompressor->stream);
+
+	G_OBJECT_CLASS (ev_xz_decompressor_parent_class)->finalize (object);
+}
+
+static void
+ev_xz_decompressor_init (EvXzDecompressor *decompressor)
+{
+	ev_xz_decompressor_start (decompressor);
+}
+
+static void
+ev_xz_decompressor_class_init (EvXzDecompressorClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = ev_xz_decompressor_finalize;
+}
+
+static void
+ev_xz_decompressor_reset (GConverter *converter)
+{
+	EvXzDecompressor *decompressor = EV_XZ_DECOMPRESSOR (converter);
+
+	lzma_end (&decompressor->stream);
+	ev_xz_decompressor_start (decompressor);
+}
+
+static GConverterResult
+ev_xz_decompressor_convert (GConverter      *converter,
+			    const void      *inbuf,
+			    gsize            inbuf_size,
+			    void            *outbuf,
+			    gsize            outbuf_size,
+			    GConverterFlags  flags,
+			    gsize           *bytes_read,
+			    gsize           *bytes_written,
+			    GError         **error)
+{
+	EvXzDecompressor *decompressor = EV_XZ_DECOMPRESSOR (converter);
+	lzma_ret          res;
+
+	if (decompressor->init_result != LZMA_OK) {
+		if (decompressor->init_result == LZMA_MEM_ERROR)
+			g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+					     "Not enough memory");
+		else
+			g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+				     "Failed to initialize the xz decoder: %d",
+				     decompressor->init_result);
+		return G_CONVERTER_ERROR;
+	}
+
+	decompressor->stream.next_in = inbuf;
+	decompressor->stream.avail_in = inbuf_size;
+	decompressor->stream.next_out = outbuf;
+	decompressor->stream.avail_out = outbuf_size;
+
+	res = lzma_code (&decompressor->stream,
+			 (flags & G_CONVERTER_INPUT_AT_END) ? LZMA_FINISH : LZMA_RUN);
+
+	*bytes_read = inbuf_size - decompressor->stream.avail_in;
+	*bytes_written = outbuf_size - decompressor->stream.avail_out;
+
+	switch (res) {
+	case LZMA_STREAM_END:
+		return G_CONVERTER_FINISHED;
+	case LZMA_OK:
+	case LZMA_BUF_ERROR:
+		if (*bytes_read == 0 && *bytes_written == 0) {
+			if (flags & G_CONVERTER_FLUSH)
+				return G_CONVERTER_FLUSHED;
+
+			g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+					     "Need more input");
+			return G_CONVERTER_ERROR;
+		}
+		return G_CONVERTER_CONVERTED;
+	case LZMA_MEM_ERROR:
+	case LZMA_MEMLIMIT_ERROR:
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+				     "Not enough memory");
+		return G_CONVERTER_ERROR;
+	case LZMA_FORMAT_ERROR:
+	case LZMA_OPTIONS_ERROR:
+	case LZMA_DATA_ERROR:
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+				     "Invalid compressed data");
+		return G_CONVERTER_ERROR;
+	default:
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+			     "Unexpected xz error %d", res);
+		return G_CONVERTER_ERROR;
+	}
+}
+
+static void
+ev_xz_decompressor_iface_init (GConverterIface *iface)
+{
+	iface->convert = ev_xz_decompressor_convert;
+	iface->reset = ev_xz_decompressor_reset;
+}
+#endif /* HAVE_LZMA */
+
+/*
+ * _ev_decompressor_new:
+ * @type: the compression type
+ *
+ * Creates a #GConverter decompressing data compressed with @type.
+ *
+ * Returns: a new #GConverter, or %NULL if @type can't be decompressed
+ *   in process
+ */
+GConverter *
+_ev_decompressor_new (EvCompressionType type)
+{
+	switch (type) {
+	case EV_COMPRESSION_GZIP:
+		return G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+#ifdef HAVE_BZIP2
+	case EV_COMPRESSION_BZIP2:
+		return G_CONVERTER (g_object_new (EV_TYPE_BZIP2_DECOMPRESSOR, NULL));
+#endif
+#ifdef HAVE_LZMA
+	case EV_COMPRESSION_LZMA:
+		return G_CONVERTER (g_object_new (EV_TYPE_XZ_DECOMPRESSOR, NULL));
+#endif
+	default:
+		return NULL;
+	}
+}
@@ -0,0 +1,37 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#if !defined (EVINCE_COMPILATION)
+#error "This is a private header."
+#endif
+
+#ifndef EV_DECOMPRESSOR_H
+#define EV_DECOMPRESSOR_H
+
+#include <gio/gio.h>
+
+#include "ev-file-helpers.h"
+
+G_BEGIN_DECLS
+
+GConverter *_ev_decompressor_new (EvCompressionType type);
+
+G_END_DECLS
+
+#endif /* !EV_DECOMPRESSOR_H */
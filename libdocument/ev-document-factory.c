@@ -40,9 +40,15 @@
 
 #define BACKEND_DATA_KEY "ev-backend-info"
 
+/* Larger compressed documents are decompressed to a temporary file */
+#define MAX_UNCOMPRESSED_IN_MEMORY (64 * 1024 * 1024)
+#define UNCOMPRESS_CHUNK_SIZE (64 * 1024)
+
 static GList *ev_backends_list = NULL;
 static GHashTable *ev_module_hash = NULL;
 static gchar *ev_backends_dir = NULL;
+/* Documents can be created from several threads */
+static GMutex ev_module_mutex;
 
 static EvDocument* ev_document_factory_new_document_for_mime_type (const char *mime_type,
                                                                    GError **error);
@@ -106,6 +112,7 @@ ev_document_factory_new_document_for_mime_type (const gchar *mime_type,
                 return NULL;
         }
 
+        g_mutex_lock (&ev_module_mutex);
         if (ev_module_hash != NULL) {
                 module = g_hash_table_lookup (ev_module_hash, info->module_name);
         }
@@ -131,11 +138,13 @@ ev_document_factory_new_document_for_mime_type (const gchar *mime_type,
                 g_set_error (error, EV_DOCUMENT_ERROR, EV_DOCUMENT_ERROR_INVALID,
                              "Failed to load backend for '%s': %s",
                              mime_type, err ? err : "unknown error");
+                g_mutex_unlock (&ev_module_mutex);
                 return NULL;
         }
 
         document = EV_DOCUMENT (_ev_module_new_object (EV_MODULE (module)));
         g_type_module_unuse (module);
+        g_mutex_unlock (&ev_module_mutex);
 
         g_object_set_data_full (G_OBJECT (document), BACKEND_DATA_KEY,
                                 _ev_backend_info_ref (info),
@@ -216,6 +225,127 @@ free_uncompressed_uri (gchar *uri_unc)
 	g_free (uri_unc);
 }
 
+/*
+ * load_document_from_bytes:
+ * @document: a #EvDocument
+ * @bytes: the uncompressed contents of the document
+ * @uri: the URI of the compressed document
+ * @flags: flags from #EvDocumentLoadFlags
+ * @error: a #GError location to store an error, or %NULL
+ *
+ * Loads @document from a stream reading @bytes.
+ *
+ * Returns: %TRUE on success, or %FALSE on failure with @error filled in
+ */
+static gboolean
+load_document_from_bytes (EvDocument          *document,
+			  GBytes              *bytes,
+			  const char          *uri,
+			  EvDocumentLoadFlags  flags,
+			  GError             **error)
+{
+	GInputStream *stream;
+	gboolean      retval;
+
+	stream = g_memory_input_stream_new_from_bytes (bytes);
+	retval = ev_document_load_stream (document, stream, flags, NULL, error);
+	g_object_unref (stream);
+
+	/* Set also when the document is encrypted, so that it can be
+	 * loaded again with the password */
+	_ev_document_set_uri (document, uri);
+
+	return retval;
+}
+
+/*
+ * load_compressed_document_from_stream:
+ * @document: a #EvDocument
+ * @uri: the URI of the compressed document
+ * @compression: the document's compression type
+ * @flags: flags from #EvDocumentLoadFlags
+ * @result: a location to store whether the document was loaded
+ * @error: a #GError location to store an error, or %NULL
+ *
+ * Decompresses the document at @uri in memory and loads it from a
+ * stream, avoiding writing it to a temporary file, for backends that
+ * support loading from streams. The decompressed data is kept in the
+ * "bytes-uncompressed" data of @document to load it again, so documents
+ * larger than %MAX_UNCOMPRESSED_IN_MEMORY are left to the temporary file.
+ *
+ * Returns: %FALSE if the document can't be loaded this way and has to
+ *   be decompressed to a temporary file, %TRUE otherwise with @result
+ *   filled in
+ */
+static gboolean
+load_compressed_document_from_stream (EvDocument          *document,
+				      const char          *uri,
+				      EvCompressionType    compression,
+				      EvDocumentLoadFlags  flags,
+				      gboolean            *result,
+				      GError             **error)
+{
+	GFile         *file;
+	GInputStream  *file_stream;
+	GInputStream  *stream;
+	GByteArray    *data;
+	GBytes        *bytes;
+
+	if (compression == EV_COMPRESSION_NONE ||
+	    !EV_DOCUMENT_GET_CLASS (document)->load_stream)
+		return FALSE;
+
+	file = g_file_new_for_uri (uri);
+	file_stream = G_INPUT_STREAM (g_file_read (file, NULL, NULL));
+	g_object_unref (file);
+	if (!file_stream)
+		return FALSE;
+
+	stream = ev_file_uncompress_stream (file_stream, compression, NULL);
+	g_object_unref (file_stream);
+	if (!stream)
+		return FALSE;
+
+	data = g_byte_array_new ();
+	while (TRUE) {
+		guint  len = data->len;
+		gssize n_read;
+
+		if (len > MAX_UNCOMPRESSED_IN_MEMORY) {
+			g_object_unref (stream);
+			g_byte_array_unref (data);
+
+			return FALSE;
+		}
+
+		g_byte_array_set_size (data, len + UNCOMPRESS_CHUNK_SIZE);
+		n_read = g_input_stream_read (stream, data->data + len,
+					      UNCOMPRESS_CHUNK_SIZE, NULL, error);
+		if (n_read < 0) {
+			g_object_unref (stream);
+			g_byte_array_unref (data);
+			*result = FALSE;
+
+			return TRUE;
+		}
+
+		g_byte_array_set_size (data, len + n_read);
+		if (n_read == 0)
+			break;
+	}
+	g_object_unref (stream);
+
+	bytes = g_byte_array_free_to_bytes (data);
+
+	*result = load_document_from_bytes (document, bytes, uri, flags, error);
+	g_object_set_data_full (G_OBJECT (document),
+				"bytes-uncompressed",
+				bytes,
+				(GDestroyNotify) g_bytes_unref);
+
+	return TRUE;
+}
+
 /*
  * _ev_document_factory_init:
  *
@@ -299,7 +429,9 @@ ev_document_factory_get_document_full (const char           *uri,
 	document = new_document_for_uri (uri, TRUE, &compression, &err);
 	g_assert (document != NULL || err != NULL);
 
-	if (document != NULL) {
+	if (document != NULL &&
+	    !load_compressed_document_from_stream (document, uri, compression,
+						   flags, &result, &err)) {
 		uri_unc = ev_file_uncompress (uri, compression, &err);
 		if (uri_unc) {
 			g_object_set_data_full (G_OBJECT (document),
@@ -314,7 +446,9 @@ ev_document_factory_get_document_full (const char           *uri,
 		}
 
 		result = ev_document_load_full (document, uri_unc ? uri_unc : uri, flags, &err);
+	}
 
+	if (document != NULL) {
 		if (result == FALSE || err) {
 			if (err &&
 			    g_error_matches (err, EV_DOCUMENT_ERROR, EV_DOCUMENT_ERROR_ENCRYPTED)) {
@@ -341,22 +475,26 @@ ev_document_factory_get_document_full (const char           *uri,
 		return NULL;
 	}
 
-	uri_unc = ev_file_uncompress (uri, compression, &err);
-	if (uri_unc) {
-		g_object_set_data_full (G_OBJECT (document),
-					"uri-uncompressed",
-					uri_unc,
-					(GDestroyNotify) free_uncompressed_uri);
-	} else if (err != NULL) {
-		/* Error uncompressing file */
-		g_propagate_error (error, err);
+	if (!load_compressed_document_from_stream (document, uri, compression,
+						   EV_DOCUMENT_LOAD_FLAG_NONE,
+						   &result, &err)) {
+		uri_unc = ev_file_uncompress (uri, compression, &err);
+		if (uri_unc) {
+			g_object_set_data_full (G_OBJECT (document),
+						"uri-uncompressed",
+						uri_unc,
+						(GDestroyNotify) free_uncompressed_uri);
+		} else if (err != NULL) {
+			/* Error uncompressing file */
+			g_propagate_error (error, err);
 
-		g_object_unref (document);
-		return NULL;
-	}
+			g_object_unref (document);
+			return NULL;
+		}
 
-	result = ev_document_load_full (document, uri_unc ? uri_unc : uri,
-					EV_DOCUMENT_LOAD_FLAG_NONE, &err);
+		result = ev_document_load_full (document, uri_unc ? uri_unc : uri,
+						EV_DOCUMENT_LOAD_FLAG_NONE, &err);
+	}
 	if (result == FALSE) {
 		if (err == NULL) {
 			/* FIXME: this really should not happen; the backend should
@@ -401,6 +539,108 @@ ev_document_factory_get_document (const char *uri, GError **error)
 						      error);
 }
 
+/**
+ * ev_document_factory_get_worker_copy:
+ * @document: a loaded #EvDocument
+ * @error: (allow-none): a #GError location to store an error, or %NULL
+ *
+ * Loads the file of @document again in a new document, so that a worker
+ * thread can use it while @document is used by other threads, when the
+ * backend is not thread-safe but supports worker copies. Only documents
+ * loaded from a local file, without unsaved changes, can be copied, and
+ * the file must not have changed since @document was loaded.
+ *
+ * Returns: (transfer full): a new #EvDocument, or %NULL
+ *
+ * Since: 3.30
+ */
+EvDocument *
+ev_document_factory_get_worker_copy (EvDocument *document,
+				     GError    **error)
+{
+	EvDocument  *copy;
+	const gchar *uri;
+	GFile       *file;
+	gboolean     native;
+	GError      *err = NULL;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), NULL);
+
+	uri = ev_document_get_uri (document);
+	if (!uri || !ev_document_supports_worker_copies (document) ||
+	    ev_document_get_modified (document)) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+				     "The document can't be copied");
+		return NULL;
+	}
+
+	file = g_file_new_for_uri (uri);
+	native = g_file_is_native (file);
+	g_object_unref (file);
+	if (!native) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+				     "Only local documents can be copied");
+		return NULL;
+	}
+
+	copy = ev_document_factory_get_document_full (uri, EV_DOCUMENT_LOAD_FLAG_NONE, &err);
+	if (!copy) {
+		g_propagate_error (error, err);
+		return NULL;
+	}
+
+	/* Encrypted documents are returned with an error set */
+	if (err) {
+		g_object_unref (copy);
+		g_propagate_error (error, err);
+		return NULL;
+	}
+
+	if (G_OBJECT_TYPE (copy) != G_OBJECT_TYPE (document) ||
+	    ev_document_get_size (copy) != ev_document_get_size (document) ||
+	    ev_document_get_n_pages (copy) != ev_document_get_n_pages (document)) {
+		g_object_unref (copy);
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+				     "The document changed since it was loaded");
+		return NULL;
+	}
+
+	return copy;
+}
+
+/**
+ * ev_document_factory_mime_type_is_thread_safe:
+ * @mime_type: a MIME type
+ *
+ * Finds out whether the documents of @mime_type are thread-safe before
+ * loading one, so that callers loading several documents at the same
+ * time can decide which ones must be loaded and rendered one at a time.
+ * See ev_document_is_thread_safe().
+ *
+ * Returns: %TRUE if the backend for @mime_type is thread-safe, %FALSE
+ * if it is not or if @mime_type is not supported
+ *
+ * Since: 3.30
+ */
+gboolean
+ev_document_factory_mime_type_is_thread_safe (const gchar *mime_type)
+{
+	EvDocument *document;
+	gboolean    thread_safe;
+
+	g_return_val_if_fail (mime_type != NULL, FALSE);
+
+	/* Backends report it for any document, even one not loaded */
+	document = ev_document_factory_new_document_for_mime_type (mime_type, NULL);
+	if (!document)
+		return FALSE;
+
+	thread_safe = ev_document_is_thread_safe (document);
+	g_object_unref (document);
+
+	return thread_safe;
+}
+
 /**
  * ev_document_factory_get_document_for_gfile:
  * @file: a #GFile
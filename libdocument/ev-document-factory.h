@@ -47,6 +47,9 @@ EvDocument* ev_document_factory_get_document_for_stream (GInputStream *stream,
                                                          EvDocumentLoadFlags flags,
                                                          GCancellable *cancellable,
                                                          GError **error);
+EvDocument *ev_document_factory_get_worker_copy (EvDocument *document,
+                                                 GError    **error);
+gboolean    ev_document_factory_mime_type_is_thread_safe (const gchar *mime_type);
 
 void 	    ev_document_factory_add_filters  (GtkWidget *chooser, EvDocument *document);
 
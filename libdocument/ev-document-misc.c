@@ -26,6 +26,8 @@
 #include <gtk/gtk.h>
 
 #include "ev-document-misc.h"
+#include "ev-pixel-kernels.h"
+#include "ev-surface-pool.h"
 
 /* Returns a new GdkPixbuf that is suitable for placing in the thumbnail view.
  * It is four pixels wider and taller than the source.  If source_pixbuf is not
@@ -366,23 +368,137 @@ ev_document_misc_paint_one_page (cairo_t      *cr,
 	cairo_fill (cr);
 }
 
+static gboolean
+is_argb32_image_surface (cairo_surface_t *surface)
+{
+	cairo_format_t format;
+
+	if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS ||
+	    cairo_surface_get_type (surface) != CAIRO_SURFACE_TYPE_IMAGE)
+		return FALSE;
+
+	format = cairo_image_surface_get_format (surface);
+
+	return format == CAIRO_FORMAT_ARGB32 || format == CAIRO_FORMAT_RGB24;
+}
+
 cairo_surface_t *
 ev_document_misc_surface_from_pixbuf (GdkPixbuf *pixbuf)
+{
+	return ev_document_misc_surface_from_pixbuf_rotated (pixbuf, 0);
+}
+
+/* Rows converted at once before being rotated into the surface */
+#define ROTATE_STRIP_HEIGHT 16
+
+/**
+ * ev_document_misc_surface_from_pixbuf_rotated:
+ * @pixbuf: a #GdkPixbuf
+ * @rotation: the clockwise rotation in degrees, a multiple of 90
+ *
+ * Converts @pixbuf to an image surface rotated by @rotation, in a
+ * single pass instead of rotating the pixbuf and then converting it.
+ *
+ * Returns: (transfer full): a new #cairo_surface_t
+ *
+ * Since: 3.30
+ */
+cairo_surface_t *
+ev_document_misc_surface_from_pixbuf_rotated (GdkPixbuf *pixbuf,
+					      gint       rotation)
 {
 	cairo_surface_t *surface;
 	cairo_t         *cr;
+	gboolean         has_alpha;
+	gint             width, height;
+	gint             new_width, new_height;
 
 	g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
+	g_return_val_if_fail (rotation == 0 || rotation == 90 ||
+			      rotation == 180 || rotation == 270, NULL);
+
+	has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
+	width = gdk_pixbuf_get_width (pixbuf);
+	height = gdk_pixbuf_get_height (pixbuf);
+	new_width = rotation == 90 || rotation == 270 ? height : width;
+	new_height = rotation == 90 || rotation == 270 ? width : height;
+
+	surface = _ev_surface_pool_create_surface (has_alpha ?
+						   CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24,
+						   new_width, new_height);
+	if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+		return surface;
+
+	if (gdk_pixbuf_get_colorspace (pixbuf) == GDK_COLORSPACE_RGB &&
+	    gdk_pixbuf_get_bits_per_sample (pixbuf) == 8 &&
+	    gdk_pixbuf_get_n_channels (pixbuf) == (has_alpha ? 4 : 3)) {
+		const guchar *src = gdk_pixbuf_read_pixels (pixbuf);
+		gint          src_stride = gdk_pixbuf_get_rowstride (pixbuf);
+		gint          n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+		guchar       *dest;
+		gint          dest_stride;
+		guchar       *strip;
+		gint          y;
+
+		cairo_surface_flush (surface);
+		dest = cairo_image_surface_get_data (surface);
+		dest_stride = cairo_image_surface_get_stride (surface);
+
+		if (rotation == 0) {
+			_ev_pixels_rgb_to_argb32 (src, src_stride, n_channels,
+						  dest, dest_stride,
+						  width, height);
+			cairo_surface_mark_dirty (surface);
+
+			return surface;
+		}
+
+		/* Strips small enough to stay in the cache between
+		 * their conversion and their rotation */
+		strip = g_malloc ((gsize) width * 4 * ROTATE_STRIP_HEIGHT);
+		for (y = 0; y < height; y += ROTATE_STRIP_HEIGHT) {
+			gint    h = MIN (ROTATE_STRIP_HEIGHT, height - y);
+			guchar *d;
+
+			_ev_pixels_rgb_to_argb32 (src + (gsize) y * src_stride, src_stride, n_channels,
+						  strip, width * 4,
+						  width, h);
+
+			/* Where the top left corner of the rotated strip goes */
+			if (rotation == 90)
+				d = dest + (height - y - h) * 4;
+			else if (rotation == 180)
+				d = dest + (gsize) (height - y - h) * dest_stride;
+			else
+				d = dest + y * 4;
+
+			_ev_pixels_rotate_argb32 (strip, width * 4, width, h,
+						  d, dest_stride, rotation);
+		}
+		g_free (strip);
+		cairo_surface_mark_dirty (surface);
+
+		return surface;
+	}
 
-	surface = cairo_image_surface_create (gdk_pixbuf_get_has_alpha (pixbuf) ?
-					      CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24,
-					      gdk_pixbuf_get_width (pixbuf),
-					      gdk_pixbuf_get_height (pixbuf));
 	cr = cairo_create (surface);
+	switch (rotation) {
+	        case 90:
+			cairo_translate (cr, new_width, 0);
+			break;
+	        case 180:
+			cairo_translate (cr, new_width, new_height);
+			break;
+	        case 270:
+			cairo_translate (cr, 0, new_height);
+			break;
+	}
+	cairo_rotate (cr, rotation * G_PI / 180.0);
+	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
 	gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
 	cairo_paint (cr);
 	cairo_destroy (cr);
-	
+
 	return surface;
 }
 
@@ -395,12 +511,34 @@ ev_document_misc_surface_from_pixbuf (GdkPixbuf *pixbuf)
 GdkPixbuf *
 ev_document_misc_pixbuf_from_surface (cairo_surface_t *surface)
 {
+	GdkPixbuf *pixbuf;
+	gint       width, height;
+
 	g_return_val_if_fail (surface, NULL);	
 
-        return gdk_pixbuf_get_from_surface (surface,
-                                            0, 0,
-                                            cairo_image_surface_get_width (surface),
-                                            cairo_image_surface_get_height (surface));
+	width = cairo_image_surface_get_width (surface);
+	height = cairo_image_surface_get_height (surface);
+
+	if (width > 0 && height > 0 && is_argb32_image_surface (surface)) {
+		gboolean has_alpha;
+
+		has_alpha = cairo_image_surface_get_format (surface) == CAIRO_FORMAT_ARGB32;
+		pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8, width, height);
+		if (!pixbuf)
+			return NULL;
+
+		cairo_surface_flush (surface);
+		_ev_pixels_argb32_to_rgb (cairo_image_surface_get_data (surface),
+					  cairo_image_surface_get_stride (surface),
+					  gdk_pixbuf_get_pixels (pixbuf),
+					  gdk_pixbuf_get_rowstride (pixbuf),
+					  gdk_pixbuf_get_n_channels (pixbuf),
+					  width, height);
+
+		return pixbuf;
+	}
+
+        return gdk_pixbuf_get_from_surface (surface, 0, 0, width, height);
 }
 
 cairo_surface_t *
@@ -429,6 +567,45 @@ ev_document_misc_surface_rotate_and_scale (cairo_surface_t *surface,
 		new_height = dest_width;
 	}
 
+	/* Right angle rotations and downscales by a factor of two or more
+	 * of image surfaces are done without going through cairo. A box
+	 * filter also avoids the aliasing of the bilinear filter, which
+	 * only samples four source pixels for each destination pixel. */
+	if (is_argb32_image_surface (surface) &&
+	    (dest_rotation == 0 || dest_rotation == 90 ||
+	     dest_rotation == 180 || dest_rotation == 270) &&
+	    dest_width > 0 && dest_height > 0 &&
+	    ((dest_width == width && dest_height == height) ||
+	     (dest_width * 2 <= width && dest_height * 2 <= height))) {
+		cairo_format_t format = cairo_image_surface_get_format (surface);
+
+		cairo_surface_flush (surface);
+
+		new_surface = _ev_surface_pool_create_surface (format, new_width, new_height);
+		if (cairo_surface_status (new_surface) != CAIRO_STATUS_SUCCESS)
+			return new_surface;
+
+		/* Scaled and rotated in a single pass */
+		if (dest_width != width || dest_height != height)
+			_ev_pixels_downscale_rotate_argb32 (cairo_image_surface_get_data (surface),
+							    cairo_image_surface_get_stride (surface),
+							    width, height,
+							    cairo_image_surface_get_data (new_surface),
+							    cairo_image_surface_get_stride (new_surface),
+							    dest_width, dest_height,
+							    dest_rotation);
+		else
+			_ev_pixels_rotate_argb32 (cairo_image_surface_get_data (surface),
+						  cairo_image_surface_get_stride (surface),
+						  width, height,
+						  cairo_image_surface_get_data (new_surface),
+						  cairo_image_surface_get_stride (new_surface),
+						  dest_rotation);
+		cairo_surface_mark_dirty (new_surface);
+
+		return new_surface;
+	}
+
 	new_surface = cairo_surface_create_similar (surface,
 						    cairo_surface_get_content (surface),
 						    new_width, new_height);
@@ -467,6 +644,17 @@ void
 ev_document_misc_invert_surface (cairo_surface_t *surface) {
 	cairo_t *cr;
 
+	if (is_argb32_image_surface (surface)) {
+		cairo_surface_flush (surface);
+		_ev_pixels_invert_argb32 (cairo_image_surface_get_data (surface),
+					  cairo_image_surface_get_width (surface),
+					  cairo_image_surface_get_height (surface),
+					  cairo_image_surface_get_stride (surface));
+		cairo_surface_mark_dirty (surface);
+
+		return;
+	}
+
 	cr = cairo_create (surface);
 
 	/* white + DIFFERENCE -> invert */
@@ -476,34 +664,61 @@ ev_document_misc_invert_surface (cairo_surface_t *surface) {
 	cairo_destroy (cr);
 }
 
+/* Cross-fades @origin and @target into @dest, progress is the weight
+ * of @target from 0 to 1 */
 void
-ev_document_misc_invert_pixbuf (GdkPixbuf *pixbuf)
+ev_document_misc_blend_surfaces (cairo_surface_t *origin,
+				 cairo_surface_t *target,
+				 cairo_surface_t *dest,
+				 gdouble          progress)
 {
-	guchar *data, *p;
-	guint   width, height, x, y, rowstride, n_channels;
+	cairo_t *cr;
 
-	n_channels = gdk_pixbuf_get_n_channels (pixbuf);
-	g_assert (gdk_pixbuf_get_colorspace (pixbuf) == GDK_COLORSPACE_RGB);
-	g_assert (gdk_pixbuf_get_bits_per_sample (pixbuf) == 8);
+	if (is_argb32_image_surface (origin) &&
+	    is_argb32_image_surface (target) &&
+	    is_argb32_image_surface (dest) &&
+	    cairo_image_surface_get_width (origin) == cairo_image_surface_get_width (dest) &&
+	    cairo_image_surface_get_height (origin) == cairo_image_surface_get_height (dest) &&
+	    cairo_image_surface_get_width (target) == cairo_image_surface_get_width (dest) &&
+	    cairo_image_surface_get_height (target) == cairo_image_surface_get_height (dest)) {
+		cairo_surface_flush (origin);
+		cairo_surface_flush (target);
+		cairo_surface_flush (dest);
+		_ev_pixels_blend_argb32 (cairo_image_surface_get_data (origin),
+					 cairo_image_surface_get_stride (origin),
+					 cairo_image_surface_get_data (target),
+					 cairo_image_surface_get_stride (target),
+					 cairo_image_surface_get_data (dest),
+					 cairo_image_surface_get_stride (dest),
+					 cairo_image_surface_get_width (dest),
+					 cairo_image_surface_get_height (dest),
+					 (guint) (CLAMP (progress, 0., 1.) * 256 + 0.5));
+		cairo_surface_mark_dirty (dest);
+
+		return;
+	}
 
-	/* First grab a pointer to the raw pixel data. */
-	data = gdk_pixbuf_get_pixels (pixbuf);
+	cr = cairo_create (dest);
+	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_surface (cr, origin, 0, 0);
+	cairo_paint (cr);
+	cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+	cairo_set_source_surface (cr, target, 0, 0);
+	cairo_paint_with_alpha (cr, progress);
+	cairo_destroy (cr);
+}
 
-	/* Find the number of bytes per row (could be padded). */
-	rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+void
+ev_document_misc_invert_pixbuf (GdkPixbuf *pixbuf)
+{
+	g_assert (gdk_pixbuf_get_colorspace (pixbuf) == GDK_COLORSPACE_RGB);
+	g_assert (gdk_pixbuf_get_bits_per_sample (pixbuf) == 8);
 
-	width = gdk_pixbuf_get_width (pixbuf);
-	height = gdk_pixbuf_get_height (pixbuf);
-	for (x = 0; x < width; x++) {
-		for (y = 0; y < height; y++) {
-			/* Calculate pixel's offset into the data array. */
-			p = data + x * n_channels + y * rowstride;
-			/* Change the RGB values*/
-			p[0] = 255 - p[0];
-			p[1] = 255 - p[1];
-			p[2] = 255 - p[2];
-		}
-	}
+	_ev_pixels_invert_rgb (gdk_pixbuf_get_pixels (pixbuf),
+			       gdk_pixbuf_get_width (pixbuf),
+			       gdk_pixbuf_get_height (pixbuf),
+			       gdk_pixbuf_get_rowstride (pixbuf),
+			       gdk_pixbuf_get_n_channels (pixbuf));
 }
 
 gdouble
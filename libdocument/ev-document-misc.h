@@ -72,12 +72,18 @@ void       ev_document_misc_paint_one_page       (cairo_t      *cr,
 						  gboolean      inverted_colors);
 
 cairo_surface_t *ev_document_misc_surface_from_pixbuf (GdkPixbuf *pixbuf);
+cairo_surface_t *ev_document_misc_surface_from_pixbuf_rotated (GdkPixbuf *pixbuf,
+							       gint       rotation);
 GdkPixbuf       *ev_document_misc_pixbuf_from_surface (cairo_surface_t *surface);
 cairo_surface_t *ev_document_misc_surface_rotate_and_scale (cairo_surface_t *surface,
 							    gint             dest_width,
 							    gint             dest_height,
 							    gint             dest_rotation);
 void             ev_document_misc_invert_surface (cairo_surface_t *surface);
+void             ev_document_misc_blend_surfaces (cairo_surface_t *origin,
+						  cairo_surface_t *target,
+						  cairo_surface_t *dest,
+						  gdouble          progress);
 void		 ev_document_misc_invert_pixbuf  (GdkPixbuf       *pixbuf);
 
 gdouble          ev_document_misc_get_screen_dpi (GdkScreen *screen);
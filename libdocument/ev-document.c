@@ -25,7 +25,10 @@
 #include <string.h>
 
 #include "ev-document.h"
+#include "ev-cached-stream.h"
 #include "ev-document-misc.h"
+#include "ev-file-helpers.h"
+#include "ev-page-geometry.h"
 #include "synctex_parser.h"
 
 #define EV_DOCUMENT_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), EV_TYPE_DOCUMENT, EvDocumentPrivate))
@@ -35,11 +38,12 @@ enum {
 	PROP_MODIFIED
 };
 
-typedef struct _EvPageSize
-{
-	gdouble width;
-	gdouble height;
-} EvPageSize;
+/* Documents with fewer pages are fast enough to scan */
+#define PAGE_GEOMETRY_MIN_PAGES  100
+#define PAGE_GEOMETRY_CACHE_SIZE (16 * 1024 * 1024)
+
+/* The most of a remote file kept in memory */
+#define REMOTE_CACHE_SIZE (64 * 1024 * 1024)
 
 struct _EvDocumentPrivate
 {
@@ -64,6 +68,31 @@ struct _EvDocumentPrivate
 	EvPageSize     *page_sizes;
 	EvDocumentInfo *info;
 
+	GRWLock         lock;
+	gboolean        thread_safe;
+
+	/* Lazily loaded cache */
+	gint            n_cached_pages;
+	gboolean        custom_page_labels;
+	volatile gint   cache_complete;
+	GRWLock         cache_lock;
+
+	/* Page fingerprints */
+	gchar         **page_fingerprints;
+	gint            n_fingerprints;
+	GHashTable     *fingerprint_pages;
+	GMutex          fingerprints_lock;
+
+	/* Last page rendered whole to crop areas from, for
+	 * backends that can't render only an area */
+	cairo_surface_t *area_source;
+	gint             area_source_page;
+	gint             area_source_rotation;
+	gdouble          area_source_scale;
+	gint             area_source_width;
+	gint             area_source_height;
+	GMutex           area_source_lock;
+
 	synctex_scanner_t synctex_scanner;
 };
 
@@ -78,6 +107,7 @@ static gchar          *_ev_document_get_page_label  (EvDocument *document,
 						     EvPage     *page);
 static EvDocumentInfo *_ev_document_get_info        (EvDocument *document);
 static gboolean        _ev_document_support_synctex (EvDocument *document);
+static gboolean        _ev_document_is_thread_safe  (EvDocument *document);
 
 static GMutex ev_doc_mutex;
 static GMutex ev_fc_mutex;
@@ -107,6 +137,19 @@ ev_document_impl_get_info (EvDocument *document)
 	return g_new0 (EvDocumentInfo, 1);
 }
 
+static void
+ev_document_clear_fingerprints (EvDocument *document)
+{
+	EvDocumentPrivate *priv = document->priv;
+	gint               i;
+
+	g_clear_pointer (&priv->fingerprint_pages, g_hash_table_destroy);
+	for (i = 0; i < priv->n_fingerprints; i++)
+		g_free (priv->page_fingerprints[i]);
+	g_clear_pointer (&priv->page_fingerprints, g_free);
+	priv->n_fingerprints = 0;
+}
+
 static void
 ev_document_finalize (GObject *object)
 {
@@ -134,6 +177,15 @@ ev_document_finalize (GObject *object)
 		document->priv->synctex_scanner = NULL;
 	}
 
+	ev_document_clear_fingerprints (document);
+
+	g_clear_pointer (&document->priv->area_source, cairo_surface_destroy);
+
+	g_rw_lock_clear (&document->priv->lock);
+	g_rw_lock_clear (&document->priv->cache_lock);
+	g_mutex_clear (&document->priv->fingerprints_lock);
+	g_mutex_clear (&document->priv->area_source_lock);
+
 	G_OBJECT_CLASS (ev_document_parent_class)->finalize (object);
 }
 
@@ -177,6 +229,11 @@ ev_document_init (EvDocument *document)
 {
 	document->priv = EV_DOCUMENT_GET_PRIVATE (document);
 
+	g_rw_lock_init (&document->priv->lock);
+	g_rw_lock_init (&document->priv->cache_lock);
+	g_mutex_init (&document->priv->fingerprints_lock);
+	g_mutex_init (&document->priv->area_source_lock);
+
 	/* Assume all pages are the same size until proven otherwise */
 	document->priv->uniform = TRUE;
 }
@@ -246,6 +303,14 @@ ev_document_set_modified (EvDocument *document,
 	}
 }
 
+/**
+ * ev_document_doc_mutex_lock:
+ *
+ * Locks the process-wide document mutex.
+ *
+ * Deprecated: 3.30: Use ev_document_lock() instead, the global mutex
+ * is no longer taken by #EvJob<!-- -->s.
+ */
 void
 ev_document_doc_mutex_lock (void)
 {
@@ -282,89 +347,494 @@ ev_document_fc_mutex_trylock (void)
 	return g_mutex_trylock (&ev_fc_mutex);
 }
 
+/**
+ * ev_document_lock:
+ * @document: an #EvDocument
+ *
+ * Acquires exclusive access to @document. Every call into the backend
+ * that is not a render must be done while holding this lock.
+ *
+ * Since: 3.30
+ */
+void
+ev_document_lock (EvDocument *document)
+{
+	g_return_if_fail (EV_IS_DOCUMENT (document));
+
+	g_rw_lock_writer_lock (&document->priv->lock);
+}
+
+/**
+ * ev_document_unlock:
+ * @document: an #EvDocument
+ *
+ * Releases the lock acquired with ev_document_lock() or
+ * ev_document_trylock().
+ *
+ * Since: 3.30
+ */
+void
+ev_document_unlock (EvDocument *document)
+{
+	g_return_if_fail (EV_IS_DOCUMENT (document));
+
+	g_rw_lock_writer_unlock (&document->priv->lock);
+}
+
+/**
+ * ev_document_trylock:
+ * @document: an #EvDocument
+ *
+ * Like ev_document_lock(), but returns %FALSE instead of blocking
+ * when the lock is held by another thread.
+ *
+ * Returns: %TRUE if the lock was acquired
+ *
+ * Since: 3.30
+ */
+gboolean
+ev_document_trylock (EvDocument *document)
+{
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), FALSE);
+
+	return g_rw_lock_writer_trylock (&document->priv->lock);
+}
+
+/**
+ * ev_document_render_lock:
+ * @document: an #EvDocument
+ *
+ * Acquires the lock needed to render a page of @document. For
+ * thread-safe backends the lock is shared, so several pages can be
+ * rendered at the same time; for any other backend this is the same
+ * as ev_document_lock().
+ *
+ * Since: 3.30
+ */
+void
+ev_document_render_lock (EvDocument *document)
+{
+	g_return_if_fail (EV_IS_DOCUMENT (document));
+
+	if (document->priv->thread_safe)
+		g_rw_lock_reader_lock (&document->priv->lock);
+	else
+		g_rw_lock_writer_lock (&document->priv->lock);
+}
+
+/**
+ * ev_document_render_unlock:
+ * @document: an #EvDocument
+ *
+ * Releases the lock acquired with ev_document_render_lock().
+ *
+ * Since: 3.30
+ */
+void
+ev_document_render_unlock (EvDocument *document)
+{
+	g_return_if_fail (EV_IS_DOCUMENT (document));
+
+	if (document->priv->thread_safe)
+		g_rw_lock_reader_unlock (&document->priv->lock);
+	else
+		g_rw_lock_writer_unlock (&document->priv->lock);
+}
+
+/**
+ * ev_document_is_thread_safe:
+ * @document: an #EvDocument
+ *
+ * Returns: %TRUE if the backend of @document can render several
+ * pages concurrently
+ *
+ * Since: 3.30
+ */
+gboolean
+ev_document_is_thread_safe (EvDocument *document)
+{
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), FALSE);
+
+	return document->priv->thread_safe;
+}
+
+/**
+ * ev_document_supports_render_area:
+ * @document: an #EvDocument
+ *
+ * Returns: %TRUE if the backend of @document honors the area set with
+ * ev_render_context_set_area() and only renders the requested part of
+ * the page
+ *
+ * Since: 3.30
+ */
+gboolean
+ev_document_supports_render_area (EvDocument *document)
+{
+	EvDocumentClass *klass;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), FALSE);
+
+	klass = EV_DOCUMENT_GET_CLASS (document);
+
+	return klass->supports_render_area ? klass->supports_render_area (document) : FALSE;
+}
+
+/**
+ * ev_document_supports_worker_copies:
+ * @document: an #EvDocument
+ *
+ * Returns: %TRUE if separate documents of the backend of @document
+ * don't share any state, so that a backend that is not thread-safe can
+ * still be used from several threads with a copy of the document for
+ * every thread. See ev_document_factory_get_worker_copy().
+ *
+ * Since: 3.30
+ */
+gboolean
+ev_document_supports_worker_copies (EvDocument *document)
+{
+	EvDocumentClass *klass;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), FALSE);
+
+	klass = EV_DOCUMENT_GET_CLASS (document);
+
+	return klass->supports_worker_copies ? klass->supports_worker_copies (document) : FALSE;
+}
+
+static void
+ev_document_get_page_info (EvDocument *document,
+			   gint        index,
+			   gdouble    *page_width,
+			   gdouble    *page_height,
+			   gchar     **page_label)
+{
+	EvPage *page = ev_document_get_page (document, index);
+
+	*page_width = 0;
+	*page_height = 0;
+	_ev_document_get_page_size (document, page, page_width, page_height);
+	*page_label = _ev_document_get_page_label (document, page);
+
+	g_object_unref (page);
+}
+
+/* Adds the size and label of page @i to the cache, which takes the
+ * ownership of @page_label */
+static void
+ev_document_cache_page (EvDocument *document,
+			gint        i,
+			gdouble     page_width,
+			gdouble     page_height,
+			gchar      *page_label)
+{
+        EvDocumentPrivate *priv = document->priv;
+        EvPageSize        *page_size;
+
+        if (i == 0) {
+                priv->uniform_width = page_width;
+                priv->uniform_height = page_height;
+                priv->max_width = priv->uniform_width;
+                priv->max_height = priv->uniform_height;
+                priv->min_width = priv->uniform_width;
+                priv->min_height = priv->uniform_height;
+        } else if (priv->uniform &&
+                    (priv->uniform_width != page_width ||
+                    priv->uniform_height != page_height)) {
+                /* It's a different page size.  Backfill the array,
+                 * including the pages that are not cached yet. */
+                int j;
+
+                priv->page_sizes = g_new0 (EvPageSize, priv->n_pages);
+
+                for (j = 0; j < priv->n_pages; j++) {
+                        page_size = &(priv->page_sizes[j]);
+                        page_size->width = priv->uniform_width;
+                        page_size->height = priv->uniform_height;
+                }
+                priv->uniform = FALSE;
+        }
+        if (!priv->uniform) {
+                page_size = &(priv->page_sizes[i]);
+
+                page_size->width = page_width;
+                page_size->height = page_height;
+
+                if (page_width > priv->max_width)
+                        priv->max_width = page_width;
+                if (page_width < priv->min_width)
+                        priv->min_width = page_width;
+
+                if (page_height > priv->max_height)
+                        priv->max_height = page_height;
+                if (page_height < priv->min_height)
+                        priv->min_height = page_height;
+        }
+
+        if (page_label) {
+                if (!priv->page_labels)
+                        priv->page_labels = g_new0 (gchar *, priv->n_pages + 1);
+
+                if (!priv->custom_page_labels) {
+                        gchar *real_page_label;
+
+                        real_page_label = g_strdup_printf ("%d", i + 1);
+                        priv->custom_page_labels = g_strcmp0 (real_page_label, page_label) != 0;
+                        g_free (real_page_label);
+                }
+
+                priv->page_labels[i] = page_label;
+                priv->max_label = MAX (priv->max_label,
+                                        g_utf8_strlen (page_label, 256));
+        }
+}
+
+static void
+ev_document_reset_cache (EvDocument *document)
+{
+        EvDocumentPrivate *priv = document->priv;
+
+        g_clear_pointer (&priv->page_sizes, g_free);
+        g_clear_pointer (&priv->page_labels, g_strfreev);
+        priv->uniform = TRUE;
+        priv->max_label = 0;
+        priv->custom_page_labels = FALSE;
+        priv->n_cached_pages = 0;
+        g_atomic_int_set (&priv->cache_complete, FALSE);
+}
+
+static void
+ev_document_finish_cache (EvDocument *document)
+{
+        EvDocumentPrivate *priv = document->priv;
+
+        if (!priv->custom_page_labels)
+                g_clear_pointer (&priv->page_labels, g_strfreev);
+
+        g_atomic_int_set (&priv->cache_complete, TRUE);
+}
+
+/* Documents loaded from a temporary copy, like the decompressed ones,
+ * get a new URI every time they are opened, so their page geometry
+ * would never be found again */
+static gboolean
+ev_document_can_cache_page_geometry (EvDocument *document)
+{
+        EvDocumentPrivate *priv = document->priv;
+        GFile             *file;
+        gboolean           retval;
+
+        if (!priv->uri || priv->n_pages < PAGE_GEOMETRY_MIN_PAGES)
+                return FALSE;
+
+        file = g_file_new_for_uri (priv->uri);
+        retval = !ev_file_is_temp (file);
+        g_object_unref (file);
+
+        return retval;
+}
+
+/* Fills in the cache from the page geometry saved the last time the
+ * document was opened, see ev-page-geometry.c */
+static gboolean
+ev_document_load_page_geometry (EvDocument *document)
+{
+        EvDocumentPrivate *priv = document->priv;
+        EvPageGeometry     geometry;
+
+        if (!ev_document_can_cache_page_geometry (document))
+                return FALSE;
+
+        geometry.n_pages = priv->n_pages;
+        if (!_ev_page_geometry_load (priv->uri, G_OBJECT_TYPE_NAME (document), &geometry))
+                return FALSE;
+
+        priv->uniform = geometry.uniform;
+        priv->uniform_width = geometry.uniform_width;
+        priv->uniform_height = geometry.uniform_height;
+        priv->max_width = geometry.max_width;
+        priv->max_height = geometry.max_height;
+        priv->min_width = geometry.min_width;
+        priv->min_height = geometry.min_height;
+        priv->max_label = geometry.max_label;
+        priv->page_sizes = geometry.page_sizes;
+        priv->page_labels = geometry.page_labels;
+        priv->custom_page_labels = geometry.page_labels != NULL;
+        priv->n_cached_pages = priv->n_pages;
+
+        return TRUE;
+}
+
+static void
+ev_document_save_page_geometry (EvDocument *document)
+{
+        EvDocumentPrivate *priv = document->priv;
+        EvPageGeometry     geometry;
+        GError            *error = NULL;
+
+        if (!ev_document_can_cache_page_geometry (document))
+                return;
+
+        geometry.n_pages = priv->n_pages;
+        geometry.uniform = priv->uniform;
+        geometry.uniform_width = priv->uniform_width;
+        geometry.uniform_height = priv->uniform_height;
+        geometry.max_width = priv->max_width;
+        geometry.max_height = priv->max_height;
+        geometry.min_width = priv->min_width;
+        geometry.min_height = priv->min_height;
+        geometry.max_label = priv->max_label;
+        geometry.page_sizes = priv->page_sizes;
+        geometry.page_labels = priv->page_labels;
+
+        if (!_ev_page_geometry_save (priv->uri, G_OBJECT_TYPE_NAME (document),
+                                     &geometry, &error)) {
+                g_debug ("Failed to save the page geometry of %s: %s",
+                         priv->uri, error->message);
+                g_error_free (error);
+                return;
+        }
+
+        _ev_page_geometry_prune (PAGE_GEOMETRY_CACHE_SIZE);
+}
+
 static void
 ev_document_setup_cache (EvDocument *document)
 {
         EvDocumentPrivate *priv = document->priv;
-        gboolean custom_page_labels = FALSE;
         gint i;
 
         /* Cache some info about the document to avoid
          * going to the backends since it requires locks
          */
-	priv->cache_loaded = TRUE;
+        ev_document_reset_cache (document);
+
+        if (ev_document_load_page_geometry (document)) {
+                ev_document_finish_cache (document);
+                priv->cache_loaded = TRUE;
+                return;
+        }
 
         for (i = 0; i < priv->n_pages; i++) {
-                EvPage     *page = ev_document_get_page (document, i);
-                gdouble     page_width = 0;
-                gdouble     page_height = 0;
-                EvPageSize *page_size;
-                gchar      *page_label;
-
-                _ev_document_get_page_size (document, page, &page_width, &page_height);
-
-                if (i == 0) {
-                        priv->uniform_width = page_width;
-                        priv->uniform_height = page_height;
-                        priv->max_width = priv->uniform_width;
-                        priv->max_height = priv->uniform_height;
-                        priv->min_width = priv->uniform_width;
-                        priv->min_height = priv->uniform_height;
-                } else if (priv->uniform &&
-                            (priv->uniform_width != page_width ||
-                            priv->uniform_height != page_height)) {
-                        /* It's a different page size.  Backfill the array. */
-                        int j;
-
-                        priv->page_sizes = g_new0 (EvPageSize, priv->n_pages);
-
-                        for (j = 0; j < i; j++) {
-                                page_size = &(priv->page_sizes[j]);
-                                page_size->width = priv->uniform_width;
-                                page_size->height = priv->uniform_height;
-                        }
-                        priv->uniform = FALSE;
-                }
-                if (!priv->uniform) {
-                        page_size = &(priv->page_sizes[i]);
+                gdouble page_width, page_height;
+                gchar  *page_label;
 
-                        page_size->width = page_width;
-                        page_size->height = page_height;
+                ev_document_get_page_info (document, i, &page_width, &page_height, &page_label);
+                ev_document_cache_page (document, i, page_width, page_height, page_label);
+        }
+        priv->n_cached_pages = priv->n_pages;
 
-                        if (page_width > priv->max_width)
-                                priv->max_width = page_width;
-                        if (page_width < priv->min_width)
-                                priv->min_width = page_width;
+        ev_document_finish_cache (document);
+	priv->cache_loaded = TRUE;
 
-                        if (page_height > priv->max_height)
-                                priv->max_height = page_height;
-                        if (page_height < priv->min_height)
-                                priv->min_height = page_height;
-                }
+        ev_document_save_page_geometry (document);
+}
 
-                page_label = _ev_document_get_page_label (document, page);
-                if (page_label) {
-                        if (!priv->page_labels)
-                                priv->page_labels = g_new0 (gchar *, priv->n_pages + 1);
+/* Only the first page is cached while loading, so that the document can
+ * be shown right away. The other pages are assumed to be the same size
+ * until ev_document_fill_cache() caches them. */
+static void
+ev_document_setup_lazy_cache (EvDocument *document)
+{
+        EvDocumentPrivate *priv = document->priv;
 
-                        if (!custom_page_labels) {
-                                gchar *real_page_label;
+        ev_document_reset_cache (document);
+	priv->cache_loaded = TRUE;
 
-                                real_page_label = g_strdup_printf ("%d", i + 1);
-                                custom_page_labels = g_strcmp0 (real_page_label, page_label) != 0;
-                                g_free (real_page_label);
-                        }
+        if (ev_document_load_page_geometry (document)) {
+                ev_document_finish_cache (document);
+                return;
+        }
 
-                        priv->page_labels[i] = page_label;
-                        priv->max_label = MAX (priv->max_label,
-                                                g_utf8_strlen (page_label, 256));
-                }
+        if (priv->n_pages > 0) {
+                gdouble page_width, page_height;
+                gchar  *page_label;
 
-                g_object_unref (page);
+                ev_document_get_page_info (document, 0, &page_width, &page_height, &page_label);
+                ev_document_cache_page (document, 0, page_width, page_height, page_label);
+                priv->n_cached_pages = 1;
         }
 
-	if (!custom_page_labels)
-		g_clear_pointer (&priv->page_labels, g_strfreev);
+        if (priv->n_cached_pages == priv->n_pages)
+                ev_document_finish_cache (document);
+}
+
+static void
+ev_document_load_cache (EvDocument          *document,
+			EvDocumentLoadFlags  flags)
+{
+	if (flags & (EV_DOCUMENT_LOAD_FLAG_NO_CACHE | EV_DOCUMENT_LOAD_FLAG_PROBE))
+		return;
+
+	if (flags & EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE)
+		ev_document_setup_lazy_cache (document);
+	else
+		ev_document_setup_cache (document);
+}
+
+/* The pages are fingerprinted right after loading, while the file is the
+ * one loaded, so that they can be told apart from the pages of the file
+ * reloaded when it changes. Backends implementing get_page_fingerprint
+ * are expected to do it cheaply. */
+static void
+ev_document_load_fingerprints (EvDocument *document)
+{
+	EvDocumentClass *klass = EV_DOCUMENT_GET_CLASS (document);
+	gint             i;
+
+	g_mutex_lock (&document->priv->fingerprints_lock);
+	ev_document_clear_fingerprints (document);
+	g_mutex_unlock (&document->priv->fingerprints_lock);
+
+	if (!klass->get_page_fingerprint)
+		return;
+
+	for (i = 0; i < document->priv->n_pages; i++) {
+		EvPage *page;
+		gchar  *fingerprint;
+
+		page = ev_document_get_page (document, i);
+		fingerprint = ev_document_get_page_fingerprint (document, page);
+		g_object_unref (page);
+
+		/* Pages the backend can't fingerprint are rendered again */
+		g_free (fingerprint);
+	}
+}
+
+/* While a lazily loaded cache is filled in from another thread, reading
+ * it requires the cache lock. Returns whether it was taken. */
+static gboolean
+ev_document_cache_reader_lock (EvDocument *document)
+{
+	if (g_atomic_int_get (&document->priv->cache_complete))
+		return FALSE;
+
+	g_rw_lock_reader_lock (&document->priv->cache_lock);
+
+	return TRUE;
+}
+
+static void
+ev_document_cache_reader_unlock (EvDocument *document,
+				 gboolean    locked)
+{
+	if (locked)
+		g_rw_lock_reader_unlock (&document->priv->cache_lock);
+}
+
+/* For documents loaded with EV_DOCUMENT_LOAD_FLAG_NO_CACHE */
+static void
+ev_document_ensure_cache (EvDocument *document)
+{
+	if (document->priv->cache_loaded)
+		return;
+
+	g_rw_lock_writer_lock (&document->priv->lock);
+	if (!document->priv->cache_loaded)
+		ev_document_setup_cache (document);
+	g_rw_lock_writer_unlock (&document->priv->lock);
 }
 
 static void
@@ -413,6 +883,19 @@ ev_document_load_full (EvDocument           *document,
 	gboolean retval;
 	GError *err = NULL;
 
+	/* Remote files are read progressively when the backend can */
+	if (klass->load_stream) {
+		GFile *file = g_file_new_for_uri (uri);
+
+		if (!g_file_is_native (file)) {
+			retval = ev_document_load_gfile (document, file, flags, NULL, error);
+			g_object_unref (file);
+
+			return retval;
+		}
+		g_object_unref (file);
+	}
+
 	retval = klass->load (document, uri, &err);
 	if (!retval) {
 		if (err) {
@@ -430,11 +913,15 @@ ev_document_load_full (EvDocument           *document,
 	} else {
 		document->priv->info = _ev_document_get_info (document);
 		document->priv->n_pages = _ev_document_get_n_pages (document);
-		if (!(flags & EV_DOCUMENT_LOAD_FLAG_NO_CACHE))
-			ev_document_setup_cache (document);
+		document->priv->thread_safe = _ev_document_is_thread_safe (document);
+		g_free (document->priv->uri);
 		document->priv->uri = g_strdup (uri);
+		ev_document_load_cache (document, flags);
 		document->priv->file_size = _ev_document_get_size (uri);
-		ev_document_initialize_synctex (document, uri);
+		if (!(flags & EV_DOCUMENT_LOAD_FLAG_PROBE)) {
+			ev_document_load_fingerprints (document);
+			ev_document_initialize_synctex (document, uri);
+		}
         }
 
 	return retval;
@@ -507,13 +994,65 @@ ev_document_load_stream (EvDocument         *document,
 
 	document->priv->info = _ev_document_get_info (document);
 	document->priv->n_pages = _ev_document_get_n_pages (document);
+	document->priv->thread_safe = _ev_document_is_thread_safe (document);
 
-        if (!(flags & EV_DOCUMENT_LOAD_FLAG_NO_CACHE))
-                ev_document_setup_cache (document);
+        ev_document_load_cache (document, flags);
+	if (!(flags & EV_DOCUMENT_LOAD_FLAG_PROBE))
+		ev_document_load_fingerprints (document);
 
         return TRUE;
 }
 
+/* Remote files are read through a cache of the blocks the backend asked
+ * for, instead of being downloaded first: only the byte ranges needed to
+ * show the first page of a linearized PDF are fetched before it's shown,
+ * the rest of the file as other pages need it.
+ */
+static GInputStream *
+ev_document_open_remote_stream (GFile        *file,
+				GCancellable *cancellable,
+				GError      **error)
+{
+	GFileInputStream *base;
+	GFileInfo        *info;
+	GInputStream     *stream;
+
+	base = g_file_read (file, cancellable, error);
+	if (!base)
+		return NULL;
+
+	if (!g_seekable_can_seek (G_SEEKABLE (base))) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+				     "Remote file is not seekable");
+		g_object_unref (base);
+
+		return NULL;
+	}
+
+	info = g_file_input_stream_query_info (base, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+					       cancellable, NULL);
+	if (!info) {
+		info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+					  G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+	}
+	if (!info || !g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_SIZE)) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+				     "Size of the remote file is unknown");
+		g_clear_object (&info);
+		g_object_unref (base);
+
+		return NULL;
+	}
+
+	stream = _ev_cached_stream_new (G_INPUT_STREAM (base),
+					g_file_info_get_size (info),
+					REMOTE_CACHE_SIZE);
+	g_object_unref (info);
+	g_object_unref (base);
+
+	return stream;
+}
+
 /**
  * ev_document_load_gfile:
  * @document: a #EvDocument
@@ -544,28 +1083,68 @@ ev_document_load_gfile (EvDocument         *document,
         g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
         klass = EV_DOCUMENT_GET_CLASS (document);
-        if (!klass->load_gfile) {
-                g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
-                                     "Backend does not support loading from GFile");
-                return FALSE;
-        }
+        if (!g_file_is_native (file) && klass->load_stream) {
+                GInputStream *stream;
+                gboolean      retval;
+
+                stream = ev_document_open_remote_stream (file, cancellable, error);
+                if (!stream)
+                        return FALSE;
+
+                retval = klass->load_stream (document, stream, flags, cancellable, error);
+                g_object_unref (stream);
+                if (!retval)
+                        return FALSE;
+        } else {
+                if (!klass->load_gfile) {
+                        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                                             "Backend does not support loading from GFile");
+                        return FALSE;
+                }
 
-        if (!klass->load_gfile (document, file, flags, cancellable, error))
-                return FALSE;
+                if (!klass->load_gfile (document, file, flags, cancellable, error))
+                        return FALSE;
+        }
 
 	document->priv->info = _ev_document_get_info (document);
 	document->priv->n_pages = _ev_document_get_n_pages (document);
+	document->priv->thread_safe = _ev_document_is_thread_safe (document);
 
-        if (!(flags & EV_DOCUMENT_LOAD_FLAG_NO_CACHE))
-                ev_document_setup_cache (document);
-
+	g_free (document->priv->uri);
 	document->priv->uri = g_file_get_uri (file);
+
+        ev_document_load_cache (document, flags);
 	document->priv->file_size = _ev_document_get_size_gfile (file);
-	ev_document_initialize_synctex (document, document->priv->uri);
+	if (!(flags & EV_DOCUMENT_LOAD_FLAG_PROBE)) {
+		ev_document_load_fingerprints (document);
+		ev_document_initialize_synctex (document, document->priv->uri);
+	}
 
         return TRUE;
 }
 
+/*
+ * _ev_document_set_uri:
+ * @document: a #EvDocument
+ * @uri: the document's URI
+ *
+ * Sets the URI of a document loaded from a stream with the contents of
+ * the file at @uri, like a compressed file decompressed in memory.
+ */
+void
+_ev_document_set_uri (EvDocument  *document,
+		      const gchar *uri)
+{
+	g_return_if_fail (EV_IS_DOCUMENT (document));
+	g_return_if_fail (uri != NULL);
+
+	g_free (document->priv->uri);
+	document->priv->uri = g_strdup (uri);
+	document->priv->file_size = _ev_document_get_size (uri);
+	if (!document->priv->synctex_scanner)
+		ev_document_initialize_synctex (document, uri);
+}
+
 /**
  * ev_document_save:
  * @document: a #EvDocument
@@ -610,6 +1189,14 @@ _ev_document_support_synctex (EvDocument *document)
 	return klass->support_synctex ? klass->support_synctex (document) : FALSE;
 }
 
+static gboolean
+_ev_document_is_thread_safe (EvDocument *document)
+{
+	EvDocumentClass *klass = EV_DOCUMENT_GET_CLASS (document);
+
+	return klass->is_thread_safe ? klass->is_thread_safe (document) : FALSE;
+}
+
 gboolean
 ev_document_has_synctex (EvDocument *document)
 {
@@ -789,6 +1376,9 @@ ev_document_get_page_size (EvDocument *document,
 	priv = document->priv;
 
 	if (priv->cache_loaded) {
+		gboolean locked;
+
+		locked = ev_document_cache_reader_lock (document);
 		if (width)
 			*width = priv->uniform ?
 				priv->uniform_width :
@@ -797,17 +1387,66 @@ ev_document_get_page_size (EvDocument *document,
 			*height = priv->uniform ?
 				priv->uniform_height :
 				priv->page_sizes[page_index].height;
+		ev_document_cache_reader_unlock (document, locked);
 	} else {
 		EvPage *page;
 
-		g_mutex_lock (&ev_doc_mutex);
+		g_rw_lock_writer_lock (&document->priv->lock);
 		page = ev_document_get_page (document, page_index);
 		_ev_document_get_page_size (document, page, width, height);
 		g_object_unref (page);
-		g_mutex_unlock (&ev_doc_mutex);
+		g_rw_lock_writer_unlock (&document->priv->lock);
 	}
 }
 
+/**
+ * ev_document_lookup_page_size:
+ * @document: a #EvDocument
+ * @page_index: index of page
+ * @width: (out) (allow-none): return location for the width of the page, or %NULL
+ * @height: (out) (allow-none): return location for the height of the page, or %NULL
+ *
+ * Like ev_document_get_page_size(), but the backend is never asked, so it
+ * can be called by backends with the document lock held.
+ *
+ * Returns: %TRUE if the size of page @page_index is cached already
+ *
+ * Since: 3.30
+ */
+gboolean
+ev_document_lookup_page_size (EvDocument *document,
+			      gint        page_index,
+			      double     *width,
+			      double     *height)
+{
+	EvDocumentPrivate *priv;
+	gboolean           locked;
+	gboolean           retval = FALSE;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), FALSE);
+
+	priv = document->priv;
+	if (!priv->cache_loaded || page_index < 0 || page_index >= priv->n_pages)
+		return FALSE;
+
+	locked = ev_document_cache_reader_lock (document);
+	/* Pages not cached yet are only assumed to be like the first one */
+	if (!locked || page_index < priv->n_cached_pages) {
+		if (width)
+			*width = priv->uniform ?
+				priv->uniform_width :
+				priv->page_sizes[page_index].width;
+		if (height)
+			*height = priv->uniform ?
+				priv->uniform_height :
+				priv->page_sizes[page_index].height;
+		retval = TRUE;
+	}
+	ev_document_cache_reader_unlock (document, locked);
+
+	return retval;
+}
+
 static gchar *
 _ev_document_get_page_label (EvDocument *document,
 			     EvPage     *page)
@@ -822,25 +1461,31 @@ gchar *
 ev_document_get_page_label (EvDocument *document,
 			    gint        page_index)
 {
+	gchar    *page_label;
+	gboolean  locked;
+
 	g_return_val_if_fail (EV_IS_DOCUMENT (document), NULL);
 	g_return_val_if_fail (page_index >= 0 || page_index < document->priv->n_pages, NULL);
 
 	if (!document->priv->cache_loaded) {
 		EvPage *page;
-		gchar *page_label;
 
-		g_mutex_lock (&ev_doc_mutex);
+		g_rw_lock_writer_lock (&document->priv->lock);
 		page = ev_document_get_page (document, page_index);
 		page_label = _ev_document_get_page_label (document, page);
 		g_object_unref (page);
-		g_mutex_unlock (&ev_doc_mutex);
+		g_rw_lock_writer_unlock (&document->priv->lock);
 
 		return page_label ? page_label : g_strdup_printf ("%d", page_index + 1);
 	}
 
-	return (document->priv->page_labels && document->priv->page_labels[page_index]) ?
+	locked = ev_document_cache_reader_lock (document);
+	page_label = (document->priv->page_labels && document->priv->page_labels[page_index]) ?
 		g_strdup (document->priv->page_labels[page_index]) :
 		g_strdup_printf ("%d", page_index + 1);
+	ev_document_cache_reader_unlock (document, locked);
+
+	return page_label;
 }
 
 static EvDocumentInfo *
@@ -873,13 +1518,91 @@ ev_document_get_backend_info (EvDocument *document, EvDocumentBackendInfo *info)
 	return klass->get_backend_info (document, info);
 }
 
+static gboolean
+ev_document_area_source_matches (EvDocument      *document,
+				 EvRenderContext *rc)
+{
+	EvDocumentPrivate *priv = document->priv;
+
+	return priv->area_source &&
+		priv->area_source_page == rc->page->index &&
+		priv->area_source_rotation == rc->rotation &&
+		priv->area_source_scale == rc->scale &&
+		priv->area_source_width == rc->target_width &&
+		priv->area_source_height == rc->target_height;
+}
+
+/* The whole page the area of @rc is cropped from. It's rendered once
+ * and kept for the next areas of the page at the same size, so that
+ * rendering a page in tiles doesn't render it whole for every tile.
+ */
+static cairo_surface_t *
+ev_document_get_area_source (EvDocument      *document,
+			     EvRenderContext *rc)
+{
+	EvDocumentClass   *klass = EV_DOCUMENT_GET_CLASS (document);
+	EvDocumentPrivate *priv = document->priv;
+	cairo_surface_t   *surface = NULL;
+
+	g_mutex_lock (&priv->area_source_lock);
+	if (ev_document_area_source_matches (document, rc))
+		surface = cairo_surface_reference (priv->area_source);
+	g_mutex_unlock (&priv->area_source_lock);
+
+	if (surface)
+		return surface;
+
+	surface = klass->render (document, rc);
+	if (!surface)
+		return NULL;
+
+	g_mutex_lock (&priv->area_source_lock);
+	if (priv->area_source)
+		cairo_surface_destroy (priv->area_source);
+	priv->area_source = cairo_surface_reference (surface);
+	priv->area_source_page = rc->page->index;
+	priv->area_source_rotation = rc->rotation;
+	priv->area_source_scale = rc->scale;
+	priv->area_source_width = rc->target_width;
+	priv->area_source_height = rc->target_height;
+	g_mutex_unlock (&priv->area_source_lock);
+
+	return surface;
+}
+
 cairo_surface_t *
 ev_document_render (EvDocument      *document,
 		    EvRenderContext *rc)
 {
 	EvDocumentClass *klass = EV_DOCUMENT_GET_CLASS (document);
+	cairo_surface_t *surface;
+	cairo_surface_t *area_surface;
+	cairo_t         *cr;
+
+	if (!rc->has_area || ev_document_supports_render_area (document)) {
+		/* A page rendered whole again may have changed */
+		g_mutex_lock (&document->priv->area_source_lock);
+		g_clear_pointer (&document->priv->area_source, cairo_surface_destroy);
+		g_mutex_unlock (&document->priv->area_source_lock);
 
-	return klass->render (document, rc);
+		return klass->render (document, rc);
+	}
+
+	surface = ev_document_get_area_source (document, rc);
+	if (!surface)
+		return NULL;
+
+	/* The backend rendered the whole page, crop it to the requested area */
+	area_surface = cairo_image_surface_create (cairo_image_surface_get_format (surface),
+						   rc->area.width,
+						   rc->area.height);
+	cr = cairo_create (area_surface);
+	cairo_set_source_surface (cr, surface, -rc->area.x, -rc->area.y);
+	cairo_paint (cr);
+	cairo_destroy (cr);
+	cairo_surface_destroy (surface);
+
+	return area_surface;
 }
 
 static GdkPixbuf *
@@ -959,15 +1682,17 @@ ev_document_get_title (EvDocument *document)
 gboolean
 ev_document_is_page_size_uniform (EvDocument *document)
 {
+	gboolean uniform, locked;
+
 	g_return_val_if_fail (EV_IS_DOCUMENT (document), TRUE);
 
-	if (!document->priv->cache_loaded) {
-		g_mutex_lock (&ev_doc_mutex);
-		ev_document_setup_cache (document);
-		g_mutex_unlock (&ev_doc_mutex);
-	}
+	ev_document_ensure_cache (document);
 
-	return document->priv->uniform;
+	locked = ev_document_cache_reader_lock (document);
+	uniform = document->priv->uniform;
+	ev_document_cache_reader_unlock (document, locked);
+
+	return uniform;
 }
 
 void
@@ -975,18 +1700,18 @@ ev_document_get_max_page_size (EvDocument *document,
 			       gdouble    *width,
 			       gdouble    *height)
 {
+	gboolean locked;
+
 	g_return_if_fail (EV_IS_DOCUMENT (document));
 
-	if (!document->priv->cache_loaded) {
-		g_mutex_lock (&ev_doc_mutex);
-		ev_document_setup_cache (document);
-		g_mutex_unlock (&ev_doc_mutex);
-	}
+	ev_document_ensure_cache (document);
 
+	locked = ev_document_cache_reader_lock (document);
 	if (width)
 		*width = document->priv->max_width;
 	if (height)
 		*height = document->priv->max_height;
+	ev_document_cache_reader_unlock (document, locked);
 }
 
 void
@@ -994,32 +1719,34 @@ ev_document_get_min_page_size (EvDocument *document,
 			       gdouble    *width,
 			       gdouble    *height)
 {
+	gboolean locked;
+
 	g_return_if_fail (EV_IS_DOCUMENT (document));
 
-	if (!document->priv->cache_loaded) {
-		g_mutex_lock (&ev_doc_mutex);
-		ev_document_setup_cache (document);
-		g_mutex_unlock (&ev_doc_mutex);
-	}
+	ev_document_ensure_cache (document);
 
+	locked = ev_document_cache_reader_lock (document);
 	if (width)
 		*width = document->priv->min_width;
 	if (height)
 		*height = document->priv->min_height;
+	ev_document_cache_reader_unlock (document, locked);
 }
 
 gboolean
 ev_document_check_dimensions (EvDocument *document)
 {
+	gboolean retval, locked;
+
 	g_return_val_if_fail (EV_IS_DOCUMENT (document), FALSE);
 
-	if (!document->priv->cache_loaded) {
-		g_mutex_lock (&ev_doc_mutex);
-		ev_document_setup_cache (document);
-		g_mutex_unlock (&ev_doc_mutex);
-	}
+	ev_document_ensure_cache (document);
 
-	return (document->priv->max_width > 0 && document->priv->max_height > 0);
+	locked = ev_document_cache_reader_lock (document);
+	retval = document->priv->max_width > 0 && document->priv->max_height > 0;
+	ev_document_cache_reader_unlock (document, locked);
+
+	return retval;
 }
 
 guint64
@@ -1033,29 +1760,35 @@ ev_document_get_size (EvDocument *document)
 gint
 ev_document_get_max_label_len (EvDocument *document)
 {
+	gint     max_label;
+	gboolean locked;
+
 	g_return_val_if_fail (EV_IS_DOCUMENT (document), -1);
 
-	if (!document->priv->cache_loaded) {
-		g_mutex_lock (&ev_doc_mutex);
-		ev_document_setup_cache (document);
-		g_mutex_unlock (&ev_doc_mutex);
-	}
+	ev_document_ensure_cache (document);
+
+	locked = ev_document_cache_reader_lock (document);
+	max_label = document->priv->max_label;
+	ev_document_cache_reader_unlock (document, locked);
 
-	return document->priv->max_label;
+	return max_label;
 }
 
 gboolean
 ev_document_has_text_page_labels (EvDocument *document)
 {
+	gboolean has_labels, locked;
+
 	g_return_val_if_fail (EV_IS_DOCUMENT (document), FALSE);
 
-	if (!document->priv->cache_loaded) {
-		g_mutex_lock (&ev_doc_mutex);
-		ev_document_setup_cache (document);
-		g_mutex_unlock (&ev_doc_mutex);
-	}
+	ev_document_ensure_cache (document);
 
-	return document->priv->page_labels != NULL;
+	locked = ev_document_cache_reader_lock (document);
+	/* Page labels are only cached for good when some is not the page number */
+	has_labels = document->priv->page_labels != NULL && document->priv->custom_page_labels;
+	ev_document_cache_reader_unlock (document, locked);
+
+	return has_labels;
 }
 
 gboolean
@@ -1066,23 +1799,23 @@ ev_document_find_page_by_label (EvDocument  *document,
 	gint i, page;
 	glong value;
 	gchar *endptr = NULL;
+	gboolean locked;
 	EvDocumentPrivate *priv = document->priv;
 
 	g_return_val_if_fail (EV_IS_DOCUMENT (document), FALSE);
 	g_return_val_if_fail (page_label != NULL, FALSE);
 	g_return_val_if_fail (page_index != NULL, FALSE);
 
-	if (!document->priv->cache_loaded) {
-		g_mutex_lock (&ev_doc_mutex);
-		ev_document_setup_cache (document);
-		g_mutex_unlock (&ev_doc_mutex);
-	}
+	ev_document_ensure_cache (document);
+
+	locked = ev_document_cache_reader_lock (document);
 
         /* First, look for a literal label match */
 	for (i = 0; priv->page_labels && i < priv->n_pages; i ++) {
 		if (priv->page_labels[i] != NULL &&
 		    ! strcmp (page_label, priv->page_labels[i])) {
 			*page_index = i;
+			ev_document_cache_reader_unlock (document, locked);
 			return TRUE;
 		}
 	}
@@ -1092,10 +1825,13 @@ ev_document_find_page_by_label (EvDocument  *document,
 		if (priv->page_labels[i] != NULL &&
 		    ! strcasecmp (page_label, priv->page_labels[i])) {
 			*page_index = i;
+			ev_document_cache_reader_unlock (document, locked);
 			return TRUE;
 		}
 	}
 
+	ev_document_cache_reader_unlock (document, locked);
+
 	/* Next, parse the label, and see if the number fits */
 	value = strtol (page_label, &endptr, 10);
 	if (endptr[0] == '\0') {
@@ -1113,6 +1849,234 @@ ev_document_find_page_by_label (EvDocument  *document,
 	return FALSE;
 }
 
+/**
+ * ev_document_is_cache_complete:
+ * @document: an #EvDocument
+ *
+ * Returns: %FALSE if @document was loaded with
+ * %EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE and the size or label of some of
+ * its pages is not known yet, %TRUE otherwise
+ *
+ * Since: 3.30
+ */
+gboolean
+ev_document_is_cache_complete (EvDocument *document)
+{
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), TRUE);
+
+	return !document->priv->cache_loaded ||
+		g_atomic_int_get (&document->priv->cache_complete);
+}
+
+/**
+ * ev_document_fill_cache:
+ * @document: an #EvDocument loaded with %EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE
+ * @max_pages: the maximum number of pages to cache
+ * @first_page: (out) (allow-none): return location for the first page cached, or %NULL
+ * @n_pages: (out) (allow-none): return location for the number of pages cached, or %NULL
+ *
+ * Caches the size and label of up to @max_pages more pages of @document.
+ * Until a page is cached, it's assumed to be the same size as the first
+ * page. The document lock is taken while the backend is queried, so it
+ * must not be held by the caller. Only one thread should fill the cache
+ * of a document at a time.
+ *
+ * Returns: %TRUE if all the pages of @document are cached
+ *
+ * Since: 3.30
+ */
+gboolean
+ev_document_fill_cache (EvDocument *document,
+			gint        max_pages,
+			gint       *first_page,
+			gint       *n_pages)
+{
+	EvDocumentPrivate *priv;
+	EvPageSize        *sizes;
+	gchar            **labels;
+	gint               first, last, i;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), TRUE);
+	g_return_val_if_fail (max_pages > 0, FALSE);
+
+	priv = document->priv;
+
+	if (first_page)
+		*first_page = priv->n_cached_pages;
+	if (n_pages)
+		*n_pages = 0;
+
+	if (ev_document_is_cache_complete (document))
+		return TRUE;
+
+	/* The backend is queried without the cache lock,
+	 * so that the cached pages can be read meanwhile */
+	first = priv->n_cached_pages;
+	last = MIN (first + max_pages, priv->n_pages);
+	sizes = g_new (EvPageSize, last - first);
+	labels = g_new (gchar *, last - first);
+
+	g_rw_lock_writer_lock (&priv->lock);
+	for (i = first; i < last; i++) {
+		ev_document_get_page_info (document, i,
+					   &sizes[i - first].width,
+					   &sizes[i - first].height,
+					   &labels[i - first]);
+	}
+	g_rw_lock_writer_unlock (&priv->lock);
+
+	g_rw_lock_writer_lock (&priv->cache_lock);
+	for (i = first; i < last; i++) {
+		ev_document_cache_page (document, i,
+					sizes[i - first].width,
+					sizes[i - first].height,
+					labels[i - first]);
+	}
+	priv->n_cached_pages = last;
+	if (last == priv->n_pages)
+		ev_document_finish_cache (document);
+	g_rw_lock_writer_unlock (&priv->cache_lock);
+
+	g_free (sizes);
+	g_free (labels);
+
+	if (last == priv->n_pages)
+		ev_document_save_page_geometry (document);
+
+	if (n_pages)
+		*n_pages = last - first;
+
+	return last == priv->n_pages;
+}
+
+/**
+ * ev_document_get_page_fingerprint:
+ * @document: an #EvDocument
+ * @page: an #EvPage of @document
+ *
+ * Gets a string identifying the contents of @page: two pages with the same
+ * fingerprint, in the same or in different documents, render the same.
+ * This is used to keep what was rendered for the pages that didn't change
+ * when a document is reloaded. Fingerprints are computed when the document
+ * is loaded and then remembered; if the backend has to be asked, the
+ * document mutex must be held by the caller like when rendering @page.
+ *
+ * Returns: (transfer full) (nullable): the fingerprint of @page, or %NULL
+ *   if the backend can't fingerprint it
+ *
+ * Since: 3.30
+ */
+gchar *
+ev_document_get_page_fingerprint (EvDocument *document,
+				  EvPage     *page)
+{
+	EvDocumentClass   *klass = EV_DOCUMENT_GET_CLASS (document);
+	EvDocumentPrivate *priv;
+	gchar             *fingerprint;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), NULL);
+	g_return_val_if_fail (EV_IS_PAGE (page), NULL);
+
+	priv = document->priv;
+	if (!klass->get_page_fingerprint || page->index < 0 || page->index >= priv->n_pages)
+		return NULL;
+
+	fingerprint = ev_document_lookup_page_fingerprint (document, page->index);
+	if (fingerprint)
+		return fingerprint;
+
+	fingerprint = klass->get_page_fingerprint (document, page);
+	if (!fingerprint)
+		return NULL;
+
+	g_mutex_lock (&priv->fingerprints_lock);
+	if (!priv->page_fingerprints) {
+		priv->n_fingerprints = priv->n_pages;
+		priv->page_fingerprints = g_new0 (gchar *, priv->n_fingerprints);
+		priv->fingerprint_pages = g_hash_table_new (g_str_hash, g_str_equal);
+	}
+	if (!priv->page_fingerprints[page->index]) {
+		priv->page_fingerprints[page->index] = g_strdup (fingerprint);
+		/* Identical pages, blank ones for example, map to the first one */
+		if (!g_hash_table_contains (priv->fingerprint_pages, fingerprint))
+			g_hash_table_insert (priv->fingerprint_pages,
+					     priv->page_fingerprints[page->index],
+					     GINT_TO_POINTER (page->index));
+	}
+	g_mutex_unlock (&priv->fingerprints_lock);
+
+	return fingerprint;
+}
+
+/**
+ * ev_document_lookup_page_fingerprint:
+ * @document: an #EvDocument
+ * @page_index: the index of a page of @document
+ *
+ * Like ev_document_get_page_fingerprint(), but the backend is never asked,
+ * so it can be called from any thread, even when the document file has
+ * changed since it was loaded.
+ *
+ * Returns: (transfer full) (nullable): the fingerprint of page @page_index
+ *   if it has been computed already, or %NULL
+ *
+ * Since: 3.30
+ */
+gchar *
+ev_document_lookup_page_fingerprint (EvDocument *document,
+				     gint        page_index)
+{
+	EvDocumentPrivate *priv;
+	gchar             *fingerprint = NULL;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), NULL);
+
+	priv = document->priv;
+	if (page_index < 0)
+		return NULL;
+
+	g_mutex_lock (&priv->fingerprints_lock);
+	if (page_index < priv->n_fingerprints)
+		fingerprint = g_strdup (priv->page_fingerprints[page_index]);
+	g_mutex_unlock (&priv->fingerprints_lock);
+
+	return fingerprint;
+}
+
+/**
+ * ev_document_find_page_by_fingerprint:
+ * @document: an #EvDocument
+ * @fingerprint: a page fingerprint, as returned by ev_document_get_page_fingerprint()
+ *
+ * Finds a page of @document with the given fingerprint among the pages whose
+ * fingerprint has been computed already.
+ *
+ * Returns: the index of the page, or -1 if no such page is known
+ *
+ * Since: 3.30
+ */
+gint
+ev_document_find_page_by_fingerprint (EvDocument  *document,
+				      const gchar *fingerprint)
+{
+	EvDocumentPrivate *priv;
+	gpointer           page_index;
+	gint               retval = -1;
+
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), -1);
+	g_return_val_if_fail (fingerprint != NULL, -1);
+
+	priv = document->priv;
+
+	g_mutex_lock (&priv->fingerprints_lock);
+	if (priv->fingerprint_pages &&
+	    g_hash_table_lookup_extended (priv->fingerprint_pages, fingerprint, NULL, &page_index))
+		retval = GPOINTER_TO_INT (page_index);
+	g_mutex_unlock (&priv->fingerprints_lock);
+
+	return retval;
+}
+
 /* EvSourceLink */
 G_DEFINE_BOXED_TYPE (EvSourceLink, ev_source_link, ev_source_link_copy, ev_source_link_free)
 
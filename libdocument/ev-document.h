@@ -54,9 +54,23 @@ typedef struct _EvDocumentPrivate EvDocumentPrivate;
 #define EV_DOC_MUTEX_LOCK (ev_document_doc_mutex_lock ())
 #define EV_DOC_MUTEX_UNLOCK (ev_document_doc_mutex_unlock ())
 
+/**
+ * EvDocumentLoadFlags:
+ * @EV_DOCUMENT_LOAD_FLAG_NONE: no flags
+ * @EV_DOCUMENT_LOAD_FLAG_NO_CACHE: don't cache the page sizes and labels
+ *   when loading, they are cached the first time they are needed
+ * @EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE: only cache the size and label of the
+ *   first page when loading, the rest are cached with ev_document_fill_cache().
+ *   Since: 3.30
+ * @EV_DOCUMENT_LOAD_FLAG_PROBE: load just what's needed to get the document
+ *   info and render the first page, like for a thumbnail: nothing is cached,
+ *   the pages are not fingerprinted and synctex is not set up. Since: 3.30
+ */
 typedef enum /*< flags >*/ {
-        EV_DOCUMENT_LOAD_FLAG_NONE = 0,
-        EV_DOCUMENT_LOAD_FLAG_NO_CACHE
+        EV_DOCUMENT_LOAD_FLAG_NONE       = 0,
+        EV_DOCUMENT_LOAD_FLAG_NO_CACHE   = 1 << 0,
+        EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE = 1 << 1,
+        EV_DOCUMENT_LOAD_FLAG_PROBE      = 1 << 2
 } EvDocumentLoadFlags;
 
 typedef enum
@@ -117,6 +131,9 @@ struct _EvDocumentClass
         gboolean          (* get_backend_info)      (EvDocument          *document,
 						     EvDocumentBackendInfo *info);
         gboolean	  (* support_synctex)       (EvDocument          *document);
+        gboolean          (* is_thread_safe)        (EvDocument          *document);
+        gboolean          (* supports_render_area)  (EvDocument          *document);
+        gboolean          (* supports_worker_copies) (EvDocument         *document);
 
         /* GIO streams */
         gboolean          (* load_stream)           (EvDocument          *document,
@@ -131,6 +148,8 @@ struct _EvDocumentClass
 						     GError             **error);
 	cairo_surface_t * (* get_thumbnail_surface) (EvDocument          *document,
 						     EvRenderContext     *rc);
+	gchar           * (* get_page_fingerprint)  (EvDocument          *document,
+						     EvPage              *page);
 };
 
 GType            ev_document_get_type             (void) G_GNUC_CONST;
@@ -142,6 +161,16 @@ void             ev_document_doc_mutex_lock       (void);
 void             ev_document_doc_mutex_unlock     (void);
 gboolean         ev_document_doc_mutex_trylock    (void);
 
+/* Per-document lock */
+void             ev_document_lock                 (EvDocument      *document);
+void             ev_document_unlock               (EvDocument      *document);
+gboolean         ev_document_trylock              (EvDocument      *document);
+void             ev_document_render_lock          (EvDocument      *document);
+void             ev_document_render_unlock        (EvDocument      *document);
+gboolean         ev_document_is_thread_safe       (EvDocument      *document);
+gboolean         ev_document_supports_render_area (EvDocument      *document);
+gboolean         ev_document_supports_worker_copies (EvDocument    *document);
+
 /* FontConfig mutex */
 GMutex          *ev_document_get_fc_mutex         (void);
 void             ev_document_fc_mutex_lock        (void);
@@ -171,6 +200,8 @@ gboolean         ev_document_load_gfile           (EvDocument         *document,
                                                    EvDocumentLoadFlags flags,
                                                    GCancellable       *cancellable,
                                                    GError            **error);
+void             _ev_document_set_uri             (EvDocument         *document,
+                                                   const gchar        *uri);
 gboolean         ev_document_save                 (EvDocument      *document,
 						   const char      *uri,
 						   GError         **error);
@@ -181,6 +212,10 @@ void             ev_document_get_page_size        (EvDocument      *document,
 						   gint             page_index,
 						   double          *width,
 						   double          *height);
+gboolean         ev_document_lookup_page_size     (EvDocument      *document,
+						   gint             page_index,
+						   double          *width,
+						   double          *height);
 gchar           *ev_document_get_page_label       (EvDocument      *document,
 						   gint             page_index);
 cairo_surface_t *ev_document_render               (EvDocument      *document,
@@ -205,6 +240,17 @@ gboolean         ev_document_has_text_page_labels (EvDocument      *document);
 gboolean         ev_document_find_page_by_label   (EvDocument      *document,
 						   const gchar     *page_label,
 						   gint            *page_index);
+gboolean         ev_document_is_cache_complete    (EvDocument      *document);
+gboolean         ev_document_fill_cache           (EvDocument      *document,
+						   gint             max_pages,
+						   gint            *first_page,
+						   gint            *n_pages);
+gchar           *ev_document_get_page_fingerprint (EvDocument      *document,
+						   EvPage          *page);
+gchar           *ev_document_lookup_page_fingerprint (EvDocument   *document,
+						      gint          page_index);
+gint             ev_document_find_page_by_fingerprint (EvDocument  *document,
+						       const gchar *fingerprint);
 gboolean	 ev_document_has_synctex 	  (EvDocument      *document);
 
 EvSourceLink    *ev_document_synctex_backward_search
@@ -82,3 +82,66 @@ ev_file_exporter_get_capabilities (EvFileExporter *exporter)
 
 	return iface->get_capabilities (exporter);
 }
+
+/**
+ * ev_file_exporter_can_render_pages:
+ * @exporter: an #EvFileExporter
+ *
+ * Returns: %TRUE if the pages of @exporter can be rendered with
+ *   ev_file_exporter_render_page() before they are exported
+ *
+ * Since: 3.30
+ */
+gboolean
+ev_file_exporter_can_render_pages (EvFileExporter *exporter)
+{
+	EvFileExporterInterface *iface = EV_FILE_EXPORTER_GET_IFACE (exporter);
+
+	return iface->render_page != NULL && iface->do_rendered_page != NULL;
+}
+
+/**
+ * ev_file_exporter_render_page:
+ * @exporter: an #EvFileExporter
+ * @rc: an #EvRenderContext
+ *
+ * Renders the page of @rc for exporting it later with
+ * ev_file_exporter_do_rendered_page(). It doesn't depend on the export
+ * in progress, so pages can be rendered in other threads while previous
+ * pages are exported, with the render lock of the document held.
+ *
+ * Returns: (transfer full) (nullable): a surface with the page, or %NULL
+ *
+ * Since: 3.30
+ */
+cairo_surface_t *
+ev_file_exporter_render_page (EvFileExporter  *exporter,
+			      EvRenderContext *rc)
+{
+	EvFileExporterInterface *iface = EV_FILE_EXPORTER_GET_IFACE (exporter);
+
+	if (!iface->render_page)
+		return NULL;
+
+	return iface->render_page (exporter, rc);
+}
+
+/**
+ * ev_file_exporter_do_rendered_page:
+ * @exporter: an #EvFileExporter
+ * @rc: an #EvRenderContext
+ * @surface: the page of @rc rendered with ev_file_exporter_render_page()
+ *
+ * Like ev_file_exporter_do_page(), with a page rendered in advance.
+ *
+ * Since: 3.30
+ */
+void
+ev_file_exporter_do_rendered_page (EvFileExporter  *exporter,
+				   EvRenderContext *rc,
+				   cairo_surface_t *surface)
+{
+	EvFileExporterInterface *iface = EV_FILE_EXPORTER_GET_IFACE (exporter);
+
+	iface->do_rendered_page (exporter, rc, surface);
+}
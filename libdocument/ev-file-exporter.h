@@ -86,6 +86,13 @@ struct _EvFileExporterInterface {
 	void                       (* end_page)         (EvFileExporter        *exporter);
         void                       (* end)              (EvFileExporter        *exporter);
 	EvFileExporterCapabilities (* get_capabilities) (EvFileExporter        *exporter);
+
+	/* Optional, to render pages ahead in other threads */
+	cairo_surface_t           *(* render_page)      (EvFileExporter        *exporter,
+							 EvRenderContext       *rc);
+	void                       (* do_rendered_page) (EvFileExporter        *exporter,
+							 EvRenderContext       *rc,
+							 cairo_surface_t       *surface);
 };
 
 GType                      ev_file_exporter_get_type         (void) G_GNUC_CONST;
@@ -97,6 +104,12 @@ void                       ev_file_exporter_do_page          (EvFileExporter
 void                       ev_file_exporter_end_page         (EvFileExporter        *exporter);
 void                       ev_file_exporter_end              (EvFileExporter        *exporter);
 EvFileExporterCapabilities ev_file_exporter_get_capabilities (EvFileExporter        *exporter);
+gboolean                   ev_file_exporter_can_render_pages (EvFileExporter        *exporter);
+cairo_surface_t           *ev_file_exporter_render_page      (EvFileExporter        *exporter,
+							      EvRenderContext       *rc);
+void                       ev_file_exporter_do_rendered_page (EvFileExporter        *exporter,
+							      EvRenderContext       *rc,
+							      cairo_surface_t       *surface);
 
 G_END_DECLS
 
@@ -30,6 +30,7 @@
 #include <glib/gi18n-lib.h>
 
 #include "ev-file-helpers.h"
+#include "ev-decompressor.h"
 
 static gchar *tmp_dir = NULL;
 
@@ -589,6 +590,72 @@ static const char *compressor_cmds[] = {
 #define N_ARGS      4
 #define BUFFER_SIZE 1024
 
+/* Size of the chunks written to the temporary file when decompressing
+ * in process */
+#define UNCOMPRESS_BUFFER_SIZE (64 * 1024)
+
+/* Decompresses @uri to @fd without running the decompressor command.
+ * Returns %FALSE without setting @error when @type can't be
+ * decompressed in process.
+ */
+static gboolean
+uncompress_in_process (const gchar       *uri,
+		       EvCompressionType  type,
+		       gint               fd,
+		       GError           **error)
+{
+	GFile        *file;
+	GInputStream *file_stream;
+	GInputStream *stream;
+	gchar        *buf;
+	gssize        bytes_read;
+	gboolean      write_failed = FALSE;
+
+	file = g_file_new_for_uri (uri);
+	file_stream = G_INPUT_STREAM (g_file_read (file, NULL, error));
+	g_object_unref (file);
+	if (!file_stream)
+		return TRUE;
+
+	stream = ev_file_uncompress_stream (file_stream, type, NULL);
+	g_object_unref (file_stream);
+	if (!stream)
+		return FALSE;
+
+	buf = g_malloc (UNCOMPRESS_BUFFER_SIZE);
+	while ((bytes_read = g_input_stream_read (stream, buf, UNCOMPRESS_BUFFER_SIZE,
+						  NULL, error)) > 0) {
+		gchar *p = buf;
+
+		while (bytes_read > 0) {
+			gssize written = write (fd, p, bytes_read);
+
+			if (written < 0) {
+				int errsv = errno;
+
+				if (errsv == EINTR)
+					continue;
+
+				g_set_error_literal (error, G_FILE_ERROR,
+						     g_file_error_from_errno (errsv),
+						     g_strerror (errsv));
+				write_failed = TRUE;
+				break;
+			}
+			p += written;
+			bytes_read -= written;
+		}
+
+		if (write_failed)
+			break;
+	}
+
+	g_free (buf);
+	g_object_unref (stream);
+
+	return TRUE;
+}
+
 static gchar *
 compression_run (const gchar       *uri,
 		 EvCompressionType  type,
@@ -605,6 +672,30 @@ compression_run (const gchar       *uri,
 	if (type == EV_COMPRESSION_NONE)
 		return NULL;
 
+	if (!compress) {
+		fd = ev_mkstemp ("comp.XXXXXX", &filename_dst, error);
+		if (fd == -1)
+			return NULL;
+
+		if (uncompress_in_process (uri, type, fd, &err)) {
+			close (fd);
+
+			if (err) {
+				g_propagate_error (error, err);
+				ev_tmp_filename_unlink (filename_dst);
+			} else {
+				uri_dst = g_filename_to_uri (filename_dst, NULL, error);
+			}
+			g_free (filename_dst);
+
+			return uri_dst;
+		}
+
+		close (fd);
+		ev_tmp_filename_unlink (filename_dst);
+		g_clear_pointer (&filename_dst, g_free);
+	}
+
 	cmd = g_find_program_in_path (compressor_cmds[type]);
 	if (!cmd) {
 		/* FIXME: better error codes! */
@@ -712,6 +803,47 @@ ev_file_uncompress (const gchar       *uri,
 	return compression_run (uri, type, FALSE, error);
 }
 
+/**
+ * ev_file_uncompress_stream:
+ * @stream: a #GInputStream
+ * @type: the compression type
+ * @error: a #GError location to store an error, or %NULL
+ *
+ * Creates a stream returning the data of @stream decompressed, without
+ * running any external command nor writing the decompressed data to
+ * disk.
+ *
+ * If @type can't be decompressed in process, it returns %NULL and
+ * fills in @error with %G_IO_ERROR_NOT_SUPPORTED.
+ *
+ * Returns: (transfer full): a new #GInputStream, or %NULL on error
+ *
+ * Since: 3.30
+ */
+GInputStream *
+ev_file_uncompress_stream (GInputStream      *stream,
+			   EvCompressionType  type,
+			   GError           **error)
+{
+	GConverter   *converter;
+	GInputStream *retval;
+
+	g_return_val_if_fail (G_IS_INPUT_STREAM (stream), NULL);
+
+	converter = _ev_decompressor_new (type);
+	if (!converter) {
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			     "Decompressing \"%s\" files is not supported",
+			     type == EV_COMPRESSION_NONE ? "uncompressed" : compressor_cmds[type]);
+		return NULL;
+	}
+
+	retval = g_converter_input_stream_new (stream, converter);
+	g_object_unref (converter);
+
+	return retval;
+}
+
 /**
  * ev_file_compress:
  * @uri: a file URI
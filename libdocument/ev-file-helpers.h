@@ -65,6 +65,9 @@ gchar       *ev_file_get_mime_type    (const gchar       *uri,
 gchar       *ev_file_uncompress       (const gchar       *uri,
 				       EvCompressionType  type,
 				       GError           **error);
+GInputStream *ev_file_uncompress_stream (GInputStream     *stream,
+				       EvCompressionType  type,
+				       GError           **error);
 gchar       *ev_file_compress         (const gchar       *uri,
 				       EvCompressionType  type,
 				       GError           **error);
@@ -29,6 +29,7 @@
 #include "ev-document-factory.h"
 #include "ev-debug.h"
 #include "ev-file-helpers.h"
+#include "ev-surface-pool.h"
 
 static int ev_init_count;
 
@@ -142,6 +143,7 @@ ev_shutdown (void)
         _ev_document_factory_shutdown ();
         _ev_file_helpers_shutdown ();
         _ev_debug_shutdown ();
+        _ev_surface_pool_clear ();
 }
 
 /*
@@ -18,6 +18,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include <math.h>
+
 #include "ev-mapping-list.h"
 
 /**
@@ -26,11 +28,40 @@
  *
  * Since: 3.8
  */
+
+/* Lists with fewer mappings than this are just walked */
+#define MIN_INDEXED_MAPPINGS 32
+#define MAX_GRID_SIZE        256
+
+/* Uniform grid over the bounding box of the mappings. Every cell holds
+ * the positions in the list of the mappings overlapping it, in list
+ * order. Mappings covering a big part of the grid are kept apart and
+ * checked on every query instead of being added to most cells.
+ */
+typedef struct {
+	EvMapping **mappings;
+	guint       n_mappings;
+
+	gdouble     x1, y1, x2, y2;
+	gdouble     cell_width;
+	gdouble     cell_height;
+	guint       n_cols;
+	guint       n_rows;
+
+	guint      *cell_start;
+	guint      *cells;
+
+	guint      *large;
+	guint       n_large;
+} EvMappingIndex;
+
 struct _EvMappingList {
-	guint          page;
-	GList         *list;
-	GDestroyNotify data_destroy_func;
-	volatile gint  ref_count;
+	guint           page;
+	GList          *list;
+	GDestroyNotify  data_destroy_func;
+	volatile gint   ref_count;
+
+	EvMappingIndex *index;
 };
 
 G_DEFINE_BOXED_TYPE (EvMappingList, ev_mapping_list, ev_mapping_list_ref, ev_mapping_list_unref)
@@ -123,6 +154,262 @@ cmp_mapping_area_size (EvMapping *a,
 	return (wa * ha < wb * hb) ? -1 : 1;
 }
 
+static void
+ev_mapping_index_free (EvMappingIndex *grid)
+{
+	g_free (grid->mappings);
+	g_free (grid->cell_start);
+	g_free (grid->cells);
+	g_free (grid->large);
+	g_slice_free (EvMappingIndex, grid);
+}
+
+static void
+ev_mapping_index_get_cells (EvMappingIndex    *grid,
+			    const EvRectangle *area,
+			    guint             *col1,
+			    guint             *row1,
+			    guint             *col2,
+			    guint             *row2)
+{
+	gdouble x1 = MIN (area->x1, area->x2);
+	gdouble x2 = MAX (area->x1, area->x2);
+	gdouble y1 = MIN (area->y1, area->y2);
+	gdouble y2 = MAX (area->y1, area->y2);
+
+	*col1 = (guint) CLAMP ((x1 - grid->x1) / grid->cell_width, 0, grid->n_cols - 1);
+	*col2 = (guint) CLAMP ((x2 - grid->x1) / grid->cell_width, 0, grid->n_cols - 1);
+	*row1 = (guint) CLAMP ((y1 - grid->y1) / grid->cell_height, 0, grid->n_rows - 1);
+	*row2 = (guint) CLAMP ((y2 - grid->y1) / grid->cell_height, 0, grid->n_rows - 1);
+}
+
+static EvMappingIndex *
+ev_mapping_index_new (GList *list,
+		      guint  n_mappings)
+{
+	EvMappingIndex *grid;
+	guint          *fill;
+	gboolean       *is_large;
+	guint           n_cells, grid_size;
+	guint           i;
+
+	grid = g_slice_new0 (EvMappingIndex);
+	grid->n_mappings = n_mappings;
+	grid->mappings = g_new (EvMapping *, n_mappings);
+
+	for (i = 0; list; list = list->next, i++) {
+		EvMapping *mapping = list->data;
+
+		grid->mappings[i] = mapping;
+		if (i == 0) {
+			grid->x1 = MIN (mapping->area.x1, mapping->area.x2);
+			grid->y1 = MIN (mapping->area.y1, mapping->area.y2);
+			grid->x2 = MAX (mapping->area.x1, mapping->area.x2);
+			grid->y2 = MAX (mapping->area.y1, mapping->area.y2);
+		} else {
+			grid->x1 = MIN (grid->x1, MIN (mapping->area.x1, mapping->area.x2));
+			grid->y1 = MIN (grid->y1, MIN (mapping->area.y1, mapping->area.y2));
+			grid->x2 = MAX (grid->x2, MAX (mapping->area.x1, mapping->area.x2));
+			grid->y2 = MAX (grid->y2, MAX (mapping->area.y1, mapping->area.y2));
+		}
+	}
+
+	/* About one mapping per cell */
+	grid_size = CLAMP ((guint) ceil (sqrt (n_mappings)), 1, MAX_GRID_SIZE);
+	grid->n_cols = grid_size;
+	grid->n_rows = grid_size;
+	grid->cell_width = (grid->x2 - grid->x1) / grid_size;
+	grid->cell_height = (grid->y2 - grid->y1) / grid_size;
+	if (grid->cell_width <= 0)
+		grid->cell_width = 1;
+	if (grid->cell_height <= 0)
+		grid->cell_height = 1;
+
+	n_cells = grid->n_cols * grid->n_rows;
+	grid->cell_start = g_new0 (guint, n_cells + 1);
+	is_large = g_new0 (gboolean, n_mappings);
+
+	/* Count the mappings of every cell, then fill them in */
+	for (i = 0; i < n_mappings; i++) {
+		guint col1, row1, col2, row2, row, col;
+
+		ev_mapping_index_get_cells (grid, &grid->mappings[i]->area,
+					    &col1, &row1, &col2, &row2);
+		if (n_cells >= 16 && (col2 - col1 + 1) * (row2 - row1 + 1) > n_cells / 4) {
+			is_large[i] = TRUE;
+			grid->n_large++;
+			continue;
+		}
+
+		for (row = row1; row <= row2; row++) {
+			for (col = col1; col <= col2; col++)
+				grid->cell_start[row * grid->n_cols + col + 1]++;
+		}
+	}
+
+	for (i = 0; i < n_cells; i++)
+		grid->cell_start[i + 1] += grid->cell_start[i];
+
+	grid->cells = g_new (guint, grid->cell_start[n_cells]);
+	grid->large = g_new (guint, grid->n_large);
+	fill = g_memdup (grid->cell_start, n_cells * sizeof (guint));
+	grid->n_large = 0;
+
+	for (i = 0; i < n_mappings; i++) {
+		guint col1, row1, col2, row2, row, col;
+
+		if (is_large[i]) {
+			grid->large[grid->n_large++] = i;
+			continue;
+		}
+
+		ev_mapping_index_get_cells (grid, &grid->mappings[i]->area,
+					    &col1, &row1, &col2, &row2);
+		for (row = row1; row <= row2; row++) {
+			for (col = col1; col <= col2; col++)
+				grid->cells[fill[row * grid->n_cols + col]++] = i;
+		}
+	}
+
+	g_free (fill);
+	g_free (is_large);
+
+	return grid;
+}
+
+static EvMappingIndex *
+ev_mapping_list_get_index (EvMappingList *mapping_list)
+{
+	guint n_mappings;
+
+	if (mapping_list->index)
+		return mapping_list->index;
+
+	n_mappings = g_list_length (mapping_list->list);
+	if (n_mappings < MIN_INDEXED_MAPPINGS)
+		return NULL;
+
+	mapping_list->index = ev_mapping_index_new (mapping_list->list, n_mappings);
+
+	return mapping_list->index;
+}
+
+static inline gboolean
+mapping_contains_point (EvMapping *mapping,
+			gdouble    x,
+			gdouble    y)
+{
+	return (x >= mapping->area.x1) &&
+		(y >= mapping->area.y1) &&
+		(x <= mapping->area.x2) &&
+		(y <= mapping->area.y2);
+}
+
+static inline gboolean
+mapping_overlaps_area (EvMapping         *mapping,
+		       const EvRectangle *area)
+{
+	return (mapping->area.x1 <= area->x2) &&
+		(mapping->area.y1 <= area->y2) &&
+		(mapping->area.x2 >= area->x1) &&
+		(mapping->area.y2 >= area->y1);
+}
+
+static EvMapping *
+ev_mapping_index_get (EvMappingIndex *grid,
+		      gdouble         x,
+		      gdouble         y)
+{
+	EvRectangle point = { x, y, x, y };
+	EvMapping  *found = NULL;
+	guint       col, row, cell;
+	guint       i, end, j;
+
+	if (x < grid->x1 || x > grid->x2 || y < grid->y1 || y > grid->y2)
+		return NULL;
+
+	ev_mapping_index_get_cells (grid, &point, &col, &row, &col, &row);
+	cell = row * grid->n_cols + col;
+	i = grid->cell_start[cell];
+	end = grid->cell_start[cell + 1];
+	j = 0;
+
+	/* Visit the candidates in list order, merging the ones of the
+	 * cell and the large ones, so that the same mapping as walking
+	 * the whole list is chosen */
+	while (i < end || j < grid->n_large) {
+		EvMapping *mapping;
+
+		if (j == grid->n_large ||
+		    (i < end && grid->cells[i] < grid->large[j]))
+			mapping = grid->mappings[grid->cells[i++]];
+		else
+			mapping = grid->mappings[grid->large[j++]];
+
+		if (mapping_contains_point (mapping, x, y) &&
+		    (found == NULL || cmp_mapping_area_size (mapping, found) < 0))
+			found = mapping;
+	}
+
+	return found;
+}
+
+static gint
+compare_positions (gconstpointer a,
+		   gconstpointer b)
+{
+	guint pa = *(const guint *) a;
+	guint pb = *(const guint *) b;
+
+	return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+static GList *
+ev_mapping_index_get_in_area (EvMappingIndex    *grid,
+			      const EvRectangle *area)
+{
+	GArray *positions;
+	GList  *retval = NULL;
+	guint   col1, row1, col2, row2, row, col;
+	guint   i;
+
+	if (area->x2 < grid->x1 || area->x1 > grid->x2 ||
+	    area->y2 < grid->y1 || area->y1 > grid->y2)
+		return NULL;
+
+	positions = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	ev_mapping_index_get_cells (grid, area, &col1, &row1, &col2, &row2);
+	for (row = row1; row <= row2; row++) {
+		for (col = col1; col <= col2; col++) {
+			guint cell = row * grid->n_cols + col;
+
+			for (i = grid->cell_start[cell]; i < grid->cell_start[cell + 1]; i++) {
+				if (mapping_overlaps_area (grid->mappings[grid->cells[i]], area))
+					g_array_append_val (positions, grid->cells[i]);
+			}
+		}
+	}
+	for (i = 0; i < grid->n_large; i++) {
+		if (mapping_overlaps_area (grid->mappings[grid->large[i]], area))
+			g_array_append_val (positions, grid->large[i]);
+	}
+
+	/* Mappings spanning several cells are found more than once */
+	g_array_sort (positions, compare_positions);
+	for (i = positions->len; i > 0; i--) {
+		guint position = g_array_index (positions, guint, i - 1);
+
+		if (i < positions->len &&
+		    position == g_array_index (positions, guint, i))
+			continue;
+		retval = g_list_prepend (retval, grid->mappings[position]);
+	}
+	g_array_free (positions, TRUE);
+
+	return retval;
+}
+
 /**
  * ev_mapping_list_get:
  * @mapping_list: an #EvMappingList
@@ -140,16 +427,18 @@ ev_mapping_list_get (EvMappingList *mapping_list,
 {
 	GList *list;
 	EvMapping *found = NULL;
+	EvMappingIndex *grid;
 
 	g_return_val_if_fail (mapping_list != NULL, NULL);
+
+	grid = ev_mapping_list_get_index (mapping_list);
+	if (grid)
+		return ev_mapping_index_get (grid, x, y);
 	
 	for (list = mapping_list->list; list; list = list->next) {
 		EvMapping *mapping = list->data;
 
-		if ((x >= mapping->area.x1) &&
-		    (y >= mapping->area.y1) &&
-		    (x <= mapping->area.x2) &&
-		    (y <= mapping->area.y2)) {
+		if (mapping_contains_point (mapping, x, y)) {
 
 			/* In case of only one match choose that. Otherwise
 			 * compare the area of the bounding boxes and return the
@@ -162,6 +451,60 @@ ev_mapping_list_get (EvMappingList *mapping_list,
 	return found;
 }
 
+/**
+ * ev_mapping_list_get_in_area:
+ * @mapping_list: an #EvMappingList
+ * @area: an #EvRectangle
+ *
+ * Returns: (transfer container) (element-type EvMapping): a new #GList
+ *   with the #EvMapping<!-- -->s in the list overlapping @area, in list order
+ *
+ * Since: 3.30
+ */
+GList *
+ev_mapping_list_get_in_area (EvMappingList     *mapping_list,
+			     const EvRectangle *area)
+{
+	GList *list;
+	GList *retval = NULL;
+	EvMappingIndex *grid;
+
+	g_return_val_if_fail (mapping_list != NULL, NULL);
+	g_return_val_if_fail (area != NULL, NULL);
+
+	grid = ev_mapping_list_get_index (mapping_list);
+	if (grid)
+		return ev_mapping_index_get_in_area (grid, area);
+
+	for (list = mapping_list->list; list; list = list->next) {
+		EvMapping *mapping = list->data;
+
+		if (mapping_overlaps_area (mapping, area))
+			retval = g_list_prepend (retval, mapping);
+	}
+
+	return g_list_reverse (retval);
+}
+
+/**
+ * ev_mapping_list_changed:
+ * @mapping_list: an #EvMappingList
+ *
+ * Notifies @mapping_list that mappings were added to its list, or that
+ * the area of any of its mappings changed. It must be called after
+ * modifying the list returned by ev_mapping_list_get_list() or a
+ * mapping's area, so that lookups by coordinates see the changes.
+ *
+ * Since: 3.30
+ */
+void
+ev_mapping_list_changed (EvMappingList *mapping_list)
+{
+	g_return_if_fail (mapping_list != NULL);
+
+	g_clear_pointer (&mapping_list->index, ev_mapping_index_free);
+}
+
 /**
  * ev_mapping_list_get_data:
  * @mapping_list: an #EvMappingList
@@ -208,6 +551,7 @@ ev_mapping_list_remove (EvMappingList *mapping_list,
 			EvMapping     *mapping)
 {
 	mapping_list->list = g_list_remove (mapping_list->list, mapping);
+	g_clear_pointer (&mapping_list->index, ev_mapping_index_free);
         mapping_list->data_destroy_func (mapping->data);
         g_free (mapping);
 }
@@ -248,6 +592,7 @@ ev_mapping_list_new (guint          page,
 	mapping_list->list = list;
 	mapping_list->data_destroy_func = data_destroy_func;
 	mapping_list->ref_count = 1;
+	mapping_list->index = NULL;
 
 	return mapping_list;
 }
@@ -282,6 +627,8 @@ ev_mapping_list_unref (EvMappingList *mapping_list)
 				(GFunc)mapping_list_free_foreach,
 				mapping_list->data_destroy_func);
 		g_list_free (mapping_list->list);
+		if (mapping_list->index)
+			ev_mapping_index_free (mapping_list->index);
 		g_slice_free (EvMappingList, mapping_list);
 	}
 }
@@ -52,6 +52,9 @@ EvMapping     *ev_mapping_list_find_custom (EvMappingList *mapping_list,
 EvMapping     *ev_mapping_list_get         (EvMappingList *mapping_list,
 					    gdouble        x,
 					    gdouble        y);
+GList         *ev_mapping_list_get_in_area (EvMappingList     *mapping_list,
+					    const EvRectangle *area);
+void           ev_mapping_list_changed     (EvMappingList *mapping_list);
 gpointer       ev_mapping_list_get_data    (EvMappingList *mapping_list,
 					    gdouble        x,
 					    gdouble        y);
@@ -0,0 +1,474 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "ev-page-geometry.h"
+
+/* The page geometry of the documents opened recently is kept in the
+ * user cache directory, one file per document URI, so that opening a
+ * large document again doesn't need to ask the backend for the size
+ * and label of every page. A file is only used while the document
+ * keeps the same inode, size and modification time. The least recently
+ * used files are removed when the directory grows too large.
+ *
+ * A cache file is written in host byte order:
+ *
+ *   GeometryHeader
+ *   gchar               the document URI, NUL terminated and padded to 8 bytes
+ *   EvPageSize          n_pages, only when the sizes are not uniform
+ *   guint32             n_pages label offsets from the start of the labels,
+ *                       G_MAXUINT32 for pages without a label
+ *   gchar               the NUL terminated labels
+ */
+
+#define GEOMETRY_MAGIC      "EvGeo001"
+#define GEOMETRY_BYTE_ORDER 0x01020304
+#define GEOMETRY_BACKEND_SIZE 64
+#define GEOMETRY_NO_LABEL   G_MAXUINT32
+
+#define GEOMETRY_QUERY_ATTRIBUTES		\
+	G_FILE_ATTRIBUTE_UNIX_INODE ","		\
+	G_FILE_ATTRIBUTE_STANDARD_SIZE ","	\
+	G_FILE_ATTRIBUTE_TIME_MODIFIED ","	\
+	G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+enum {
+	GEOMETRY_UNIFORM    = 1 << 0,
+	GEOMETRY_HAS_LABELS = 1 << 1
+};
+
+typedef struct {
+	gchar   magic[8];
+	guint32 byte_order;
+	guint32 n_pages;
+	gchar   backend[GEOMETRY_BACKEND_SIZE];
+	guint64 inode;
+	guint64 size;
+	guint64 mtime;
+	guint32 mtime_usec;
+	guint32 flags;
+	gdouble uniform_width;
+	gdouble uniform_height;
+	gdouble max_width;
+	gdouble max_height;
+	gdouble min_width;
+	gdouble min_height;
+	gint32  max_label;
+	guint32 uri_len;
+	guint64 sizes_offset;
+	guint64 label_offsets_offset;
+	guint64 labels_offset;
+	guint64 labels_size;
+} GeometryHeader;
+
+typedef struct {
+	gchar  *path;
+	gint64  atime;
+	guint64 size;
+} CacheEntry;
+
+static gchar *
+get_cache_dir (void)
+{
+	return g_build_filename (g_get_user_cache_dir (), "evince",
+				 "page-geometry", NULL);
+}
+
+static gchar *
+get_cache_path (const gchar *uri)
+{
+	gchar *dir, *name, *path;
+
+	dir = get_cache_dir ();
+	name = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+	path = g_build_filename (dir, name, NULL);
+	g_free (dir);
+	g_free (name);
+
+	return path;
+}
+
+/* Fills in the fields of @header identifying the document */
+static gboolean
+header_set_file_identity (GeometryHeader *header,
+			  const gchar    *uri,
+			  const gchar    *backend)
+{
+	GFile     *file;
+	GFileInfo *info;
+
+	if (strlen (backend) >= GEOMETRY_BACKEND_SIZE)
+		return FALSE;
+
+	file = g_file_new_for_uri (uri);
+	info = g_file_query_info (file, GEOMETRY_QUERY_ATTRIBUTES,
+				  G_FILE_QUERY_INFO_NONE, NULL, NULL);
+	g_object_unref (file);
+	if (!info)
+		return FALSE;
+
+	/* Without a modification time changes can't be detected */
+	if (!g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_TIME_MODIFIED)) {
+		g_object_unref (info);
+		return FALSE;
+	}
+
+	memset (header->backend, 0, GEOMETRY_BACKEND_SIZE);
+	g_strlcpy (header->backend, backend, GEOMETRY_BACKEND_SIZE);
+	header->inode = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE);
+	header->size = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+	header->mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+	header->mtime_usec = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+	g_object_unref (info);
+
+	return TRUE;
+}
+
+static inline void
+byte_array_align (GByteArray *data,
+		  guint       alignment)
+{
+	static const guint8 zeros[8] = { 0, };
+
+	if (data->len % alignment)
+		g_byte_array_append (data, zeros, alignment - data->len % alignment);
+}
+
+/**
+ * _ev_page_geometry_load:
+ * @uri: the document URI
+ * @backend: the type name of the document backend
+ * @geometry: the #EvPageGeometry to fill in, with n_pages set to the
+ *     number of pages of the document
+ *
+ * Reads the cached page geometry of the document at @uri, if it didn't
+ * change since it was saved. The page sizes and labels of @geometry are
+ * newly allocated.
+ *
+ * Returns: %TRUE if @geometry was filled in
+ */
+gboolean
+_ev_page_geometry_load (const gchar    *uri,
+			const gchar    *backend,
+			EvPageGeometry *geometry)
+{
+	GeometryHeader        identity;
+	const GeometryHeader *header;
+	GMappedFile          *file;
+	const gchar          *data;
+	gsize                 size;
+	gchar                *path;
+	gboolean              uniform, has_labels;
+	guint                 n_pages = geometry->n_pages;
+	guint                 i;
+
+	if (!header_set_file_identity (&identity, uri, backend))
+		return FALSE;
+
+	path = get_cache_path (uri);
+	file = g_mapped_file_new (path, FALSE, NULL);
+	if (!file) {
+		g_free (path);
+		return FALSE;
+	}
+
+	data = g_mapped_file_get_contents (file);
+	size = g_mapped_file_get_length (file);
+	header = (const GeometryHeader *)data;
+
+	if (size < sizeof (GeometryHeader) ||
+	    memcmp (header->magic, GEOMETRY_MAGIC, sizeof (header->magic)) != 0 ||
+	    header->byte_order != GEOMETRY_BYTE_ORDER ||
+	    header->n_pages != n_pages ||
+	    strncmp (header->backend, identity.backend, GEOMETRY_BACKEND_SIZE) != 0 ||
+	    header->inode != identity.inode ||
+	    header->size != identity.size ||
+	    header->mtime != identity.mtime ||
+	    header->mtime_usec != identity.mtime_usec ||
+	    header->uri_len != strlen (uri) ||
+	    size - sizeof (GeometryHeader) <= header->uri_len ||
+	    strncmp (data + sizeof (GeometryHeader), uri, header->uri_len + 1) != 0) {
+		g_mapped_file_unref (file);
+		g_free (path);
+
+		return FALSE;
+	}
+
+	uniform = (header->flags & GEOMETRY_UNIFORM) != 0;
+	has_labels = (header->flags & GEOMETRY_HAS_LABELS) != 0;
+
+	if ((!uniform &&
+	     (header->sizes_offset % 8 != 0 ||
+	      header->sizes_offset > size ||
+	      (size - header->sizes_offset) / sizeof (EvPageSize) < n_pages)) ||
+	    (has_labels &&
+	     (header->label_offsets_offset % 4 != 0 ||
+	      header->label_offsets_offset > size ||
+	      (size - header->label_offsets_offset) / sizeof (guint32) < n_pages ||
+	      header->labels_offset > size ||
+	      size - header->labels_offset < header->labels_size))) {
+		g_mapped_file_unref (file);
+		g_free (path);
+
+		return FALSE;
+	}
+
+	geometry->page_sizes = NULL;
+	geometry->page_labels = NULL;
+
+	if (has_labels) {
+		const guint32 *offsets;
+		const gchar   *labels;
+
+		offsets = (const guint32 *)(data + header->label_offsets_offset);
+		labels = data + header->labels_offset;
+
+		geometry->page_labels = g_new0 (gchar *, n_pages + 1);
+		for (i = 0; i < n_pages; i++) {
+			const gchar *label;
+
+			if (offsets[i] == GEOMETRY_NO_LABEL)
+				continue;
+
+			label = offsets[i] < header->labels_size ?
+				memchr (labels + offsets[i], '\0', header->labels_size - offsets[i]) :
+				NULL;
+			if (!label) {
+				g_strfreev (geometry->page_labels);
+				geometry->page_labels = NULL;
+				g_mapped_file_unref (file);
+				g_free (path);
+
+				return FALSE;
+			}
+
+			geometry->page_labels[i] = g_strdup (labels + offsets[i]);
+		}
+	}
+
+	if (!uniform) {
+		geometry->page_sizes = g_memdup (data + header->sizes_offset,
+						 n_pages * sizeof (EvPageSize));
+	}
+
+	geometry->uniform = uniform;
+	geometry->uniform_width = header->uniform_width;
+	geometry->uniform_height = header->uniform_height;
+	geometry->max_width = header->max_width;
+	geometry->max_height = header->max_height;
+	geometry->min_width = header->min_width;
+	geometry->min_height = header->min_height;
+	geometry->max_label = header->max_label;
+
+	g_mapped_file_unref (file);
+
+	/* The access time is not reliable, the modification time of the
+	 * cache file is used as the last time it was used instead */
+	g_utime (path, NULL);
+	g_free (path);
+
+	return TRUE;
+}
+
+/**
+ * _ev_page_geometry_save:
+ * @uri: the document URI
+ * @backend: the type name of the document backend
+ * @geometry: the page geometry of the document
+ * @error: (allow-none): a #GError
+ *
+ * Writes @geometry to the cache file of the document at @uri.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+_ev_page_geometry_save (const gchar          *uri,
+			const gchar          *backend,
+			const EvPageGeometry *geometry,
+			GError              **error)
+{
+	GeometryHeader *header;
+	GByteArray     *data;
+	gchar          *path, *dir;
+	gboolean        retval;
+	guint           i;
+
+	data = g_byte_array_new ();
+	g_byte_array_set_size (data, sizeof (GeometryHeader));
+	memset (data->data, 0, data->len);
+
+	header = (GeometryHeader *)data->data;
+	if (!header_set_file_identity (header, uri, backend)) {
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			     "Cannot identify the document “%s”", uri);
+		g_byte_array_unref (data);
+
+		return FALSE;
+	}
+
+	memcpy (header->magic, GEOMETRY_MAGIC, sizeof (header->magic));
+	header->byte_order = GEOMETRY_BYTE_ORDER;
+	header->n_pages = geometry->n_pages;
+	header->flags = (geometry->uniform ? GEOMETRY_UNIFORM : 0) |
+		(geometry->page_labels ? GEOMETRY_HAS_LABELS : 0);
+	header->uniform_width = geometry->uniform_width;
+	header->uniform_height = geometry->uniform_height;
+	header->max_width = geometry->max_width;
+	header->max_height = geometry->max_height;
+	header->min_width = geometry->min_width;
+	header->min_height = geometry->min_height;
+	header->max_label = geometry->max_label;
+	header->uri_len = strlen (uri);
+
+	g_byte_array_append (data, (const guint8 *)uri, header->uri_len + 1);
+	byte_array_align (data, 8);
+
+	if (!geometry->uniform) {
+		header = (GeometryHeader *)data->data;
+		header->sizes_offset = data->len;
+		g_byte_array_append (data, (const guint8 *)geometry->page_sizes,
+				     geometry->n_pages * sizeof (EvPageSize));
+	}
+
+	if (geometry->page_labels) {
+		guint32 *offsets;
+		guint32  label_offsets_offset, labels_offset;
+
+		label_offsets_offset = data->len;
+		g_byte_array_set_size (data, data->len + geometry->n_pages * sizeof (guint32));
+		labels_offset = data->len;
+
+		offsets = g_new (guint32, geometry->n_pages);
+		for (i = 0; i < geometry->n_pages; i++) {
+			const gchar *label = geometry->page_labels[i];
+
+			if (!label) {
+				offsets[i] = GEOMETRY_NO_LABEL;
+				continue;
+			}
+
+			offsets[i] = data->len - labels_offset;
+			g_byte_array_append (data, (const guint8 *)label, strlen (label) + 1);
+		}
+		memcpy (data->data + label_offsets_offset, offsets,
+			geometry->n_pages * sizeof (guint32));
+		g_free (offsets);
+
+		header = (GeometryHeader *)data->data;
+		header->label_offsets_offset = label_offsets_offset;
+		header->labels_offset = labels_offset;
+		header->labels_size = data->len - labels_offset;
+	}
+
+	dir = get_cache_dir ();
+	if (g_mkdir_with_parents (dir, 0700) == -1) {
+		int errsv = errno;
+
+		g_set_error (error, G_FILE_ERROR,
+			     g_file_error_from_errno (errsv),
+			     "Failed to create directory “%s”: %s",
+			     dir, g_strerror (errsv));
+		g_free (dir);
+		g_byte_array_unref (data);
+
+		return FALSE;
+	}
+	g_free (dir);
+
+	path = get_cache_path (uri);
+	retval = g_file_set_contents (path, (const gchar *)data->data, data->len, error);
+	g_free (path);
+	g_byte_array_unref (data);
+
+	return retval;
+}
+
+static gint
+cmp_cache_entry (gconstpointer a,
+		 gconstpointer b)
+{
+	const CacheEntry *entry_a = a;
+	const CacheEntry *entry_b = b;
+
+	if (entry_a->atime == entry_b->atime)
+		return 0;
+
+	return entry_a->atime < entry_b->atime ? -1 : 1;
+}
+
+/**
+ * _ev_page_geometry_prune:
+ * @max_size: the maximum size of the cache directory in bytes
+ *
+ * Removes the least recently used cache files until the cache
+ * directory takes at most @max_size bytes.
+ */
+void
+_ev_page_geometry_prune (guint64 max_size)
+{
+	GDir        *dir;
+	GArray      *entries;
+	gchar       *dir_path;
+	const gchar *name;
+	guint64      total_size = 0;
+	guint        i;
+
+	dir_path = get_cache_dir ();
+	dir = g_dir_open (dir_path, 0, NULL);
+	if (!dir) {
+		g_free (dir_path);
+		return;
+	}
+
+	entries = g_array_new (FALSE, FALSE, sizeof (CacheEntry));
+	while ((name = g_dir_read_name (dir))) {
+		CacheEntry entry;
+		GStatBuf   buf;
+
+		entry.path = g_build_filename (dir_path, name, NULL);
+		if (g_stat (entry.path, &buf) == -1 || !S_ISREG (buf.st_mode)) {
+			g_free (entry.path);
+			continue;
+		}
+
+		entry.atime = buf.st_mtime;
+		entry.size = buf.st_size;
+		total_size += entry.size;
+		g_array_append_val (entries, entry);
+	}
+	g_dir_close (dir);
+	g_free (dir_path);
+
+	g_array_sort (entries, cmp_cache_entry);
+	for (i = 0; i < entries->len; i++) {
+		CacheEntry *entry = &g_array_index (entries, CacheEntry, i);
+
+		if (total_size > max_size && g_unlink (entry->path) == 0)
+			total_size -= entry->size;
+		g_free (entry->path);
+	}
+	g_array_free (entries, TRUE);
+}
@@ -0,0 +1,63 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#if !defined (EVINCE_COMPILATION)
+#error "This is a private header."
+#endif
+
+#ifndef EV_PAGE_GEOMETRY_H
+#define EV_PAGE_GEOMETRY_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _EvPageSize
+{
+	gdouble width;
+	gdouble height;
+} EvPageSize;
+
+/* The page sizes and labels EvDocument caches when loading a document */
+typedef struct {
+	guint       n_pages;
+	gboolean    uniform;
+	gdouble     uniform_width;
+	gdouble     uniform_height;
+	gdouble     max_width;
+	gdouble     max_height;
+	gdouble     min_width;
+	gdouble     min_height;
+	gint        max_label;
+	EvPageSize *page_sizes;  /* NULL when uniform */
+	gchar     **page_labels; /* NULL when the labels are the page numbers */
+} EvPageGeometry;
+
+gboolean _ev_page_geometry_load     (const gchar          *uri,
+				     const gchar          *backend,
+				     EvPageGeometry       *geometry);
+gboolean _ev_page_geometry_save     (const gchar          *uri,
+				     const gchar          *backend,
+				     const EvPageGeometry *geometry,
+				     GError              **error);
+void     _ev_page_geometry_prune    (guint64               max_size);
+
+G_END_DECLS
+
+#endif /* !EV_PAGE_GEOMETRY_H */
@@ -0,0 +1,1257 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include "ev-pixel-kernels.h"
+
+/* Pixel kernels work on rows, the vector implementations are chosen at
+ * runtime depending on the CPU. Every implementation must give exactly
+ * the same results as the scalar one, test-ev-pixel-kernels checks it.
+ *
+ * ARGB32 pixels are native endian 32 bit words, the vector
+ * implementations are only built for little endian CPUs.
+ */
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__ ((target ("sse2")))
+#define TARGET_AVX2 __attribute__ ((target ("avx2")))
+#endif
+
+#if defined (__ARM_NEON) && G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define HAVE_NEON_KERNELS 1
+#include <arm_neon.h>
+#endif
+
+#define ROTATE_TILE_SIZE 64
+
+typedef struct {
+	void (* invert_argb32)  (guint32       *pixels,
+				 gint           n_pixels);
+	void (* invert_rgba)    (guchar        *pixels,
+				 gint           n_pixels);
+	void (* invert_bytes)   (guchar        *data,
+				 gint           n_bytes);
+	void (* argb32_to_rgba) (const guint32 *src,
+				 guchar        *dest,
+				 gint           n_pixels);
+	void (* rgba_to_argb32) (const guchar  *src,
+				 guint32       *dest,
+				 gint           n_pixels);
+	void (* reverse_row)    (const guint32 *src,
+				 guint32       *dest,
+				 gint           n_pixels);
+	/* Writes the columns of the 4x4 block at src as rows, starting at
+	 * dest and moving dest_step pixels for every column */
+	void (* rotate_block)   (const guint32 *src,
+				 gint           src_stride,
+				 guint32       *dest,
+				 gint           dest_step,
+				 gboolean       reverse);
+	void (* accumulate)     (const guchar  *src,
+				 guint32       *sums,
+				 gint           n_bytes);
+	/* dest = origin + (target - origin) * alpha / 256, for every
+	 * channel, alpha from 0 to 256 */
+	void (* blend)          (const guint32 *origin,
+				 const guint32 *target,
+				 guint32       *dest,
+				 gint           n_pixels,
+				 guint          alpha);
+} EvPixelKernels;
+
+/* Scalar kernels */
+static inline guint8
+unpremultiply (guint c,
+	       guint a)
+{
+	return (c * 255 + a / 2) / a;
+}
+
+static inline guint8
+premultiply (guint c,
+	     guint a)
+{
+	guint t = c * a + 0x80;
+
+	return ((t >> 8) + t) >> 8;
+}
+
+static void
+invert_argb32_scalar (guint32 *pixels,
+		      gint     n_pixels)
+{
+	gint i;
+
+	/* Same as painting white with CAIRO_OPERATOR_DIFFERENCE */
+	for (i = 0; i < n_pixels; i++)
+		pixels[i] = ~pixels[i] | 0xff000000;
+}
+
+static void
+invert_rgba_scalar (guchar *pixels,
+		    gint    n_pixels)
+{
+	gint i;
+
+	for (i = 0; i < n_pixels; i++) {
+		pixels[i * 4] ^= 0xff;
+		pixels[i * 4 + 1] ^= 0xff;
+		pixels[i * 4 + 2] ^= 0xff;
+	}
+}
+
+static void
+invert_bytes_scalar (guchar *data,
+		     gint    n_bytes)
+{
+	gint i;
+
+	for (i = 0; i < n_bytes; i++)
+		data[i] ^= 0xff;
+}
+
+static void
+argb32_to_rgba_scalar (const guint32 *src,
+		       guchar        *dest,
+		       gint           n_pixels)
+{
+	gint i;
+
+	/* Same as gdk_pixbuf_get_from_surface() */
+	for (i = 0; i < n_pixels; i++, dest += 4) {
+		guint32 p = src[i];
+		guint   a = p >> 24;
+
+		if (a == 0) {
+			dest[0] = dest[1] = dest[2] = dest[3] = 0;
+		} else {
+			dest[0] = unpremultiply ((p >> 16) & 0xff, a);
+			dest[1] = unpremultiply ((p >> 8) & 0xff, a);
+			dest[2] = unpremultiply (p & 0xff, a);
+			dest[3] = a;
+		}
+	}
+}
+
+static void
+rgba_to_argb32_scalar (const guchar *src,
+		       guint32      *dest,
+		       gint          n_pixels)
+{
+	gint i;
+
+	/* Same as gdk_cairo_set_source_pixbuf() */
+	for (i = 0; i < n_pixels; i++, src += 4) {
+		guint a = src[3];
+
+		dest[i] = (a << 24) |
+			(premultiply (src[0], a) << 16) |
+			(premultiply (src[1], a) << 8) |
+			premultiply (src[2], a);
+	}
+}
+
+static void
+reverse_row_scalar (const guint32 *src,
+		    guint32       *dest,
+		    gint           n_pixels)
+{
+	gint i;
+
+	for (i = 0; i < n_pixels; i++)
+		dest[n_pixels - 1 - i] = src[i];
+}
+
+static void
+rotate_block_scalar (const guint32 *src,
+		     gint           src_stride,
+		     guint32       *dest,
+		     gint           dest_step,
+		     gboolean       reverse)
+{
+	gint x, y;
+
+	for (x = 0; x < 4; x++, dest += dest_step) {
+		for (y = 0; y < 4; y++)
+			dest[reverse ? 3 - y : y] = src[y * src_stride + x];
+	}
+}
+
+static void
+accumulate_scalar (const guchar *src,
+		   guint32      *sums,
+		   gint          n_bytes)
+{
+	gint i;
+
+	for (i = 0; i < n_bytes; i++)
+		sums[i] += src[i];
+}
+
+static void
+blend_scalar (const guint32 *origin,
+	      const guint32 *target,
+	      guint32       *dest,
+	      gint           n_pixels,
+	      guint          alpha)
+{
+	gint i;
+
+	/* Two channels at a time */
+	for (i = 0; i < n_pixels; i++) {
+		guint32 o = origin[i];
+		guint32 t = target[i];
+		guint32 rb, ag;
+
+		rb = ((o & 0xff00ff) * (256 - alpha) + (t & 0xff00ff) * alpha) >> 8;
+		ag = ((o >> 8) & 0xff00ff) * (256 - alpha) + ((t >> 8) & 0xff00ff) * alpha;
+		dest[i] = (rb & 0xff00ff) | (ag & 0xff00ff00);
+	}
+}
+
+static const EvPixelKernels scalar_kernels = {
+	invert_argb32_scalar,
+	invert_rgba_scalar,
+	invert_bytes_scalar,
+	argb32_to_rgba_scalar,
+	rgba_to_argb32_scalar,
+	reverse_row_scalar,
+	rotate_block_scalar,
+	accumulate_scalar,
+	blend_scalar
+};
+
+#ifdef HAVE_X86_KERNELS
+/* SSE2 kernels */
+static TARGET_SSE2 void
+invert_argb32_sse2 (guint32 *pixels,
+		    gint     n_pixels)
+{
+	const __m128i ones = _mm_set1_epi32 (-1);
+	const __m128i alpha = _mm_set1_epi32 (0xff000000);
+	gint          i;
+
+	for (i = 0; i + 4 <= n_pixels; i += 4) {
+		__m128i v = _mm_loadu_si128 ((const __m128i *)(pixels + i));
+
+		v = _mm_or_si128 (_mm_xor_si128 (v, ones), alpha);
+		_mm_storeu_si128 ((__m128i *)(pixels + i), v);
+	}
+
+	invert_argb32_scalar (pixels + i, n_pixels - i);
+}
+
+static TARGET_SSE2 void
+invert_rgba_sse2 (guchar *pixels,
+		  gint    n_pixels)
+{
+	const __m128i mask = _mm_set1_epi32 (0x00ffffff);
+	gint          i;
+
+	for (i = 0; i + 4 <= n_pixels; i += 4) {
+		__m128i v = _mm_loadu_si128 ((const __m128i *)(pixels + i * 4));
+
+		_mm_storeu_si128 ((__m128i *)(pixels + i * 4), _mm_xor_si128 (v, mask));
+	}
+
+	invert_rgba_scalar (pixels + i * 4, n_pixels - i);
+}
+
+static TARGET_SSE2 void
+invert_bytes_sse2 (guchar *data,
+		   gint    n_bytes)
+{
+	const __m128i ones = _mm_set1_epi32 (-1);
+	gint          i;
+
+	for (i = 0; i + 16 <= n_bytes; i += 16) {
+		__m128i v = _mm_loadu_si128 ((const __m128i *)(data + i));
+
+		_mm_storeu_si128 ((__m128i *)(data + i), _mm_xor_si128 (v, ones));
+	}
+
+	invert_bytes_scalar (data + i, n_bytes - i);
+}
+
+static TARGET_SSE2 void
+argb32_to_rgba_sse2 (const guint32 *src,
+		     guchar        *dest,
+		     gint           n_pixels)
+{
+	const __m128i alpha = _mm_set1_epi32 (0xff000000);
+	const __m128i ag = _mm_set1_epi32 (0xff00ff00);
+	const __m128i low = _mm_set1_epi32 (0xff);
+	gint          i;
+
+	/* Only runs of opaque pixels are vectorized, the division by
+	 * alpha is left to the scalar kernel */
+	for (i = 0; i + 4 <= n_pixels; i += 4) {
+		__m128i v = _mm_loadu_si128 ((const __m128i *)(src + i));
+
+		if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (_mm_and_si128 (v, alpha), alpha)) != 0xffff) {
+			argb32_to_rgba_scalar (src + i, dest + i * 4, 4);
+			continue;
+		}
+
+		v = _mm_or_si128 (_mm_and_si128 (v, ag),
+				  _mm_or_si128 (_mm_and_si128 (_mm_srli_epi32 (v, 16), low),
+						_mm_slli_epi32 (_mm_and_si128 (v, low), 16)));
+		_mm_storeu_si128 ((__m128i *)(dest + i * 4), v);
+	}
+
+	argb32_to_rgba_scalar (src + i, dest + i * 4, n_pixels - i);
+}
+
+static inline TARGET_SSE2 __m128i
+premultiply_sse2 (__m128i v,
+		  __m128i a)
+{
+	const __m128i round = _mm_set1_epi16 (0x80);
+	__m128i       t;
+
+	t = _mm_add_epi16 (_mm_mullo_epi16 (v, a), round);
+
+	return _mm_srli_epi16 (_mm_add_epi16 (t, _mm_srli_epi16 (t, 8)), 8);
+}
+
+static TARGET_SSE2 void
+rgba_to_argb32_sse2 (const guchar *src,
+		     guint32      *dest,
+		     gint          n_pixels)
+{
+	const __m128i zero = _mm_setzero_si128 ();
+	const __m128i alpha = _mm_set1_epi32 (0xff000000);
+	const __m128i green = _mm_set1_epi32 (0xff00);
+	const __m128i low = _mm_set1_epi32 (0xff);
+	gint          i;
+
+	for (i = 0; i + 4 <= n_pixels; i += 4) {
+		__m128i v, lo, hi, p;
+
+		v = _mm_loadu_si128 ((const __m128i *)(src + i * 4));
+		lo = _mm_unpacklo_epi8 (v, zero);
+		hi = _mm_unpackhi_epi8 (v, zero);
+		lo = premultiply_sse2 (lo, _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (lo, 0xff), 0xff));
+		hi = premultiply_sse2 (hi, _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (hi, 0xff), 0xff));
+		p = _mm_packus_epi16 (lo, hi);
+
+		/* RGBA bytes to native endian ARGB */
+		p = _mm_or_si128 (_mm_or_si128 (_mm_and_si128 (v, alpha),
+						_mm_and_si128 (p, green)),
+				  _mm_or_si128 (_mm_slli_epi32 (_mm_and_si128 (p, low), 16),
+						_mm_and_si128 (_mm_srli_epi32 (p, 16), low)));
+		_mm_storeu_si128 ((__m128i *)(dest + i), p);
+	}
+
+	rgba_to_argb32_scalar (src + i * 4, dest + i, n_pixels - i);
+}
+
+static TARGET_SSE2 void
+reverse_row_sse2 (const guint32 *src,
+		  guint32       *dest,
+		  gint           n_pixels)
+{
+	gint i;
+
+	for (i = 0; i + 4 <= n_pixels; i += 4) {
+		__m128i v = _mm_loadu_si128 ((const __m128i *)(src + i));
+
+		_mm_storeu_si128 ((__m128i *)(dest + n_pixels - 4 - i),
+				  _mm_shuffle_epi32 (v, _MM_SHUFFLE (0, 1, 2, 3)));
+	}
+
+	for (; i < n_pixels; i++)
+		dest[n_pixels - 1 - i] = src[i];
+}
+
+static TARGET_SSE2 void
+rotate_block_sse2 (const guint32 *src,
+		   gint           src_stride,
+		   guint32       *dest,
+		   gint           dest_step,
+		   gboolean       reverse)
+{
+	__m128i r0, r1, r2, r3, t0, t1, t2, t3, c[4];
+	gint    i;
+
+	r0 = _mm_loadu_si128 ((const __m128i *)src);
+	r1 = _mm_loadu_si128 ((const __m128i *)(src + src_stride));
+	r2 = _mm_loadu_si128 ((const __m128i *)(src + 2 * src_stride));
+	r3 = _mm_loadu_si128 ((const __m128i *)(src + 3 * src_stride));
+
+	t0 = _mm_unpacklo_epi32 (r0, r1);
+	t1 = _mm_unpacklo_epi32 (r2, r3);
+	t2 = _mm_unpackhi_epi32 (r0, r1);
+	t3 = _mm_unpackhi_epi32 (r2, r3);
+	c[0] = _mm_unpacklo_epi64 (t0, t1);
+	c[1] = _mm_unpackhi_epi64 (t0, t1);
+	c[2] = _mm_unpacklo_epi64 (t2, t3);
+	c[3] = _mm_unpackhi_epi64 (t2, t3);
+
+	for (i = 0; i < 4; i++, dest += dest_step) {
+		if (reverse)
+			c[i] = _mm_shuffle_epi32 (c[i], _MM_SHUFFLE (0, 1, 2, 3));
+		_mm_storeu_si128 ((__m128i *)dest, c[i]);
+	}
+}
+
+static TARGET_SSE2 void
+accumulate_sse2 (const guchar *src,
+		 guint32      *sums,
+		 gint          n_bytes)
+{
+	const __m128i zero = _mm_setzero_si128 ();
+	gint          i;
+
+	for (i = 0; i + 16 <= n_bytes; i += 16) {
+		__m128i v = _mm_loadu_si128 ((const __m128i *)(src + i));
+		__m128i lo = _mm_unpacklo_epi8 (v, zero);
+		__m128i hi = _mm_unpackhi_epi8 (v, zero);
+		__m128i *s = (__m128i *)(sums + i);
+
+		_mm_storeu_si128 (s, _mm_add_epi32 (_mm_loadu_si128 (s), _mm_unpacklo_epi16 (lo, zero)));
+		_mm_storeu_si128 (s + 1, _mm_add_epi32 (_mm_loadu_si128 (s + 1), _mm_unpackhi_epi16 (lo, zero)));
+		_mm_storeu_si128 (s + 2, _mm_add_epi32 (_mm_loadu_si128 (s + 2), _mm_unpacklo_epi16 (hi, zero)));
+		_mm_storeu_si128 (s + 3, _mm_add_epi32 (_mm_loadu_si128 (s + 3), _mm_unpackhi_epi16 (hi, zero)));
+	}
+
+	accumulate_scalar (src + i, sums + i, n_bytes - i);
+}
+
+static TARGET_SSE2 void
+blend_sse2 (const guint32 *origin,
+	    const guint32 *target,
+	    guint32       *dest,
+	    gint           n_pixels,
+	    guint          alpha)
+{
+	const __m128i zero = _mm_setzero_si128 ();
+	const __m128i a = _mm_set1_epi16 (alpha);
+	const __m128i ia = _mm_set1_epi16 (256 - alpha);
+	gint          i;
+
+	for (i = 0; i + 4 <= n_pixels; i += 4) {
+		__m128i o = _mm_loadu_si128 ((const __m128i *)(origin + i));
+		__m128i t = _mm_loadu_si128 ((const __m128i *)(target + i));
+		__m128i lo, hi;
+
+		lo = _mm_add_epi16 (_mm_mullo_epi16 (_mm_unpacklo_epi8 (o, zero), ia),
+				    _mm_mullo_epi16 (_mm_unpacklo_epi8 (t, zero), a));
+		hi = _mm_add_epi16 (_mm_mullo_epi16 (_mm_unpackhi_epi8 (o, zero), ia),
+				    _mm_mullo_epi16 (_mm_unpackhi_epi8 (t, zero), a));
+		_mm_storeu_si128 ((__m128i *)(dest + i),
+				  _mm_packus_epi16 (_mm_srli_epi16 (lo, 8),
+						    _mm_srli_epi16 (hi, 8)));
+	}
+
+	blend_scalar (origin + i, target + i, dest + i, n_pixels - i, alpha);
+}
+
+static const EvPixelKernels sse2_kernels = {
+	invert_argb32_sse2,
+	invert_rgba_sse2,
+	invert_bytes_sse2,
+	argb32_to_rgba_sse2,
+	rgba_to_argb32_sse2,
+	reverse_row_sse2,
+	rotate_block_sse2,
+	accumulate_sse2,
+	blend_sse2
+};
+
+/* AVX2 kernels, the rotation is done with the SSE2 ones */
+static TARGET_AVX2 void
+invert_argb32_avx2 (guint32 *pixels,
+		    gint     n_pixels)
+{
+	const __m256i ones = _mm256_set1_epi32 (-1);
+	const __m256i alpha = _mm256_set1_epi32 (0xff000000);
+	gint          i;
+
+	for (i = 0; i + 8 <= n_pixels; i += 8) {
+		__m256i v = _mm256_loadu_si256 ((const __m256i *)(pixels + i));
+
+		v = _mm256_or_si256 (_mm256_xor_si256 (v, ones), alpha);
+		_mm256_storeu_si256 ((__m256i *)(pixels + i), v);
+	}
+
+	invert_argb32_scalar (pixels + i, n_pixels - i);
+}
+
+static TARGET_AVX2 void
+invert_rgba_avx2 (guchar *pixels,
+		  gint    n_pixels)
+{
+	const __m256i mask = _mm256_set1_epi32 (0x00ffffff);
+	gint          i;
+
+	for (i = 0; i + 8 <= n_pixels; i += 8) {
+		__m256i v = _mm256_loadu_si256 ((const __m256i *)(pixels + i * 4));
+
+		_mm256_storeu_si256 ((__m256i *)(pixels + i * 4), _mm256_xor_si256 (v, mask));
+	}
+
+	invert_rgba_scalar (pixels + i * 4, n_pixels - i);
+}
+
+static TARGET_AVX2 void
+invert_bytes_avx2 (guchar *data,
+		   gint    n_bytes)
+{
+	const __m256i ones = _mm256_set1_epi32 (-1);
+	gint          i;
+
+	for (i = 0; i + 32 <= n_bytes; i += 32) {
+		__m256i v = _mm256_loadu_si256 ((const __m256i *)(data + i));
+
+		_mm256_storeu_si256 ((__m256i *)(data + i), _mm256_xor_si256 (v, ones));
+	}
+
+	invert_bytes_scalar (data + i, n_bytes - i);
+}
+
+static TARGET_AVX2 void
+argb32_to_rgba_avx2 (const guint32 *src,
+		     guchar        *dest,
+		     gint           n_pixels)
+{
+	const __m256i alpha = _mm256_set1_epi32 (0xff000000);
+	const __m256i ag = _mm256_set1_epi32 (0xff00ff00);
+	const __m256i low = _mm256_set1_epi32 (0xff);
+	gint          i;
+
+	for (i = 0; i + 8 <= n_pixels; i += 8) {
+		__m256i v = _mm256_loadu_si256 ((const __m256i *)(src + i));
+
+		if (_mm256_movemask_epi8 (_mm256_cmpeq_epi32 (_mm256_and_si256 (v, alpha), alpha)) != -1) {
+			argb32_to_rgba_scalar (src + i, dest + i * 4, 8);
+			continue;
+		}
+
+		v = _mm256_or_si256 (_mm256_and_si256 (v, ag),
+				     _mm256_or_si256 (_mm256_and_si256 (_mm256_srli_epi32 (v, 16), low),
+						      _mm256_slli_epi32 (_mm256_and_si256 (v, low), 16)));
+		_mm256_storeu_si256 ((__m256i *)(dest + i * 4), v);
+	}
+
+	argb32_to_rgba_scalar (src + i, dest + i * 4, n_pixels - i);
+}
+
+static inline TARGET_AVX2 __m256i
+premultiply_avx2 (__m256i v,
+		  __m256i a)
+{
+	const __m256i round = _mm256_set1_epi16 (0x80);
+	__m256i       t;
+
+	t = _mm256_add_epi16 (_mm256_mullo_epi16 (v, a), round);
+
+	return _mm256_srli_epi16 (_mm256_add_epi16 (t, _mm256_srli_epi16 (t, 8)), 8);
+}
+
+static TARGET_AVX2 void
+rgba_to_argb32_avx2 (const guchar *src,
+		     guint32      *dest,
+		     gint          n_pixels)
+{
+	const __m256i zero = _mm256_setzero_si256 ();
+	const __m256i alpha = _mm256_set1_epi32 (0xff000000);
+	const __m256i green = _mm256_set1_epi32 (0xff00);
+	const __m256i low = _mm256_set1_epi32 (0xff);
+	gint          i;
+
+	/* Unpacking and packing work within 128 bit lanes, so the pixel
+	 * order is kept */
+	for (i = 0; i + 8 <= n_pixels; i += 8) {
+		__m256i v, lo, hi, p;
+
+		v = _mm256_loadu_si256 ((const __m256i *)(src + i * 4));
+		lo = _mm256_unpacklo_epi8 (v, zero);
+		hi = _mm256_unpackhi_epi8 (v, zero);
+		lo = premultiply_avx2 (lo, _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (lo, 0xff), 0xff));
+		hi = premultiply_avx2 (hi, _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (hi, 0xff), 0xff));
+		p = _mm256_packus_epi16 (lo, hi);
+
+		p = _mm256_or_si256 (_mm256_or_si256 (_mm256_and_si256 (v, alpha),
+						      _mm256_and_si256 (p, green)),
+				     _mm256_or_si256 (_mm256_slli_epi32 (_mm256_and_si256 (p, low), 16),
+						      _mm256_and_si256 (_mm256_srli_epi32 (p, 16), low)));
+		_mm256_storeu_si256 ((__m256i *)(dest + i), p);
+	}
+
+	rgba_to_argb32_scalar (src + i * 4, dest + i, n_pixels - i);
+}
+
+static TARGET_AVX2 void
+accumulate_avx2 (const guchar *src,
+		 guint32      *sums,
+		 gint          n_bytes)
+{
+	gint i;
+
+	for (i = 0; i + 8 <= n_bytes; i += 8) {
+		__m256i v = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *)(src + i)));
+		__m256i *s = (__m256i *)(sums + i);
+
+		_mm256_storeu_si256 (s, _mm256_add_epi32 (_mm256_loadu_si256 (s), v));
+	}
+
+	accumulate_scalar (src + i, sums + i, n_bytes - i);
+}
+
+static TARGET_AVX2 void
+blend_avx2 (const guint32 *origin,
+	    const guint32 *target,
+	    guint32       *dest,
+	    gint           n_pixels,
+	    guint          alpha)
+{
+	const __m256i zero = _mm256_setzero_si256 ();
+	const __m256i a = _mm256_set1_epi16 (alpha);
+	const __m256i ia = _mm256_set1_epi16 (256 - alpha);
+	gint          i;
+
+	/* Unpacking and packing are done within 128 bit lanes, so
+	 * the pixels keep their order */
+	for (i = 0; i + 8 <= n_pixels; i += 8) {
+		__m256i o = _mm256_loadu_si256 ((const __m256i *)(origin + i));
+		__m256i t = _mm256_loadu_si256 ((const __m256i *)(target + i));
+		__m256i lo, hi;
+
+		lo = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_unpacklo_epi8 (o, zero), ia),
+				       _mm256_mullo_epi16 (_mm256_unpacklo_epi8 (t, zero), a));
+		hi = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_unpackhi_epi8 (o, zero), ia),
+				       _mm256_mullo_epi16 (_mm256_unpackhi_epi8 (t, zero), a));
+		_mm256_storeu_si256 ((__m256i *)(dest + i),
+				     _mm256_packus_epi16 (_mm256_srli_epi16 (lo, 8),
+							  _mm256_srli_epi16 (hi, 8)));
+	}
+
+	blend_sse2 (origin + i, target + i, dest + i, n_pixels - i, alpha);
+}
+
+static const EvPixelKernels avx2_kernels = {
+	invert_argb32_avx2,
+	invert_rgba_avx2,
+	invert_bytes_avx2,
+	argb32_to_rgba_avx2,
+	rgba_to_argb32_avx2,
+	reverse_row_sse2,
+	rotate_block_sse2,
+	accumulate_avx2,
+	blend_avx2
+};
+#endif /* HAVE_X86_KERNELS */
+
+#ifdef HAVE_NEON_KERNELS
+/* NEON kernels */
+static void
+invert_argb32_neon (guint32 *pixels,
+		    gint     n_pixels)
+{
+	const uint32x4_t alpha = vdupq_n_u32 (0xff000000);
+	gint             i;
+
+	for (i = 0; i + 4 <= n_pixels; i += 4)
+		vst1q_u32 (pixels + i, vorrq_u32 (vmvnq_u32 (vld1q_u32 (pixels + i)), alpha));
+
+	invert_argb32_scalar (pixels + i, n_pixels - i);
+}
+
+static void
+invert_rgba_neon (guchar *pixels,
+		  gint    n_pixels)
+{
+	const uint32x4_t mask = vdupq_n_u32 (0x00ffffff);
+	gint             i;
+
+	for (i = 0; i + 4 <= n_pixels; i += 4) {
+		uint32x4_t v = vreinterpretq_u32_u8 (vld1q_u8 (pixels + i * 4));
+
+		vst1q_u8 (pixels + i * 4, vreinterpretq_u8_u32 (veorq_u32 (v, mask)));
+	}
+
+	invert_rgba_scalar (pixels + i * 4, n_pixels - i);
+}
+
+static void
+invert_bytes_neon (guchar *data,
+		   gint    n_bytes)
+{
+	gint i;
+
+	for (i = 0; i + 16 <= n_bytes; i += 16)
+		vst1q_u8 (data + i, vmvnq_u8 (vld1q_u8 (data + i)));
+
+	invert_bytes_scalar (data + i, n_bytes - i);
+}
+
+static void
+argb32_to_rgba_neon (const guint32 *src,
+		     guchar        *dest,
+		     gint           n_pixels)
+{
+	gint i;
+
+	for (i = 0; i + 16 <= n_pixels; i += 16) {
+		/* Native endian ARGB is B, G, R, A in memory */
+		uint8x16x4_t v = vld4q_u8 ((const guint8 *)(src + i));
+		uint8x8_t    a = vand_u8 (vget_low_u8 (v.val[3]), vget_high_u8 (v.val[3]));
+		uint8x16x4_t p;
+
+		a = vpmin_u8 (a, a);
+		a = vpmin_u8 (a, a);
+		a = vpmin_u8 (a, a);
+		if (vget_lane_u8 (a, 0) != 0xff) {
+			argb32_to_rgba_scalar (src + i, dest + i * 4, 16);
+			continue;
+		}
+
+		p.val[0] = v.val[2];
+		p.val[1] = v.val[1];
+		p.val[2] = v.val[0];
+		p.val[3] = v.val[3];
+		vst4q_u8 (dest + i * 4, p);
+	}
+
+	argb32_to_rgba_scalar (src + i, dest + i * 4, n_pixels - i);
+}
+
+static inline uint8x8_t
+premultiply_neon (uint8x8_t c,
+		  uint8x8_t a)
+{
+	uint16x8_t t = vaddq_u16 (vmull_u8 (c, a), vdupq_n_u16 (0x80));
+
+	return vshrn_n_u16 (vaddq_u16 (t, vshrq_n_u16 (t, 8)), 8);
+}
+
+static void
+rgba_to_argb32_neon (const guchar *src,
+		     guint32      *dest,
+		     gint          n_pixels)
+{
+	gint i;
+
+	for (i = 0; i + 8 <= n_pixels; i += 8) {
+		uint8x8x4_t v = vld4_u8 (src + i * 4);
+		uint8x8x4_t p;
+
+		p.val[0] = premultiply_neon (v.val[2], v.val[3]);
+		p.val[1] = premultiply_neon (v.val[1], v.val[3]);
+		p.val[2] = premultiply_neon (v.val[0], v.val[3]);
+		p.val[3] = v.val[3];
+		vst4_u8 ((guint8 *)(dest + i), p);
+	}
+
+	rgba_to_argb32_scalar (src + i * 4, dest + i, n_pixels - i);
+}
+
+static inline uint32x4_t
+reverse_neon (uint32x4_t v)
+{
+	v = vrev64q_u32 (v);
+
+	return vcombine_u32 (vget_high_u32 (v), vget_low_u32 (v));
+}
+
+static void
+reverse_row_neon (const guint32 *src,
+		  guint32       *dest,
+		  gint           n_pixels)
+{
+	gint i;
+
+	for (i = 0; i + 4 <= n_pixels; i += 4)
+		vst1q_u32 (dest + n_pixels - 4 - i, reverse_neon (vld1q_u32 (src + i)));
+
+	for (; i < n_pixels; i++)
+		dest[n_pixels - 1 - i] = src[i];
+}
+
+static void
+rotate_block_neon (const guint32 *src,
+		   gint           src_stride,
+		   guint32       *dest,
+		   gint           dest_step,
+		   gboolean       reverse)
+{
+	uint32x4x2_t t01, t23;
+	uint32x4_t   c[4];
+	gint         i;
+
+	t01 = vtrnq_u32 (vld1q_u32 (src), vld1q_u32 (src + src_stride));
+	t23 = vtrnq_u32 (vld1q_u32 (src + 2 * src_stride), vld1q_u32 (src + 3 * src_stride));
+	c[0] = vcombine_u32 (vget_low_u32 (t01.val[0]), vget_low_u32 (t23.val[0]));
+	c[1] = vcombine_u32 (vget_low_u32 (t01.val[1]), vget_low_u32 (t23.val[1]));
+	c[2] = vcombine_u32 (vget_high_u32 (t01.val[0]), vget_high_u32 (t23.val[0]));
+	c[3] = vcombine_u32 (vget_high_u32 (t01.val[1]), vget_high_u32 (t23.val[1]));
+
+	for (i = 0; i < 4; i++, dest += dest_step)
+		vst1q_u32 (dest, reverse ? reverse_neon (c[i]) : c[i]);
+}
+
+static void
+accumulate_neon (const guchar *src,
+		 guint32      *sums,
+		 gint          n_bytes)
+{
+	gint i;
+
+	for (i = 0; i + 8 <= n_bytes; i += 8) {
+		uint16x8_t v = vmovl_u8 (vld1_u8 (src + i));
+
+		vst1q_u32 (sums + i, vaddw_u16 (vld1q_u32 (sums + i), vget_low_u16 (v)));
+		vst1q_u32 (sums + i + 4, vaddw_u16 (vld1q_u32 (sums + i + 4), vget_high_u16 (v)));
+	}
+
+	accumulate_scalar (src + i, sums + i, n_bytes - i);
+}
+
+static inline uint8x8_t
+blend_neon_half (uint8x8_t o,
+		 uint8x8_t t,
+		 guint     alpha)
+{
+	uint16x8_t v;
+
+	v = vmulq_n_u16 (vmovl_u8 (o), 256 - alpha);
+	v = vmlaq_n_u16 (v, vmovl_u8 (t), alpha);
+
+	return vshrn_n_u16 (v, 8);
+}
+
+static void
+blend_neon (const guint32 *origin,
+	    const guint32 *target,
+	    guint32       *dest,
+	    gint           n_pixels,
+	    guint          alpha)
+{
+	gint i;
+
+	for (i = 0; i + 4 <= n_pixels; i += 4) {
+		uint8x16_t o = vld1q_u8 ((const uint8_t *)(origin + i));
+		uint8x16_t t = vld1q_u8 ((const uint8_t *)(target + i));
+
+		vst1q_u8 ((uint8_t *)(dest + i),
+			  vcombine_u8 (blend_neon_half (vget_low_u8 (o), vget_low_u8 (t), alpha),
+				       blend_neon_half (vget_high_u8 (o), vget_high_u8 (t), alpha)));
+	}
+
+	blend_scalar (origin + i, target + i, dest + i, n_pixels - i, alpha);
+}
+
+static const EvPixelKernels neon_kernels = {
+	invert_argb32_neon,
+	invert_rgba_neon,
+	invert_bytes_neon,
+	argb32_to_rgba_neon,
+	rgba_to_argb32_neon,
+	reverse_row_neon,
+	rotate_block_neon,
+	accumulate_neon,
+	blend_neon
+};
+#endif /* HAVE_NEON_KERNELS */
+
+/* Dispatch */
+static const EvPixelKernels *kernels_impls[EV_PIXEL_KERNELS_N_IMPLS] = {
+	&scalar_kernels,
+#ifdef HAVE_X86_KERNELS
+	&sse2_kernels,
+	&avx2_kernels,
+#else
+	NULL,
+	NULL,
+#endif
+#ifdef HAVE_NEON_KERNELS
+	&neon_kernels
+#else
+	NULL
+#endif
+};
+
+static EvPixelKernelsImpl kernels_impl;
+
+gboolean
+_ev_pixel_kernels_is_supported (EvPixelKernelsImpl impl)
+{
+	g_return_val_if_fail (impl < EV_PIXEL_KERNELS_N_IMPLS, FALSE);
+
+	if (!kernels_impls[impl])
+		return FALSE;
+
+	switch (impl) {
+#ifdef HAVE_X86_KERNELS
+	case EV_PIXEL_KERNELS_SSE2:
+#ifdef __x86_64__
+		return TRUE;
+#else
+		return __builtin_cpu_supports ("sse2") != 0;
+#endif
+	case EV_PIXEL_KERNELS_AVX2:
+		return __builtin_cpu_supports ("avx2") != 0;
+#endif
+	default:
+		return TRUE;
+	}
+}
+
+static const EvPixelKernels *
+get_kernels (void)
+{
+	static gsize initialized = 0;
+
+	if (g_once_init_enter (&initialized)) {
+		EvPixelKernelsImpl impl;
+
+		for (impl = EV_PIXEL_KERNELS_N_IMPLS - 1; impl > EV_PIXEL_KERNELS_SCALAR; impl--) {
+			if (_ev_pixel_kernels_is_supported (impl))
+				break;
+		}
+		kernels_impl = impl;
+
+		g_once_init_leave (&initialized, 1);
+	}
+
+	return kernels_impls[kernels_impl];
+}
+
+EvPixelKernelsImpl
+_ev_pixel_kernels_get_impl (void)
+{
+	get_kernels ();
+
+	return kernels_impl;
+}
+
+/* Only meant for tests and benchmarks, it's not thread safe */
+gboolean
+_ev_pixel_kernels_set_impl (EvPixelKernelsImpl impl)
+{
+	if (!_ev_pixel_kernels_is_supported (impl))
+		return FALSE;
+
+	get_kernels ();
+	kernels_impl = impl;
+
+	return TRUE;
+}
+
+const gchar *
+_ev_pixel_kernels_get_impl_name (EvPixelKernelsImpl impl)
+{
+	static const gchar *names[EV_PIXEL_KERNELS_N_IMPLS] = {
+		"scalar", "sse2", "avx2", "neon"
+	};
+
+	g_return_val_if_fail (impl < EV_PIXEL_KERNELS_N_IMPLS, NULL);
+
+	return names[impl];
+}
+
+/* Image operations */
+void
+_ev_pixels_invert_argb32 (guchar *data,
+			  gint    width,
+			  gint    height,
+			  gint    stride)
+{
+	const EvPixelKernels *kernels = get_kernels ();
+	gint                  y;
+
+	for (y = 0; y < height; y++)
+		kernels->invert_argb32 ((guint32 *)(data + y * stride), width);
+}
+
+void
+_ev_pixels_invert_rgb (guchar *data,
+		       gint    width,
+		       gint    height,
+		       gint    stride,
+		       gint    n_channels)
+{
+	const EvPixelKernels *kernels = get_kernels ();
+	gint                  y;
+
+	g_return_if_fail (n_channels == 3 || n_channels == 4);
+
+	for (y = 0; y < height; y++) {
+		if (n_channels == 4)
+			kernels->invert_rgba (data + y * stride, width);
+		else
+			kernels->invert_bytes (data + y * stride, width * 3);
+	}
+}
+
+void
+_ev_pixels_argb32_to_rgb (const guchar *src,
+			  gint          src_stride,
+			  guchar       *dest,
+			  gint          dest_stride,
+			  gint          n_channels,
+			  gint          width,
+			  gint          height)
+{
+	const EvPixelKernels *kernels = get_kernels ();
+	gint                  x, y;
+
+	g_return_if_fail (n_channels == 3 || n_channels == 4);
+
+	for (y = 0; y < height; y++) {
+		const guint32 *s = (const guint32 *)(src + y * src_stride);
+		guchar        *d = dest + y * dest_stride;
+
+		if (n_channels == 4) {
+			kernels->argb32_to_rgba (s, d, width);
+			continue;
+		}
+
+		for (x = 0; x < width; x++, d += 3) {
+			d[0] = s[x] >> 16;
+			d[1] = s[x] >> 8;
+			d[2] = s[x];
+		}
+	}
+}
+
+void
+_ev_pixels_rgb_to_argb32 (const guchar *src,
+			  gint          src_stride,
+			  gint          n_channels,
+			  guchar       *dest,
+			  gint          dest_stride,
+			  gint          width,
+			  gint          height)
+{
+	const EvPixelKernels *kernels = get_kernels ();
+	gint                  x, y;
+
+	g_return_if_fail (n_channels == 3 || n_channels == 4);
+
+	for (y = 0; y < height; y++) {
+		const guchar *s = src + y * src_stride;
+		guint32      *d = (guint32 *)(dest + y * dest_stride);
+
+		if (n_channels == 4) {
+			kernels->rgba_to_argb32 (s, d, width);
+			continue;
+		}
+
+		for (x = 0; x < width; x++, s += 3)
+			d[x] = 0xff000000 | (s[0] << 16) | (s[1] << 8) | s[2];
+	}
+}
+
+/* Rotates clockwise like cairo_rotate() does, a tile at a time so
+ * that both images are accessed with good locality */
+void
+_ev_pixels_rotate_argb32 (const guchar *src,
+			  gint          src_stride,
+			  gint          width,
+			  gint          height,
+			  guchar       *dest,
+			  gint          dest_stride,
+			  gint          rotation)
+{
+	const EvPixelKernels *kernels = get_kernels ();
+	const guint32        *s = (const guint32 *)src;
+	guint32              *d = (guint32 *)dest;
+	gint                  ss = src_stride / 4;
+	gint                  ds = dest_stride / 4;
+	gint                  tx, ty, x, y;
+
+	g_return_if_fail (src_stride % 4 == 0 && dest_stride % 4 == 0);
+
+	switch (rotation) {
+	case 0:
+		for (y = 0; y < height; y++)
+			memcpy (d + y * ds, s + y * ss, width * 4);
+		return;
+	case 180:
+		for (y = 0; y < height; y++)
+			kernels->reverse_row (s + y * ss, d + (height - 1 - y) * ds, width);
+		return;
+	case 90:
+	case 270:
+		break;
+	default:
+		g_return_if_reached ();
+	}
+
+	for (ty = 0; ty < height; ty += ROTATE_TILE_SIZE) {
+		gint y1 = MIN (ty + ROTATE_TILE_SIZE, height);
+
+		for (tx = 0; tx < width; tx += ROTATE_TILE_SIZE) {
+			gint x1 = MIN (tx + ROTATE_TILE_SIZE, width);
+
+			for (y = ty; y < y1; y += 4) {
+				for (x = tx; x < x1; x += 4) {
+					gint bx, by;
+
+					if (y + 4 <= y1 && x + 4 <= x1) {
+						if (rotation == 90)
+							kernels->rotate_block (s + y * ss + x, ss,
+									       d + x * ds + height - 4 - y,
+									       ds, TRUE);
+						else
+							kernels->rotate_block (s + y * ss + x, ss,
+									       d + (width - 1 - x) * ds + y,
+									       -ds, FALSE);
+						continue;
+					}
+
+					for (by = y; by < MIN (y + 4, y1); by++) {
+						for (bx = x; bx < MIN (x + 4, x1); bx++) {
+							if (rotation == 90)
+								d[bx * ds + height - 1 - by] = s[by * ss + bx];
+							else
+								d[(width - 1 - bx) * ds + by] = s[by * ss + bx];
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+/* Averages the source pixels covered by every destination pixel and
+ * stores the result rotated clockwise by @rotation, so that a scaled
+ * and rotated image is made in a single pass. @dest_width and
+ * @dest_height are the size before the rotation. The destination
+ * can't be larger than the source. */
+void
+_ev_pixels_downscale_rotate_argb32 (const guchar *src,
+				    gint          src_stride,
+				    gint          width,
+				    gint          height,
+				    guchar       *dest,
+				    gint          dest_stride,
+				    gint          dest_width,
+				    gint          dest_height,
+				    gint          rotation)
+{
+	const EvPixelKernels *kernels = get_kernels ();
+	guint32              *sums;
+	gint                  x, y, i;
+
+	g_return_if_fail (dest_width > 0 && dest_width <= width);
+	g_return_if_fail (dest_height > 0 && dest_height <= height);
+	g_return_if_fail (rotation == 0 || rotation == 90 ||
+			  rotation == 180 || rotation == 270);
+
+	sums = g_new (guint32, width * 4);
+
+	for (y = 0; y < dest_height; y++) {
+		gint    sy0 = (gint64) y * height / dest_height;
+		gint    sy1 = (gint64) (y + 1) * height / dest_height;
+		guchar *d;
+		gssize  step;
+
+		/* Where the pixel (0, y) goes, and the offset to (x + 1, y) */
+		switch (rotation) {
+		case 90:
+			d = dest + (dest_height - 1 - y) * 4;
+			step = dest_stride;
+			break;
+		case 180:
+			d = dest + (dest_height - 1 - y) * dest_stride + (dest_width - 1) * 4;
+			step = -4;
+			break;
+		case 270:
+			d = dest + (dest_width - 1) * dest_stride + y * 4;
+			step = -dest_stride;
+			break;
+		default:
+			d = dest + y * dest_stride;
+			step = 4;
+		}
+
+		memset (sums, 0, width * 4 * sizeof (guint32));
+		for (i = sy0; i < sy1; i++)
+			kernels->accumulate (src + i * src_stride, sums, width * 4);
+
+		for (x = 0; x < dest_width; x++, d += step) {
+			gint    sx0 = (gint64) x * width / dest_width;
+			gint    sx1 = (gint64) (x + 1) * width / dest_width;
+			guint64 count = (guint64) (sx1 - sx0) * (sy1 - sy0);
+			guint64 sum[4] = { 0, 0, 0, 0 };
+			gint    c;
+
+			for (i = sx0; i < sx1; i++) {
+				for (c = 0; c < 4; c++)
+					sum[c] += sums[i * 4 + c];
+			}
+
+			for (c = 0; c < 4; c++)
+				d[c] = (sum[c] + count / 2) / count;
+		}
+	}
+
+	g_free (sums);
+}
+
+/* Averages the source pixels covered by every destination pixel. The
+ * destination can't be larger than the source. */
+void
+_ev_pixels_downscale_argb32 (const guchar *src,
+			     gint          src_stride,
+			     gint          width,
+			     gint          height,
+			     guchar       *dest,
+			     gint          dest_stride,
+			     gint          dest_width,
+			     gint          dest_height)
+{
+	_ev_pixels_downscale_rotate_argb32 (src, src_stride, width, height,
+					    dest, dest_stride,
+					    dest_width, dest_height, 0);
+}
+
+/* Cross-fades two images of the same size, alpha is the weight of
+ * @target from 0 to 256 */
+void
+_ev_pixels_blend_argb32 (const guchar *origin,
+			 gint          origin_stride,
+			 const guchar *target,
+			 gint          target_stride,
+			 guchar       *dest,
+			 gint          dest_stride,
+			 gint          width,
+			 gint          height,
+			 guint         alpha)
+{
+	const EvPixelKernels *kernels = get_kernels ();
+	gint                  y;
+
+	g_return_if_fail (alpha <= 256);
+
+	for (y = 0; y < height; y++) {
+		kernels->blend ((const guint32 *)(origin + y * origin_stride),
+				(const guint32 *)(target + y * target_stride),
+				(guint32 *)(dest + y * dest_stride),
+				width, alpha);
+	}
+}
@@ -0,0 +1,105 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#if !defined (EVINCE_COMPILATION)
+#error "This is a private header."
+#endif
+
+#ifndef EV_PIXEL_KERNELS_H
+#define EV_PIXEL_KERNELS_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+	EV_PIXEL_KERNELS_SCALAR,
+	EV_PIXEL_KERNELS_SSE2,
+	EV_PIXEL_KERNELS_AVX2,
+	EV_PIXEL_KERNELS_NEON,
+	EV_PIXEL_KERNELS_N_IMPLS
+} EvPixelKernelsImpl;
+
+EvPixelKernelsImpl _ev_pixel_kernels_get_impl       (void);
+gboolean           _ev_pixel_kernels_set_impl       (EvPixelKernelsImpl impl);
+gboolean           _ev_pixel_kernels_is_supported   (EvPixelKernelsImpl impl);
+const gchar       *_ev_pixel_kernels_get_impl_name  (EvPixelKernelsImpl impl);
+
+/* ARGB32 and RGB24 are cairo image surface pixels, RGB and RGBA are
+ * GdkPixbuf pixels. Strides are in bytes. */
+void _ev_pixels_invert_argb32    (guchar       *data,
+				  gint          width,
+				  gint          height,
+				  gint          stride);
+void _ev_pixels_invert_rgb       (guchar       *data,
+				  gint          width,
+				  gint          height,
+				  gint          stride,
+				  gint          n_channels);
+void _ev_pixels_argb32_to_rgb    (const guchar *src,
+				  gint          src_stride,
+				  guchar       *dest,
+				  gint          dest_stride,
+				  gint          n_channels,
+				  gint          width,
+				  gint          height);
+void _ev_pixels_rgb_to_argb32    (const guchar *src,
+				  gint          src_stride,
+				  gint          n_channels,
+				  guchar       *dest,
+				  gint          dest_stride,
+				  gint          width,
+				  gint          height);
+void _ev_pixels_rotate_argb32    (const guchar *src,
+				  gint          src_stride,
+				  gint          width,
+				  gint          height,
+				  guchar       *dest,
+				  gint          dest_stride,
+				  gint          rotation);
+void _ev_pixels_downscale_argb32 (const guchar *src,
+				  gint          src_stride,
+				  gint          width,
+				  gint          height,
+				  guchar       *dest,
+				  gint          dest_stride,
+				  gint          dest_width,
+				  gint          dest_height);
+void _ev_pixels_downscale_rotate_argb32 (const guchar *src,
+					 gint          src_stride,
+					 gint          width,
+					 gint          height,
+					 guchar       *dest,
+					 gint          dest_stride,
+					 gint          dest_width,
+					 gint          dest_height,
+					 gint          rotation);
+void _ev_pixels_blend_argb32     (const guchar *origin,
+				  gint          origin_stride,
+				  const guchar *target,
+				  gint          target_stride,
+				  guchar       *dest,
+				  gint          dest_stride,
+				  gint          width,
+				  gint          height,
+				  guint         alpha);
+
+G_END_DECLS
+
+#endif /* !EV_PIXEL_KERNELS_H */
@@ -19,6 +19,7 @@
 
 #include <config.h>
 #include "ev-render-context.h"
+#include "ev-surface-pool.h"
 
 static void ev_render_context_init       (EvRenderContext      *rc);
 static void ev_render_context_class_init (EvRenderContextClass *class);
@@ -113,6 +114,29 @@ ev_render_context_set_target_size (EvRenderContext *rc,
 	rc->target_height = target_height;
 }
 
+/**
+ * ev_render_context_set_area:
+ * @rc: an #EvRenderContext
+ * @area: (allow-none): the area to render, or %NULL to render the whole page
+ *
+ * Restricts rendering to @area. The area is given in pixels of the
+ * rotated and scaled output, so that the surface returned by
+ * ev_document_render() is @area's size and its origin corresponds
+ * to (@area->x, @area->y) of the whole page.
+ *
+ * Since: 3.30
+ */
+void
+ev_render_context_set_area (EvRenderContext             *rc,
+			    const cairo_rectangle_int_t *area)
+{
+	g_return_if_fail (rc != NULL);
+
+	rc->has_area = area != NULL;
+	if (area)
+		rc->area = *area;
+}
+
 void
 ev_render_context_compute_scaled_size (EvRenderContext *rc,
 				       double		width_points,
@@ -180,3 +204,33 @@ ev_render_context_compute_scales (EvRenderContext *rc,
 	if (scale_y)
 		*scale_y = scaled_height / height_points;
 }
+
+/**
+ * ev_render_context_create_surface:
+ * @rc: an #EvRenderContext
+ * @format: the format of the surface
+ * @width: the width of the surface
+ * @height: the height of the surface
+ *
+ * Creates an image surface for rendering @rc into, for backends to use
+ * instead of cairo_image_surface_create() for the surface returned by
+ * ev_document_render() and for the images the page is decoded into.
+ * The pixels of %CAIRO_FORMAT_ARGB32 and %CAIRO_FORMAT_RGB24 surfaces
+ * are reused by the next surfaces of about the same size once they are
+ * destroyed, so the contents of the new surface are undefined and it
+ * must be painted completely.
+ *
+ * Returns: (transfer full): a new #cairo_surface_t
+ *
+ * Since: 3.30
+ */
+cairo_surface_t *
+ev_render_context_create_surface (EvRenderContext *rc,
+				  cairo_format_t   format,
+				  int              width,
+				  int              height)
+{
+	g_return_val_if_fail (rc != NULL, NULL);
+
+	return _ev_surface_pool_create_surface (format, width, height);
+}
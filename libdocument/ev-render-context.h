@@ -25,6 +25,7 @@
 #define EV_RENDER_CONTEXT_H
 
 #include <glib-object.h>
+#include <cairo.h>
 
 #include "ev-page.h"
 
@@ -52,6 +53,9 @@ struct _EvRenderContext
 	gdouble scale;
 	gint	target_width;
 	gint	target_height;
+
+	gboolean              has_area;
+	cairo_rectangle_int_t area;
 };
 
 
@@ -68,6 +72,8 @@ void             ev_render_context_set_scale       (EvRenderContext *rc,
 void             ev_render_context_set_target_size (EvRenderContext *rc,
                                                     int              target_width,
                                                     int              target_height);
+void             ev_render_context_set_area        (EvRenderContext             *rc,
+                                                    const cairo_rectangle_int_t *area);
 void             ev_render_context_compute_scaled_size      (EvRenderContext *rc,
                                                              double           width_points,
                                                              double           height_points,
@@ -83,6 +89,10 @@ void             ev_render_context_compute_scales  (EvRenderContext *rc,
                                                     double           height_points,
                                                     double          *scale_x,
                                                     double          *scale_y);
+cairo_surface_t *ev_render_context_create_surface  (EvRenderContext *rc,
+                                                    cairo_format_t   format,
+                                                    int              width,
+                                                    int              height);
 
 G_END_DECLS
 
@@ -0,0 +1,193 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <config.h>
+
+#include "ev-surface-pool.h"
+
+/* Enough for a few pages of a maximized window on a HiDPI screen */
+#define DEFAULT_MAX_SIZE (64 * 1024 * 1024)
+#define MAX_BUFFERS      8
+
+typedef struct {
+	guchar *data;
+	gsize   size;
+} PoolBuffer;
+
+static GMutex pool_mutex;
+static GQueue free_buffers = G_QUEUE_INIT; /* Most recently released first */
+static gsize  free_size;
+static gsize  max_size = DEFAULT_MAX_SIZE;
+static guint  n_allocated;
+static guint  n_reused;
+
+static const cairo_user_data_key_t buffer_key;
+
+static void
+pool_buffer_free (PoolBuffer *buffer)
+{
+	g_free (buffer->data);
+	g_slice_free (PoolBuffer, buffer);
+}
+
+/* Must be called with the mutex held */
+static void
+pool_trim (gsize size)
+{
+	while (free_size > size || g_queue_get_length (&free_buffers) > MAX_BUFFERS) {
+		PoolBuffer *buffer = g_queue_pop_tail (&free_buffers);
+
+		free_size -= buffer->size;
+		pool_buffer_free (buffer);
+	}
+}
+
+static void
+pool_buffer_release (PoolBuffer *buffer)
+{
+	g_mutex_lock (&pool_mutex);
+	if (buffer->size > max_size) {
+		pool_buffer_free (buffer);
+	} else {
+		g_queue_push_head (&free_buffers, buffer);
+		free_size += buffer->size;
+		pool_trim (max_size);
+	}
+	g_mutex_unlock (&pool_mutex);
+}
+
+/* The smallest free buffer that fits, as long as it doesn't waste more
+ * than a quarter of its size */
+static PoolBuffer *
+pool_buffer_take (gsize size)
+{
+	PoolBuffer *best = NULL;
+	GList      *l;
+
+	g_mutex_lock (&pool_mutex);
+	for (l = free_buffers.head; l; l = g_list_next (l)) {
+		PoolBuffer *buffer = l->data;
+
+		if (buffer->size < size || buffer->size - buffer->size / 4 > size)
+			continue;
+
+		if (!best || buffer->size < best->size)
+			best = buffer;
+	}
+
+	if (best) {
+		g_queue_remove (&free_buffers, best);
+		free_size -= best->size;
+		n_reused++;
+	}
+	g_mutex_unlock (&pool_mutex);
+
+	return best;
+}
+
+cairo_surface_t *
+_ev_surface_pool_create_surface (cairo_format_t format,
+				 gint           width,
+				 gint           height)
+{
+	cairo_surface_t *surface;
+	PoolBuffer      *buffer;
+	gint             stride;
+	gsize            size;
+
+	/* Only the pixels of the formats rendered by the backends are reused */
+	if (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24)
+		return cairo_image_surface_create (format, width, height);
+
+	stride = cairo_format_stride_for_width (format, width);
+	if (stride <= 0 || height <= 0 || (gsize) height > G_MAXSIZE / stride)
+		return cairo_image_surface_create (format, width, height);
+	size = (gsize) stride * height;
+
+	buffer = pool_buffer_take (size);
+	if (!buffer) {
+		guchar *data = g_try_malloc (size);
+
+		if (!data)
+			return cairo_image_surface_create (format, width, height);
+
+		buffer = g_slice_new (PoolBuffer);
+		buffer->data = data;
+		buffer->size = size;
+
+		g_mutex_lock (&pool_mutex);
+		n_allocated++;
+		g_mutex_unlock (&pool_mutex);
+	}
+
+	surface = cairo_image_surface_create_for_data (buffer->data, format,
+						       width, height, stride);
+	if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS ||
+	    cairo_surface_set_user_data (surface, &buffer_key, buffer,
+					 (cairo_destroy_func_t) pool_buffer_release) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy (surface);
+		pool_buffer_release (buffer);
+
+		return cairo_image_surface_create (format, width, height);
+	}
+
+	return surface;
+}
+
+/* The free buffers kept, the ones of surfaces alive are not counted */
+void
+_ev_surface_pool_set_max_size (gsize size)
+{
+	g_mutex_lock (&pool_mutex);
+	max_size = size;
+	pool_trim (max_size);
+	g_mutex_unlock (&pool_mutex);
+}
+
+gsize
+_ev_surface_pool_get_size (void)
+{
+	gsize size;
+
+	g_mutex_lock (&pool_mutex);
+	size = free_size;
+	g_mutex_unlock (&pool_mutex);
+
+	return size;
+}
+
+void
+_ev_surface_pool_get_stats (guint *allocated,
+			    guint *reused)
+{
+	g_mutex_lock (&pool_mutex);
+	if (allocated)
+		*allocated = n_allocated;
+	if (reused)
+		*reused = n_reused;
+	g_mutex_unlock (&pool_mutex);
+}
+
+void
+_ev_surface_pool_clear (void)
+{
+	g_mutex_lock (&pool_mutex);
+	pool_trim (0);
+	g_mutex_unlock (&pool_mutex);
+}
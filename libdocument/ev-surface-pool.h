@@ -0,0 +1,47 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#if !defined (EVINCE_COMPILATION)
+#error "This is a private header."
+#endif
+
+#ifndef EV_SURFACE_POOL_H
+#define EV_SURFACE_POOL_H
+
+#include <glib.h>
+#include <cairo.h>
+
+G_BEGIN_DECLS
+
+/* Image surfaces whose pixel buffers go back to a pool shared by the
+ * whole process when they are destroyed, to be reused by the next
+ * surfaces of about the same size instead of allocating and clearing
+ * new ones. The contents of a new surface are undefined. */
+cairo_surface_t *_ev_surface_pool_create_surface (cairo_format_t format,
+						  gint           width,
+						  gint           height);
+void             _ev_surface_pool_set_max_size   (gsize          max_size);
+gsize            _ev_surface_pool_get_size       (void);
+void             _ev_surface_pool_get_stats      (guint         *allocated,
+						  guint         *reused);
+void             _ev_surface_pool_clear          (void);
+
+G_END_DECLS
+
+#endif /* !EV_SURFACE_POOL_H */
@@ -0,0 +1,372 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <gio/gio.h>
+
+#include "ev-init.h"
+#include "ev-document-factory.h"
+#include "ev-cached-stream.h"
+
+#define DEFAULT_BANDWIDTH 1024 /* KiB/s */
+#define DEFAULT_LATENCY   50   /* ms */
+#define CHECK_SIZE        (8 * 1024 * 1024 + 123)
+#define CHECK_N_READS     2000
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Checks the cached stream and times showing remote documents\n");
+	g_print ("Usage: %s [FILE [BANDWIDTH [LATENCY]]]\n", prog);
+	g_print ("Reads FILE like a remote file, through a stream limited to BANDWIDTH\n"
+		 "KiB/s (default %d) with LATENCY ms (default %d) for every request, and\n"
+		 "reports the time until its first page is rendered when the file is\n"
+		 "downloaded first, and when it's read progressively\n",
+		 DEFAULT_BANDWIDTH, DEFAULT_LATENCY);
+}
+
+/* ThrottledStream: a local stand-in for a remote file, a read after
+ * a seek is a new request paying the latency */
+typedef struct {
+	GInputStream parent;
+
+	GInputStream *base;
+	gint64        bandwidth; /* bytes per second */
+	gint64        latency;   /* microseconds */
+	gboolean      new_request;
+} ThrottledStream;
+
+typedef GInputStreamClass ThrottledStreamClass;
+
+static GType throttled_stream_get_type (void);
+static void  throttled_stream_seekable_iface_init (GSeekableIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (ThrottledStream, throttled_stream, G_TYPE_INPUT_STREAM,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_SEEKABLE,
+						throttled_stream_seekable_iface_init))
+
+static gssize
+throttled_stream_read (GInputStream *input_stream,
+		       void         *buffer,
+		       gsize         count,
+		       GCancellable *cancellable,
+		       GError      **error)
+{
+	ThrottledStream *stream = (ThrottledStream *) input_stream;
+	gssize           n_read;
+
+	if (stream->new_request) {
+		g_usleep (stream->latency);
+		stream->new_request = FALSE;
+	}
+
+	n_read = g_input_stream_read (stream->base, buffer, count, cancellable, error);
+	if (n_read > 0)
+		g_usleep (n_read * G_USEC_PER_SEC / stream->bandwidth);
+
+	return n_read;
+}
+
+static void
+throttled_stream_finalize (GObject *object)
+{
+	g_object_unref (((ThrottledStream *) object)->base);
+
+	G_OBJECT_CLASS (throttled_stream_parent_class)->finalize (object);
+}
+
+static void
+throttled_stream_init (ThrottledStream *stream)
+{
+	stream->new_request = TRUE;
+}
+
+static void
+throttled_stream_class_init (ThrottledStreamClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = throttled_stream_finalize;
+	klass->read_fn = throttled_stream_read;
+}
+
+static goffset
+throttled_stream_tell (GSeekable *seekable)
+{
+	return g_seekable_tell (G_SEEKABLE (((ThrottledStream *) seekable)->base));
+}
+
+static gboolean
+throttled_stream_can_seek (GSeekable *seekable)
+{
+	return TRUE;
+}
+
+static gboolean
+throttled_stream_seek (GSeekable    *seekable,
+		       goffset       offset,
+		       GSeekType     type,
+		       GCancellable *cancellable,
+		       GError      **error)
+{
+	ThrottledStream *stream = (ThrottledStream *) seekable;
+	goffset          position = g_seekable_tell (G_SEEKABLE (stream->base));
+
+	if (!g_seekable_seek (G_SEEKABLE (stream->base), offset, type, cancellable, error))
+		return FALSE;
+
+	if (g_seekable_tell (G_SEEKABLE (stream->base)) != position)
+		stream->new_request = TRUE;
+
+	return TRUE;
+}
+
+static gboolean
+throttled_stream_can_truncate (GSeekable *seekable)
+{
+	return FALSE;
+}
+
+static void
+throttled_stream_seekable_iface_init (GSeekableIface *iface)
+{
+	iface->tell = throttled_stream_tell;
+	iface->can_seek = throttled_stream_can_seek;
+	iface->seek = throttled_stream_seek;
+	iface->can_truncate = throttled_stream_can_truncate;
+}
+
+static GInputStream *
+throttled_stream_new (GInputStream *base,
+		      gint64        bandwidth,
+		      gint64        latency)
+{
+	ThrottledStream *stream;
+
+	stream = g_object_new (throttled_stream_get_type (), NULL);
+	stream->base = g_object_ref (base);
+	stream->bandwidth = MAX (bandwidth, 1);
+	stream->latency = latency;
+
+	return G_INPUT_STREAM (stream);
+}
+
+/* Random reads through a cache smaller than the data, so that
+ * blocks are evicted and fetched again */
+static gboolean
+check_contents (void)
+{
+	GInputStream *base, *stream;
+	guint8       *data, *buffer;
+	GRand        *rand;
+	gboolean      retval = TRUE;
+	gint          i;
+
+	rand = g_rand_new_with_seed (42);
+	data = g_malloc (CHECK_SIZE);
+	for (i = 0; i < CHECK_SIZE; i++)
+		data[i] = g_rand_int (rand);
+	buffer = g_malloc (256 * 1024);
+
+	base = g_memory_input_stream_new_from_data (data, CHECK_SIZE, NULL);
+	stream = _ev_cached_stream_new (base, CHECK_SIZE, 0);
+	g_object_unref (base);
+
+	for (i = 0; i < CHECK_N_READS && retval; i++) {
+		goffset offset;
+		gsize   count, n_read;
+
+		/* Mostly sequential reads, like parsing a content stream */
+		if (i % 4 == 0) {
+			offset = g_rand_int_range (rand, 0, CHECK_SIZE);
+			g_seekable_seek (G_SEEKABLE (stream), offset, G_SEEK_SET, NULL, NULL);
+		}
+		offset = g_seekable_tell (G_SEEKABLE (stream));
+		count = g_rand_int_range (rand, 1, 256 * 1024);
+
+		if (!g_input_stream_read_all (stream, buffer, count, &n_read, NULL, NULL) ||
+		    n_read != MIN (count, CHECK_SIZE - offset) ||
+		    memcmp (buffer, data + offset, n_read) != 0) {
+			g_print ("Read %" G_GSIZE_FORMAT " bytes at %" G_GOFFSET_FORMAT " differ\n",
+				 count, offset);
+			retval = FALSE;
+		}
+	}
+
+	if (retval) {
+		g_print ("%d reads of %d bytes checked, %u requests\n",
+			 CHECK_N_READS, CHECK_SIZE,
+			 _ev_cached_stream_get_n_fetches (EV_CACHED_STREAM (stream)));
+	}
+
+	g_object_unref (stream);
+	g_rand_free (rand);
+	g_free (buffer);
+	g_free (data);
+
+	return retval;
+}
+
+static gboolean
+render_first_page (GInputStream *stream,
+		   const gchar  *mime_type)
+{
+	EvDocument      *document;
+	EvPage          *page;
+	EvRenderContext *rc;
+	cairo_surface_t *surface;
+	GError          *error = NULL;
+
+	document = ev_document_factory_get_document_for_stream (stream, mime_type,
+								 EV_DOCUMENT_LOAD_FLAG_NO_CACHE,
+								 NULL, &error);
+	if (!document) {
+		g_print ("Failed to load the document: %s\n", error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	page = ev_document_get_page (document, 0);
+	rc = ev_render_context_new (page, 0, 1.0);
+	surface = ev_document_render (document, rc);
+	g_object_unref (rc);
+	g_object_unref (page);
+	g_object_unref (document);
+
+	if (!surface)
+		return FALSE;
+	cairo_surface_destroy (surface);
+
+	return TRUE;
+}
+
+static gboolean
+time_first_page (const gchar *filename,
+		 gint64       bandwidth,
+		 gint64       latency)
+{
+	GFile            *file;
+	GFileInputStream *file_stream;
+	GFileInfo        *info;
+	GInputStream     *remote, *stream;
+	gchar            *content_type, *mime_type;
+	guint8           *contents;
+	goffset           size;
+	gsize             n_read;
+	GTimer           *timer;
+	gdouble           elapsed;
+	gboolean          retval = FALSE;
+
+	file = g_file_new_for_commandline_arg (filename);
+	file_stream = g_file_read (file, NULL, NULL);
+	info = file_stream ? g_file_input_stream_query_info (file_stream, G_FILE_ATTRIBUTE_STANDARD_SIZE, NULL, NULL) : NULL;
+	g_object_unref (file);
+	if (!info) {
+		g_print ("Failed to open '%s'\n", filename);
+		g_clear_object (&file_stream);
+		return FALSE;
+	}
+	size = g_file_info_get_size (info);
+	g_object_unref (info);
+
+	content_type = g_content_type_guess (filename, NULL, 0, NULL);
+	mime_type = g_content_type_get_mime_type (content_type);
+	g_free (content_type);
+
+	g_print ("MODE\t\tFIRST PAGE (s)\tFETCHED (KiB)\tREQUESTS\n");
+	timer = g_timer_new ();
+
+	/* What evince used to do: download, then load */
+	remote = throttled_stream_new (G_INPUT_STREAM (file_stream), bandwidth, latency);
+	contents = g_malloc (size);
+	g_timer_start (timer);
+	if (g_input_stream_read_all (remote, contents, size, &n_read, NULL, NULL)) {
+		stream = g_memory_input_stream_new_from_data (contents, n_read, NULL);
+		if (render_first_page (stream, mime_type)) {
+			elapsed = g_timer_elapsed (timer, NULL);
+			g_print ("download\t%.2f\t\t%" G_GSIZE_FORMAT "\t\t1\n",
+				 elapsed, n_read / 1024);
+			retval = TRUE;
+		}
+		g_object_unref (stream);
+	}
+	g_free (contents);
+	g_object_unref (remote);
+
+	/* Progressive: only the blocks the backend reads */
+	g_seekable_seek (G_SEEKABLE (file_stream), 0, G_SEEK_SET, NULL, NULL);
+	remote = throttled_stream_new (G_INPUT_STREAM (file_stream), bandwidth, latency);
+	stream = _ev_cached_stream_new (remote, size, 64 * 1024 * 1024);
+	g_object_unref (remote);
+	g_timer_start (timer);
+	if (render_first_page (stream, mime_type)) {
+		elapsed = g_timer_elapsed (timer, NULL);
+		g_print ("progressive\t%.2f\t\t%" G_GUINT64_FORMAT "\t\t%u\n",
+			 elapsed,
+			 _ev_cached_stream_get_bytes_fetched (EV_CACHED_STREAM (stream)) / 1024,
+			 _ev_cached_stream_get_n_fetches (EV_CACHED_STREAM (stream)));
+	} else {
+		retval = FALSE;
+	}
+	g_object_unref (stream);
+
+	g_timer_destroy (timer);
+	g_object_unref (file_stream);
+	g_free (mime_type);
+
+	return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+	gint64 bandwidth = DEFAULT_BANDWIDTH;
+	gint64 latency = DEFAULT_LATENCY;
+	int    retval = 0;
+
+	if (argc > 4) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (argc > 2)
+		bandwidth = MAX (atoi (argv[2]), 1);
+	if (argc > 3)
+		latency = MAX (atoi (argv[3]), 0);
+
+	if (!check_contents ())
+		retval = 1;
+
+	if (argc > 1) {
+		if (!ev_init ()) {
+			g_warning ("No backends found");
+			return 1;
+		}
+
+		if (!time_first_page (argv[1], bandwidth * 1024, latency * 1000))
+			retval = 1;
+
+		ev_shutdown ();
+	}
+
+	return retval;
+}
@@ -0,0 +1,259 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "ev-mapping-list.h"
+
+#define PAGE_WIDTH         612.0
+#define PAGE_HEIGHT        792.0
+#define DEFAULT_N_MAPPINGS 10000
+#define N_QUERIES          100000
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Times looking up mappings by point and by area in a page\n");
+	g_print ("Usage: %s [n-mappings]\n", prog);
+	g_print ("Checks the results against walking the whole list, default is %d mappings\n",
+		 DEFAULT_N_MAPPINGS);
+}
+
+static void
+mapping_data_free (gpointer data)
+{
+}
+
+/* A grid of small link-like areas, with some random areas of any size
+ * on top, including a few covering most of the page */
+static EvMappingList *
+create_mapping_list (GRand *rand,
+		     guint  n_mappings)
+{
+	GList *list = NULL;
+	guint  n_random = MAX (n_mappings / 100, 1);
+	guint  n_grid = n_mappings - n_random;
+	guint  grid_size = 1;
+	guint  i;
+
+	while (grid_size * grid_size < n_grid)
+		grid_size++;
+
+	for (i = 0; i < n_mappings; i++) {
+		EvMapping *mapping = g_new (EvMapping, 1);
+
+		if (i < n_grid) {
+			gdouble w = PAGE_WIDTH / grid_size;
+			gdouble h = PAGE_HEIGHT / grid_size;
+
+			mapping->area.x1 = (i % grid_size) * w;
+			mapping->area.y1 = (i / grid_size) * h;
+			mapping->area.x2 = mapping->area.x1 + w * 0.8;
+			mapping->area.y2 = mapping->area.y1 + h * 0.8;
+		} else {
+			mapping->area.x1 = g_rand_double_range (rand, 0, PAGE_WIDTH);
+			mapping->area.y1 = g_rand_double_range (rand, 0, PAGE_HEIGHT);
+			mapping->area.x2 = g_rand_double_range (rand, mapping->area.x1, PAGE_WIDTH);
+			mapping->area.y2 = g_rand_double_range (rand, mapping->area.y1, PAGE_HEIGHT);
+		}
+		mapping->data = GUINT_TO_POINTER (i);
+
+		list = g_list_prepend (list, mapping);
+	}
+
+	return ev_mapping_list_new (0, g_list_reverse (list), mapping_data_free);
+}
+
+/* How lookups were done before the spatial index */
+static int
+cmp_mapping_area_size (EvMapping *a,
+		       EvMapping *b)
+{
+	gdouble wa, ha, wb, hb;
+
+	wa = a->area.x2 - a->area.x1;
+	ha = a->area.y2 - a->area.y1;
+	wb = b->area.x2 - b->area.x1;
+	hb = b->area.y2 - b->area.y1;
+
+	if (wa == wb) {
+		if (ha == hb)
+			return 0;
+		return (ha < hb) ? -1 : 1;
+	}
+
+	if (ha == hb) {
+		return (wa < wb) ? -1 : 1;
+	}
+
+	return (wa * ha < wb * hb) ? -1 : 1;
+}
+
+static EvMapping *
+linear_get (GList  *list,
+	    gdouble x,
+	    gdouble y)
+{
+	EvMapping *found = NULL;
+
+	for (; list; list = list->next) {
+		EvMapping *mapping = list->data;
+
+		if ((x >= mapping->area.x1) &&
+		    (y >= mapping->area.y1) &&
+		    (x <= mapping->area.x2) &&
+		    (y <= mapping->area.y2)) {
+			if (found == NULL || cmp_mapping_area_size (mapping, found) < 0)
+				found = mapping;
+		}
+	}
+
+	return found;
+}
+
+static GList *
+linear_get_in_area (GList             *list,
+		    const EvRectangle *area)
+{
+	GList *retval = NULL;
+
+	for (; list; list = list->next) {
+		EvMapping *mapping = list->data;
+
+		if (mapping->area.x1 <= area->x2 && mapping->area.y1 <= area->y2 &&
+		    mapping->area.x2 >= area->x1 && mapping->area.y2 >= area->y1)
+			retval = g_list_prepend (retval, mapping);
+	}
+
+	return g_list_reverse (retval);
+}
+
+static gboolean
+lists_equal (GList *a,
+	     GList *b)
+{
+	for (; a && b; a = a->next, b = b->next) {
+		if (a->data != b->data)
+			return FALSE;
+	}
+
+	return a == NULL && b == NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+	EvMappingList *mapping_list;
+	EvPoint       *points;
+	EvRectangle   *areas;
+	GRand         *rand;
+	GTimer        *timer;
+	gdouble        indexed_time, linear_time;
+	guint          n_mappings = DEFAULT_N_MAPPINGS;
+	guint          n_mismatches = 0;
+	guint          n_area_queries;
+	guint          i;
+
+	if (argc > 2 || (argc == 2 && atoi (argv[1]) <= 0)) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (argc == 2)
+		n_mappings = atoi (argv[1]);
+
+	rand = g_rand_new_with_seed (42);
+	mapping_list = create_mapping_list (rand, n_mappings);
+
+	points = g_new (EvPoint, N_QUERIES);
+	for (i = 0; i < N_QUERIES; i++) {
+		points[i].x = g_rand_double_range (rand, -10, PAGE_WIDTH + 10);
+		points[i].y = g_rand_double_range (rand, -10, PAGE_HEIGHT + 10);
+	}
+
+	n_area_queries = N_QUERIES / 100;
+	areas = g_new (EvRectangle, n_area_queries);
+	for (i = 0; i < n_area_queries; i++) {
+		areas[i].x1 = g_rand_double_range (rand, 0, PAGE_WIDTH);
+		areas[i].y1 = g_rand_double_range (rand, 0, PAGE_HEIGHT);
+		areas[i].x2 = areas[i].x1 + g_rand_double_range (rand, 0, PAGE_WIDTH / 8);
+		areas[i].y2 = areas[i].y1 + g_rand_double_range (rand, 0, PAGE_HEIGHT / 8);
+	}
+
+	g_print ("%u mappings\n", n_mappings);
+	g_print ("QUERY\tCOUNT\tINDEXED\tLINEAR (seconds)\n");
+
+	/* The first lookup builds the index */
+	timer = g_timer_new ();
+	for (i = 0; i < N_QUERIES; i++)
+		ev_mapping_list_get (mapping_list, points[i].x, points[i].y);
+	indexed_time = g_timer_elapsed (timer, NULL);
+
+	g_timer_start (timer);
+	for (i = 0; i < N_QUERIES; i++)
+		linear_get (ev_mapping_list_get_list (mapping_list), points[i].x, points[i].y);
+	linear_time = g_timer_elapsed (timer, NULL);
+
+	g_print ("point\t%u\t%.4f\t%.4f\n", N_QUERIES, indexed_time, linear_time);
+
+	g_timer_start (timer);
+	for (i = 0; i < n_area_queries; i++)
+		g_list_free (ev_mapping_list_get_in_area (mapping_list, &areas[i]));
+	indexed_time = g_timer_elapsed (timer, NULL);
+
+	g_timer_start (timer);
+	for (i = 0; i < n_area_queries; i++)
+		g_list_free (linear_get_in_area (ev_mapping_list_get_list (mapping_list), &areas[i]));
+	linear_time = g_timer_elapsed (timer, NULL);
+
+	g_print ("area\t%u\t%.4f\t%.4f\n", n_area_queries, indexed_time, linear_time);
+	g_timer_destroy (timer);
+
+	/* Check that the same mappings are found */
+	for (i = 0; i < N_QUERIES; i++) {
+		GList *list = ev_mapping_list_get_list (mapping_list);
+
+		if (ev_mapping_list_get (mapping_list, points[i].x, points[i].y) !=
+		    linear_get (list, points[i].x, points[i].y))
+			n_mismatches++;
+	}
+
+	for (i = 0; i < n_area_queries; i++) {
+		GList *list = ev_mapping_list_get_list (mapping_list);
+		GList *indexed = ev_mapping_list_get_in_area (mapping_list, &areas[i]);
+		GList *linear = linear_get_in_area (list, &areas[i]);
+
+		if (!lists_equal (indexed, linear))
+			n_mismatches++;
+		g_list_free (indexed);
+		g_list_free (linear);
+	}
+
+	if (n_mismatches > 0)
+		g_warning ("%u lookups differ from walking the list", n_mismatches);
+
+	g_free (points);
+	g_free (areas);
+	g_rand_free (rand);
+	ev_mapping_list_unref (mapping_list);
+
+	return n_mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,256 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "ev-page-geometry.h"
+
+#define N_PAGES     10000
+#define N_DOCUMENTS 8
+#define BACKEND     "TestDocument"
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Checks the page geometry cache files and times reading them\n");
+	g_print ("Usage: %s\n", prog);
+	g_print ("Uses a temporary cache directory and documents of %d pages\n", N_PAGES);
+}
+
+static void
+geometry_init (EvPageGeometry *geometry,
+	       guint           n_pages)
+{
+	guint i;
+
+	memset (geometry, 0, sizeof (EvPageGeometry));
+	geometry->n_pages = n_pages;
+	geometry->uniform_width = geometry->min_width = 595;
+	geometry->uniform_height = geometry->min_height = 595;
+	geometry->max_width = geometry->max_height = 842;
+	geometry->page_sizes = g_new (EvPageSize, n_pages);
+	geometry->page_labels = g_new0 (gchar *, n_pages + 1);
+
+	for (i = 0; i < n_pages; i++) {
+		geometry->page_sizes[i].width = i % 7 == 6 ? 842 : 595;
+		geometry->page_sizes[i].height = i % 7 == 6 ? 595 : 842;
+		/* Some pages without a label */
+		if (i % 100 != 99)
+			geometry->page_labels[i] = g_strdup_printf ("A-%u", i + 1);
+		geometry->max_label = MAX (geometry->max_label,
+					   geometry->page_labels[i] ? strlen (geometry->page_labels[i]) : 0);
+	}
+}
+
+static void
+geometry_clear (EvPageGeometry *geometry)
+{
+	g_clear_pointer (&geometry->page_sizes, g_free);
+	g_clear_pointer (&geometry->page_labels, g_strfreev);
+}
+
+static gboolean
+geometry_equal (const EvPageGeometry *a,
+		const EvPageGeometry *b)
+{
+	guint i;
+
+	if (a->n_pages != b->n_pages || a->uniform != b->uniform ||
+	    a->max_width != b->max_width || a->max_height != b->max_height ||
+	    a->min_width != b->min_width || a->min_height != b->min_height ||
+	    a->max_label != b->max_label ||
+	    memcmp (a->page_sizes, b->page_sizes, a->n_pages * sizeof (EvPageSize)) != 0 ||
+	    (a->page_labels == NULL) != (b->page_labels == NULL))
+		return FALSE;
+
+	for (i = 0; a->page_labels && i < a->n_pages; i++) {
+		if (g_strcmp0 (a->page_labels[i], b->page_labels[i]) != 0)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gchar *
+create_document (const gchar *dir,
+		 guint        n)
+{
+	gchar *path, *uri, *contents;
+
+	path = g_strdup_printf ("%s/document-%u", dir, n);
+	contents = g_strdup_printf ("document %u", n);
+	g_file_set_contents (path, contents, -1, NULL);
+	uri = g_filename_to_uri (path, NULL, NULL);
+	g_free (contents);
+	g_free (path);
+
+	return uri;
+}
+
+static guint64
+get_cache_size (const gchar *cache_dir,
+		guint       *n_files)
+{
+	GDir        *dir;
+	const gchar *name;
+	guint64      size = 0;
+
+	*n_files = 0;
+	dir = g_dir_open (cache_dir, 0, NULL);
+	if (!dir)
+		return 0;
+
+	while ((name = g_dir_read_name (dir))) {
+		gchar   *path = g_build_filename (cache_dir, name, NULL);
+		GStatBuf buf;
+
+		if (g_stat (path, &buf) == 0) {
+			size += buf.st_size;
+			(*n_files)++;
+		}
+		g_free (path);
+	}
+	g_dir_close (dir);
+
+	return size;
+}
+
+int
+main (int argc, char **argv)
+{
+	EvPageGeometry geometry, loaded;
+	GTimer        *timer;
+	gchar         *tmp_dir, *cache_dir, *uri, *path;
+	gchar         *uris[N_DOCUMENTS];
+	guint64        size;
+	guint          i, n_files;
+	int            retval = 0;
+
+	if (argc != 1) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	tmp_dir = g_dir_make_tmp ("test-ev-page-geometry-XXXXXX", NULL);
+	if (!tmp_dir)
+		return 1;
+
+	/* Must be set before anything asks for the user cache dir */
+	g_setenv ("XDG_CACHE_HOME", tmp_dir, TRUE);
+	cache_dir = g_build_filename (tmp_dir, "evince", "page-geometry", NULL);
+
+	geometry_init (&geometry, N_PAGES);
+	uri = create_document (tmp_dir, 0);
+
+	if (!_ev_page_geometry_save (uri, BACKEND, &geometry, NULL)) {
+		g_print ("Failed to save the page geometry\n");
+		retval = 1;
+	}
+
+	loaded.n_pages = N_PAGES;
+	timer = g_timer_new ();
+	if (!_ev_page_geometry_load (uri, BACKEND, &loaded)) {
+		g_print ("Failed to load the page geometry\n");
+		retval = 1;
+	} else {
+		g_print ("Loaded the geometry of %d pages in %.2f ms\n",
+			 N_PAGES, g_timer_elapsed (timer, NULL) * 1000);
+		if (!geometry_equal (&geometry, &loaded)) {
+			g_print ("The loaded page geometry differs from the saved one\n");
+			retval = 1;
+		}
+		geometry_clear (&loaded);
+	}
+	g_timer_destroy (timer);
+
+	/* Stale when the number of pages, the backend or the file change */
+	loaded.n_pages = N_PAGES - 1;
+	if (_ev_page_geometry_load (uri, BACKEND, &loaded)) {
+		g_print ("Loaded the page geometry for a different number of pages\n");
+		geometry_clear (&loaded);
+		retval = 1;
+	}
+	loaded.n_pages = N_PAGES;
+	if (_ev_page_geometry_load (uri, "OtherDocument", &loaded)) {
+		g_print ("Loaded the page geometry for a different backend\n");
+		geometry_clear (&loaded);
+		retval = 1;
+	}
+	path = g_filename_from_uri (uri, NULL, NULL);
+	g_file_set_contents (path, "changed document", -1, NULL);
+	g_free (path);
+	if (_ev_page_geometry_load (uri, BACKEND, &loaded)) {
+		g_print ("Loaded the page geometry of a changed document\n");
+		geometry_clear (&loaded);
+		retval = 1;
+	}
+	g_free (uri);
+
+	/* Only the most recently used files are kept */
+	for (i = 0; i < N_DOCUMENTS; i++) {
+		uris[i] = create_document (tmp_dir, i + 1);
+		_ev_page_geometry_save (uris[i], BACKEND, &geometry, NULL);
+	}
+	size = get_cache_size (cache_dir, &n_files) / n_files;
+
+	/* The modification time has a resolution of a second */
+	g_usleep (G_USEC_PER_SEC + 100000);
+	loaded.n_pages = N_PAGES;
+	if (_ev_page_geometry_load (uris[0], BACKEND, &loaded))
+		geometry_clear (&loaded);
+
+	_ev_page_geometry_prune (size * 2 + size / 2);
+	if (get_cache_size (cache_dir, &n_files) > size * 2 + size / 2 || n_files != 2) {
+		g_print ("The cache was not pruned: %u files left\n", n_files);
+		retval = 1;
+	}
+	if (!_ev_page_geometry_load (uris[0], BACKEND, &loaded)) {
+		g_print ("The most recently used file was pruned\n");
+		retval = 1;
+	} else {
+		geometry_clear (&loaded);
+	}
+
+	for (i = 0; i < N_DOCUMENTS; i++) {
+		path = g_filename_from_uri (uris[i], NULL, NULL);
+		g_unlink (path);
+		g_free (path);
+		g_free (uris[i]);
+	}
+	_ev_page_geometry_prune (0);
+	path = g_build_filename (tmp_dir, "document-0", NULL);
+	g_unlink (path);
+	g_free (path);
+	g_rmdir (cache_dir);
+	path = g_build_filename (tmp_dir, "evince", NULL);
+	g_rmdir (path);
+	g_free (path);
+	g_rmdir (tmp_dir);
+
+	geometry_clear (&geometry);
+	g_free (cache_dir);
+	g_free (tmp_dir);
+
+	return retval;
+}
@@ -0,0 +1,416 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ev-pixel-kernels.h"
+
+/* A4 at 300 dpi */
+#define DEFAULT_WIDTH  2480
+#define DEFAULT_HEIGHT 3508
+#define N_CHECKS       500
+#define N_RUNS         5
+
+typedef enum {
+	OP_INVERT_ARGB32,
+	OP_INVERT_RGB,
+	OP_INVERT_RGBA,
+	OP_ARGB32_TO_RGB,
+	OP_ARGB32_TO_RGBA,
+	OP_RGB_TO_ARGB32,
+	OP_RGBA_TO_ARGB32,
+	OP_ROTATE_90,
+	OP_ROTATE_180,
+	OP_ROTATE_270,
+	OP_DOWNSCALE_2,
+	OP_DOWNSCALE_3,
+	OP_DOWNSCALE_2_ROTATE_90,
+	OP_BLEND,
+	N_OPS
+} Op;
+
+static const char *op_names[] = {
+	"invert-argb32",
+	"invert-rgb",
+	"invert-rgba",
+	"argb32-to-rgb",
+	"argb32-to-rgba",
+	"rgb-to-argb32",
+	"rgba-to-argb32",
+	"rotate-90",
+	"rotate-180",
+	"rotate-270",
+	"downscale-2",
+	"downscale-3",
+	"downscale-2-rot90",
+	"blend"
+};
+
+typedef struct {
+	gint    width;
+	gint    height;
+	gint    stride;
+	guchar *data;
+	gsize   size;
+} Image;
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Checks that every pixel kernel implementation supported by this CPU\n"
+		 "  gives the same result as the scalar one, and that downscaling and\n"
+		 "  rotating in one pass gives the same result as in two, then times them\n");
+	g_print ("Usage: %s [width height]\n", prog);
+	g_print ("The default image size is %dx%d\n", DEFAULT_WIDTH, DEFAULT_HEIGHT);
+}
+
+/* Premultiplied pixels with many fully opaque and fully transparent
+ * ones, which the kernels handle specially */
+static void
+image_fill (Image *image,
+	    GRand *rand)
+{
+	gsize i;
+
+	for (i = 0; i < image->size; i++)
+		image->data[i] = g_rand_int_range (rand, 0, 256);
+
+	for (i = 0; i + 4 <= image->size; i += 4) {
+		guchar  alpha;
+		guint32 p = 0;
+		gint    c;
+
+		switch (g_rand_int_range (rand, 0, 4)) {
+		case 0:
+			alpha = 0;
+			break;
+		case 1:
+		case 2:
+			alpha = 0xff;
+			break;
+		default:
+			alpha = g_rand_int_range (rand, 1, 256);
+		}
+
+		for (c = 0; c < 3; c++)
+			p |= (guint32) g_rand_int_range (rand, 0, alpha + 1) << (c * 8);
+		p |= (guint32) alpha << 24;
+		memcpy (image->data + i, &p, 4);
+	}
+}
+
+static Image *
+image_new (gint width,
+	   gint height,
+	   gint stride)
+{
+	Image *image = g_new (Image, 1);
+
+	image->width = width;
+	image->height = height;
+	image->stride = stride;
+	image->size = (gsize) stride * height;
+	image->data = g_malloc0 (image->size);
+
+	return image;
+}
+
+static void
+image_free (Image *image)
+{
+	g_free (image->data);
+	g_free (image);
+}
+
+/* Runs @op on @src, which is both an ARGB32 and a RGB(A) image depending
+ * on the operation, into @dest, that must be large enough */
+static void
+run_op (Op     op,
+	Image *src,
+	Image *dest)
+{
+	switch (op) {
+	case OP_INVERT_ARGB32:
+		memcpy (dest->data, src->data, src->size);
+		_ev_pixels_invert_argb32 (dest->data, src->width, src->height, src->stride);
+		break;
+	case OP_INVERT_RGB:
+	case OP_INVERT_RGBA:
+		memcpy (dest->data, src->data, src->size);
+		_ev_pixels_invert_rgb (dest->data, src->width, src->height, src->stride,
+				       op == OP_INVERT_RGB ? 3 : 4);
+		break;
+	case OP_ARGB32_TO_RGB:
+	case OP_ARGB32_TO_RGBA:
+		_ev_pixels_argb32_to_rgb (src->data, src->stride,
+					  dest->data, dest->stride,
+					  op == OP_ARGB32_TO_RGB ? 3 : 4,
+					  src->width, src->height);
+		break;
+	case OP_RGB_TO_ARGB32:
+	case OP_RGBA_TO_ARGB32:
+		_ev_pixels_rgb_to_argb32 (src->data, src->stride,
+					  op == OP_RGB_TO_ARGB32 ? 3 : 4,
+					  dest->data, dest->stride,
+					  src->width, src->height);
+		break;
+	case OP_ROTATE_90:
+	case OP_ROTATE_180:
+	case OP_ROTATE_270:
+		_ev_pixels_rotate_argb32 (src->data, src->stride, src->width, src->height,
+					  dest->data, dest->stride,
+					  90 * (op - OP_ROTATE_90 + 1));
+		break;
+	case OP_DOWNSCALE_2:
+	case OP_DOWNSCALE_3:
+		_ev_pixels_downscale_argb32 (src->data, src->stride, src->width, src->height,
+					     dest->data, dest->stride,
+					     MAX (src->width / (op - OP_DOWNSCALE_2 + 2), 1),
+					     MAX (src->height / (op - OP_DOWNSCALE_2 + 2), 1));
+		break;
+	case OP_DOWNSCALE_2_ROTATE_90:
+		_ev_pixels_downscale_rotate_argb32 (src->data, src->stride, src->width, src->height,
+						    dest->data, dest->stride,
+						    MAX (src->width / 2, 1),
+						    MAX (src->height / 2, 1),
+						    90);
+		break;
+	case OP_BLEND:
+		/* Cross-fades the image with itself upside down */
+		_ev_pixels_blend_argb32 (src->data, src->stride,
+					 src->data + (src->height - 1) * src->stride, -src->stride,
+					 dest->data, dest->stride,
+					 src->width, src->height, 100);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+}
+
+/* A destination image any operation fits in */
+static Image *
+dest_new_for_src (Image *src)
+{
+	gint size = MAX (src->width, src->height);
+
+	return image_new (size, size, MAX (size * 4, src->stride));
+}
+
+static gboolean
+check_impl (EvPixelKernelsImpl impl,
+	    GRand             *rand)
+{
+	guint i;
+	Op    op;
+
+	for (i = 0; i < N_CHECKS; i++) {
+		gint   width = g_rand_int_range (rand, 1, 150);
+		gint   height = g_rand_int_range (rand, 1, 100);
+		Image *src, *expected, *result;
+
+		/* Strides that are not a multiple of the vector size,
+		 * and RGB rows that are not a multiple of four bytes */
+		src = image_new (width, height, width * 4 + 4 * g_rand_int_range (rand, 0, 5));
+		image_fill (src, rand);
+		expected = dest_new_for_src (src);
+		result = dest_new_for_src (src);
+
+		for (op = 0; op < N_OPS; op++) {
+			gint stride = src->stride;
+
+			if (op == OP_INVERT_RGB || op == OP_ARGB32_TO_RGB || op == OP_RGB_TO_ARGB32)
+				src->stride = width * 3 + g_rand_int_range (rand, 0, 5);
+
+			memset (expected->data, 0, expected->size);
+			memset (result->data, 0, result->size);
+
+			/* Keep the RGB destination stride odd too */
+			if (op == OP_ARGB32_TO_RGB)
+				expected->stride = result->stride = width * 3 + 1;
+			else
+				expected->stride = result->stride = expected->width * 4;
+
+			_ev_pixel_kernels_set_impl (EV_PIXEL_KERNELS_SCALAR);
+			run_op (op, src, expected);
+			_ev_pixel_kernels_set_impl (impl);
+			run_op (op, src, result);
+
+			src->stride = stride;
+
+			if (memcmp (expected->data, result->data, expected->size) != 0) {
+				g_print ("%s: %s differs from scalar for a %dx%d image\n",
+					 op_names[op], _ev_pixel_kernels_get_impl_name (impl),
+					 width, height);
+				image_free (src);
+				image_free (expected);
+				image_free (result);
+
+				return FALSE;
+			}
+		}
+
+		image_free (src);
+		image_free (expected);
+		image_free (result);
+	}
+
+	return TRUE;
+}
+
+/* The fused downscale and rotation against the two passes it replaces */
+static gboolean
+check_fused (GRand *rand)
+{
+	guint i;
+
+	_ev_pixel_kernels_set_impl (EV_PIXEL_KERNELS_SCALAR);
+
+	for (i = 0; i < N_CHECKS; i++) {
+		gint   width = g_rand_int_range (rand, 1, 150);
+		gint   height = g_rand_int_range (rand, 1, 100);
+		gint   dest_width = g_rand_int_range (rand, 1, width + 1);
+		gint   dest_height = g_rand_int_range (rand, 1, height + 1);
+		gint   rotation = 90 * g_rand_int_range (rand, 0, 4);
+		Image *src, *scaled, *expected, *result;
+
+		src = image_new (width, height, width * 4 + 4 * g_rand_int_range (rand, 0, 5));
+		image_fill (src, rand);
+		scaled = image_new (dest_width, dest_height, dest_width * 4);
+		expected = dest_new_for_src (src);
+		result = dest_new_for_src (src);
+
+		_ev_pixels_downscale_argb32 (src->data, src->stride, width, height,
+					     scaled->data, scaled->stride,
+					     dest_width, dest_height);
+		_ev_pixels_rotate_argb32 (scaled->data, scaled->stride, dest_width, dest_height,
+					  expected->data, expected->stride, rotation);
+		_ev_pixels_downscale_rotate_argb32 (src->data, src->stride, width, height,
+						    result->data, result->stride,
+						    dest_width, dest_height, rotation);
+
+		image_free (src);
+		image_free (scaled);
+
+		if (memcmp (expected->data, result->data, expected->size) != 0) {
+			g_print ("downscale-rotate-%d differs from two passes for a %dx%d image scaled to %dx%d\n",
+				 rotation, width, height, dest_width, dest_height);
+			image_free (expected);
+			image_free (result);
+
+			return FALSE;
+		}
+
+		image_free (expected);
+		image_free (result);
+	}
+
+	return TRUE;
+}
+
+static gdouble
+time_op (Op     op,
+	 Image *src,
+	 Image *dest)
+{
+	GTimer *timer;
+	gdouble best = G_MAXDOUBLE;
+	guint   i;
+
+	timer = g_timer_new ();
+	for (i = 0; i < N_RUNS; i++) {
+		g_timer_start (timer);
+		run_op (op, src, dest);
+		g_timer_stop (timer);
+		best = MIN (best, g_timer_elapsed (timer, NULL));
+	}
+	g_timer_destroy (timer);
+
+	return best;
+}
+
+int
+main (int argc, char **argv)
+{
+	EvPixelKernelsImpl  impl, best_impl;
+	GRand              *rand;
+	Image              *src, *dest;
+	gint                width = DEFAULT_WIDTH;
+	gint                height = DEFAULT_HEIGHT;
+	Op                  op;
+	int                 retval = 0;
+
+	if (argc == 3) {
+		width = atoi (argv[1]);
+		height = atoi (argv[2]);
+	}
+
+	if ((argc != 1 && argc != 3) || width <= 0 || height <= 0) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	best_impl = _ev_pixel_kernels_get_impl ();
+	rand = g_rand_new_with_seed (1);
+
+	for (impl = EV_PIXEL_KERNELS_SCALAR + 1; impl < EV_PIXEL_KERNELS_N_IMPLS; impl++) {
+		if (!_ev_pixel_kernels_is_supported (impl))
+			continue;
+
+		if (!check_impl (impl, rand))
+			retval = 1;
+	}
+
+	if (!check_fused (rand))
+		retval = 1;
+	_ev_pixel_kernels_set_impl (best_impl);
+
+	src = image_new (width, height, width * 4);
+	image_fill (src, rand);
+	dest = dest_new_for_src (src);
+	g_rand_free (rand);
+
+	g_print ("Default implementation: %s\n", _ev_pixel_kernels_get_impl_name (best_impl));
+	g_print ("OPERATION\t");
+	for (impl = EV_PIXEL_KERNELS_SCALAR; impl < EV_PIXEL_KERNELS_N_IMPLS; impl++) {
+		if (_ev_pixel_kernels_is_supported (impl))
+			g_print ("%s\t", _ev_pixel_kernels_get_impl_name (impl));
+	}
+	g_print ("(ms for %dx%d)\n", width, height);
+
+	for (op = 0; op < N_OPS; op++) {
+		g_print ("%-14s\t", op_names[op]);
+		for (impl = EV_PIXEL_KERNELS_SCALAR; impl < EV_PIXEL_KERNELS_N_IMPLS; impl++) {
+			if (!_ev_pixel_kernels_is_supported (impl))
+				continue;
+
+			_ev_pixel_kernels_set_impl (impl);
+			dest->stride = op == OP_ARGB32_TO_RGB ? width * 3 : dest->width * 4;
+			g_print ("%.2f\t", time_op (op, src, dest) * 1000);
+		}
+		g_print ("\n");
+	}
+
+	image_free (src);
+	image_free (dest);
+
+	return retval;
+}
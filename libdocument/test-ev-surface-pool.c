@@ -0,0 +1,210 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "ev-surface-pool.h"
+
+/* A4 at 150% on a 96 dpi screen */
+#define DEFAULT_WIDTH  1240
+#define DEFAULT_HEIGHT 1754
+#define N_PAGES        200
+#define N_CACHED       5   /* Pages kept by the view while scrolling */
+#define MAX_SIZE       (64 * 1024 * 1024)
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Checks the surface pool and times rendering pages with it\n");
+	g_print ("Usage: %s [width height]\n", prog);
+	g_print ("Renders %d pages of width x height (default %dx%d), every tenth one\n"
+		 "in landscape, keeping the last %d like the view does while scrolling,\n"
+		 "and reports the time per page with surfaces created by cairo and with\n"
+		 "surfaces from the pool, and the buffers the pool allocated and reused\n",
+		 N_PAGES, DEFAULT_WIDTH, DEFAULT_HEIGHT, N_CACHED);
+}
+
+typedef cairo_surface_t *(* CreateSurfaceFunc) (cairo_format_t format,
+						gint           width,
+						gint           height);
+
+/* Like a backend painting the whole page */
+static cairo_surface_t *
+render_page (CreateSurfaceFunc create_surface,
+	     gint              width,
+	     gint              height)
+{
+	cairo_surface_t *surface;
+	cairo_t         *cr;
+
+	surface = create_surface (CAIRO_FORMAT_ARGB32, width, height);
+	cr = cairo_create (surface);
+	cairo_set_source_rgb (cr, 1., 1., 1.);
+	cairo_paint (cr);
+	cairo_set_source_rgb (cr, 0., 0., 0.);
+	cairo_rectangle (cr, width / 10, height / 10, width / 2, 10);
+	cairo_fill (cr);
+	cairo_destroy (cr);
+
+	return surface;
+}
+
+static gboolean
+check_page (cairo_surface_t *surface)
+{
+	guint32 *pixels;
+	gint     width, height, stride;
+
+	if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+		return FALSE;
+
+	cairo_surface_flush (surface);
+	pixels = (guint32 *) cairo_image_surface_get_data (surface);
+	width = cairo_image_surface_get_width (surface);
+	height = cairo_image_surface_get_height (surface);
+	stride = cairo_image_surface_get_stride (surface) / 4;
+
+	return pixels[0] == 0xffffffff &&
+		pixels[(height - 1) * stride + width - 1] == 0xffffffff &&
+		pixels[(height / 10) * stride + width / 10] == 0xff000000;
+}
+
+static gboolean
+time_pages (CreateSurfaceFunc create_surface,
+	    const gchar      *name,
+	    gint              width,
+	    gint              height)
+{
+	cairo_surface_t *cached[N_CACHED] = { NULL, };
+	GTimer          *timer;
+	gdouble          elapsed;
+	guint            n_allocated, n_reused;
+	guint            allocated, reused;
+	gboolean         retval = TRUE;
+	gint             i;
+
+	_ev_surface_pool_clear ();
+	_ev_surface_pool_get_stats (&allocated, &reused);
+	timer = g_timer_new ();
+
+	for (i = 0; i < N_PAGES; i++) {
+		cairo_surface_t *surface;
+		gboolean         landscape = i % 10 == 9;
+
+		surface = render_page (create_surface,
+				       landscape ? height : width,
+				       landscape ? width : height);
+		if (!check_page (surface)) {
+			g_print ("Page %d is wrong\n", i);
+			retval = FALSE;
+		}
+
+		if (cached[i % N_CACHED])
+			cairo_surface_destroy (cached[i % N_CACHED]);
+		cached[i % N_CACHED] = surface;
+	}
+
+	for (i = 0; i < N_CACHED; i++)
+		cairo_surface_destroy (cached[i]);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	_ev_surface_pool_get_stats (&n_allocated, &n_reused);
+	if (_ev_surface_pool_get_size () > MAX_SIZE) {
+		g_print ("The pool grew over its maximum size\n");
+		retval = FALSE;
+	}
+
+	g_print ("%s\t%.2f\t\t%u\t\t%u\n",
+		 name, elapsed * 1000 / N_PAGES,
+		 n_allocated - allocated, n_reused - reused);
+
+	return retval;
+}
+
+/* Buffers are only reused for surfaces of about their size */
+static gboolean
+check_reuse (void)
+{
+	cairo_surface_t *surface;
+	guchar          *data;
+	gboolean         retval = TRUE;
+
+	surface = _ev_surface_pool_create_surface (CAIRO_FORMAT_RGB24, 400, 400);
+	data = cairo_image_surface_get_data (surface);
+	cairo_surface_destroy (surface);
+
+	surface = _ev_surface_pool_create_surface (CAIRO_FORMAT_RGB24, 100, 100);
+	if (cairo_image_surface_get_data (surface) == data) {
+		g_print ("A large buffer was reused for a small surface\n");
+		retval = FALSE;
+	}
+	cairo_surface_destroy (surface);
+
+	surface = _ev_surface_pool_create_surface (CAIRO_FORMAT_ARGB32, 400, 390);
+	if (cairo_image_surface_get_data (surface) != data) {
+		g_print ("A buffer of about the same size was not reused\n");
+		retval = FALSE;
+	}
+	cairo_surface_destroy (surface);
+
+	/* The least recently used ones are freed first */
+	_ev_surface_pool_set_max_size (400 * 400 * 4);
+	if (_ev_surface_pool_get_size () != 400 * 400 * 4) {
+		g_print ("The pool was not trimmed\n");
+		retval = FALSE;
+	}
+	_ev_surface_pool_set_max_size (MAX_SIZE);
+	_ev_surface_pool_clear ();
+
+	return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+	gint width = DEFAULT_WIDTH;
+	gint height = DEFAULT_HEIGHT;
+	int  retval = 0;
+
+	if (argc == 3) {
+		width = atoi (argv[1]);
+		height = atoi (argv[2]);
+	}
+
+	if ((argc != 1 && argc != 3) || width <= 0 || height <= 0) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	_ev_surface_pool_set_max_size (MAX_SIZE);
+	if (!check_reuse ())
+		retval = 1;
+
+	g_print ("SURFACES\tPAGE (ms)\tALLOCATED\tREUSED\n");
+
+	if (!time_pages (cairo_image_surface_create, "cairo\t", width, height))
+		retval = 1;
+	if (!time_pages (_ev_surface_pool_create_surface, "pool\t", width, height))
+		retval = 1;
+
+	return retval;
+}
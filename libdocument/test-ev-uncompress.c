@@ -0,0 +1,206 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "ev-init.h"
+#include "ev-document-factory.h"
+#include "ev-file-helpers.h"
+
+#define DEFAULT_N_RUNS 10
+#define BUFFER_SIZE    1024
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Times opening a compressed document and rendering its first page\n");
+	g_print ("Usage: %s filename [n-runs]\n", prog);
+	g_print ("Where filename ends in .gz, .bz2 or .xz. The document is opened\n"
+		 "decompressing it in process, and running the decompressor command\n"
+		 "to a temporary file as evince used to do\n");
+}
+
+static const gchar *
+get_compressor_cmd (const gchar *filename)
+{
+	if (g_str_has_suffix (filename, ".gz"))
+		return "gzip";
+	if (g_str_has_suffix (filename, ".bz2"))
+		return "bzip2";
+	if (g_str_has_suffix (filename, ".xz"))
+		return "xz";
+
+	return NULL;
+}
+
+static gboolean
+render_first_page (const gchar *uri)
+{
+	EvDocument      *document;
+	EvPage          *page;
+	EvRenderContext *rc;
+	cairo_surface_t *surface;
+	GError          *error = NULL;
+
+	document = ev_document_factory_get_document (uri, &error);
+	if (!document) {
+		g_warning ("Failed to load '%s': %s", uri, error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	page = ev_document_get_page (document, 0);
+	rc = ev_render_context_new (page, 0, 1.0);
+	surface = ev_document_render (document, rc);
+	g_object_unref (rc);
+	g_object_unref (page);
+	g_object_unref (document);
+
+	if (!surface)
+		return FALSE;
+	cairo_surface_destroy (surface);
+
+	return TRUE;
+}
+
+/* What evince used to do: run the decompressor, write its output to
+ * a temporary file and load the document from it */
+static gboolean
+spawn_and_render (const gchar *cmd,
+		  const gchar *filename)
+{
+	gchar   *argv[4];
+	gchar    buf[BUFFER_SIZE];
+	gssize   n_read;
+	gchar   *tmp_filename = NULL;
+	gchar   *tmp_uri;
+	gint     fd, pout;
+	gboolean retval;
+	GError  *error = NULL;
+
+	argv[0] = (gchar *) cmd;
+	argv[1] = (gchar *) "-cd";
+	argv[2] = (gchar *) filename;
+	argv[3] = NULL;
+
+	fd = g_file_open_tmp ("test-ev-uncompress-XXXXXX", &tmp_filename, &error);
+	if (fd == -1) {
+		g_warning ("Failed to create temporary file: %s", error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	if (!g_spawn_async_with_pipes (NULL, argv, NULL,
+				       G_SPAWN_SEARCH_PATH | G_SPAWN_STDERR_TO_DEV_NULL,
+				       NULL, NULL, NULL,
+				       NULL, &pout, NULL, &error)) {
+		g_warning ("Failed to run %s: %s", cmd, error->message);
+		g_error_free (error);
+		close (fd);
+		g_unlink (tmp_filename);
+		g_free (tmp_filename);
+		return FALSE;
+	}
+
+	while ((n_read = read (pout, buf, BUFFER_SIZE)) > 0) {
+		if (write (fd, buf, n_read) != n_read)
+			break;
+	}
+	close (pout);
+	close (fd);
+
+	tmp_uri = g_filename_to_uri (tmp_filename, NULL, NULL);
+	retval = render_first_page (tmp_uri);
+	g_free (tmp_uri);
+
+	g_unlink (tmp_filename);
+	g_free (tmp_filename);
+
+	return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+	const gchar *cmd;
+	GFile       *file;
+	gchar       *uri;
+	gchar       *filename;
+	GTimer      *timer;
+	gdouble      in_process = 0, spawn = 0;
+	gint         n_runs = DEFAULT_N_RUNS;
+	gint         i;
+	int          retval = 0;
+
+	if (argc < 2 || argc > 3) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	cmd = get_compressor_cmd (argv[1]);
+	if (!cmd) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (argc == 3)
+		n_runs = MAX (atoi (argv[2]), 1);
+
+	if (!ev_init ()) {
+		g_warning ("No backends found");
+		return 1;
+	}
+
+	file = g_file_new_for_commandline_arg (argv[1]);
+	uri = g_file_get_uri (file);
+	filename = g_file_get_path (file);
+	g_object_unref (file);
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < n_runs && retval == 0; i++) {
+		g_timer_start (timer);
+		if (!render_first_page (uri))
+			retval = 1;
+		in_process += g_timer_elapsed (timer, NULL);
+
+		g_timer_start (timer);
+		if (!spawn_and_render (cmd, filename))
+			retval = 1;
+		spawn += g_timer_elapsed (timer, NULL);
+	}
+
+	g_timer_destroy (timer);
+
+	if (retval == 0) {
+		g_print ("PATH\t\tSECONDS (average of %d runs)\n", n_runs);
+		g_print ("in-process\t%.4f\n", in_process / n_runs);
+		g_print ("%s\t\t%.4f\n", cmd, spawn / n_runs);
+	}
+
+	g_free (uri);
+	g_free (filename);
+	ev_shutdown ();
+
+	return retval;
+}
@@ -23,6 +23,8 @@
 #include "ev-document-model.h"
 #include "ev-view-type-builtins.h"
 #include "ev-view-marshal.h"
+#include "ev-jobs.h"
+#include "ev-job-scheduler.h"
 
 struct _EvDocumentModel
 {
@@ -44,6 +46,9 @@ struct _EvDocumentModel
 
 	gdouble max_scale;
 	gdouble min_scale;
+
+	/* Caches the page sizes of documents loaded lazily */
+	EvJob *page_sizes_job;
 };
 
 enum {
@@ -66,6 +71,7 @@ enum {
 enum
 {
 	PAGE_CHANGED,
+	PAGE_SIZES_CHANGED,
 	N_SIGNALS
 };
 
@@ -76,11 +82,24 @@ G_DEFINE_TYPE (EvDocumentModel, ev_document_model, G_TYPE_OBJECT)
 #define DEFAULT_MIN_SCALE 0.25
 #define DEFAULT_MAX_SCALE 5.0
 
+static void
+ev_document_model_clear_page_sizes_job (EvDocumentModel *model)
+{
+	if (!model->page_sizes_job)
+		return;
+
+	g_signal_handlers_disconnect_by_data (model->page_sizes_job, model);
+	ev_job_cancel (model->page_sizes_job);
+	g_clear_object (&model->page_sizes_job);
+}
+
 static void
 ev_document_model_finalize (GObject *object)
 {
 	EvDocumentModel *model = EV_DOCUMENT_MODEL (object);
 
+	ev_document_model_clear_page_sizes_job (model);
+
 	if (model->document) {
 		g_object_unref (model->document);
 		model->document = NULL;
@@ -322,6 +341,27 @@ ev_document_model_class_init (EvDocumentModelClass *klass)
 			      ev_view_marshal_VOID__INT_INT,
 			      G_TYPE_NONE, 2,
 			      G_TYPE_INT, G_TYPE_INT);
+
+	/**
+	 * EvDocumentModel::page-sizes-changed:
+	 * @model: the #EvDocumentModel
+	 * @first_page: the first page whose size or label changed
+	 * @n_pages: the number of pages that changed
+	 *
+	 * Emitted when the real sizes and labels of a range of pages are
+	 * known, for documents loaded with %EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE.
+	 *
+	 * Since: 3.30
+	 */
+	signals [PAGE_SIZES_CHANGED] =
+		g_signal_new ("page-sizes-changed",
+			      EV_TYPE_DOCUMENT_MODEL,
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL,
+			      ev_view_marshal_VOID__INT_INT,
+			      G_TYPE_NONE, 2,
+			      G_TYPE_INT, G_TYPE_INT);
 }
 
 static void
@@ -336,6 +376,40 @@ ev_document_model_init (EvDocumentModel *model)
 	model->max_scale = DEFAULT_MAX_SCALE;
 }
 
+static void
+page_sizes_job_updated_cb (EvJobPageSizes  *job,
+			   gint             first_page,
+			   gint             n_pages,
+			   EvDocumentModel *model)
+{
+	g_signal_emit (model, signals[PAGE_SIZES_CHANGED], 0, first_page, n_pages);
+}
+
+static void
+page_sizes_job_finished_cb (EvJob           *job,
+			    EvDocumentModel *model)
+{
+	ev_document_model_clear_page_sizes_job (model);
+}
+
+static void
+ev_document_model_cache_page_sizes (EvDocumentModel *model)
+{
+	ev_document_model_clear_page_sizes_job (model);
+
+	if (ev_document_is_cache_complete (model->document))
+		return;
+
+	model->page_sizes_job = ev_job_page_sizes_new (model->document);
+	g_signal_connect (model->page_sizes_job, "updated",
+			  G_CALLBACK (page_sizes_job_updated_cb),
+			  model);
+	g_signal_connect (model->page_sizes_job, "finished",
+			  G_CALLBACK (page_sizes_job_finished_cb),
+			  model);
+	ev_job_scheduler_push_job (model->page_sizes_job, EV_JOB_PRIORITY_LOW);
+}
+
 EvDocumentModel *
 ev_document_model_new (void)
 {
@@ -363,6 +437,7 @@ ev_document_model_set_document (EvDocumentModel *model,
 	if (model->document)
 		g_object_unref (model->document);
 	model->document = g_object_ref (document);
+	ev_document_model_cache_page_sizes (model);
 
 	model->n_pages = ev_document_get_n_pages (document);
 	ev_document_model_set_page (model, CLAMP (model->page, 0,
@@ -25,12 +25,13 @@ typedef struct _EvSchedulerJob {
 	EvJob         *job;
 	EvJobPriority  priority;
 	GSList        *job_link;
+	EvDocument    *running_document;
 } EvSchedulerJob;
 
 G_LOCK_DEFINE_STATIC(job_list);
 static GSList *job_list = NULL;
 
-static volatile EvJob *running_job = NULL;
+static GPrivate running_job;
 
 static gpointer ev_job_thread_proxy               (gpointer        data);
 static void     ev_scheduler_thread_job_cancelled (EvSchedulerJob *job,
@@ -51,6 +52,12 @@ static GQueue *job_queue[EV_JOB_N_PRIORITIES] = {
 	&queue_none
 };
 
+/* Worker pool, protected by job_queue_mutex */
+static guint       n_workers = 0;
+static guint       max_workers = 0;
+static GHashTable *busy_documents = NULL;
+static GHashTable *running_jobs = NULL;
+
 static void
 ev_job_queue_push (EvSchedulerJob *job,
 		   EvJobPriority   priority)
@@ -65,27 +72,120 @@ ev_job_queue_push (EvSchedulerJob *job,
 	g_mutex_unlock (&job_queue_mutex);
 }
 
+/* Jobs of a document whose backend is not thread-safe are run by one
+ * worker at a time, otherwise the other workers would pop them and just
+ * wait for the document lock, losing the priority order.
+ */
+static gboolean
+ev_job_queue_job_is_runnable_unlocked (EvSchedulerJob *job)
+{
+	EvDocument *document = job->job->document;
+
+	if (!document || ev_document_is_thread_safe (document))
+		return TRUE;
+
+	return !g_hash_table_contains (busy_documents, document);
+}
+
+static void
+ev_job_queue_job_started_unlocked (EvSchedulerJob *job)
+{
+	EvDocument *document = job->job->document;
+	guint       n_running;
+
+	/* Load jobs set the document while running */
+	job->running_document = document;
+	if (!document)
+		return;
+
+	n_running = GPOINTER_TO_UINT (g_hash_table_lookup (busy_documents, document));
+	g_hash_table_insert (busy_documents, document, GUINT_TO_POINTER (n_running + 1));
+}
+
+static void
+ev_job_queue_job_done (EvSchedulerJob *job)
+{
+	EvDocument *document = job->running_document;
+	guint       n_running;
+
+	if (!document)
+		return;
+
+	g_mutex_lock (&job_queue_mutex);
+
+	n_running = GPOINTER_TO_UINT (g_hash_table_lookup (busy_documents, document));
+	if (n_running > 1)
+		g_hash_table_insert (busy_documents, document, GUINT_TO_POINTER (n_running - 1));
+	else
+		g_hash_table_remove (busy_documents, document);
+	g_cond_broadcast (&job_queue_cond);
+
+	g_mutex_unlock (&job_queue_mutex);
+}
+
 static EvSchedulerJob *
 ev_job_queue_get_next_unlocked (void)
 {
 	gint i;
 	EvSchedulerJob *job = NULL;
 	
-	for (i = EV_JOB_PRIORITY_URGENT; i < EV_JOB_N_PRIORITIES; i++) {
-		job = (EvSchedulerJob *) g_queue_pop_head (job_queue[i]);
-		if (job)
-			break;
+	for (i = EV_JOB_PRIORITY_URGENT; i < EV_JOB_N_PRIORITIES && !job; i++) {
+		GList *l;
+
+		for (l = g_queue_peek_head_link (job_queue[i]); l; l = g_list_next (l)) {
+			if (ev_job_queue_job_is_runnable_unlocked (l->data)) {
+				job = (EvSchedulerJob *) l->data;
+				g_queue_delete_link (job_queue[i], l);
+				break;
+			}
+		}
 	}
 
-	ev_debug_message (DEBUG_JOBS, "%s", job ? EV_GET_TYPE_NAME (job->job) : "No jobs in queue");
+	if (job)
+		ev_job_queue_job_started_unlocked (job);
+
+	ev_debug_message (DEBUG_JOBS, "%s", job ? EV_GET_TYPE_NAME (job->job) : "No runnable jobs in queue");
 
 	return job;
 }
 
+static guint
+ev_job_scheduler_get_default_n_threads (void)
+{
+	const gchar *env;
+
+	env = g_getenv ("EV_JOB_SCHEDULER_THREADS");
+	if (env) {
+		guint64 n_threads = g_ascii_strtoull (env, NULL, 10);
+
+		if (n_threads > 0)
+			return MIN (n_threads, G_MAXUINT);
+	}
+
+	return g_get_num_processors ();
+}
+
+static void
+ev_job_scheduler_spawn_workers_unlocked (void)
+{
+	while (n_workers < max_workers) {
+		g_thread_unref (g_thread_new ("EvJobScheduler", ev_job_thread_proxy, NULL));
+		n_workers++;
+	}
+}
+
 static gpointer
 ev_job_scheduler_init (gpointer data)
 {
-	g_thread_new ("EvJobScheduler", ev_job_thread_proxy, NULL);
+	g_mutex_lock (&job_queue_mutex);
+
+	busy_documents = g_hash_table_new (g_direct_hash, g_direct_equal);
+	running_jobs = g_hash_table_new (g_direct_hash, g_direct_equal);
+	if (max_workers == 0)
+		max_workers = ev_job_scheduler_get_default_n_threads ();
+	ev_job_scheduler_spawn_workers_unlocked ();
+
+	g_mutex_unlock (&job_queue_mutex);
 
 	return NULL;
 }
@@ -169,23 +269,30 @@ ev_scheduler_thread_job_cancelled (EvSchedulerJob *job,
 	}
 }
 
-static void
+/* Returns whether the job has to be run again */
+static gboolean
 ev_job_thread (EvJob *job)
 {
 	gboolean result;
 
 	ev_debug_message (DEBUG_JOBS, "%s", EV_GET_TYPE_NAME (job));
 
-	do {
-		if (g_cancellable_is_cancelled (job->cancellable))
-			result = FALSE;
-		else {
-                        g_atomic_pointer_set (&running_job, job);
-			result = ev_job_run (job);
-                }
-	} while (result);
+	if (g_cancellable_is_cancelled (job->cancellable))
+		return FALSE;
+
+	g_mutex_lock (&job_queue_mutex);
+	g_hash_table_add (running_jobs, job);
+	g_mutex_unlock (&job_queue_mutex);
 
-        g_atomic_pointer_set (&running_job, NULL);
+        g_private_set (&running_job, job);
+	result = ev_job_run (job);
+        g_private_set (&running_job, NULL);
+
+	g_mutex_lock (&job_queue_mutex);
+	g_hash_table_remove (running_jobs, job);
+	g_mutex_unlock (&job_queue_mutex);
+
+	return result && !g_cancellable_is_cancelled (job->cancellable);
 }
 
 static gboolean
@@ -206,6 +313,13 @@ ev_job_thread_proxy (gpointer data)
 		EvSchedulerJob *job;
 
 		g_mutex_lock (&job_queue_mutex);
+		if (n_workers > max_workers) {
+			/* The pool was shrunk, let this worker go */
+			n_workers--;
+			g_mutex_unlock (&job_queue_mutex);
+			break;
+		}
+
 		job = ev_job_queue_get_next_unlocked ();
 		if (!job) {
 			g_cond_wait (&job_queue_cond, &job_queue_mutex);
@@ -214,21 +328,38 @@ ev_job_thread_proxy (gpointer data)
 		}
 		g_mutex_unlock (&job_queue_mutex);
 		
-		ev_job_thread (job->job);
+		if (ev_job_thread (job->job)) {
+			/* Jobs run in steps go back to the queue, so the
+			 * jobs pushed meanwhile can run in between, and
+			 * other jobs of a document that is not thread-safe
+			 * don't have to wait for all the steps */
+			ev_job_queue_job_done (job);
+			ev_job_queue_push (job, job->priority);
+			continue;
+		}
+
+		ev_job_queue_job_done (job);
 		ev_scheduler_job_destroy (job);
 	}
 
 	return NULL;
 }
 
+static void
+ev_job_scheduler_ensure_init (void)
+{
+	static GOnce once_init = G_ONCE_INIT;
+
+	g_once (&once_init, ev_job_scheduler_init, NULL);
+}
+
 void
 ev_job_scheduler_push_job (EvJob         *job,
 			   EvJobPriority  priority)
 {
-	static GOnce once_init = G_ONCE_INIT;
 	EvSchedulerJob *s_job;
 
-	g_once (&once_init, ev_job_scheduler_init, NULL);
+	ev_job_scheduler_ensure_init ();
 
 	ev_debug_message (DEBUG_JOBS, "%s pirority %d", EV_GET_TYPE_NAME (job), priority);
 
@@ -310,10 +441,89 @@ ev_job_scheduler_update_job (EvJob         *job,
 /**
  * ev_job_scheduler_get_running_thread_job:
  *
- * Returns: (transfer none): an #EvJob
+ * Returns the job being run by the calling scheduler thread. Use
+ * ev_job_scheduler_is_job_running() to know from the main thread
+ * whether a job is being run by any of the scheduler threads.
+ *
+ * Returns: (transfer none): an #EvJob, or %NULL when not called
+ * from a scheduler thread
  */
 EvJob *
 ev_job_scheduler_get_running_thread_job (void)
 {
-        return g_atomic_pointer_get (&running_job);
+        return g_private_get (&running_job);
+}
+
+/**
+ * ev_job_scheduler_is_job_running:
+ * @job: an #EvJob
+ *
+ * Returns: %TRUE if @job is being run by a scheduler thread
+ *
+ * Since: 3.30
+ */
+gboolean
+ev_job_scheduler_is_job_running (EvJob *job)
+{
+	gboolean running;
+
+	ev_job_scheduler_ensure_init ();
+
+	g_mutex_lock (&job_queue_mutex);
+	running = g_hash_table_contains (running_jobs, job);
+	g_mutex_unlock (&job_queue_mutex);
+
+	return running;
+}
+
+/**
+ * ev_job_scheduler_set_n_threads:
+ * @n_threads: the number of worker threads, or 0 for the default
+ *
+ * Sets the number of threads used to run #EV_JOB_RUN_THREAD jobs. The
+ * default is the number of processors, which can be overridden with
+ * the EV_JOB_SCHEDULER_THREADS environment variable. When the pool
+ * shrinks, the extra workers exit after finishing their current job.
+ *
+ * Since: 3.30
+ */
+void
+ev_job_scheduler_set_n_threads (guint n_threads)
+{
+	if (n_threads == 0)
+		n_threads = ev_job_scheduler_get_default_n_threads ();
+
+	g_mutex_lock (&job_queue_mutex);
+	max_workers = n_threads;
+	g_mutex_unlock (&job_queue_mutex);
+
+	ev_job_scheduler_ensure_init ();
+
+	g_mutex_lock (&job_queue_mutex);
+
+	ev_job_scheduler_spawn_workers_unlocked ();
+	g_cond_broadcast (&job_queue_cond);
+
+	g_mutex_unlock (&job_queue_mutex);
+}
+
+/**
+ * ev_job_scheduler_get_n_threads:
+ *
+ * Returns: the number of worker threads of the scheduler
+ *
+ * Since: 3.30
+ */
+guint
+ev_job_scheduler_get_n_threads (void)
+{
+	guint n_threads;
+
+	ev_job_scheduler_ensure_init ();
+
+	g_mutex_lock (&job_queue_mutex);
+	n_threads = max_workers;
+	g_mutex_unlock (&job_queue_mutex);
+
+	return n_threads;
 }
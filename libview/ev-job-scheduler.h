@@ -38,11 +38,14 @@ typedef enum {
 	EV_JOB_N_PRIORITIES
 } EvJobPriority;
 
-void   ev_job_scheduler_push_job               (EvJob        *job,
-                                                EvJobPriority priority);
-void   ev_job_scheduler_update_job             (EvJob        *job,
-                                                EvJobPriority priority);
-EvJob *ev_job_scheduler_get_running_thread_job (void);
+void     ev_job_scheduler_push_job               (EvJob        *job,
+                                                  EvJobPriority priority);
+void     ev_job_scheduler_update_job             (EvJob        *job,
+                                                  EvJobPriority priority);
+EvJob   *ev_job_scheduler_get_running_thread_job (void);
+gboolean ev_job_scheduler_is_job_running         (EvJob        *job);
+void     ev_job_scheduler_set_n_threads          (guint         n_threads);
+guint    ev_job_scheduler_get_n_threads          (void);
 
 G_END_DECLS
 
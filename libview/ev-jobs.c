@@ -29,6 +29,7 @@
 #include "ev-document-misc.h"
 #include "ev-file-helpers.h"
 #include "ev-document-fonts.h"
+#include "ev-view-marshal.h"
 #include "ev-document-security.h"
 #include "ev-document-find.h"
 #include "ev-document-layers.h"
@@ -37,6 +38,8 @@
 #include "ev-document-attachments.h"
 #include "ev-document-media.h"
 #include "ev-document-text.h"
+#include "ev-search-index.h"
+#include "ev-job-scheduler.h"
 #include "ev-debug.h"
 
 #include <errno.h>
@@ -64,10 +67,16 @@ static void ev_job_save_init              (EvJobSave             *job);
 static void ev_job_save_class_init        (EvJobSaveClass        *class);
 static void ev_job_find_init              (EvJobFind             *job);
 static void ev_job_find_class_init        (EvJobFindClass        *class);
+static void ev_job_search_index_init      (EvJobSearchIndex      *job);
+static void ev_job_search_index_class_init (EvJobSearchIndexClass *class);
+static void ev_job_page_sizes_init        (EvJobPageSizes        *job);
+static void ev_job_page_sizes_class_init  (EvJobPageSizesClass   *class);
 static void ev_job_layers_init            (EvJobLayers           *job);
 static void ev_job_layers_class_init      (EvJobLayersClass      *class);
 static void ev_job_export_init            (EvJobExport           *job);
 static void ev_job_export_class_init      (EvJobExportClass      *class);
+static void ev_job_export_render_init     (EvJobExportRender     *job);
+static void ev_job_export_render_class_init (EvJobExportRenderClass *class);
 static void ev_job_print_init             (EvJobPrint            *job);
 static void ev_job_print_class_init       (EvJobPrintClass       *class);
 
@@ -87,9 +96,21 @@ enum {
 	FIND_LAST_SIGNAL
 };
 
+enum {
+	PAGE_SIZES_UPDATED,
+	PAGE_SIZES_LAST_SIGNAL
+};
+
+enum {
+	ANNOTS_UPDATED,
+	ANNOTS_LAST_SIGNAL
+};
+
 static guint job_signals[LAST_SIGNAL] = { 0 };
 static guint job_fonts_signals[FONTS_LAST_SIGNAL] = { 0 };
 static guint job_find_signals[FIND_LAST_SIGNAL] = { 0 };
+static guint job_page_sizes_signals[PAGE_SIZES_LAST_SIGNAL] = { 0 };
+static guint job_annots_signals[ANNOTS_LAST_SIGNAL] = { 0 };
 
 G_DEFINE_ABSTRACT_TYPE (EvJob, ev_job, G_TYPE_OBJECT)
 G_DEFINE_TYPE (EvJobLinks, ev_job_links, EV_TYPE_JOB)
@@ -104,8 +125,11 @@ G_DEFINE_TYPE (EvJobLoadStream, ev_job_load_stream, EV_TYPE_JOB)
 G_DEFINE_TYPE (EvJobLoadGFile, ev_job_load_gfile, EV_TYPE_JOB)
 G_DEFINE_TYPE (EvJobSave, ev_job_save, EV_TYPE_JOB)
 G_DEFINE_TYPE (EvJobFind, ev_job_find, EV_TYPE_JOB)
+G_DEFINE_TYPE (EvJobSearchIndex, ev_job_search_index, EV_TYPE_JOB)
+G_DEFINE_TYPE (EvJobPageSizes, ev_job_page_sizes, EV_TYPE_JOB)
 G_DEFINE_TYPE (EvJobLayers, ev_job_layers, EV_TYPE_JOB)
 G_DEFINE_TYPE (EvJobExport, ev_job_export, EV_TYPE_JOB)
+G_DEFINE_TYPE (EvJobExportRender, ev_job_export_render, EV_TYPE_JOB)
 G_DEFINE_TYPE (EvJobPrint, ev_job_print, EV_TYPE_JOB)
 
 /* EvJob */
@@ -342,9 +366,50 @@ ev_job_links_dispose (GObject *object)
 		job->model = NULL;
 	}
 
+	if (job->page_paths) {
+		g_array_free (job->page_paths, TRUE);
+		job->page_paths = NULL;
+	}
+
 	(* G_OBJECT_CLASS (ev_job_links_parent_class)->dispose) (object);
 }
 
+/* The first row pointing to each page, sorted by page, so that the row
+ * for the current page is found without walking the model */
+typedef struct {
+	gint         page;
+	GtkTreePath *path;
+} LinkPagePath;
+
+static void
+link_page_path_clear (LinkPagePath *page_path)
+{
+	gtk_tree_path_free (page_path->path);
+}
+
+static gint
+link_page_path_compare (const LinkPagePath *a,
+			const LinkPagePath *b)
+{
+	if (a->page != b->page)
+		return a->page < b->page ? -1 : 1;
+
+	return gtk_tree_path_compare (a->path, b->path);
+}
+
+static EvLinkDest *
+get_link_dest (EvLink *link)
+{
+	EvLinkAction *action;
+
+	action = ev_link_get_action (link);
+	if (!action ||
+	    ev_link_action_get_action_type (action) != EV_LINK_ACTION_TYPE_GOTO_DEST)
+		return NULL;
+
+	return ev_link_action_get_dest (action);
+}
+
 static gboolean
 fill_page_labels (GtkTreeModel   *tree_model,
 		  GtkTreePath    *path,
@@ -353,6 +418,8 @@ fill_page_labels (GtkTreeModel   *tree_model,
 {
 	EvDocumentLinks *document_links;
 	EvLink          *link;
+	EvLinkDest      *dest;
+	LinkPagePath     page_path;
 	gchar           *page_label;
 
 	gtk_tree_model_get (tree_model, iter,
@@ -362,21 +429,61 @@ fill_page_labels (GtkTreeModel   *tree_model,
 	if (!link)
 		return FALSE;
 
-	document_links = EV_DOCUMENT_LINKS (job->document);
-	page_label = ev_document_links_get_link_page_label (document_links, link);
-	if (!page_label)
+	dest = get_link_dest (link);
+	if (!dest) {
+		g_object_unref (link);
 		return FALSE;
+	}
 
-	gtk_tree_store_set (GTK_TREE_STORE (tree_model), iter,
-			    EV_DOCUMENT_LINKS_COLUMN_PAGE_LABEL, page_label,
-			    -1);
+	/* The page is resolved once for both the label and the index */
+	document_links = EV_DOCUMENT_LINKS (job->document);
+	page_path.page = ev_document_links_get_dest_page (document_links, dest);
+	if (ev_link_dest_get_dest_type (dest) == EV_LINK_DEST_TYPE_PAGE_LABEL)
+		page_label = g_strdup (ev_link_dest_get_page_label (dest));
+	else if (page_path.page != -1)
+		page_label = ev_document_get_page_label (job->document, page_path.page);
+	else
+		page_label = NULL;
+
+	if (page_path.page >= 0) {
+		page_path.path = gtk_tree_path_copy (path);
+		g_array_append_val (EV_JOB_LINKS (job)->page_paths, page_path);
+	}
+
+	if (page_label) {
+		gtk_tree_store_set (GTK_TREE_STORE (tree_model), iter,
+				    EV_DOCUMENT_LINKS_COLUMN_PAGE_LABEL, page_label,
+				    -1);
+		g_free (page_label);
+	}
 
-	g_free (page_label);
 	g_object_unref (link);
 
 	return FALSE;
 }
 
+static void
+build_page_paths (EvJobLinks *job)
+{
+	GArray *page_paths = job->page_paths;
+	guint   i, n = 0;
+
+	g_array_sort (page_paths, (GCompareFunc) link_page_path_compare);
+
+	/* Only the first row in the model is kept for every page */
+	for (i = 0; i < page_paths->len; i++) {
+		LinkPagePath *page_path = &g_array_index (page_paths, LinkPagePath, i);
+
+		if (n > 0 && g_array_index (page_paths, LinkPagePath, n - 1).page == page_path->page) {
+			gtk_tree_path_free (page_path->path);
+			continue;
+		}
+
+		g_array_index (page_paths, LinkPagePath, n++) = *page_path;
+	}
+	page_paths->len = n;
+}
+
 static gboolean
 ev_job_links_run (EvJob *job)
 {
@@ -385,11 +492,16 @@ ev_job_links_run (EvJob *job)
 	ev_debug_message (DEBUG_JOBS, NULL);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 	
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (job->document);
 	job_links->model = ev_document_links_get_links_model (EV_DOCUMENT_LINKS (job->document));
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (job->document);
 
-	gtk_tree_model_foreach (job_links->model, (GtkTreeModelForeachFunc)fill_page_labels, job);
+	job_links->page_paths = g_array_new (FALSE, FALSE, sizeof (LinkPagePath));
+	g_array_set_clear_func (job_links->page_paths, (GDestroyNotify) link_page_path_clear);
+	if (job_links->model) {
+		gtk_tree_model_foreach (job_links->model, (GtkTreeModelForeachFunc)fill_page_labels, job);
+		build_page_paths (job_links);
+	}
 
 	ev_job_succeeded (job);
 	
@@ -435,6 +547,47 @@ ev_job_links_get_model (EvJobLinks *job)
 	return job->model;
 }
 
+/**
+ * ev_job_links_get_page_path:
+ * @job: a finished #EvJobLinks
+ * @page: the index of a page
+ *
+ * Finds the row of the links model to show for @page: the first row
+ * pointing to @page or, if there's none, to the closest page before it.
+ *
+ * Return value: (transfer full) (nullable): the #GtkTreePath of the row,
+ *   or %NULL if no row points to @page or a page before it
+ *
+ * Since: 3.30
+ */
+GtkTreePath *
+ev_job_links_get_page_path (EvJobLinks *job,
+			    gint        page)
+{
+	guint low = 0, high;
+
+	g_return_val_if_fail (EV_IS_JOB_LINKS (job), NULL);
+
+	if (!job->page_paths)
+		return NULL;
+
+	/* The last row pointing to a page up to @page */
+	high = job->page_paths->len;
+	while (low < high) {
+		guint mid = low + (high - low) / 2;
+
+		if (g_array_index (job->page_paths, LinkPagePath, mid).page <= page)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if (low == 0)
+		return NULL;
+
+	return gtk_tree_path_copy (g_array_index (job->page_paths, LinkPagePath, low - 1).path);
+}
+
 /* EvJobAttachments */
 static void
 ev_job_attachments_init (EvJobAttachments *job)
@@ -468,10 +621,10 @@ ev_job_attachments_run (EvJob *job)
 	ev_debug_message (DEBUG_JOBS, NULL);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (job->document);
 	job_attachments->attachments =
 		ev_document_attachments_get_attachments (EV_DOCUMENT_ATTACHMENTS (job->document));
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (job->document);
 
 	ev_job_succeeded (job);
 
@@ -502,10 +655,19 @@ ev_job_attachments_new (EvDocument *document)
 }
 
 /* EvJobAnnots */
+
+/* Longest time the document is kept locked while scanning, so that
+ * pages are still rendered meanwhile, in microseconds */
+#define ANNOTS_LOCK_TIME (G_USEC_PER_SEC / 100)
+/* Minimum time between "updated" signals, in microseconds */
+#define ANNOTS_UPDATE_INTERVAL (G_USEC_PER_SEC / 10)
+
 static void
 ev_job_annots_init (EvJobAnnots *job)
 {
 	EV_JOB (job)->run_mode = EV_JOB_RUN_THREAD;
+
+	g_mutex_init (&job->mutex);
 }
 
 static void
@@ -523,35 +685,130 @@ ev_job_annots_dispose (GObject *object)
 		job->annots = NULL;
 	}
 
+	if (job->found) {
+		g_list_free_full (job->found, (GDestroyNotify)ev_mapping_list_unref);
+		job->found = NULL;
+	}
+
 	G_OBJECT_CLASS (ev_job_annots_parent_class)->dispose (object);
 }
 
+static void
+ev_job_annots_finalize (GObject *object)
+{
+	EvJobAnnots *job = EV_JOB_ANNOTS (object);
+
+	g_mutex_clear (&job->mutex);
+
+	G_OBJECT_CLASS (ev_job_annots_parent_class)->finalize (object);
+}
+
+static gint
+compare_mapping_list_page (EvMappingList *a,
+			   EvMappingList *b)
+{
+	return (gint) ev_mapping_list_get_page (a) - (gint) ev_mapping_list_get_page (b);
+}
+
+/* Moves the pages found since the last update to annots, which is
+ * kept in page order, and reports them in the order they were found */
+static gboolean
+ev_job_annots_emit_updated (EvJobAnnots *job)
+{
+	GList *found, *l;
+
+	g_mutex_lock (&job->mutex);
+	found = g_list_reverse (job->found);
+	job->found = NULL;
+	job->updated_id = 0;
+	g_mutex_unlock (&job->mutex);
+
+	for (l = found; l; l = g_list_next (l)) {
+		job->annots = g_list_insert_sorted (job->annots, l->data,
+						    (GCompareFunc)compare_mapping_list_page);
+	}
+
+	for (l = found; l; l = g_list_next (l)) {
+		/* A handler may have cancelled the job */
+		if (g_cancellable_is_cancelled (EV_JOB (job)->cancellable))
+			break;
+
+		g_signal_emit (job, job_annots_signals[ANNOTS_UPDATED], 0, l->data);
+	}
+	g_list_free (found);
+
+	return FALSE;
+}
+
+static void
+ev_job_annots_queue_updated (EvJobAnnots *job,
+			     gboolean     complete)
+{
+	gint64 now;
+
+	g_mutex_lock (&job->mutex);
+	now = g_get_monotonic_time ();
+	if (job->updated_id == 0 && job->found &&
+	    (complete || now - job->last_updated >= ANNOTS_UPDATE_INTERVAL)) {
+		job->last_updated = now;
+		job->updated_id =
+			g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+					 (GSourceFunc)ev_job_annots_emit_updated,
+					 g_object_ref (job),
+					 (GDestroyNotify)g_object_unref);
+	}
+	g_mutex_unlock (&job->mutex);
+}
+
+/* Scans the pages for ANNOTS_LOCK_TIME on every run, so that the
+ * scheduler runs the other jobs of the document in between */
 static gboolean
 ev_job_annots_run (EvJob *job)
 {
 	EvJobAnnots *job_annots = EV_JOB_ANNOTS (job);
-	gint         i;
+	gint         n_pages;
+	gint64       start;
 
 	ev_debug_message (DEBUG_JOBS, NULL);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 
-	ev_document_doc_mutex_lock ();
-	for (i = 0; i < ev_document_get_n_pages (job->document); i++) {
+	if (g_cancellable_is_cancelled (job->cancellable))
+		return FALSE;
+
+	n_pages = ev_document_get_n_pages (job->document);
+
+	ev_document_lock (job->document);
+	start = g_get_monotonic_time ();
+	while (job_annots->n_scanned < n_pages &&
+	       g_get_monotonic_time () - start < ANNOTS_LOCK_TIME) {
 		EvMappingList *mapping_list;
 		EvPage        *page;
 
-		page = ev_document_get_page (job->document, i);
+		/* From start_page on, so that the pages around
+		 * the current one are reported first */
+		page = ev_document_get_page (job->document,
+					     (job_annots->start_page + job_annots->n_scanned++) % n_pages);
 		mapping_list = ev_document_annotations_get_annotations (EV_DOCUMENT_ANNOTATIONS (job->document),
 									page);
 		g_object_unref (page);
 
-		if (mapping_list)
-			job_annots->annots = g_list_prepend (job_annots->annots, mapping_list);
+		if (mapping_list) {
+			g_mutex_lock (&job_annots->mutex);
+			job_annots->found = g_list_prepend (job_annots->found, mapping_list);
+			g_mutex_unlock (&job_annots->mutex);
+		}
 	}
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (job->document);
+	job_annots->n_batches++;
 
-	job_annots->annots = g_list_reverse (job_annots->annots);
+	/* Queued before the job finishes, so that
+	 * "updated" is emitted before "finished" */
+	ev_job_annots_queue_updated (job_annots, job_annots->n_scanned >= n_pages);
+
+	if (job_annots->n_scanned < n_pages)
+		return TRUE;
 
+	ev_debug_message (DEBUG_JOBS, "%d pages scanned in %u batches", n_pages, job_annots->n_batches);
 	ev_job_succeeded (job);
 
 	return FALSE;
@@ -564,9 +821,31 @@ ev_job_annots_class_init (EvJobAnnotsClass *class)
 	EvJobClass   *job_class = EV_JOB_CLASS (class);
 
 	oclass->dispose = ev_job_annots_dispose;
+	oclass->finalize = ev_job_annots_finalize;
 	job_class->run = ev_job_annots_run;
+
+	job_annots_signals[ANNOTS_UPDATED] =
+		g_signal_new ("updated",
+			      EV_TYPE_JOB_ANNOTS,
+			      G_SIGNAL_RUN_LAST,
+			      G_STRUCT_OFFSET (EvJobAnnotsClass, updated),
+			      NULL, NULL,
+			      g_cclosure_marshal_VOID__BOXED,
+			      G_TYPE_NONE,
+			      1, EV_TYPE_MAPPING_LIST);
 }
 
+/**
+ * ev_job_annots_new:
+ * @document: an #EvDocument implementing #EvDocumentAnnotations
+ *
+ * Creates a job that gets the annotations of every page of @document.
+ * The "updated" signal is emitted with the annotations of every page
+ * that has some as they are found, and when the job finishes they are
+ * all in the annots list, in page order.
+ *
+ * Returns: (transfer full): a new #EvJob
+ */
 EvJob *
 ev_job_annots_new (EvDocument *document)
 {
@@ -580,6 +859,25 @@ ev_job_annots_new (EvDocument *document)
 	return job;
 }
 
+/**
+ * ev_job_annots_set_start_page:
+ * @job: an #EvJobAnnots
+ * @start_page: the page to scan first
+ *
+ * Makes @job scan the pages from @start_page on, wrapping around at
+ * the end of the document. It must be called before @job is run.
+ *
+ * Since: 3.30
+ */
+void
+ev_job_annots_set_start_page (EvJobAnnots *job,
+			      gint         start_page)
+{
+	g_return_if_fail (EV_IS_JOB_ANNOTS (job));
+
+	job->start_page = MAX (start_page, 0);
+}
+
 /* EvJobRender */
 static void
 ev_job_render_init (EvJobRender *job)
@@ -620,27 +918,34 @@ ev_job_render_run (EvJob *job)
 	EvJobRender     *job_render = EV_JOB_RENDER (job);
 	EvPage          *ev_page;
 	EvRenderContext *rc;
+	gboolean         thread_safe;
 
 	ev_debug_message (DEBUG_JOBS, "page: %d (%p)", job_render->page, job);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 	
-	ev_document_doc_mutex_lock ();
+	ev_document_render_lock (job->document);
 
 	ev_profiler_start (EV_PROFILE_JOBS, "Rendering page %d", job_render->page);
-		
-	ev_document_fc_mutex_lock ();
+
+	/* Thread-safe backends take care of fontconfig themselves */
+	thread_safe = ev_document_is_thread_safe (job->document);
+	if (!thread_safe)
+		ev_document_fc_mutex_lock ();
 
 	ev_page = ev_document_get_page (job->document, job_render->page);
 	rc = ev_render_context_new (ev_page, job_render->rotation, job_render->scale);
 	ev_render_context_set_target_size (rc,
 					   job_render->target_width, job_render->target_height);
+	if (job_render->has_area)
+		ev_render_context_set_area (rc, &job_render->area);
 	g_object_unref (ev_page);
 
 	job_render->surface = ev_document_render (job->document, rc);
 
 	if (job_render->surface == NULL) {
-		ev_document_fc_mutex_unlock ();
-		ev_document_doc_mutex_unlock ();
+		if (!thread_safe)
+			ev_document_fc_mutex_unlock ();
+		ev_document_render_unlock (job->document);
 		g_object_unref (rc);
 
 		ev_job_failed (job,
@@ -656,8 +961,9 @@ ev_job_render_run (EvJob *job)
 	 * we return now, so that the thread is finished ASAP
 	 */
 	if (g_cancellable_is_cancelled (job->cancellable)) {
-		ev_document_fc_mutex_unlock ();
-		ev_document_doc_mutex_unlock ();
+		if (!thread_safe)
+			ev_document_fc_mutex_unlock ();
+		ev_document_render_unlock (job->document);
 		g_object_unref (rc);
 
 		return FALSE;
@@ -680,8 +986,9 @@ ev_job_render_run (EvJob *job)
 
 	g_object_unref (rc);
 
-	ev_document_fc_mutex_unlock ();
-	ev_document_doc_mutex_unlock ();
+	if (!thread_safe)
+		ev_document_fc_mutex_unlock ();
+	ev_document_render_unlock (job->document);
 	
 	ev_job_succeeded (job);
 	
@@ -737,6 +1044,27 @@ ev_job_render_set_selection_info (EvJobRender     *job,
 	job->base = *base;
 }
 
+/**
+ * ev_job_render_set_area:
+ * @job: an #EvJobRender
+ * @area: (allow-none): the area of the page to render, or %NULL
+ *
+ * Restricts the job to render only @area of the page, in pixels of
+ * the rotated and scaled page. See ev_render_context_set_area().
+ *
+ * Since: 3.30
+ */
+void
+ev_job_render_set_area (EvJobRender                 *job,
+			const cairo_rectangle_int_t *area)
+{
+	g_return_if_fail (EV_IS_JOB_RENDER (job));
+
+	job->has_area = area != NULL;
+	if (area)
+		job->area = *area;
+}
+
 /* EvJobPageData */
 static void
 ev_job_page_data_init (EvJobPageData *job)
@@ -753,7 +1081,7 @@ ev_job_page_data_run (EvJob *job)
 	ev_debug_message (DEBUG_JOBS, "page: %d (%p)", job_pd->page, job);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (job->document);
 	ev_page = ev_document_get_page (job->document, job_pd->page);
 
 	if ((job_pd->flags & EV_PAGE_DATA_INCLUDE_TEXT_MAPPING) && EV_IS_DOCUMENT_TEXT (job->document))
@@ -798,7 +1126,7 @@ ev_job_page_data_run (EvJob *job)
                         ev_document_media_get_media_mapping (EV_DOCUMENT_MEDIA (job->document),
                                                              ev_page);
 	g_object_unref (ev_page);
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (job->document);
 
 	ev_job_succeeded (job);
 
@@ -871,7 +1199,7 @@ ev_job_thumbnail_run (EvJob *job)
 	ev_debug_message (DEBUG_JOBS, "%d (%p)", job_thumb->page, job);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 	
-	ev_document_doc_mutex_lock ();
+	ev_document_render_lock (job->document);
 
 	page = ev_document_get_page (job->document, job_thumb->page);
 	rc = ev_render_context_new (page, job_thumb->rotation, job_thumb->scale);
@@ -884,7 +1212,7 @@ ev_job_thumbnail_run (EvJob *job)
         else
                 job_thumb->thumbnail_surface = ev_document_get_thumbnail_surface (job->document, rc);
 	g_object_unref (rc);
-	ev_document_doc_mutex_unlock ();
+	ev_document_render_unlock (job->document);
 
         /* EV_JOB_THUMBNAIL_SURFACE is not compatible with has_frame = TRUE */
         if (job_thumb->format == EV_JOB_THUMBNAIL_PIXBUF && pixbuf) {
@@ -1003,11 +1331,13 @@ ev_job_fonts_run (EvJob *job)
 	ev_debug_message (DEBUG_JOBS, NULL);
 	
 	/* Do not block the main loop */
-	if (!ev_document_doc_mutex_trylock ())
+	if (!ev_document_trylock (job->document))
 		return TRUE;
 	
-	if (!ev_document_fc_mutex_trylock ())
+	if (!ev_document_fc_mutex_trylock ()) {
+		ev_document_unlock (job->document);
 		return TRUE;
+	}
 
 #ifdef EV_ENABLE_DEBUG
 	/* We use the #ifdef in this case because of the if */
@@ -1020,7 +1350,7 @@ ev_job_fonts_run (EvJob *job)
 		       ev_document_fonts_get_progress (fonts));
 
 	ev_document_fc_mutex_unlock ();
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (job->document);
 
 	if (job_fonts->scan_completed)
 		ev_job_succeeded (job);
@@ -1103,6 +1433,7 @@ ev_job_load_run (EvJob *job)
 	   creating a new instance */
 	if (job->document) {
 		const gchar *uncompressed_uri;
+		GBytes      *uncompressed_bytes;
 
 		if (job_load->password) {
 			ev_document_security_set_password (EV_DOCUMENT_SECURITY (job->document),
@@ -1115,12 +1446,27 @@ ev_job_load_run (EvJob *job)
 
 		uncompressed_uri = g_object_get_data (G_OBJECT (job->document),
 						      "uri-uncompressed");
-		ev_document_load (job->document,
-				  uncompressed_uri ? uncompressed_uri : job_load->uri,
-				  &error);
+		uncompressed_bytes = g_object_get_data (G_OBJECT (job->document),
+							"bytes-uncompressed");
+		if (uncompressed_bytes) {
+			GInputStream *stream;
+
+			/* Compressed document decompressed in memory */
+			stream = g_memory_input_stream_new_from_bytes (uncompressed_bytes);
+			ev_document_load_stream (job->document, stream,
+						 job_load->flags,
+						 NULL, &error);
+			g_object_unref (stream);
+		} else {
+			ev_document_load_full (job->document,
+					       uncompressed_uri ? uncompressed_uri : job_load->uri,
+					       job_load->flags,
+					       &error);
+		}
 	} else {
-		job->document = ev_document_factory_get_document (job_load->uri,
-								  &error);
+		job->document = ev_document_factory_get_document_full (job_load->uri,
+								       job_load->flags,
+								       &error);
 	}
 
 	ev_document_fc_mutex_unlock ();
@@ -1178,6 +1524,22 @@ ev_job_load_set_password (EvJobLoad *job, const gchar *password)
 	job->password = password ? g_strdup (password) : NULL;
 }
 
+/**
+ * ev_job_load_set_load_flags:
+ * @job: an #EvJobLoad
+ * @flags: the #EvDocumentLoadFlags to load the document with
+ *
+ * Since: 3.30
+ */
+void
+ev_job_load_set_load_flags (EvJobLoad          *job,
+			    EvDocumentLoadFlags flags)
+{
+	g_return_if_fail (EV_IS_JOB_LOAD (job));
+
+	job->flags = flags;
+}
+
 /* EvJobLoadStream */
 
 /**
@@ -1464,6 +1826,96 @@ ev_job_load_gfile_set_password (EvJobLoadGFile *job,
         g_free (old_password);
 }
 
+/* EvJobLoadWorkerCopy */
+
+/* Loads a copy of a document for the jobs of a worker thread. The copy
+ * is the document of the job once it has finished. */
+typedef struct {
+	EvJob       parent;
+
+	EvDocument *source;
+} EvJobLoadWorkerCopy;
+
+typedef EvJobClass EvJobLoadWorkerCopyClass;
+
+static GType ev_job_load_worker_copy_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE (EvJobLoadWorkerCopy, ev_job_load_worker_copy, EV_TYPE_JOB)
+
+static void
+ev_job_load_worker_copy_init (EvJobLoadWorkerCopy *job)
+{
+	EV_JOB (job)->run_mode = EV_JOB_RUN_THREAD;
+}
+
+static void
+ev_job_load_worker_copy_dispose (GObject *object)
+{
+	EvJobLoadWorkerCopy *job = (EvJobLoadWorkerCopy *) object;
+
+	g_clear_object (&job->source);
+
+	(* G_OBJECT_CLASS (ev_job_load_worker_copy_parent_class)->dispose) (object);
+}
+
+static gboolean
+ev_job_load_worker_copy_run (EvJob *job)
+{
+	EvJobLoadWorkerCopy *job_copy = (EvJobLoadWorkerCopy *) job;
+	GError              *error = NULL;
+
+	ev_debug_message (DEBUG_JOBS, NULL);
+	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
+
+	ev_document_fc_mutex_lock ();
+	job->document = ev_document_factory_get_worker_copy (job_copy->source, &error);
+	ev_document_fc_mutex_unlock ();
+
+	if (error) {
+		ev_job_failed_from_error (job, error);
+		g_error_free (error);
+	} else {
+		ev_job_succeeded (job);
+	}
+
+	return FALSE;
+}
+
+static void
+ev_job_load_worker_copy_class_init (EvJobLoadWorkerCopyClass *class)
+{
+	GObjectClass *oclass = G_OBJECT_CLASS (class);
+
+	oclass->dispose = ev_job_load_worker_copy_dispose;
+	class->run = ev_job_load_worker_copy_run;
+}
+
+/**
+ * ev_job_load_worker_copy_new:
+ * @document: an #EvDocument
+ *
+ * Loads a copy of @document with ev_document_factory_get_worker_copy()
+ * in a worker thread. When the job succeeds, its document is the copy,
+ * which can be used by jobs running at the same time as the jobs of
+ * @document even if the backend is not thread-safe.
+ *
+ * Returns: (transfer full): a new #EvJob
+ *
+ * Since: 3.30
+ */
+EvJob *
+ev_job_load_worker_copy_new (EvDocument *document)
+{
+	EvJobLoadWorkerCopy *job;
+
+	ev_debug_message (DEBUG_JOBS, NULL);
+
+	job = g_object_new (ev_job_load_worker_copy_get_type (), NULL);
+	job->source = g_object_ref (document);
+
+	return EV_JOB (job);
+}
+
 /* EvJobSave */
 static void
 ev_job_save_init (EvJobSave *job)
@@ -1512,7 +1964,7 @@ ev_job_save_run (EvJob *job)
 	}
 	close (fd);
 
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (job->document);
 
 	/* Save document to temp filename */
 	local_uri = g_filename_to_uri (tmp_filename, NULL, &error);
@@ -1520,7 +1972,7 @@ ev_job_save_run (EvJob *job)
                 ev_document_save (job->document, local_uri, &error);
         }
 
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (job->document);
 
 	if (error) {
 		g_free (local_uri);
@@ -1533,7 +1985,8 @@ ev_job_save_run (EvJob *job)
 	/* If original document was compressed,
 	 * compress it again before saving
 	 */
-	if (g_object_get_data (G_OBJECT (job->document), "uri-uncompressed")) {
+	if (g_object_get_data (G_OBJECT (job->document), "uri-uncompressed") ||
+	    g_object_get_data (G_OBJECT (job->document), "bytes-uncompressed")) {
 		EvCompressionType ctype = EV_COMPRESSION_NONE;
 		const gchar      *ext;
 		gchar            *uri_comp;
@@ -1622,6 +2075,22 @@ static void
 ev_job_find_init (EvJobFind *job)
 {
 	EV_JOB (job)->run_mode = EV_JOB_RUN_MAIN_LOOP;
+
+	g_mutex_init (&job->mutex);
+}
+
+static void
+ev_job_find_free_pages (GList **pages,
+			gint    n_pages)
+{
+	gint i;
+
+	for (i = 0; i < n_pages; i++) {
+		g_list_foreach (pages[i], (GFunc)ev_rectangle_free, NULL);
+		g_list_free (pages[i]);
+	}
+
+	g_free (pages);
 }
 
 static void
@@ -1637,73 +2106,297 @@ ev_job_find_dispose (GObject *object)
 	}
 
 	if (job->pages) {
-		gint i;
-
-		for (i = 0; i < job->n_pages; i++) {
-			g_list_foreach (job->pages[i], (GFunc)ev_rectangle_free, NULL);
-			g_list_free (job->pages[i]);
-		}
-
-		g_free (job->pages);
+		ev_job_find_free_pages (job->pages, job->n_pages);
 		job->pages = NULL;
 	}
+
+	if (job->results) {
+		ev_job_find_free_pages (job->results, job->n_pages);
+		job->results = NULL;
+	}
+
+	g_clear_pointer (&job->searched, g_free);
 	
 	(* G_OBJECT_CLASS (ev_job_find_parent_class)->dispose) (object);
 }
 
-static gboolean
-ev_job_find_run (EvJob *job)
+static void
+ev_job_find_finalize (GObject *object)
 {
-	EvJobFind      *job_find = EV_JOB_FIND (job);
-	EvDocumentFind *find = EV_DOCUMENT_FIND (job->document);
-	EvPage         *ev_page;
-	GList          *matches;
+	EvJobFind *job = EV_JOB_FIND (object);
 
-	ev_debug_message (DEBUG_JOBS, NULL);
-	
-	/* Do not block the main loop */
-	if (!ev_document_doc_mutex_trylock ())
-		return TRUE;
-	
-#ifdef EV_ENABLE_DEBUG
-	/* We use the #ifdef in this case because of the if */
-	if (job_find->current_page == job_find->start_page)
-		ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
-#endif
+	g_mutex_clear (&job->mutex);
 
-	ev_page = ev_document_get_page (job->document, job_find->current_page);
-	matches = ev_document_find_find_text_with_options (find, ev_page, job_find->text,
-                                                           job_find->options);
-	g_object_unref (ev_page);
-	
-	ev_document_doc_mutex_unlock ();
+	(* G_OBJECT_CLASS (ev_job_find_parent_class)->finalize) (object);
+}
 
-	if (!job_find->has_results)
-		job_find->has_results = (matches != NULL);
+/* Reports the pages searched so far in search order, so that "updated"
+ * is still emitted for every page from start_page on, wrapping around */
+static gboolean
+ev_job_find_emit_updated (EvJobFind *job_find)
+{
+	EvJob *job = EV_JOB (job_find);
 
-	job_find->pages[job_find->current_page] = matches;
-	g_signal_emit (job_find, job_find_signals[FIND_UPDATED], 0, job_find->current_page);
-		       
-	job_find->current_page = (job_find->current_page + 1) % job_find->n_pages;
-	if (job_find->current_page == job_find->start_page) {
-		ev_job_succeeded (job);
+	g_mutex_lock (&job_find->mutex);
+	job_find->updated_id = 0;
+	g_mutex_unlock (&job_find->mutex);
 
+	if (g_cancellable_is_cancelled (job->cancellable))
 		return FALSE;
+
+	while (!ev_job_is_finished (job)) {
+		gint page = job_find->current_page;
+
+		g_mutex_lock (&job_find->mutex);
+		if (!job_find->searched[page]) {
+			g_mutex_unlock (&job_find->mutex);
+			break;
+		}
+		job_find->pages[page] = job_find->results[page];
+		job_find->results[page] = NULL;
+		g_mutex_unlock (&job_find->mutex);
+
+		if (!job_find->has_results)
+			job_find->has_results = (job_find->pages[page] != NULL);
+
+		job_find->current_page = (page + 1) % job_find->n_pages;
+		g_signal_emit (job_find, job_find_signals[FIND_UPDATED], 0, page);
+
+		/* A handler may have cancelled the search */
+		if (g_cancellable_is_cancelled (job->cancellable))
+			break;
+
+		if (job_find->current_page == job_find->start_page)
+			ev_job_succeeded (job);
 	}
 
-	return TRUE;
+	return FALSE;
 }
 
+/* The pages of an EvJobFind are searched by these jobs, run by the
+ * scheduler like any other job, so that a backend that is not
+ * thread-safe is never used by more than one of them at a time. Each
+ * run searches one page and the job goes back to the queue until all
+ * the pages have been handed out.
+ *
+ * Backends that support worker copies are searched by one job on the
+ * document itself and a few jobs on copies of it, loaded by each job
+ * in its first run, so that they don't share the backend context. */
+#define FIND_MAX_WORKER_COPIES 3
+#define FIND_PAGES_PER_WORKER_COPY 50
+
+typedef struct {
+	EvJob          parent;
+
+	EvJobFind     *job_find;
+	EvDocument    *source;
+	EvSearchIndex *index;
+	gint           n_skipped;
+	gint64         index_time;
+} EvJobFindPages;
+
+typedef EvJobClass EvJobFindPagesClass;
+
+static GType ev_job_find_pages_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE (EvJobFindPages, ev_job_find_pages, EV_TYPE_JOB)
+
 static void
-ev_job_find_class_init (EvJobFindClass *class)
+ev_job_find_pages_init (EvJobFindPages *job)
 {
-	EvJobClass   *job_class = EV_JOB_CLASS (class);
-	GObjectClass *gobject_class = G_OBJECT_CLASS (class);
-	
-	job_class->run = ev_job_find_run;
-	gobject_class->dispose = ev_job_find_dispose;
-	
-	job_find_signals[FIND_UPDATED] =
+	EV_JOB (job)->run_mode = EV_JOB_RUN_THREAD;
+}
+
+static void
+ev_job_find_pages_dispose (GObject *object)
+{
+	EvJobFindPages *job = (EvJobFindPages *) object;
+
+	g_clear_object (&job->job_find);
+	g_clear_object (&job->source);
+	g_clear_pointer (&job->index, ev_search_index_unref);
+
+	(* G_OBJECT_CLASS (ev_job_find_pages_parent_class)->dispose) (object);
+}
+
+static gboolean
+ev_job_find_pages_run (EvJob *job)
+{
+	EvJobFindPages *job_pages = (EvJobFindPages *) job;
+	EvJobFind      *job_find = job_pages->job_find;
+	EvPage         *ev_page;
+	GList          *matches = NULL;
+	gint            page;
+	gboolean        may_contain = TRUE;
+
+	if (g_cancellable_is_cancelled (EV_JOB (job_find)->cancellable))
+		return FALSE;
+
+	if (!job->document) {
+		GError *error = NULL;
+
+		ev_document_fc_mutex_lock ();
+		job->document = ev_document_factory_get_worker_copy (job_pages->source, &error);
+		ev_document_fc_mutex_unlock ();
+		g_clear_object (&job_pages->source);
+		if (!job->document) {
+			/* The other jobs search the remaining pages */
+			ev_debug_message (DEBUG_JOBS, "no worker copy: %s", error->message);
+			g_error_free (error);
+
+			return FALSE;
+		}
+
+		/* The scheduler hasn't seen the copy yet */
+		return TRUE;
+	}
+
+	/* Pages are handed out from start_page on, so the ones
+	 * around the current view are searched first */
+	g_mutex_lock (&job_find->mutex);
+	if (job_find->n_dispatched == job_find->n_pages) {
+		g_mutex_unlock (&job_find->mutex);
+
+		if (job_pages->index) {
+			ev_debug_message (DEBUG_JOBS, "%d pages skipped by the search index in %.3f ms",
+					  job_pages->n_skipped, job_pages->index_time / 1000.);
+		}
+
+		return FALSE;
+	}
+	page = (job_find->start_page + job_find->n_dispatched++) % job_find->n_pages;
+	g_mutex_unlock (&job_find->mutex);
+
+	if (job_pages->index) {
+		gint64 start = g_get_monotonic_time ();
+
+		may_contain = ev_search_index_page_may_contain (job_pages->index, page,
+								job_find->text);
+		job_pages->index_time += g_get_monotonic_time () - start;
+		if (!may_contain)
+			job_pages->n_skipped++;
+	}
+
+	if (may_contain) {
+		ev_document_render_lock (job->document);
+		ev_page = ev_document_get_page (job->document, page);
+		matches = ev_document_find_find_text_with_options (EV_DOCUMENT_FIND (job->document),
+								   ev_page, job_find->text,
+								   job_find->options);
+		g_object_unref (ev_page);
+		ev_document_render_unlock (job->document);
+	}
+
+	g_mutex_lock (&job_find->mutex);
+	job_find->results[page] = matches;
+	job_find->searched[page] = TRUE;
+	if (job_find->updated_id == 0) {
+		job_find->updated_id =
+			g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+					 (GSourceFunc)ev_job_find_emit_updated,
+					 g_object_ref (job_find),
+					 (GDestroyNotify)g_object_unref);
+	}
+	g_mutex_unlock (&job_find->mutex);
+
+	return TRUE;
+}
+
+static void
+ev_job_find_pages_class_init (EvJobFindPagesClass *class)
+{
+	GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+
+	class->run = ev_job_find_pages_run;
+	gobject_class->dispose = ev_job_find_pages_dispose;
+}
+
+static EvJob *
+ev_job_find_pages_new (EvJobFind     *job_find,
+		       EvSearchIndex *index,
+		       gboolean       worker_copy)
+{
+	EvJobFindPages *job;
+
+	job = g_object_new (ev_job_find_pages_get_type (), NULL);
+	if (worker_copy)
+		job->source = g_object_ref (EV_JOB (job_find)->document);
+	else
+		EV_JOB (job)->document = g_object_ref (EV_JOB (job_find)->document);
+	job->job_find = g_object_ref (job_find);
+	job->index = index ? ev_search_index_ref (index) : NULL;
+
+	return EV_JOB (job);
+}
+
+static gboolean
+ev_job_find_run (EvJob *job)
+{
+	EvJobFind     *job_find = EV_JOB_FIND (job);
+	EvSearchIndex *index;
+	gint           n_copies;
+	gint           i;
+
+	ev_debug_message (DEBUG_JOBS, NULL);
+	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
+
+	if (job_find->n_pages == 0) {
+		ev_job_succeeded (job);
+
+		return FALSE;
+	}
+
+	/* The backend doesn't search the pages that the search index
+	 * knows don't contain the text */
+	index = ev_search_index_get_for_document (job->document);
+	if (index && ev_search_index_get_n_pages (index) != job_find->n_pages)
+		g_clear_pointer (&index, ev_search_index_unref);
+
+	/* The scheduler runs the jobs of a backend that can't search
+	 * several pages at the same time one after the other, so those
+	 * get more jobs only when they can work on copies of the
+	 * document. Loading a copy costs about as much as searching a
+	 * few dozen pages, so short documents don't get any. */
+	if (ev_document_is_thread_safe (job->document)) {
+		job_find->n_threads = MIN ((gint) g_get_num_processors (), job_find->n_pages);
+		n_copies = 0;
+	} else if (ev_document_supports_worker_copies (job->document)) {
+		n_copies = MIN ((gint) g_get_num_processors () - 1,
+				job_find->n_pages / FIND_PAGES_PER_WORKER_COPY);
+		n_copies = CLAMP (n_copies, 0, FIND_MAX_WORKER_COPIES);
+		job_find->n_threads = 1 + n_copies;
+	} else {
+		job_find->n_threads = 1;
+		n_copies = 0;
+	}
+	job_find->results = g_new0 (GList *, job_find->n_pages);
+	job_find->searched = g_new0 (gboolean, job_find->n_pages);
+
+	for (i = 0; i < job_find->n_threads; i++) {
+		EvJob *job_pages = ev_job_find_pages_new (job_find, index,
+							  i >= job_find->n_threads - n_copies);
+
+		ev_job_scheduler_push_job (job_pages, EV_JOB_PRIORITY_LOW);
+		g_object_unref (job_pages);
+	}
+
+	if (index)
+		ev_search_index_unref (index);
+
+	return FALSE;
+}
+
+static void
+ev_job_find_class_init (EvJobFindClass *class)
+{
+	EvJobClass   *job_class = EV_JOB_CLASS (class);
+	GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+	
+	job_class->run = ev_job_find_run;
+	gobject_class->dispose = ev_job_find_dispose;
+	gobject_class->finalize = ev_job_find_finalize;
+	
+	job_find_signals[FIND_UPDATED] =
 		g_signal_new ("updated",
 			      EV_TYPE_JOB_FIND,
 			      G_SIGNAL_RUN_LAST,
@@ -1816,6 +2509,379 @@ ev_job_find_get_results (EvJobFind *job)
 	return job->pages;
 }
 
+/* EvJobSearchIndex */
+
+/* Bytes of the document hashed on every run */
+#define SEARCH_INDEX_CHECKSUM_CHUNK (1024 * 1024)
+
+static void
+ev_job_search_index_init (EvJobSearchIndex *job)
+{
+	EV_JOB (job)->run_mode = EV_JOB_RUN_THREAD;
+
+	job->page = -1;
+}
+
+static void
+ev_job_search_index_dispose (GObject *object)
+{
+	EvJobSearchIndex *job = EV_JOB_SEARCH_INDEX (object);
+
+	g_clear_object (&job->stream);
+	g_clear_pointer (&job->checksum, g_checksum_free);
+	g_clear_pointer (&job->digest, g_free);
+
+	(* G_OBJECT_CLASS (ev_job_search_index_parent_class)->dispose) (object);
+}
+
+/* Hashes a chunk of the document, returns whether the whole document
+ * has been hashed or there was an error */
+static gboolean
+ev_job_search_index_update_checksum (EvJobSearchIndex *job,
+				     GError          **error)
+{
+	EvJob  *ev_job = EV_JOB (job);
+	guchar  buffer[65536];
+	gssize  n_read = 0;
+	gsize   total = 0;
+
+	if (!job->stream) {
+		GFile     *file;
+		GFileInfo *info;
+
+		/* The index is keyed by the contents of the document, the
+		 * modification time saves reading a stale index */
+		file = g_file_new_for_uri (ev_document_get_uri (ev_job->document));
+		info = g_file_query_info (file, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+					  G_FILE_QUERY_INFO_NONE, ev_job->cancellable, error);
+		if (info) {
+			job->mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+			job->stream = g_file_read (file, ev_job->cancellable, error);
+			g_object_unref (info);
+		}
+		g_object_unref (file);
+
+		if (!job->stream)
+			return TRUE;
+
+		job->checksum = g_checksum_new (G_CHECKSUM_SHA256);
+	}
+
+	while (total < SEARCH_INDEX_CHECKSUM_CHUNK &&
+	       (n_read = g_input_stream_read (G_INPUT_STREAM (job->stream), buffer, sizeof (buffer),
+					      ev_job->cancellable, error)) > 0) {
+		g_checksum_update (job->checksum, buffer, n_read);
+		total += n_read;
+	}
+
+	if (n_read > 0)
+		return FALSE;
+
+	if (n_read == 0)
+		job->digest = g_strdup (g_checksum_get_string (job->checksum));
+	g_clear_object (&job->stream);
+
+	return TRUE;
+}
+
+/* Loads the index from the cache or attaches a new one to the
+ * document, returns whether there are pages left to index */
+static gboolean
+ev_job_search_index_load (EvJobSearchIndex *job)
+{
+	EvDocument    *document = EV_JOB (job)->document;
+	EvSearchIndex *index;
+	gchar         *path;
+	gint           n_pages;
+
+	n_pages = ev_document_get_n_pages (document);
+	path = ev_search_index_get_cache_path (job->digest);
+	index = ev_search_index_load (path, job->digest, job->mtime, n_pages);
+	if (index) {
+		ev_debug_message (DEBUG_JOBS, "loaded %s: %d pages, %" G_GSIZE_FORMAT " bytes",
+				  path, n_pages, ev_search_index_get_size (index));
+		ev_search_index_set_for_document (document, index);
+		ev_search_index_unref (index);
+		g_free (path);
+
+		return FALSE;
+	}
+	g_free (path);
+
+	/* The index is attached to the document while it's built, so
+	 * that searches can skip the pages already indexed */
+	index = ev_search_index_new (n_pages);
+	ev_search_index_set_for_document (document, index);
+	ev_search_index_unref (index);
+	job->page = 0;
+
+	return n_pages > 0;
+}
+
+static void
+ev_job_search_index_save (EvJobSearchIndex *job,
+			  EvSearchIndex    *index)
+{
+	gchar  *path;
+	GError *error = NULL;
+
+	path = ev_search_index_get_cache_path (job->digest);
+	if (!ev_search_index_save (index, path, job->digest, job->mtime, &error)) {
+		g_warning ("Failed to save search index: %s", error->message);
+		g_error_free (error);
+	}
+
+	ev_debug_message (DEBUG_JOBS, "built %s: %d pages, %" G_GSIZE_FORMAT " bytes",
+			  path, job->page, ev_search_index_get_size (index));
+	g_free (path);
+}
+
+/* Hashes a chunk of the document or indexes a page on every run, so
+ * that the document is not kept from the other jobs until the whole
+ * index is built */
+static gboolean
+ev_job_search_index_run (EvJob *job)
+{
+	EvJobSearchIndex *job_index = EV_JOB_SEARCH_INDEX (job);
+	EvDocument       *document = job->document;
+	EvSearchIndex    *index;
+	EvPage           *page;
+	gchar            *text;
+	GError           *error = NULL;
+
+	ev_debug_message (DEBUG_JOBS, NULL);
+	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
+
+	if (!EV_IS_DOCUMENT_TEXT (document) || !ev_document_get_uri (document)) {
+		ev_job_succeeded (job);
+		return FALSE;
+	}
+
+	if (g_cancellable_is_cancelled (job->cancellable))
+		return FALSE;
+
+	if (!job_index->digest) {
+		if (!ev_job_search_index_update_checksum (job_index, &error))
+			return TRUE;
+
+		if (!job_index->digest) {
+			ev_job_failed_from_error (job, error);
+			g_error_free (error);
+
+			return FALSE;
+		}
+	}
+
+	if (job_index->page == -1) {
+		if (!ev_job_search_index_load (job_index)) {
+			ev_job_succeeded (job);
+			return FALSE;
+		}
+
+		return TRUE;
+	}
+
+	index = ev_search_index_get_for_document (document);
+	if (!index)
+		return FALSE;
+
+	ev_document_render_lock (document);
+	page = ev_document_get_page (document, job_index->page);
+	text = ev_document_text_get_text (EV_DOCUMENT_TEXT (document), page);
+	g_object_unref (page);
+	ev_document_render_unlock (document);
+
+	ev_search_index_add_page (index, job_index->page, text);
+	g_free (text);
+
+	job_index->page++;
+	if ((guint) job_index->page < ev_search_index_get_n_pages (index)) {
+		ev_search_index_unref (index);
+		return TRUE;
+	}
+
+	ev_job_search_index_save (job_index, index);
+	ev_search_index_unref (index);
+	ev_job_succeeded (job);
+
+	return FALSE;
+}
+
+static void
+ev_job_search_index_class_init (EvJobSearchIndexClass *class)
+{
+	GObjectClass *oclass = G_OBJECT_CLASS (class);
+	EvJobClass   *job_class = EV_JOB_CLASS (class);
+
+	oclass->dispose = ev_job_search_index_dispose;
+	job_class->run = ev_job_search_index_run;
+}
+
+/**
+ * ev_job_search_index_new:
+ * @document: an #EvDocument
+ *
+ * Creates a job that loads the search index of @document from the
+ * user cache directory, or extracts the text of every page to build
+ * it, a page on every run. #EvJobFind doesn't search the pages that the index knows don't
+ * contain the text.
+ *
+ * Returns: (transfer full): a new #EvJob
+ *
+ * Since: 3.30
+ */
+EvJob *
+ev_job_search_index_new (EvDocument *document)
+{
+	EvJob *job;
+
+	ev_debug_message (DEBUG_JOBS, NULL);
+
+	job = g_object_new (EV_TYPE_JOB_SEARCH_INDEX, NULL);
+	job->document = g_object_ref (document);
+
+	return job;
+}
+
+/* EvJobPageSizes */
+
+/* Pages asked to the backend at once */
+#define PAGE_SIZES_CHUNK 64
+/* Minimum time between "updated" signals, in microseconds */
+#define PAGE_SIZES_UPDATE_INTERVAL (G_USEC_PER_SEC / 10)
+
+static void
+ev_job_page_sizes_init (EvJobPageSizes *job)
+{
+	EV_JOB (job)->run_mode = EV_JOB_RUN_THREAD;
+
+	g_mutex_init (&job->mutex);
+}
+
+static void
+ev_job_page_sizes_finalize (GObject *object)
+{
+	EvJobPageSizes *job = EV_JOB_PAGE_SIZES (object);
+
+	g_mutex_clear (&job->mutex);
+
+	(* G_OBJECT_CLASS (ev_job_page_sizes_parent_class)->finalize) (object);
+}
+
+/* Reports all the pages cached since the last update at once */
+static gboolean
+ev_job_page_sizes_emit_updated (EvJobPageSizes *job)
+{
+	gint first_page, n_pages;
+
+	g_mutex_lock (&job->mutex);
+	first_page = job->first_page;
+	n_pages = job->n_pages;
+	job->n_pages = 0;
+	job->updated_id = 0;
+	g_mutex_unlock (&job->mutex);
+
+	if (n_pages > 0 && !g_cancellable_is_cancelled (EV_JOB (job)->cancellable)) {
+		g_signal_emit (job, job_page_sizes_signals[PAGE_SIZES_UPDATED], 0,
+			       first_page, n_pages);
+	}
+
+	return FALSE;
+}
+
+/* Caches a chunk of pages on every run, so that the other jobs of the
+ * document don't wait for the whole cache to be filled */
+static gboolean
+ev_job_page_sizes_run (EvJob *job)
+{
+	EvJobPageSizes *job_sizes = EV_JOB_PAGE_SIZES (job);
+	gint            first_page, n_pages;
+	gboolean        complete;
+	gint64          now;
+
+	ev_debug_message (DEBUG_JOBS, NULL);
+	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
+
+	if (g_cancellable_is_cancelled (job->cancellable))
+		return FALSE;
+
+	complete = ev_document_fill_cache (job->document, PAGE_SIZES_CHUNK,
+					   &first_page, &n_pages);
+
+	/* Pages are cached in order, so the pages not
+	 * reported yet are always a single range */
+	g_mutex_lock (&job_sizes->mutex);
+	if (job_sizes->n_pages == 0)
+		job_sizes->first_page = first_page;
+	job_sizes->n_pages += n_pages;
+
+	now = g_get_monotonic_time ();
+	if (job_sizes->updated_id == 0 && job_sizes->n_pages > 0 &&
+	    (complete || now - job_sizes->last_updated >= PAGE_SIZES_UPDATE_INTERVAL)) {
+		job_sizes->last_updated = now;
+		job_sizes->updated_id =
+			g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+					 (GSourceFunc)ev_job_page_sizes_emit_updated,
+					 g_object_ref (job_sizes),
+					 (GDestroyNotify)g_object_unref);
+	}
+	g_mutex_unlock (&job_sizes->mutex);
+
+	if (!complete)
+		return TRUE;
+
+	ev_debug_message (DEBUG_JOBS, "%d pages cached",
+			  ev_document_get_n_pages (job->document));
+	ev_job_succeeded (job);
+
+	return FALSE;
+}
+
+static void
+ev_job_page_sizes_class_init (EvJobPageSizesClass *class)
+{
+	GObjectClass *oclass = G_OBJECT_CLASS (class);
+	EvJobClass   *job_class = EV_JOB_CLASS (class);
+
+	oclass->finalize = ev_job_page_sizes_finalize;
+	job_class->run = ev_job_page_sizes_run;
+
+	job_page_sizes_signals[PAGE_SIZES_UPDATED] =
+		g_signal_new ("updated",
+			      EV_TYPE_JOB_PAGE_SIZES,
+			      G_SIGNAL_RUN_LAST,
+			      G_STRUCT_OFFSET (EvJobPageSizesClass, updated),
+			      NULL, NULL,
+			      ev_view_marshal_VOID__INT_INT,
+			      G_TYPE_NONE,
+			      2, G_TYPE_INT, G_TYPE_INT);
+}
+
+/**
+ * ev_job_page_sizes_new:
+ * @document: an #EvDocument loaded with %EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE
+ *
+ * Creates a job that caches the size and label of the pages of @document
+ * that are not cached yet. The "updated" signal is emitted with the range
+ * of pages cached since the previous emission.
+ *
+ * Returns: (transfer full): a new #EvJob
+ *
+ * Since: 3.30
+ */
+EvJob *
+ev_job_page_sizes_new (EvDocument *document)
+{
+	EvJob *job;
+
+	ev_debug_message (DEBUG_JOBS, NULL);
+
+	job = g_object_new (EV_TYPE_JOB_PAGE_SIZES, NULL);
+	job->document = g_object_ref (document);
+
+	return job;
+}
+
 /* EvJobLayers */
 static void
 ev_job_layers_init (EvJobLayers *job)
@@ -1848,9 +2914,9 @@ ev_job_layers_run (EvJob *job)
 	ev_debug_message (DEBUG_JOBS, NULL);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
 	
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (job->document);
 	job_layers->model = ev_document_layers_get_layers (EV_DOCUMENT_LAYERS (job->document));
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (job->document);
 	
 	ev_job_succeeded (job);
 	
@@ -1902,6 +2968,11 @@ ev_job_export_dispose (GObject *object)
 		job->rc = NULL;
 	}
 
+	if (job->rendered_page) {
+		cairo_surface_destroy (job->rendered_page);
+		job->rendered_page = NULL;
+	}
+
 	(* G_OBJECT_CLASS (ev_job_export_parent_class)->dispose) (object);
 }
 
@@ -1915,8 +2986,13 @@ ev_job_export_run (EvJob *job)
 
 	ev_debug_message (DEBUG_JOBS, NULL);
 	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
-	
-	ev_document_doc_mutex_lock ();
+
+	/* Pages rendered in advance don't use the document, and are
+	 * exported while the following ones are rendered */
+	if (job_export->rendered_page)
+		ev_document_render_lock (job->document);
+	else
+		ev_document_lock (job->document);
 	
 	ev_page = ev_document_get_page (job->document, job_export->page);
 	if (job_export->rc) {
@@ -1930,9 +3006,19 @@ ev_job_export_run (EvJob *job)
 	}
 	g_object_unref (ev_page);
 	
-	ev_file_exporter_do_page (EV_FILE_EXPORTER (job->document), job_export->rc);
-	
-	ev_document_doc_mutex_unlock ();
+	if (job_export->rendered_page) {
+		ev_file_exporter_do_rendered_page (EV_FILE_EXPORTER (job->document),
+						   job_export->rc,
+						   job_export->rendered_page);
+		cairo_surface_destroy (job_export->rendered_page);
+		job_export->rendered_page = NULL;
+
+		ev_document_render_unlock (job->document);
+	} else {
+		ev_file_exporter_do_page (EV_FILE_EXPORTER (job->document), job_export->rc);
+
+		ev_document_unlock (job->document);
+	}
 	
 	ev_job_succeeded (job);
 	
@@ -1969,6 +3055,121 @@ ev_job_export_set_page (EvJobExport *job,
 	job->page = page;
 }
 
+/**
+ * ev_job_export_set_rendered_page:
+ * @job: an #EvJobExport
+ * @surface: (allow-none): the page of @job rendered by an #EvJobExportRender
+ *
+ * Exports @surface instead of rendering the page again. It's used only
+ * for the next run of @job.
+ *
+ * Since: 3.30
+ */
+void
+ev_job_export_set_rendered_page (EvJobExport     *job,
+				 cairo_surface_t *surface)
+{
+	if (surface)
+		cairo_surface_reference (surface);
+	if (job->rendered_page)
+		cairo_surface_destroy (job->rendered_page);
+	job->rendered_page = surface;
+}
+
+/* EvJobExportRender */
+static void
+ev_job_export_render_init (EvJobExportRender *job)
+{
+	EV_JOB (job)->run_mode = EV_JOB_RUN_THREAD;
+}
+
+static void
+ev_job_export_render_dispose (GObject *object)
+{
+	EvJobExportRender *job;
+
+	ev_debug_message (DEBUG_JOBS, "page: %d", EV_JOB_EXPORT_RENDER (object)->page);
+
+	job = EV_JOB_EXPORT_RENDER (object);
+
+	if (job->surface) {
+		cairo_surface_destroy (job->surface);
+		job->surface = NULL;
+	}
+
+	(* G_OBJECT_CLASS (ev_job_export_render_parent_class)->dispose) (object);
+}
+
+static gboolean
+ev_job_export_render_run (EvJob *job)
+{
+	EvJobExportRender *job_render = EV_JOB_EXPORT_RENDER (job);
+	EvPage            *ev_page;
+	EvRenderContext   *rc;
+
+	ev_debug_message (DEBUG_JOBS, "page: %d", job_render->page);
+	ev_profiler_start (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
+
+	ev_document_render_lock (job->document);
+
+	ev_page = ev_document_get_page (job->document, job_render->page);
+	rc = ev_render_context_new (ev_page, 0, 1.0);
+	g_object_unref (ev_page);
+
+	job_render->surface = ev_file_exporter_render_page (EV_FILE_EXPORTER (job->document), rc);
+	g_object_unref (rc);
+
+	ev_document_render_unlock (job->document);
+
+	/* The export was cancelled while rendering */
+	if (g_cancellable_is_cancelled (job->cancellable))
+		return FALSE;
+
+	ev_profiler_stop (EV_PROFILE_JOBS, "%s (%p)", EV_GET_TYPE_NAME (job), job);
+	ev_job_succeeded (job);
+
+	return FALSE;
+}
+
+static void
+ev_job_export_render_class_init (EvJobExportRenderClass *class)
+{
+	GObjectClass *oclass = G_OBJECT_CLASS (class);
+	EvJobClass   *job_class = EV_JOB_CLASS (class);
+
+	oclass->dispose = ev_job_export_render_dispose;
+	job_class->run = ev_job_export_render_run;
+}
+
+/**
+ * ev_job_export_render_new:
+ * @document: an #EvDocument implementing #EvFileExporter
+ * @page: the page to render
+ *
+ * Renders @page with ev_file_exporter_render_page(), so that it can be
+ * exported later by an #EvJobExport. Several of these jobs can run at
+ * the same time for a thread-safe document, or for worker copies of a
+ * document loaded by ev_job_load_worker_copy_new().
+ *
+ * Returns: (transfer full): a new #EvJobExportRender
+ *
+ * Since: 3.30
+ */
+EvJob *
+ev_job_export_render_new (EvDocument *document,
+			  gint        page)
+{
+	EvJobExportRender *job;
+
+	ev_debug_message (DEBUG_JOBS, "page: %d", page);
+
+	job = g_object_new (EV_TYPE_JOB_EXPORT_RENDER, NULL);
+	EV_JOB (job)->document = g_object_ref (document);
+	job->page = page;
+
+	return EV_JOB (job);
+}
+
 /* EvJobPrint */
 static void
 ev_job_print_init (EvJobPrint *job)
@@ -2011,14 +3212,14 @@ ev_job_print_run (EvJob *job)
 	job->finished = FALSE;
 	g_clear_error (&job->error);
 
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (job->document);
 
 	ev_page = ev_document_get_page (job->document, job_print->page);
 	ev_document_print_print_page (EV_DOCUMENT_PRINT (job->document),
 				      ev_page, job_print->cr);
 	g_object_unref (ev_page);
 
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (job->document);
 
         if (g_cancellable_is_cancelled (job->cancellable))
                 return FALSE;
@@ -72,12 +72,21 @@ typedef struct _EvJobSaveClass EvJobSaveClass;
 typedef struct _EvJobFind EvJobFind;
 typedef struct _EvJobFindClass EvJobFindClass;
 
+typedef struct _EvJobSearchIndex EvJobSearchIndex;
+typedef struct _EvJobSearchIndexClass EvJobSearchIndexClass;
+
+typedef struct _EvJobPageSizes EvJobPageSizes;
+typedef struct _EvJobPageSizesClass EvJobPageSizesClass;
+
 typedef struct _EvJobLayers EvJobLayers;
 typedef struct _EvJobLayersClass EvJobLayersClass;
 
 typedef struct _EvJobExport EvJobExport;
 typedef struct _EvJobExportClass EvJobExportClass;
 
+typedef struct _EvJobExportRender EvJobExportRender;
+typedef struct _EvJobExportRenderClass EvJobExportRenderClass;
+
 typedef struct _EvJobPrint EvJobPrint;
 typedef struct _EvJobPrintClass EvJobPrintClass;
 
@@ -173,6 +182,20 @@ typedef struct _EvJobPrintClass EvJobPrintClass;
 #define EV_IS_JOB_FIND_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), EV_TYPE_JOB_FIND))
 #define EV_JOB_FIND_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), EV_TYPE_JOB_FIND, EvJobFindClass))
 
+#define EV_TYPE_JOB_SEARCH_INDEX            (ev_job_search_index_get_type())
+#define EV_JOB_SEARCH_INDEX(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), EV_TYPE_JOB_SEARCH_INDEX, EvJobSearchIndex))
+#define EV_IS_JOB_SEARCH_INDEX(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EV_TYPE_JOB_SEARCH_INDEX))
+#define EV_JOB_SEARCH_INDEX_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), EV_TYPE_JOB_SEARCH_INDEX, EvJobSearchIndexClass))
+#define EV_IS_JOB_SEARCH_INDEX_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), EV_TYPE_JOB_SEARCH_INDEX))
+#define EV_JOB_SEARCH_INDEX_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), EV_TYPE_JOB_SEARCH_INDEX, EvJobSearchIndexClass))
+
+#define EV_TYPE_JOB_PAGE_SIZES            (ev_job_page_sizes_get_type())
+#define EV_JOB_PAGE_SIZES(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), EV_TYPE_JOB_PAGE_SIZES, EvJobPageSizes))
+#define EV_IS_JOB_PAGE_SIZES(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EV_TYPE_JOB_PAGE_SIZES))
+#define EV_JOB_PAGE_SIZES_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), EV_TYPE_JOB_PAGE_SIZES, EvJobPageSizesClass))
+#define EV_IS_JOB_PAGE_SIZES_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), EV_TYPE_JOB_PAGE_SIZES))
+#define EV_JOB_PAGE_SIZES_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), EV_TYPE_JOB_PAGE_SIZES, EvJobPageSizesClass))
+
 #define EV_TYPE_JOB_LAYERS            (ev_job_layers_get_type())
 #define EV_JOB_LAYERS(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), EV_TYPE_JOB_LAYERS, EvJobLayers))
 #define EV_IS_JOB_LAYERS(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EV_TYPE_JOB_LAYERS))
@@ -187,6 +210,13 @@ typedef struct _EvJobPrintClass EvJobPrintClass;
 #define EV_IS_JOB_EXPORT_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), EV_TYPE_JOB_EXPORT))
 #define EV_JOB_EXPORT_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), EV_TYPE_JOB_EXPORT, EvJobExportClass))
 
+#define EV_TYPE_JOB_EXPORT_RENDER            (ev_job_export_render_get_type())
+#define EV_JOB_EXPORT_RENDER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), EV_TYPE_JOB_EXPORT_RENDER, EvJobExportRender))
+#define EV_IS_JOB_EXPORT_RENDER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EV_TYPE_JOB_EXPORT_RENDER))
+#define EV_JOB_EXPORT_RENDER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), EV_TYPE_JOB_EXPORT_RENDER, EvJobExportRenderClass))
+#define EV_IS_JOB_EXPORT_RENDER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), EV_TYPE_JOB_EXPORT_RENDER))
+#define EV_JOB_EXPORT_RENDER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), EV_TYPE_JOB_EXPORT_RENDER, EvJobExportRenderClass))
+
 #define EV_TYPE_JOB_PRINT            (ev_job_print_get_type())
 #define EV_JOB_PRINT(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), EV_TYPE_JOB_PRINT, EvJobPrint))
 #define EV_IS_JOB_PRINT(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EV_TYPE_JOB_PRINT))
@@ -234,6 +264,7 @@ struct _EvJobLinks
 	EvJob parent;
 
 	GtkTreeModel *model;
+	GArray       *page_paths;
 };
 
 struct _EvJobLinksClass
@@ -258,11 +289,23 @@ struct _EvJobAnnots
 	EvJob parent;
 
 	GList *annots;
+
+	GMutex mutex;
+	gint   start_page;
+	gint   n_scanned;
+	guint  n_batches;
+	GList *found;
+	guint  updated_id;
+	gint64 last_updated;
 };
 
 struct _EvJobAnnotsClass
 {
 	EvJobClass parent_class;
+
+	/* Signals */
+	void (* updated)  (EvJobAnnots   *job,
+			   EvMappingList *annots);
 };
 
 struct _EvJobRender
@@ -278,6 +321,9 @@ struct _EvJobRender
 	gint target_height;
 	cairo_surface_t *surface;
 
+	gboolean has_area;
+	cairo_rectangle_int_t area;
+
 	gboolean include_selection;
 	cairo_surface_t *selection;
 	cairo_region_t *selection_region;
@@ -381,6 +427,7 @@ struct _EvJobLoad
 
 	gchar *uri;
 	gchar *password;
+	EvDocumentLoadFlags flags;
 };
 
 struct _EvJobLoadClass
@@ -441,6 +488,15 @@ struct _EvJobFind
 	gboolean case_sensitive;
 	gboolean has_results;
         EvFindOptions options;
+
+	/* Pages are searched by jobs run by the scheduler, the fields below are
+	 * protected by mutex */
+	GMutex mutex;
+	GList **results;
+	gboolean *searched;
+	gint n_dispatched;
+	gint n_threads;
+	guint updated_id;
 };
 
 struct _EvJobFindClass
@@ -452,6 +508,43 @@ struct _EvJobFindClass
 			   gint       page);
 };
 
+struct _EvJobSearchIndex
+{
+	EvJob parent;
+
+	GFileInputStream *stream;
+	GChecksum        *checksum;
+	gchar            *digest;
+	gint64            mtime;
+	gint              page;
+};
+
+struct _EvJobSearchIndexClass
+{
+	EvJobClass parent_class;
+};
+
+struct _EvJobPageSizes
+{
+	EvJob parent;
+
+	GMutex mutex;
+	gint   first_page;
+	gint   n_pages;
+	guint  updated_id;
+	gint64 last_updated;
+};
+
+struct _EvJobPageSizesClass
+{
+	EvJobClass parent_class;
+
+	/* Signals */
+	void (* updated)  (EvJobPageSizes *job,
+			   gint            first_page,
+			   gint            n_pages);
+};
+
 struct _EvJobLayers
 {
 	EvJob parent;
@@ -470,6 +563,7 @@ struct _EvJobExport
 
 	gint page;
 	EvRenderContext *rc;
+	cairo_surface_t *rendered_page;
 };
 
 struct _EvJobExportClass
@@ -477,6 +571,19 @@ struct _EvJobExportClass
 	EvJobClass parent_class;
 };
 
+struct _EvJobExportRender
+{
+	EvJob parent;
+
+	gint page;
+	cairo_surface_t *surface;
+};
+
+struct _EvJobExportRenderClass
+{
+	EvJobClass parent_class;
+};
+
 struct _EvJobPrint
 {
 	EvJob parent;
@@ -512,6 +619,8 @@ void            ev_job_set_run_mode       (EvJob          *job,
 GType           ev_job_links_get_type     (void) G_GNUC_CONST;
 EvJob          *ev_job_links_new          (EvDocument     *document);
 GtkTreeModel   *ev_job_links_get_model    (EvJobLinks     *job);
+GtkTreePath    *ev_job_links_get_page_path (EvJobLinks    *job,
+					    gint           page);
 
 /* EvJobAttachments */
 GType           ev_job_attachments_get_type (void) G_GNUC_CONST;
@@ -520,6 +629,8 @@ EvJob          *ev_job_attachments_new      (EvDocument     *document);
 /* EvJobAnnots */
 GType           ev_job_annots_get_type      (void) G_GNUC_CONST;
 EvJob          *ev_job_annots_new           (EvDocument     *document);
+void            ev_job_annots_set_start_page (EvJobAnnots   *job,
+					      gint           start_page);
 
 /* EvJobRender */
 GType           ev_job_render_get_type    (void) G_GNUC_CONST;
@@ -534,6 +645,8 @@ void     ev_job_render_set_selection_info (EvJobRender     *job,
 					   EvSelectionStyle selection_style,
 					   GdkColor        *text,
 					   GdkColor        *base);
+void            ev_job_render_set_area    (EvJobRender                 *job,
+					   const cairo_rectangle_int_t *area);
 /* EvJobPageData */
 GType           ev_job_page_data_get_type (void) G_GNUC_CONST;
 EvJob          *ev_job_page_data_new      (EvDocument      *document,
@@ -566,6 +679,8 @@ void            ev_job_load_set_uri       (EvJobLoad       *load,
 					   const gchar     *uri);
 void            ev_job_load_set_password  (EvJobLoad       *job,
 					   const gchar     *password);
+void            ev_job_load_set_load_flags (EvJobLoad          *job,
+					    EvDocumentLoadFlags flags);
 
 /* EvJobLoadStream */
 GType           ev_job_load_stream_get_type       (void) G_GNUC_CONST;
@@ -589,6 +704,9 @@ void            ev_job_load_gfile_set_load_flags  (EvJobLoadGFile     *job,
 void            ev_job_load_gfile_set_password    (EvJobLoadGFile     *job,
                                                    const gchar        *password);
 
+/* EvJobLoadWorkerCopy */
+EvJob          *ev_job_load_worker_copy_new       (EvDocument         *document);
+
 /* EvJobSave */
 GType           ev_job_save_get_type      (void) G_GNUC_CONST;
 EvJob          *ev_job_save_new           (EvDocument      *document,
@@ -610,6 +728,14 @@ gdouble         ev_job_find_get_progress  (EvJobFind       *job);
 gboolean        ev_job_find_has_results   (EvJobFind       *job);
 GList         **ev_job_find_get_results   (EvJobFind       *job);
 
+/* EvJobSearchIndex */
+GType           ev_job_search_index_get_type (void) G_GNUC_CONST;
+EvJob          *ev_job_search_index_new      (EvDocument      *document);
+
+/* EvJobPageSizes */
+GType           ev_job_page_sizes_get_type   (void) G_GNUC_CONST;
+EvJob          *ev_job_page_sizes_new        (EvDocument      *document);
+
 /* EvJobLayers */
 GType           ev_job_layers_get_type    (void) G_GNUC_CONST;
 EvJob          *ev_job_layers_new         (EvDocument     *document);
@@ -619,6 +745,13 @@ GType           ev_job_export_get_type    (void) G_GNUC_CONST;
 EvJob          *ev_job_export_new         (EvDocument     *document);
 void            ev_job_export_set_page    (EvJobExport    *job,
 					   gint            page);
+void            ev_job_export_set_rendered_page (EvJobExport     *job,
+						 cairo_surface_t *surface);
+
+/* EvJobExportRender */
+GType           ev_job_export_render_get_type (void) G_GNUC_CONST;
+EvJob          *ev_job_export_render_new      (EvDocument     *document,
+					       gint            page);
 /* EvJobPrint */
 GType           ev_job_print_get_type    (void) G_GNUC_CONST;
 EvJob          *ev_job_print_new         (EvDocument     *document);
@@ -734,13 +734,13 @@ ev_page_accessible_get_selection (AtkText *text,
 
 			page = ev_document_get_page (view->document, selection->page);
 
-			ev_document_doc_mutex_lock ();
+			ev_document_lock (view->document);
 			selected_text = ev_selection_get_selected_text (EV_SELECTION (view->document),
 									page,
 									selection->style,
 									&(selection->rect));
 
-			ev_document_doc_mutex_unlock ();
+			ev_document_unlock (view->document);
 
 			g_object_unref (page);
 
@@ -1265,6 +1265,25 @@ ev_page_accessible_get_accessible_for_mapping (EvPageAccessible *page_accessible
 	return NULL;
 }
 
+/* The data of the page was dropped by the page cache, the children are
+ * made again from the new mappings once the page is cached again */
+void
+ev_page_accessible_page_evicted (EvPageAccessible *page_accessible)
+{
+	EvView *view = ev_page_accessible_get_view (page_accessible);
+
+	clear_children (page_accessible);
+	g_clear_pointer (&page_accessible->priv->links, (GDestroyNotify)g_hash_table_destroy);
+	page_accessible->priv->children_initialized = FALSE;
+
+	g_signal_handlers_disconnect_by_func (view->page_cache,
+					      G_CALLBACK (page_cached_cb),
+					      page_accessible);
+	g_signal_connect_object (view->page_cache, "page-cached",
+				 G_CALLBACK (page_cached_cb),
+				 page_accessible, 0);
+}
+
 void
 ev_page_accessible_update_element_state (EvPageAccessible *page_accessible,
 					 EvMapping        *mapping)
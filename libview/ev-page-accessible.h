@@ -55,6 +55,7 @@ AtkObject        *ev_page_accessible_get_accessible_for_mapping (EvPageAccessibl
 								 EvMapping        *mapping);
 void              ev_page_accessible_update_element_state (EvPageAccessible *page_accessible,
 							   EvMapping        *mapping);
+void              ev_page_accessible_page_evicted        (EvPageAccessible *page_accessible);
 
 #endif  /* __EV_PAGE_ACCESSIBLE_H__ */
 
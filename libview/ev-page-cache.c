@@ -19,6 +19,7 @@
 
 #include <config.h>
 
+#include <string.h>
 #include <glib.h>
 #include "ev-jobs.h"
 #include "ev-job-scheduler.h"
@@ -31,28 +32,45 @@
 #include "ev-document-media.h"
 #include "ev-document-text.h"
 #include "ev-page-cache.h"
+#include "ev-debug.h"
 
 enum {
   PAGE_CACHED,
+  PAGE_EVICTED,
   LAST_SIGNAL
 };
 
 static guint ev_page_cache_signals[LAST_SIGNAL] = {0};
 
+/* Glyph boxes are kept in floats, half the size of an EvRectangle,
+ * and precise enough for page coordinates in points */
+typedef struct {
+	gfloat x1;
+	gfloat y1;
+	gfloat x2;
+	gfloat y2;
+} TextLayoutBox;
+
 typedef struct _EvPageCacheData {
 	EvJob             *job;
 	gboolean           done : 1;
 	gboolean           dirty : 1;
 	EvJobPageDataFlags flags;
 
+	/* Pages holding some data are in the LRU list of the cache */
+	GList              link;
+	gsize              size;
+
 	EvMappingList     *link_mapping;
 	EvMappingList     *image_mapping;
 	EvMappingList     *form_field_mapping;
 	EvMappingList     *annot_mapping;
         EvMappingList     *media_mapping;
 	cairo_region_t    *text_mapping;
-	EvRectangle       *text_layout;
+	TextLayoutBox     *text_layout;
 	guint              text_layout_length;
+	/* text_layout as rectangles, while the page is in use */
+	EvRectangle       *text_layout_areas;
 	gchar             *text;
 	PangoAttrList     *text_attrs;
         PangoLogAttr      *text_log_attrs;
@@ -71,6 +89,14 @@ struct _EvPageCache {
 	gint               end_page;
 
 	EvJobPageDataFlags flags;
+
+	/* Most recently used pages first */
+	GQueue             lru;
+	gsize              size;
+	gsize              max_size;
+
+	/* Pages whose text_layout_areas might be set */
+	GSList            *expanded_pages;
 };
 
 struct _EvPageCacheClass {
@@ -87,6 +113,13 @@ struct _EvPageCacheClass {
 
 #define PRE_CACHE_SIZE 1
 
+/* Enough for the text of a few hundred pages */
+#define DEFAULT_MAX_SIZE (32 * 1024 * 1024)
+
+/* The objects mappings point to are opaque, this is a rough guess */
+#define MAPPING_SIZE   (sizeof (EvMapping) + sizeof (GList) + 64)
+#define TEXT_ATTR_SIZE 48
+
 static void job_page_data_finished_cb (EvJob       *job,
 				       EvPageCache *cache);
 static void job_page_data_cancelled_cb (EvJob       *job,
@@ -138,6 +171,11 @@ ev_page_cache_data_free (EvPageCacheData *data)
 		data->text_layout_length = 0;
 	}
 
+	if (data->text_layout_areas) {
+		g_free (data->text_layout_areas);
+		data->text_layout_areas = NULL;
+	}
+
 	if (data->text) {
 		g_free (data->text);
 		data->text = NULL;
@@ -155,6 +193,207 @@ ev_page_cache_data_free (EvPageCacheData *data)
         }
 }
 
+static gboolean
+count_text_attr (PangoAttribute *attr,
+		 gpointer        user_data)
+{
+	(*(guint *) user_data)++;
+
+	return FALSE;
+}
+
+static gsize
+ev_page_cache_data_get_size (EvPageCacheData *data)
+{
+	gsize size = 0;
+
+	if (data->link_mapping)
+		size += ev_mapping_list_length (data->link_mapping) * MAPPING_SIZE;
+	if (data->image_mapping)
+		size += ev_mapping_list_length (data->image_mapping) * MAPPING_SIZE;
+	if (data->form_field_mapping)
+		size += ev_mapping_list_length (data->form_field_mapping) * MAPPING_SIZE;
+	if (data->annot_mapping)
+		size += ev_mapping_list_length (data->annot_mapping) * MAPPING_SIZE;
+	if (data->media_mapping)
+		size += ev_mapping_list_length (data->media_mapping) * MAPPING_SIZE;
+	if (data->text_mapping)
+		size += cairo_region_num_rectangles (data->text_mapping) * sizeof (cairo_rectangle_int_t);
+	size += data->text_layout_length * sizeof (TextLayoutBox);
+	if (data->text_layout_areas)
+		size += data->text_layout_length * sizeof (EvRectangle);
+	if (data->text)
+		size += strlen (data->text) + 1;
+	if (data->text_attrs) {
+		guint n_attrs = 0;
+
+		/* Nothing is filtered out, it only walks the list */
+		pango_attr_list_filter (data->text_attrs, count_text_attr, &n_attrs);
+		size += n_attrs * TEXT_ATTR_SIZE;
+	}
+	size += data->text_log_attrs_length * sizeof (PangoLogAttr);
+
+	return size;
+}
+
+/* Must be called whenever the data of a page changes */
+static void
+ev_page_cache_update_size (EvPageCache     *cache,
+			   EvPageCacheData *data)
+{
+	gsize size = ev_page_cache_data_get_size (data);
+
+	if (size > 0 && data->size == 0)
+		g_queue_push_head_link (&cache->lru, &data->link);
+	else if (size == 0 && data->size > 0)
+		g_queue_unlink (&cache->lru, &data->link);
+
+	cache->size = cache->size - data->size + size;
+	data->size = size;
+}
+
+static void
+ev_page_cache_touch (EvPageCache     *cache,
+		     EvPageCacheData *data)
+{
+	if (data->size == 0 || cache->lru.head == &data->link)
+		return;
+
+	g_queue_unlink (&cache->lru, &data->link);
+	g_queue_push_head_link (&cache->lru, &data->link);
+}
+
+static gboolean
+ev_page_cache_is_page_in_use (EvPageCache *cache,
+			      gint         page)
+{
+	/* The current range and the pages pre-cached around it */
+	return page >= cache->start_page - PRE_CACHE_SIZE * 2 &&
+		page <= cache->end_page + PRE_CACHE_SIZE * 2;
+}
+
+/* Drops the least recently used pages out of use until the cache
+ * fits in max_size, but the most recently used one. Their state is
+ * reset, so that they are got again if they are back in use.
+ * "page-evicted" is emitted for every page before its data is freed,
+ * so that the view drops the mappings and areas it got from it */
+static void
+ev_page_cache_evict (EvPageCache *cache)
+{
+	GList  *link;
+	GSList *evicted = NULL, *l;
+	gsize   size = cache->size;
+	guint   n_evicted = 0;
+
+	for (link = g_queue_peek_tail_link (&cache->lru);
+	     link && link != g_queue_peek_head_link (&cache->lru) && size > cache->max_size;
+	     link = link->prev) {
+		EvPageCacheData *data = link->data;
+		gint             page = data - cache->page_list;
+
+		if (data->job || ev_page_cache_is_page_in_use (cache, page))
+			continue;
+
+		evicted = g_slist_prepend (evicted, data);
+		size -= data->size;
+	}
+
+	/* Handlers may use the cache, the pages are only freed after
+	 * all of them have been notified */
+	for (l = evicted; l; l = g_slist_next (l)) {
+		EvPageCacheData *data = l->data;
+
+		g_signal_emit (cache, ev_page_cache_signals[PAGE_EVICTED], 0,
+			       (gint) (data - cache->page_list));
+	}
+
+	for (l = evicted; l; l = g_slist_next (l)) {
+		EvPageCacheData *data = l->data;
+
+		if (data->job)
+			continue;
+
+		ev_page_cache_data_free (data);
+		data->done = FALSE;
+		data->flags = EV_PAGE_DATA_INCLUDE_NONE;
+		ev_page_cache_update_size (cache, data);
+		n_evicted++;
+	}
+	g_slist_free (evicted);
+
+	if (n_evicted > 0) {
+		ev_debug_message (DEBUG_MEMORY,
+				  "%u pages evicted, %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " bytes used",
+				  n_evicted, cache->size, cache->max_size);
+	}
+}
+
+static EvRectangle *
+ev_page_cache_get_text_layout_areas (EvPageCache     *cache,
+				     EvPageCacheData *data)
+{
+	guint i;
+
+	if (data->text_layout_areas || data->text_layout_length == 0)
+		return data->text_layout_areas;
+
+	data->text_layout_areas = g_new (EvRectangle, data->text_layout_length);
+	for (i = 0; i < data->text_layout_length; i++) {
+		data->text_layout_areas[i].x1 = data->text_layout[i].x1;
+		data->text_layout_areas[i].y1 = data->text_layout[i].y1;
+		data->text_layout_areas[i].x2 = data->text_layout[i].x2;
+		data->text_layout_areas[i].y2 = data->text_layout[i].y2;
+	}
+	cache->expanded_pages = g_slist_prepend (cache->expanded_pages, data);
+	ev_page_cache_update_size (cache, data);
+
+	return data->text_layout_areas;
+}
+
+/* Only the pages in use keep their text layout as rectangles */
+static void
+ev_page_cache_drop_text_layout_areas (EvPageCache *cache)
+{
+	GSList *l, *next;
+
+	for (l = cache->expanded_pages; l; l = next) {
+		EvPageCacheData *data = l->data;
+		gint             page = data - cache->page_list;
+
+		next = l->next;
+
+		if (data->text_layout_areas && ev_page_cache_is_page_in_use (cache, page))
+			continue;
+
+		if (data->text_layout_areas) {
+			g_clear_pointer (&data->text_layout_areas, g_free);
+			ev_page_cache_update_size (cache, data);
+		}
+		cache->expanded_pages = g_slist_delete_link (cache->expanded_pages, l);
+	}
+}
+
+static TextLayoutBox *
+text_layout_boxes_new (EvRectangle *areas,
+		       guint        n_areas)
+{
+	TextLayoutBox *boxes;
+	guint          i;
+
+	if (n_areas == 0)
+		return NULL;
+
+	boxes = g_new (TextLayoutBox, n_areas);
+	for (i = 0; i < n_areas; i++) {
+		boxes[i].x1 = areas[i].x1;
+		boxes[i].y1 = areas[i].y1;
+		boxes[i].x2 = areas[i].x2;
+		boxes[i].y2 = areas[i].y2;
+	}
+
+	return boxes;
+}
+
 static void
 ev_page_cache_finalize (GObject *object)
 {
@@ -183,6 +422,9 @@ ev_page_cache_finalize (GObject *object)
 		cache->n_pages = 0;
 	}
 
+	g_slist_free (cache->expanded_pages);
+	cache->expanded_pages = NULL;
+
 	if (cache->document) {
 		g_object_unref (cache->document);
 		cache->document = NULL;
@@ -194,6 +436,8 @@ ev_page_cache_finalize (GObject *object)
 static void
 ev_page_cache_init (EvPageCache *cache)
 {
+	g_queue_init (&cache->lru);
+	cache->max_size = DEFAULT_MAX_SIZE;
 }
 
 static void
@@ -211,6 +455,15 @@ ev_page_cache_class_init (EvPageCacheClass *klass)
                                 NULL, NULL,
                                 g_cclosure_marshal_VOID__INT,
                                 G_TYPE_NONE, 1, G_TYPE_INT);
+
+        ev_page_cache_signals [PAGE_EVICTED] =
+                  g_signal_new ("page-evicted",
+                                EV_TYPE_PAGE_CACHE,
+                                G_SIGNAL_RUN_LAST,
+                                0,
+                                NULL, NULL,
+                                g_cclosure_marshal_VOID__INT,
+                                G_TYPE_NONE, 1, G_TYPE_INT);
 }
 
 static EvJobPageDataFlags
@@ -290,6 +543,7 @@ EvPageCache *
 ev_page_cache_new (EvDocument *document)
 {
 	EvPageCache *cache;
+	gint         i;
 
 	g_return_val_if_fail (EV_IS_DOCUMENT (document), NULL);
 
@@ -298,6 +552,8 @@ ev_page_cache_new (EvDocument *document)
 	cache->n_pages = ev_document_get_n_pages (document);
 	cache->flags = EV_PAGE_DATA_FLAGS_DEFAULT;
 	cache->page_list = g_new0 (EvPageCacheData, cache->n_pages);
+	for (i = 0; i < cache->n_pages; i++)
+		cache->page_list[i].link.data = &cache->page_list[i];
 
 	return cache;
 }
@@ -324,8 +580,10 @@ job_page_data_finished_cb (EvJob       *job,
 	if (job_data->flags & EV_PAGE_DATA_INCLUDE_TEXT_MAPPING)
 		data->text_mapping = job_data->text_mapping;
 	if (job_data->flags & EV_PAGE_DATA_INCLUDE_TEXT_LAYOUT) {
-		data->text_layout = job_data->text_layout;
-		data->text_layout_length = job_data->text_layout_length;
+		data->text_layout = text_layout_boxes_new (job_data->text_layout,
+							   job_data->text_layout_length);
+		data->text_layout_length = data->text_layout ? job_data->text_layout_length : 0;
+		g_clear_pointer (&job_data->text_layout, g_free);
 	}
 	if (job_data->flags & EV_PAGE_DATA_INCLUDE_TEXT)
 		data->text = job_data->text;
@@ -342,6 +600,13 @@ job_page_data_finished_cb (EvJob       *job,
 	g_object_unref (data->job);
 	data->job = NULL;
 
+	ev_page_cache_update_size (cache, data);
+	ev_page_cache_touch (cache, data);
+	ev_debug_message (DEBUG_MEMORY,
+			  "page %d: %" G_GSIZE_FORMAT " bytes, %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " bytes used",
+			  job_data->page, data->size, cache->size, cache->max_size);
+	ev_page_cache_evict (cache);
+
         g_signal_emit (cache, ev_page_cache_signals[PAGE_CACHED], 0, job_data->page);
 }
 
@@ -397,6 +662,10 @@ ev_page_cache_set_page_range (EvPageCache *cache,
 	cache->start_page = start;
 	cache->end_page = end;
 
+	for (i = start; i <= end; i++)
+		ev_page_cache_touch (cache, &cache->page_list[i]);
+	ev_page_cache_drop_text_layout_areas (cache);
+
         i = 1;
         pages_to_pre_cache = PRE_CACHE_SIZE * 2;
         while ((start - i > 0) || (end + i < cache->n_pages)) {
@@ -469,6 +738,7 @@ ev_page_cache_mark_dirty (EvPageCache       *cache,
 
 	if (flags & EV_PAGE_DATA_INCLUDE_TEXT_LAYOUT) {
                 g_clear_pointer (&data->text_layout, g_free);
+                g_clear_pointer (&data->text_layout_areas, g_free);
                 data->text_layout_length = 0;
         }
 
@@ -480,6 +750,8 @@ ev_page_cache_mark_dirty (EvPageCache       *cache,
                 data->text_log_attrs_length = 0;
         }
 
+	ev_page_cache_update_size (cache, data);
+
 	/* Update the current range */
 	ev_page_cache_set_page_range (cache, cache->start_page, cache->end_page);
 }
@@ -629,8 +901,10 @@ ev_page_cache_get_text (EvPageCache *cache,
 		return NULL;
 
 	data = &cache->page_list[page];
-	if (data->done)
+	if (data->done) {
+		ev_page_cache_touch (cache, data);
 		return data->text;
+	}
 
 	if (data->job)
 		return EV_JOB_PAGE_DATA (data->job)->text;
@@ -654,7 +928,8 @@ ev_page_cache_get_text_layout (EvPageCache  *cache,
 
 	data = &cache->page_list[page];
 	if (data->done)	{
-		*areas = data->text_layout;
+		ev_page_cache_touch (cache, data);
+		*areas = ev_page_cache_get_text_layout_areas (cache, data);
 		*n_areas = data->text_layout_length;
 
 		return TRUE;
@@ -692,8 +967,10 @@ ev_page_cache_get_text_attrs (EvPageCache    *cache,
 	    return NULL;
 
 	data = &cache->page_list[page];
-	if (data->done)
+	if (data->done) {
+		ev_page_cache_touch (cache, data);
 		return data->text_attrs;
+	}
 
 	if (data->job)
 		return EV_JOB_PAGE_DATA(data->job)->text_attrs;
@@ -730,6 +1007,7 @@ ev_page_cache_get_text_log_attrs (EvPageCache   *cache,
 
         data = &cache->page_list[page];
         if (data->done) {
+                ev_page_cache_touch (cache, data);
                 *log_attrs = data->text_log_attrs;
                 *n_attrs = data->text_log_attrs_length;
 
@@ -769,3 +1047,114 @@ ev_page_cache_is_page_cached (EvPageCache   *cache,
 
 	return data->done;
 }
+
+/**
+ * ev_page_cache_reuse_data:
+ * @cache: a #EvPageCache
+ * @old_cache: the #EvPageCache of a previous version of the document of @cache
+ *
+ * Moves the text @old_cache has for the pages whose fingerprint is the same
+ * as that of some page of the document of @cache, so that it's not extracted
+ * again when the document is reloaded. Links, images, forms, annotations and
+ * media belong to the document they were got from, so they are always got
+ * again.
+ *
+ * Since: 3.30
+ */
+void
+ev_page_cache_reuse_data (EvPageCache *cache,
+			  EvPageCache *old_cache)
+{
+	gint i;
+
+	g_return_if_fail (EV_IS_PAGE_CACHE (cache));
+	g_return_if_fail (EV_IS_PAGE_CACHE (old_cache));
+
+	for (i = 0; i < old_cache->n_pages; i++) {
+		EvPageCacheData *old_data = &old_cache->page_list[i];
+		EvPageCacheData *data;
+		gchar           *fingerprint;
+		gint             page;
+
+		if (!old_data->done)
+			continue;
+
+		fingerprint = ev_document_lookup_page_fingerprint (old_cache->document, i);
+		if (!fingerprint)
+			continue;
+
+		page = ev_document_find_page_by_fingerprint (cache->document, fingerprint);
+		g_free (fingerprint);
+		if (page < 0)
+			continue;
+
+		/* Identical pages map to the same page */
+		data = &cache->page_list[page];
+		if (data->done || data->job || data->text_mapping || data->text_layout ||
+		    data->text || data->text_attrs || data->text_log_attrs)
+			continue;
+
+		/* The flags of the data are left unset, so that a job
+		 * is scheduled for what's missing */
+		data->text_mapping = old_data->text_mapping;
+		old_data->text_mapping = NULL;
+		data->text_layout = old_data->text_layout;
+		data->text_layout_length = old_data->text_layout_length;
+		old_data->text_layout = NULL;
+		old_data->text_layout_length = 0;
+		g_clear_pointer (&old_data->text_layout_areas, g_free);
+		data->text = old_data->text;
+		old_data->text = NULL;
+		data->text_attrs = old_data->text_attrs;
+		old_data->text_attrs = NULL;
+		data->text_log_attrs = old_data->text_log_attrs;
+		data->text_log_attrs_length = old_data->text_log_attrs_length;
+		old_data->text_log_attrs = NULL;
+		old_data->text_log_attrs_length = 0;
+
+		ev_page_cache_update_size (old_cache, old_data);
+		ev_page_cache_update_size (cache, data);
+	}
+
+	ev_page_cache_evict (cache);
+}
+
+/**
+ * ev_page_cache_set_max_size:
+ * @cache: a #EvPageCache
+ * @max_size: the most bytes of page data to keep
+ *
+ * Sets the memory budget of @cache. When the data of the pages exceeds
+ * @max_size, the least recently used pages out of the current range are
+ * dropped, and they are got again when they are back in the range.
+ *
+ * Since: 3.30
+ */
+void
+ev_page_cache_set_max_size (EvPageCache *cache,
+			    gsize        max_size)
+{
+	g_return_if_fail (EV_IS_PAGE_CACHE (cache));
+
+	if (cache->max_size == max_size)
+		return;
+
+	cache->max_size = max_size;
+	ev_page_cache_evict (cache);
+}
+
+/**
+ * ev_page_cache_get_size:
+ * @cache: a #EvPageCache
+ *
+ * Returns: an estimate of the bytes of page data kept in @cache
+ *
+ * Since: 3.30
+ */
+gsize
+ev_page_cache_get_size (EvPageCache *cache)
+{
+	g_return_val_if_fail (EV_IS_PAGE_CACHE (cache), 0);
+
+	return cache->size;
+}
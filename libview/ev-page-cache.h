@@ -81,6 +81,11 @@ void               ev_page_cache_ensure_page            (EvPageCache       *cach
                                                          gint               page);
 gboolean           ev_page_cache_is_page_cached         (EvPageCache       *cache,
                                                          gint               page);
+void               ev_page_cache_reuse_data             (EvPageCache       *cache,
+							 EvPageCache       *old_cache);
+void               ev_page_cache_set_max_size           (EvPageCache       *cache,
+							 gsize              max_size);
+gsize              ev_page_cache_get_size               (EvPageCache       *cache);
 G_END_DECLS
 
 #endif /* EV_PAGE_CACHE_H */
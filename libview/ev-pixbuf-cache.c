@@ -38,6 +38,42 @@ typedef struct _CacheJobInfo
 	EvRectangle     selection_region_points;
 } CacheJobInfo;
 
+/* Pages too big to be cached as a whole are split in tiles of
+ * EV_PIXBUF_CACHE_TILE_SIZE logical pixels, rendered and cached
+ * independently.
+ */
+typedef struct _TileKey
+{
+	gint    page;
+	gint    rotation;
+	gdouble scale;
+	gint    device_scale;
+	gint    tile_x;
+	gint    tile_y;
+} TileKey;
+
+typedef struct _ReusedSurface
+{
+	cairo_surface_t *surface;
+	gint             device_scale;
+} ReusedSurface;
+
+typedef struct _TileInfo
+{
+	TileKey          key;
+	EvPixbufCache   *pixbuf_cache;
+
+	EvJob           *job;
+	EvJobPriority    priority;
+
+	cairo_surface_t *surface;
+	gsize            size;
+	/* Not requested again, the key changes with the scale */
+	gboolean         failed;
+
+	GList           *link;
+} TileInfo;
+
 struct _EvPixbufCache
 {
 	GObject parent;
@@ -63,6 +99,20 @@ struct _EvPixbufCache
 	CacheJobInfo *prev_job;
 	CacheJobInfo *job_list;
 	CacheJobInfo *next_job;
+
+	/* Tiles of the pages rendered in tiles, the queue is sorted
+	 * from the most to the least recently used tile. Tiles and page
+	 * surfaces share max_size, the visible tiles are never evicted.
+	 */
+	GHashTable *tiles;
+	GQueue      tiles_lru;
+	gsize       tiles_size;
+	GHashTable *visible_tiles; /* page -> cairo_rectangle_int_t of tiles */
+
+	/* Surfaces of the pages that didn't change when the document was
+	 * reloaded, by page, until they are needed or out of range.
+	 */
+	GHashTable *reused_surfaces;
 };
 
 struct _EvPixbufCacheClass
@@ -87,6 +137,10 @@ static void          ev_pixbuf_cache_finalize   (GObject            *object);
 static void          ev_pixbuf_cache_dispose    (GObject            *object);
 static void          job_finished_cb            (EvJob              *job,
 						 EvPixbufCache      *pixbuf_cache);
+static void          tile_job_finished_cb       (EvJob              *job,
+						 TileInfo           *tile);
+static void          ev_pixbuf_cache_evict_tiles (EvPixbufCache     *pixbuf_cache,
+						  TileInfo          *keep);
 static CacheJobInfo *find_job_cache             (EvPixbufCache      *pixbuf_cache,
 						 int                 page);
 static gboolean      new_selection_surface_needed(EvPixbufCache      *pixbuf_cache,
@@ -105,13 +159,92 @@ static gboolean      new_selection_surface_needed(EvPixbufCache      *pixbuf_cac
 
 #define MAX_PRELOADED_PAGES 3
 
+/* A page is rendered in tiles when its surface would take more than
+ * this fraction of the cache.
+ */
+#define TILED_PAGE_CACHE_FRACTION 4
+
 G_DEFINE_TYPE (EvPixbufCache, ev_pixbuf_cache, G_TYPE_OBJECT)
 
+static guint
+tile_key_hash (gconstpointer data)
+{
+	const TileKey *key = data;
+	guint          hash;
+
+	hash = g_double_hash (&key->scale);
+	hash = hash * 31 + key->page;
+	hash = hash * 31 + key->rotation;
+	hash = hash * 31 + key->device_scale;
+	hash = hash * 31 + key->tile_x;
+	hash = hash * 31 + key->tile_y;
+
+	return hash;
+}
+
+static gboolean
+tile_key_equal (gconstpointer a,
+		gconstpointer b)
+{
+	const TileKey *key_a = a;
+	const TileKey *key_b = b;
+
+	return key_a->page == key_b->page &&
+		key_a->tile_x == key_b->tile_x &&
+		key_a->tile_y == key_b->tile_y &&
+		key_a->rotation == key_b->rotation &&
+		key_a->device_scale == key_b->device_scale &&
+		key_a->scale == key_b->scale;
+}
+
+static void
+tile_end_job (TileInfo *tile)
+{
+	g_signal_handlers_disconnect_by_func (tile->job,
+					      G_CALLBACK (tile_job_finished_cb),
+					      tile);
+	ev_job_cancel (tile->job);
+	g_object_unref (tile->job);
+	tile->job = NULL;
+}
+
+static void
+tile_info_free (TileInfo *tile)
+{
+	EvPixbufCache *pixbuf_cache = tile->pixbuf_cache;
+
+	if (tile->job)
+		tile_end_job (tile);
+
+	if (tile->surface) {
+		cairo_surface_destroy (tile->surface);
+		pixbuf_cache->tiles_size -= tile->size;
+	}
+
+	g_queue_delete_link (&pixbuf_cache->tiles_lru, tile->link);
+	g_slice_free (TileInfo, tile);
+}
+
+static void
+reused_surface_free (ReusedSurface *reused)
+{
+	cairo_surface_destroy (reused->surface);
+	g_slice_free (ReusedSurface, reused);
+}
+
 static void
 ev_pixbuf_cache_init (EvPixbufCache *pixbuf_cache)
 {
 	pixbuf_cache->start_page = -1;
 	pixbuf_cache->end_page = -1;
+	pixbuf_cache->tiles = g_hash_table_new_full (tile_key_hash,
+						     tile_key_equal,
+						     NULL,
+						     (GDestroyNotify) tile_info_free);
+	g_queue_init (&pixbuf_cache->tiles_lru);
+	pixbuf_cache->visible_tiles = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+	pixbuf_cache->reused_surfaces = g_hash_table_new_full (NULL, NULL, NULL,
+							       (GDestroyNotify) reused_surface_free);
 }
 
 static void
@@ -222,6 +355,14 @@ ev_pixbuf_cache_dispose (GObject *object)
 		dispose_cache_job_info (pixbuf_cache->job_list + i, pixbuf_cache);
 	}
 
+	if (pixbuf_cache->tiles) {
+		g_hash_table_destroy (pixbuf_cache->tiles);
+		pixbuf_cache->tiles = NULL;
+	}
+	g_clear_pointer (&pixbuf_cache->visible_tiles, g_hash_table_destroy);
+
+	g_clear_pointer (&pixbuf_cache->reused_surfaces, g_hash_table_destroy);
+
 	G_OBJECT_CLASS (ev_pixbuf_cache_parent_class)->dispose (object);
 }
 
@@ -319,6 +460,9 @@ copy_job_to_job_info (EvJobRender   *job_render,
 		end_job (job_info, pixbuf_cache);
 
 	job_info->page_ready = TRUE;
+
+	/* The page surfaces take from the size left to tiles */
+	ev_pixbuf_cache_evict_tiles (pixbuf_cache, NULL);
 }
 
 static void
@@ -450,6 +594,24 @@ ev_pixbuf_cache_get_page_size (EvPixbufCache *pixbuf_cache,
 	return height * cairo_format_stride_for_width (CAIRO_FORMAT_RGB24, width);
 }
 
+static gboolean
+ev_pixbuf_cache_page_needs_tiles (EvPixbufCache *pixbuf_cache,
+				  gint           page,
+				  gdouble        scale,
+				  gint           rotation)
+{
+	gint device_scale;
+
+	if (!ev_document_supports_render_area (pixbuf_cache->document))
+		return FALSE;
+
+	device_scale = get_device_scale (pixbuf_cache);
+
+	return ev_pixbuf_cache_get_page_size (pixbuf_cache, page,
+					      scale * device_scale,
+					      rotation) > pixbuf_cache->max_size / TILED_PAGE_CACHE_FRACTION;
+}
+
 static gint
 ev_pixbuf_cache_get_preload_size (EvPixbufCache *pixbuf_cache,
 				  gint           start_page,
@@ -710,6 +872,36 @@ add_job (EvPixbufCache  *pixbuf_cache,
 	ev_job_scheduler_push_job (job_info->job, priority);
 }
 
+static gboolean
+take_reused_surface (EvPixbufCache *pixbuf_cache,
+		     CacheJobInfo  *job_info,
+		     gint           page,
+		     gint           width,
+		     gint           height)
+{
+	ReusedSurface *reused;
+	gint           device_scale = get_device_scale (pixbuf_cache);
+	gboolean       retval = FALSE;
+
+	reused = g_hash_table_lookup (pixbuf_cache->reused_surfaces, GINT_TO_POINTER (page));
+	if (!reused)
+		return FALSE;
+
+	/* Only if it was rendered at the size we need now */
+	if (reused->device_scale == device_scale &&
+	    cairo_image_surface_get_width (reused->surface) == width * device_scale &&
+	    cairo_image_surface_get_height (reused->surface) == height * device_scale) {
+		job_info->surface = cairo_surface_reference (reused->surface);
+		job_info->device_scale = device_scale;
+		job_info->points_set = FALSE;
+		job_info->page_ready = TRUE;
+		retval = TRUE;
+	}
+	g_hash_table_remove (pixbuf_cache->reused_surfaces, GINT_TO_POINTER (page));
+
+	return retval;
+}
+
 static void
 add_job_if_needed (EvPixbufCache *pixbuf_cache,
 		   CacheJobInfo  *job_info,
@@ -724,6 +916,12 @@ add_job_if_needed (EvPixbufCache *pixbuf_cache,
 	if (job_info->job)
 		return;
 
+	/* Tiles are requested by the view as they are drawn, the surface
+	 * we might have is kept as a placeholder until they are ready.
+	 */
+	if (ev_pixbuf_cache_page_needs_tiles (pixbuf_cache, page, scale, rotation))
+		return;
+
 	_get_page_size_for_scale_and_rotation (pixbuf_cache->document,
 					       page, scale, rotation,
 					       &width, &height);
@@ -734,6 +932,10 @@ add_job_if_needed (EvPixbufCache *pixbuf_cache,
 	    cairo_image_surface_get_height (job_info->surface) == height * device_scale)
 		return;
 
+	if (!job_info->surface &&
+	    take_reused_surface (pixbuf_cache, job_info, page, width, height))
+		return;
+
 	/* Free old surfaces for non visible pages */
 	if (priority == EV_JOB_PRIORITY_LOW) {
 		if (job_info->surface) {
@@ -817,6 +1019,281 @@ ev_pixbuf_cache_add_jobs_if_needed (EvPixbufCache *pixbuf_cache,
         }
 }
 
+static void
+ev_pixbuf_cache_get_n_tiles (EvPixbufCache *pixbuf_cache,
+			     const TileKey *key,
+			     gint          *n_tiles_x,
+			     gint          *n_tiles_y)
+{
+	gint width, height;
+	gint tile_size;
+
+	_get_page_size_for_scale_and_rotation (pixbuf_cache->document,
+					       key->page, key->scale, key->rotation,
+					       &width, &height);
+	tile_size = EV_PIXBUF_CACHE_TILE_SIZE;
+
+	*n_tiles_x = (width + tile_size - 1) / tile_size;
+	*n_tiles_y = (height + tile_size - 1) / tile_size;
+}
+
+static void
+tile_add_job (EvPixbufCache *pixbuf_cache,
+	      TileInfo      *tile,
+	      EvJobPriority  priority)
+{
+	cairo_rectangle_int_t area;
+	gint                  width, height;
+	gint                  device_scale = tile->key.device_scale;
+	gint                  tile_size = EV_PIXBUF_CACHE_TILE_SIZE * device_scale;
+
+	if (tile->job)
+		tile_end_job (tile);
+
+	_get_page_size_for_scale_and_rotation (pixbuf_cache->document,
+					       tile->key.page,
+					       tile->key.scale,
+					       tile->key.rotation,
+					       &width, &height);
+	width *= device_scale;
+	height *= device_scale;
+
+	area.x = tile->key.tile_x * tile_size;
+	area.y = tile->key.tile_y * tile_size;
+	area.width = MIN (tile_size, width - area.x);
+	area.height = MIN (tile_size, height - area.y);
+
+	tile->priority = priority;
+	tile->job = ev_job_render_new (pixbuf_cache->document,
+				       tile->key.page,
+				       tile->key.rotation,
+				       tile->key.scale * device_scale,
+				       width, height);
+	ev_job_render_set_area (EV_JOB_RENDER (tile->job), &area);
+
+	g_signal_connect (tile->job, "finished",
+			  G_CALLBACK (tile_job_finished_cb),
+			  tile);
+	ev_job_scheduler_push_job (tile->job, priority);
+}
+
+static gsize
+get_surface_size (cairo_surface_t *surface)
+{
+	if (!surface || cairo_surface_get_type (surface) != CAIRO_SURFACE_TYPE_IMAGE)
+		return 0;
+
+	return (gsize) cairo_image_surface_get_stride (surface) *
+		cairo_image_surface_get_height (surface);
+}
+
+/* The memory taken by the page surfaces, without the tiles */
+static gsize
+ev_pixbuf_cache_get_surfaces_size (EvPixbufCache *pixbuf_cache)
+{
+	GHashTableIter iter;
+	ReusedSurface *reused;
+	gsize          size = 0;
+	gint           i;
+
+	if (!pixbuf_cache->job_list)
+		return 0;
+
+	for (i = 0; i < pixbuf_cache->preload_cache_size; i++) {
+		size += get_surface_size (pixbuf_cache->prev_job[i].surface);
+		size += get_surface_size (pixbuf_cache->next_job[i].surface);
+	}
+
+	for (i = 0; i < PAGE_CACHE_LEN (pixbuf_cache); i++)
+		size += get_surface_size (pixbuf_cache->job_list[i].surface);
+
+	g_hash_table_iter_init (&iter, pixbuf_cache->reused_surfaces);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &reused))
+		size += get_surface_size (reused->surface);
+
+	return size;
+}
+
+static gboolean
+ev_pixbuf_cache_tile_is_visible (EvPixbufCache *pixbuf_cache,
+				 TileInfo      *tile)
+{
+	cairo_rectangle_int_t *visible;
+
+	visible = g_hash_table_lookup (pixbuf_cache->visible_tiles,
+				       GINT_TO_POINTER (tile->key.page));
+
+	return visible &&
+		tile->key.tile_x >= visible->x &&
+		tile->key.tile_x < visible->x + visible->width &&
+		tile->key.tile_y >= visible->y &&
+		tile->key.tile_y < visible->y + visible->height;
+}
+
+static gboolean
+ev_pixbuf_cache_is_full (EvPixbufCache *pixbuf_cache)
+{
+	return pixbuf_cache->tiles_size + ev_pixbuf_cache_get_surfaces_size (pixbuf_cache) >=
+		pixbuf_cache->max_size;
+}
+
+static void
+ev_pixbuf_cache_evict_tiles (EvPixbufCache *pixbuf_cache,
+			     TileInfo      *keep)
+{
+	GList *l = pixbuf_cache->tiles_lru.tail;
+	gsize  surfaces_size;
+
+	if (pixbuf_cache->tiles_size == 0)
+		return;
+
+	surfaces_size = ev_pixbuf_cache_get_surfaces_size (pixbuf_cache);
+
+	/* From the least recently used one, skipping @keep and the
+	 * visible tiles, that are kept even over the cache size not
+	 * to render them again on every draw. Tiles without a surface
+	 * don't take any memory. */
+	while (l && pixbuf_cache->tiles_size + surfaces_size > pixbuf_cache->max_size) {
+		TileInfo *tile = l->data;
+
+		l = g_list_previous (l);
+		if (tile != keep && tile->surface &&
+		    !ev_pixbuf_cache_tile_is_visible (pixbuf_cache, tile))
+			g_hash_table_remove (pixbuf_cache->tiles, &tile->key);
+	}
+}
+
+static void
+tile_job_finished_cb (EvJob    *job,
+		      TileInfo *tile)
+{
+	EvPixbufCache *pixbuf_cache = tile->pixbuf_cache;
+	EvJobRender   *job_render = EV_JOB_RENDER (job);
+
+	if (ev_job_is_failed (job)) {
+		tile->failed = TRUE;
+		tile_end_job (tile);
+		return;
+	}
+
+	if (tile->surface) {
+		cairo_surface_destroy (tile->surface);
+		pixbuf_cache->tiles_size -= tile->size;
+	}
+
+	tile->surface = cairo_surface_reference (job_render->surface);
+	set_device_scale_on_surface (tile->surface, tile->key.device_scale);
+	if (pixbuf_cache->inverted_colors)
+		ev_document_misc_invert_surface (tile->surface);
+
+	tile->size = cairo_image_surface_get_stride (tile->surface) *
+		cairo_image_surface_get_height (tile->surface);
+	pixbuf_cache->tiles_size += tile->size;
+
+	tile_end_job (tile);
+
+	ev_pixbuf_cache_evict_tiles (pixbuf_cache, tile);
+
+	g_signal_emit (pixbuf_cache, signals[JOB_FINISHED], 0, NULL);
+}
+
+static TileInfo *
+ev_pixbuf_cache_lookup_tile (EvPixbufCache *pixbuf_cache,
+			     gint           page,
+			     gint           tile_x,
+			     gint           tile_y,
+			     EvJobPriority  priority)
+{
+	TileInfo *tile;
+	TileKey   key;
+
+	key.page = page;
+	key.rotation = ev_document_model_get_rotation (pixbuf_cache->model);
+	key.scale = ev_document_model_get_scale (pixbuf_cache->model);
+	key.device_scale = get_device_scale (pixbuf_cache);
+	key.tile_x = tile_x;
+	key.tile_y = tile_y;
+
+	tile = g_hash_table_lookup (pixbuf_cache->tiles, &key);
+	if (!tile) {
+		tile = g_slice_new0 (TileInfo);
+		tile->key = key;
+		tile->pixbuf_cache = pixbuf_cache;
+
+		/* Preloaded tiles are the first ones to be evicted */
+		if (priority == EV_JOB_PRIORITY_URGENT)
+			g_queue_push_head (&pixbuf_cache->tiles_lru, tile);
+		else
+			g_queue_push_tail (&pixbuf_cache->tiles_lru, tile);
+		tile->link = priority == EV_JOB_PRIORITY_URGENT ?
+			pixbuf_cache->tiles_lru.head : pixbuf_cache->tiles_lru.tail;
+
+		g_hash_table_insert (pixbuf_cache->tiles, &tile->key, tile);
+	} else if (priority == EV_JOB_PRIORITY_URGENT) {
+		g_queue_unlink (&pixbuf_cache->tiles_lru, tile->link);
+		g_queue_push_head_link (&pixbuf_cache->tiles_lru, tile->link);
+	}
+
+	if (!tile->surface && !tile->job && !tile->failed) {
+		tile_add_job (pixbuf_cache, tile, priority);
+	} else if (tile->job && priority < tile->priority) {
+		tile->priority = priority;
+		ev_job_scheduler_update_job (tile->job, priority);
+	}
+
+	return tile;
+}
+
+static gboolean
+visible_tiles_out_of_range (gpointer       key,
+			    gpointer       value,
+			    EvPixbufCache *pixbuf_cache)
+{
+	gint page = GPOINTER_TO_INT (key);
+
+	return page < pixbuf_cache->start_page || page > pixbuf_cache->end_page;
+}
+
+/* Drops the tiles rendered for another scale or rotation, or for pages
+ * out of the cached range, and lowers the priority of the pending jobs.
+ */
+static void
+ev_pixbuf_cache_update_tiles (EvPixbufCache *pixbuf_cache,
+			      gint           rotation,
+			      gdouble        scale)
+{
+	GHashTableIter iter;
+	TileInfo      *tile;
+	gint           device_scale;
+
+	g_hash_table_foreach_remove (pixbuf_cache->visible_tiles,
+				     (GHRFunc) visible_tiles_out_of_range,
+				     pixbuf_cache);
+
+	if (g_hash_table_size (pixbuf_cache->tiles) == 0)
+		return;
+
+	device_scale = get_device_scale (pixbuf_cache);
+
+	g_hash_table_iter_init (&iter, pixbuf_cache->tiles);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &tile)) {
+		if (tile->key.rotation != rotation ||
+		    tile->key.scale != scale ||
+		    tile->key.device_scale != device_scale ||
+		    tile->key.page < pixbuf_cache->start_page - pixbuf_cache->preload_cache_size ||
+		    tile->key.page > pixbuf_cache->end_page + pixbuf_cache->preload_cache_size ||
+		    !ev_pixbuf_cache_page_needs_tiles (pixbuf_cache, tile->key.page, scale, rotation)) {
+			g_hash_table_iter_remove (&iter);
+			continue;
+		}
+
+		if (tile->job && tile->priority != EV_JOB_PRIORITY_LOW) {
+			tile->priority = EV_JOB_PRIORITY_LOW;
+			ev_job_scheduler_update_job (tile->job, EV_JOB_PRIORITY_LOW);
+		}
+	}
+}
+
 static ScrollDirection
 ev_pixbuf_cache_get_scroll_direction (EvPixbufCache *pixbuf_cache,
                                       gint           start_page,
@@ -837,6 +1314,17 @@ ev_pixbuf_cache_get_scroll_direction (EvPixbufCache *pixbuf_cache,
         return pixbuf_cache->scroll_direction;
 }
 
+static gboolean
+reused_surface_out_of_range (gpointer       key,
+			     ReusedSurface *reused,
+			     EvPixbufCache *pixbuf_cache)
+{
+	gint page = GPOINTER_TO_INT (key);
+
+	return page < pixbuf_cache->start_page - pixbuf_cache->preload_cache_size ||
+		page > pixbuf_cache->end_page + pixbuf_cache->preload_cache_size;
+}
+
 void
 ev_pixbuf_cache_set_page_range (EvPixbufCache  *pixbuf_cache,
 				gint            start_page,
@@ -862,19 +1350,33 @@ ev_pixbuf_cache_set_page_range (EvPixbufCache  *pixbuf_cache,
 	 * size, we remove them if we need to. */
 	ev_pixbuf_cache_clear_job_sizes (pixbuf_cache, scale);
 
+	/* Drop the tiles that are no longer useful and lower the
+	 * priority of the pending ones, the visible tiles will be
+	 * requested again when the view is drawn. */
+	ev_pixbuf_cache_update_tiles (pixbuf_cache, rotation, scale);
+
 	/* Next, we update the target selection for our pages */
 	ev_pixbuf_cache_set_selection_list (pixbuf_cache, selection_list);
 
 	/* Finally, we add the new jobs for all the sizes that don't have a
 	 * pixbuf */
 	ev_pixbuf_cache_add_jobs_if_needed (pixbuf_cache, rotation, scale);
+
+	/* The reused surfaces of pages we scrolled away from won't be needed */
+	if (g_hash_table_size (pixbuf_cache->reused_surfaces) > 0)
+		g_hash_table_foreach_remove (pixbuf_cache->reused_surfaces,
+					     (GHRFunc) reused_surface_out_of_range,
+					     pixbuf_cache);
 }
 
 void
 ev_pixbuf_cache_set_inverted_colors (EvPixbufCache *pixbuf_cache,
 				     gboolean       inverted_colors)
 {
-	gint i;
+	GHashTableIter iter;
+	ReusedSurface *reused;
+	GList         *l;
+	gint           i;
 
 	if (pixbuf_cache->inverted_colors == inverted_colors)
 		return;
@@ -900,6 +1402,17 @@ ev_pixbuf_cache_set_inverted_colors (EvPixbufCache *pixbuf_cache,
 		if (job_info && job_info->surface)
 			ev_document_misc_invert_surface (job_info->surface);
 	}
+
+	for (l = pixbuf_cache->tiles_lru.head; l; l = g_list_next (l)) {
+		TileInfo *tile = l->data;
+
+		if (tile->surface)
+			ev_document_misc_invert_surface (tile->surface);
+	}
+
+	g_hash_table_iter_init (&iter, pixbuf_cache->reused_surfaces);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &reused))
+		ev_document_misc_invert_surface (reused->surface);
 }
 
 cairo_surface_t *
@@ -925,6 +1438,105 @@ ev_pixbuf_cache_get_surface (EvPixbufCache *pixbuf_cache,
 	return job_info->surface;
 }
 
+/* Whether the page is too big at the current scale to be cached as a
+ * whole, in which case it's drawn from the tile surfaces.
+ */
+gboolean
+ev_pixbuf_cache_page_uses_tiles (EvPixbufCache *pixbuf_cache,
+				 gint           page)
+{
+	g_return_val_if_fail (EV_IS_PIXBUF_CACHE (pixbuf_cache), FALSE);
+
+	return ev_pixbuf_cache_page_needs_tiles (pixbuf_cache, page,
+						 ev_document_model_get_scale (pixbuf_cache->model),
+						 ev_document_model_get_rotation (pixbuf_cache->model));
+}
+
+/* Tiles are squares of EV_PIXBUF_CACHE_TILE_SIZE logical pixels of the
+ * page at the current scale and rotation, the last row and column being
+ * possibly smaller. Tiles not rendered yet are scheduled with urgent
+ * priority, and job-finished is emitted when they are ready.
+ */
+cairo_surface_t *
+ev_pixbuf_cache_get_tile_surface (EvPixbufCache *pixbuf_cache,
+				  gint           page,
+				  gint           tile_x,
+				  gint           tile_y)
+{
+	TileInfo *tile;
+
+	g_return_val_if_fail (EV_IS_PIXBUF_CACHE (pixbuf_cache), NULL);
+
+	tile = ev_pixbuf_cache_lookup_tile (pixbuf_cache, page, tile_x, tile_y,
+					    EV_JOB_PRIORITY_URGENT);
+
+	return tile->surface;
+}
+
+/* Sets the tiles of @page in the viewport, that are not evicted even
+ * when they take more than the cache size.
+ */
+void
+ev_pixbuf_cache_set_visible_tiles (EvPixbufCache *pixbuf_cache,
+				   gint           page,
+				   gint           first_x,
+				   gint           first_y,
+				   gint           last_x,
+				   gint           last_y)
+{
+	cairo_rectangle_int_t *visible;
+
+	g_return_if_fail (EV_IS_PIXBUF_CACHE (pixbuf_cache));
+
+	visible = g_new (cairo_rectangle_int_t, 1);
+	visible->x = first_x;
+	visible->y = first_y;
+	visible->width = last_x - first_x + 1;
+	visible->height = last_y - first_y + 1;
+	g_hash_table_insert (pixbuf_cache->visible_tiles, GINT_TO_POINTER (page), visible);
+}
+
+/* Schedules with low priority the tiles in the given range, clamped to
+ * the page, that haven't been rendered yet, as long as the cache is
+ * not full.
+ */
+void
+ev_pixbuf_cache_preload_tiles (EvPixbufCache *pixbuf_cache,
+			       gint           page,
+			       gint           first_x,
+			       gint           first_y,
+			       gint           last_x,
+			       gint           last_y)
+{
+	TileKey key;
+	gint    n_tiles_x, n_tiles_y;
+	gint    x, y;
+
+	g_return_if_fail (EV_IS_PIXBUF_CACHE (pixbuf_cache));
+
+	/* They would evict each other */
+	if (ev_pixbuf_cache_is_full (pixbuf_cache))
+		return;
+
+	key.page = page;
+	key.rotation = ev_document_model_get_rotation (pixbuf_cache->model);
+	key.scale = ev_document_model_get_scale (pixbuf_cache->model);
+	key.device_scale = get_device_scale (pixbuf_cache);
+	ev_pixbuf_cache_get_n_tiles (pixbuf_cache, &key, &n_tiles_x, &n_tiles_y);
+
+	first_x = MAX (first_x, 0);
+	first_y = MAX (first_y, 0);
+	last_x = MIN (last_x, n_tiles_x - 1);
+	last_y = MIN (last_y, n_tiles_y - 1);
+
+	for (y = first_y; y <= last_y; y++) {
+		for (x = first_x; x <= last_x; x++) {
+			ev_pixbuf_cache_lookup_tile (pixbuf_cache, page, x, y,
+						     EV_JOB_PRIORITY_LOW);
+		}
+	}
+}
+
 static gboolean
 new_selection_surface_needed (EvPixbufCache *pixbuf_cache,
 			      CacheJobInfo  *job_info,
@@ -982,6 +1594,10 @@ ev_pixbuf_cache_clear (EvPixbufCache *pixbuf_cache)
 {
 	int i;
 
+	g_hash_table_remove_all (pixbuf_cache->tiles);
+	g_hash_table_remove_all (pixbuf_cache->visible_tiles);
+	g_hash_table_remove_all (pixbuf_cache->reused_surfaces);
+
 	if (!pixbuf_cache->job_list)
 		return;
 
@@ -1054,6 +1670,11 @@ ev_pixbuf_cache_get_selection_surface (EvPixbufCache   *pixbuf_cache,
 	if (!job_info->points_set)
 		return NULL;
 
+	/* A selection surface as big as the page is what tiles avoid,
+	 * the view draws the selection region instead */
+	if (ev_pixbuf_cache_page_uses_tiles (pixbuf_cache, page))
+		return NULL;
+
 	/* If we have a running job, we just return what we have under the
 	 * assumption that it'll be updated later and we can scale it as need
 	 * be */
@@ -1066,7 +1687,7 @@ ev_pixbuf_cache_get_selection_surface (EvPixbufCache   *pixbuf_cache,
 
 	/* Finally, we see if the two scales are the same, and get a new pixbuf
 	 * if needed.  We do this synchronously for now.  At some point, we
-	 * _should_ be able to get rid of the doc_mutex, so the synchronicity
+	 * _should_ be able to get rid of the document lock, so the synchronicity
 	 * doesn't kill us.  Rendering a few glyphs should really be fast.
 	 */
 	if (ev_rect_cmp (&(job_info->target_points), &(job_info->selection_points))) {
@@ -1077,7 +1698,7 @@ ev_pixbuf_cache_get_selection_surface (EvPixbufCache   *pixbuf_cache,
 		gint width, height;
 
 		/* we need to get a new selection pixbuf */
-		ev_document_doc_mutex_lock ();
+		ev_document_lock (pixbuf_cache->document);
 		if (job_info->selection_points.x1 < 0) {
 			g_assert (job_info->selection == NULL);
 			old_points = NULL;
@@ -1107,7 +1728,7 @@ ev_pixbuf_cache_get_selection_surface (EvPixbufCache   *pixbuf_cache,
 		job_info->selection_points = job_info->target_points;
 		job_info->selection_scale = scale * job_info->device_scale;
 		g_object_unref (rc);
-		ev_document_doc_mutex_unlock ();
+		ev_document_unlock (pixbuf_cache->document);
 	}
 	return job_info->selection;
 }
@@ -1150,7 +1771,7 @@ ev_pixbuf_cache_get_selection_region (EvPixbufCache *pixbuf_cache,
 		EvPage *ev_page;
 		gint width, height;
 
-		ev_document_doc_mutex_lock ();
+		ev_document_lock (pixbuf_cache->document);
 		ev_page = ev_document_get_page (pixbuf_cache->document, page);
 
 		_get_page_size_for_scale_and_rotation (pixbuf_cache->document,
@@ -1170,7 +1791,7 @@ ev_pixbuf_cache_get_selection_region (EvPixbufCache *pixbuf_cache,
 		job_info->selection_region_points = job_info->target_points;
 		job_info->selection_region_scale = scale;
 		g_object_unref (rc);
-		ev_document_doc_mutex_unlock ();
+		ev_document_unlock (pixbuf_cache->document);
 	}
 	return job_info->selection_region && !cairo_region_is_empty(job_info->selection_region) ?
                 job_info->selection_region : NULL;
@@ -1372,6 +1993,23 @@ ev_pixbuf_cache_reload_page (EvPixbufCache  *pixbuf_cache,
 	if (job_info == NULL)
 		return;
 
+	if (ev_pixbuf_cache_page_needs_tiles (pixbuf_cache, page, scale, rotation)) {
+		GList *l;
+
+		/* Render again the tiles we have, they are replaced
+		 * when the new ones are ready */
+		for (l = pixbuf_cache->tiles_lru.head; l; l = g_list_next (l)) {
+			TileInfo *tile = l->data;
+
+			if (tile->key.page == page &&
+			    tile->key.rotation == rotation &&
+			    tile->key.scale == scale &&
+			    tile->surface)
+				tile_add_job (pixbuf_cache, tile, EV_JOB_PRIORITY_URGENT);
+		}
+		return;
+	}
+
 	_get_page_size_for_scale_and_rotation (pixbuf_cache->document,
 					       page, scale, rotation,
 					       &width, &height);
@@ -1381,3 +2019,64 @@ ev_pixbuf_cache_reload_page (EvPixbufCache  *pixbuf_cache,
 }
 
 
+
+static void
+reuse_job_info_surface (EvPixbufCache *pixbuf_cache,
+			EvPixbufCache *old_cache,
+			CacheJobInfo  *job_info,
+			gint           old_page)
+{
+	ReusedSurface *reused;
+	gchar         *fingerprint;
+	gint           page;
+
+	if (!job_info->surface || !job_info->page_ready)
+		return;
+
+	fingerprint = ev_document_lookup_page_fingerprint (old_cache->document, old_page);
+	if (!fingerprint)
+		return;
+
+	page = ev_document_find_page_by_fingerprint (pixbuf_cache->document, fingerprint);
+	g_free (fingerprint);
+	if (page < 0 || g_hash_table_contains (pixbuf_cache->reused_surfaces, GINT_TO_POINTER (page)))
+		return;
+
+	reused = g_slice_new (ReusedSurface);
+	reused->surface = cairo_surface_reference (job_info->surface);
+	reused->device_scale = job_info->device_scale;
+	g_hash_table_insert (pixbuf_cache->reused_surfaces, GINT_TO_POINTER (page), reused);
+}
+
+/* Keeps the surfaces @old_cache has for pages whose fingerprint is the same
+ * as that of some page of the document of @pixbuf_cache, so that they are
+ * not rendered again when the document is reloaded. They are used the next
+ * time the page range is set, if the scale and rotation didn't change.
+ */
+void
+ev_pixbuf_cache_reuse_surfaces (EvPixbufCache *pixbuf_cache,
+				EvPixbufCache *old_cache)
+{
+	gint i;
+
+	g_return_if_fail (EV_IS_PIXBUF_CACHE (pixbuf_cache));
+	g_return_if_fail (EV_IS_PIXBUF_CACHE (old_cache));
+
+	if (!old_cache->job_list)
+		return;
+
+	for (i = 0; i < PAGE_CACHE_LEN (old_cache); i++) {
+		reuse_job_info_surface (pixbuf_cache, old_cache,
+					old_cache->job_list + i,
+					old_cache->start_page + i);
+	}
+
+	for (i = 0; i < old_cache->preload_cache_size; i++) {
+		reuse_job_info_surface (pixbuf_cache, old_cache,
+					old_cache->prev_job + i,
+					old_cache->start_page - old_cache->preload_cache_size + i);
+		reuse_job_info_surface (pixbuf_cache, old_cache,
+					old_cache->next_job + i,
+					old_cache->end_page + 1 + i);
+	}
+}
@@ -39,6 +39,9 @@ G_BEGIN_DECLS
 #define EV_PIXBUF_CACHE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), EV_TYPE_PIXBUF_CACHE, EvPixbufCache))
 #define EV_IS_PIXBUF_CACHE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EV_TYPE_PIXBUF_CACHE))
 
+/* Size in logical pixels of the tiles of pages rendered in tiles */
+#define EV_PIXBUF_CACHE_TILE_SIZE 256
+
 
 
 /* The coordinates in the rect here are at scale == 1.0, so that we can ignore
@@ -77,6 +80,27 @@ void           ev_pixbuf_cache_reload_page 	    (EvPixbufCache  *pixbuf_cache,
 						     gdouble         scale);
 void           ev_pixbuf_cache_set_inverted_colors  (EvPixbufCache *pixbuf_cache,
 						     gboolean       inverted_colors);
+void           ev_pixbuf_cache_reuse_surfaces       (EvPixbufCache *pixbuf_cache,
+						     EvPixbufCache *old_cache);
+/* Tiles */
+gboolean       ev_pixbuf_cache_page_uses_tiles      (EvPixbufCache *pixbuf_cache,
+						     gint           page);
+cairo_surface_t *ev_pixbuf_cache_get_tile_surface   (EvPixbufCache *pixbuf_cache,
+						     gint           page,
+						     gint           tile_x,
+						     gint           tile_y);
+void           ev_pixbuf_cache_set_visible_tiles    (EvPixbufCache *pixbuf_cache,
+						     gint           page,
+						     gint           first_x,
+						     gint           first_y,
+						     gint           last_x,
+						     gint           last_y);
+void           ev_pixbuf_cache_preload_tiles        (EvPixbufCache *pixbuf_cache,
+						     gint           page,
+						     gint           first_x,
+						     gint           first_y,
+						     gint           last_x,
+						     gint           last_y);
 /* Selection */
 cairo_surface_t *ev_pixbuf_cache_get_selection_surface (EvPixbufCache   *pixbuf_cache,
 							gint             page,
@@ -379,6 +379,9 @@ ev_print_operation_update_status (EvPrintOperation *op,
 #define EV_PRINT_OPERATION_EXPORT_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST((klass), EV_TYPE_PRINT_OPERATION_EXPORT, EvPrintOperationExportClass))
 #define EV_IS_PRINT_OPERATION_EXPORT(object)   (G_TYPE_CHECK_INSTANCE_TYPE((object), EV_TYPE_PRINT_OPERATION_EXPORT))
 
+#define EXPORT_MAX_RENDER_AHEAD 16
+#define EXPORT_MAX_WORKER_COPIES 3
+
 typedef struct _EvPrintOperationExport      EvPrintOperationExport;
 typedef struct _EvPrintOperationExportClass EvPrintOperationExportClass;
 
@@ -387,6 +390,8 @@ static GType    ev_print_operation_export_get_type (void) G_GNUC_CONST;
 static void     ev_print_operation_export_begin    (EvPrintOperationExport *export);
 static gboolean export_print_page                  (EvPrintOperationExport *export);
 static void     export_cancel                      (EvPrintOperationExport *export);
+static void     export_push_job                    (EvPrintOperationExport *export);
+static void     export_clear_worker_copies         (EvPrintOperationExport *export);
 
 struct _EvPrintOperationExport {
 	EvPrintOperation parent;
@@ -426,6 +431,17 @@ struct _EvPrintOperationExport {
 	GtkPageRange one_range;
 
 	gint page, start, end, inc;
+
+	/* EvJobExportRender jobs of the next pages, by page */
+	GHashTable *rendered_pages;
+	gint n_render_ahead;
+	gint waiting_page;
+
+	/* EvJobLoadWorkerCopy jobs, whose documents render the pages
+	 * ahead when the document is not thread-safe */
+	GPtrArray *worker_copies;
+	guint n_worker_copies;
+	guint next_worker_copy;
 };
 
 struct _EvPrintOperationExportClass {
@@ -735,7 +751,7 @@ export_print_inc_page (EvPrintOperationExport *export)
 				    (export->page_count - 1) % export->pages_per_sheet != 0) {
 
 					EvPrintOperation *op = EV_PRINT_OPERATION (export);
-					ev_document_doc_mutex_lock ();
+					ev_document_lock (op->document);
 
 					/* keep track of all blanks but only actualise those
 					 * which are in the current odd / even sheet set */
@@ -746,7 +762,7 @@ export_print_inc_page (EvPrintOperationExport *export)
 						(export->page_set == GTK_PAGE_SET_ODD && export->sheet % 2 == 1) ) {
 						ev_file_exporter_end_page (EV_FILE_EXPORTER (op->document));
 					}
-					ev_document_doc_mutex_unlock ();
+					ev_document_unlock (op->document);
 					export->sheet = 1 + (export->page_count - 1) / export->pages_per_sheet;
 				}
 
@@ -827,6 +843,8 @@ export_print_done (EvPrintOperationExport *export)
 	GError *error = NULL;
 
 	g_assert (export->temp_file != NULL);
+
+	export_clear_worker_copies (export);
 	
 	/* Some printers take into account some print settings,
 	 * and others don't. However we have exported the document
@@ -968,9 +986,9 @@ export_job_finished (EvJobExport            *job,
 	   ( export->page_set == GTK_PAGE_SET_EVEN && export->sheet % 2 == 0 ) ||
 	   ( export->page_set == GTK_PAGE_SET_ODD && export->sheet % 2 == 1 ) ) ) ) {
 
-		ev_document_doc_mutex_lock ();
+		ev_document_lock (op->document);
 		ev_file_exporter_end_page (EV_FILE_EXPORTER (op->document));
-		ev_document_doc_mutex_unlock ();
+		ev_document_unlock (op->document);
 	}
 
 	/* Reschedule */
@@ -987,6 +1005,205 @@ export_job_cancelled (EvJobExport            *job,
 	export_cancel (export);
 }
 
+static void
+export_render_job_finished (EvJobExportRender      *job,
+			    EvPrintOperationExport *export)
+{
+	if (job->page != export->waiting_page)
+		return;
+
+	export->waiting_page = -1;
+	export_push_job (export);
+}
+
+static void
+export_render_job_free (EvJob *job)
+{
+	g_signal_handlers_disconnect_matched (job, G_SIGNAL_MATCH_FUNC,
+					      0, 0, NULL,
+					      export_render_job_finished,
+					      NULL);
+	if (!ev_job_is_finished (job))
+		ev_job_cancel (job);
+	g_object_unref (job);
+}
+
+static void
+export_clear_rendered_pages (EvPrintOperationExport *export)
+{
+	export->waiting_page = -1;
+	if (export->rendered_pages)
+		g_hash_table_remove_all (export->rendered_pages);
+}
+
+static void
+export_worker_copy_job_finished (EvJob                  *job,
+				 EvPrintOperationExport *export)
+{
+	if (ev_job_is_failed (job))
+		return;
+
+	/* The next pages are rendered ahead from now on */
+	export->n_worker_copies++;
+	export->n_render_ahead = CLAMP (2 * export->n_worker_copies,
+					2, EXPORT_MAX_RENDER_AHEAD);
+}
+
+static void
+export_worker_copy_job_free (EvJob *job)
+{
+	g_signal_handlers_disconnect_matched (job, G_SIGNAL_MATCH_FUNC,
+					      0, 0, NULL,
+					      export_worker_copy_job_finished,
+					      NULL);
+	if (!ev_job_is_finished (job))
+		ev_job_cancel (job);
+	g_object_unref (job);
+}
+
+static void
+export_clear_worker_copies (EvPrintOperationExport *export)
+{
+	/* The pages rendered ahead keep their copy while they run */
+	if (export->worker_copies) {
+		g_ptr_array_free (export->worker_copies, TRUE);
+		export->worker_copies = NULL;
+		export->n_worker_copies = 0;
+		export->n_render_ahead = 0;
+	}
+}
+
+/* Returns the document to render the next page ahead with: the
+ * document itself when it is thread-safe, or else one of the worker
+ * copies loaded so far, in turn. */
+static EvDocument *
+export_get_render_document (EvPrintOperationExport *export)
+{
+	EvPrintOperation *op = EV_PRINT_OPERATION (export);
+	guint             i;
+
+	if (!export->worker_copies)
+		return op->document;
+
+	for (i = 0; i < export->worker_copies->len; i++) {
+		EvJob *job;
+
+		job = g_ptr_array_index (export->worker_copies,
+					 export->next_worker_copy++ % export->worker_copies->len);
+		if (ev_job_is_finished (job) && !ev_job_is_failed (job))
+			return job->document;
+	}
+
+	return NULL;
+}
+
+/* Renders the pages following the current one in parallel, so that
+ * they are ready when their turn to be exported comes. At most
+ * n_render_ahead pages are rendered and not exported yet, the pages
+ * left behind are dropped.
+ */
+static void
+export_render_ahead (EvPrintOperationExport *export)
+{
+	GHashTableIter    iter;
+	gpointer          key;
+	gint              pages[EXPORT_MAX_RENDER_AHEAD];
+	gint              n_pages = 0;
+	gint              range, page, end, i;
+
+	if (!export->rendered_pages)
+		return;
+
+	range = export->range;
+	page = export->page;
+	end = export->end;
+	while (n_pages < export->n_render_ahead) {
+		if (page == end) {
+			range += export->inc;
+			if (range < 0 || range >= export->n_ranges)
+				break;
+
+			if (export->inc < 0) {
+				page = export->ranges[range].end;
+				end = export->ranges[range].start - 1;
+			} else {
+				page = export->ranges[range].start;
+				end = export->ranges[range].end + 1;
+			}
+			continue;
+		}
+
+		pages[n_pages++] = page;
+		page += export->inc;
+	}
+
+	g_hash_table_iter_init (&iter, export->rendered_pages);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		for (i = 0; i < n_pages; i++) {
+			if (pages[i] == GPOINTER_TO_INT (key))
+				break;
+		}
+		if (i == n_pages)
+			g_hash_table_iter_remove (&iter);
+	}
+
+	for (i = 0; i < n_pages; i++) {
+		EvDocument *document;
+		EvJob      *job;
+
+		if (g_hash_table_contains (export->rendered_pages, GINT_TO_POINTER (pages[i])))
+			continue;
+
+		document = export_get_render_document (export);
+		if (!document)
+			break;
+
+		job = ev_job_export_render_new (document, pages[i]);
+		g_signal_connect (job, "finished",
+				  G_CALLBACK (export_render_job_finished),
+				  export);
+		g_hash_table_insert (export->rendered_pages, GINT_TO_POINTER (pages[i]), job);
+		ev_job_scheduler_push_job (job, EV_JOB_PRIORITY_NONE);
+	}
+}
+
+static void
+export_push_job (EvPrintOperationExport *export)
+{
+	EvPrintOperation *op = EV_PRINT_OPERATION (export);
+	EvJob            *render_job = NULL;
+
+	if (!export->job_export) {
+		export->job_export = ev_job_export_new (op->document);
+		g_signal_connect (export->job_export, "finished",
+				  G_CALLBACK (export_job_finished),
+				  (gpointer)export);
+		g_signal_connect (export->job_export, "cancelled",
+				  G_CALLBACK (export_job_cancelled),
+				  (gpointer)export);
+	}
+
+	export_render_ahead (export);
+
+	if (export->rendered_pages) {
+		render_job = g_hash_table_lookup (export->rendered_pages,
+						  GINT_TO_POINTER (export->page));
+	}
+
+	if (render_job && !ev_job_is_finished (render_job)) {
+		/* Wait for it rather than rendering the page twice */
+		export->waiting_page = export->page;
+		return;
+	}
+
+	ev_job_export_set_page (EV_JOB_EXPORT (export->job_export), export->page);
+	ev_job_export_set_rendered_page (EV_JOB_EXPORT (export->job_export),
+					 render_job ? EV_JOB_EXPORT_RENDER (render_job)->surface : NULL);
+	/* Before the pages rendered ahead, which wait for it to be exported */
+	ev_job_scheduler_push_job (export->job_export,
+				   export->rendered_pages ? EV_JOB_PRIORITY_LOW : EV_JOB_PRIORITY_NONE);
+}
+
 static void
 export_cancel (EvPrintOperationExport *export)
 {
@@ -1007,6 +1224,9 @@ export_cancel (EvPrintOperationExport *export)
 		export->job_export = NULL;
 	}
 	
+	export_clear_rendered_pages (export);
+	export_clear_worker_copies (export);
+
 	if (export->fd != -1) {
 		close (export->fd);
 		export->fd = -1;
@@ -1049,13 +1269,14 @@ export_print_page (EvPrintOperationExport *export)
 	if (export->collated == export->collated_copies) {
 		export->collated = 0;
 		if (!export_print_inc_page (export)) {
-			ev_document_doc_mutex_lock ();
+			ev_document_lock (op->document);
 			ev_file_exporter_end (EV_FILE_EXPORTER (op->document));
-			ev_document_doc_mutex_unlock ();
+			ev_document_unlock (op->document);
 
 			close (export->fd);
 			export->fd = -1;
 			update_progress (export);
+			export_clear_rendered_pages (export);
 			export_print_done (export);
 
 			return FALSE;
@@ -1076,14 +1297,15 @@ export_print_page (EvPrintOperationExport *export)
 				export->collated = 0;
 
 				if (!export_print_inc_page (export)) {
-					ev_document_doc_mutex_lock ();
+					ev_document_lock (op->document);
 					ev_file_exporter_end (EV_FILE_EXPORTER (op->document));
-					ev_document_doc_mutex_unlock ();
+					ev_document_unlock (op->document);
 
 					close (export->fd);
 					export->fd = -1;
 
 					update_progress (export);
+					export_clear_rendered_pages (export);
 
 					export_print_done (export);
 					return FALSE;
@@ -1100,23 +1322,12 @@ export_print_page (EvPrintOperationExport *export)
 	    (export->page_set == GTK_PAGE_SET_ALL ||
 	    (export->page_set == GTK_PAGE_SET_EVEN && export->sheet % 2 == 0) ||
 	    (export->page_set == GTK_PAGE_SET_ODD && export->sheet % 2 == 1)))) {
-		ev_document_doc_mutex_lock ();
+		ev_document_lock (op->document);
 		ev_file_exporter_begin_page (EV_FILE_EXPORTER (op->document));
-		ev_document_doc_mutex_unlock ();
+		ev_document_unlock (op->document);
 	}
 
-	if (!export->job_export) {
-		export->job_export = ev_job_export_new (op->document);
-		g_signal_connect (export->job_export, "finished",
-				  G_CALLBACK (export_job_finished),
-				  (gpointer)export);
-		g_signal_connect (export->job_export, "cancelled",
-				  G_CALLBACK (export_job_cancelled),
-				  (gpointer)export);
-	}
-
-	ev_job_export_set_page (EV_JOB_EXPORT (export->job_export), export->page);
-	ev_job_scheduler_push_job (export->job_export, EV_JOB_PRIORITY_NONE);
+	export_push_job (export);
 
 	update_progress (export);
 	
@@ -1131,9 +1342,39 @@ ev_print_operation_export_begin (EvPrintOperationExport *export)
 	if (!export->temp_file)
 		return; /* cancelled */
 	
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (op->document);
 	ev_file_exporter_begin (EV_FILE_EXPORTER (op->document), &export->fc);
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (op->document);
+
+	/* Pages are rendered ahead only when it can be done while
+	 * the previous ones are exported: by the document itself when
+	 * it is thread-safe, or by copies of it, which start rendering
+	 * as soon as they are loaded. */
+	if (!ev_file_exporter_can_render_pages (EV_FILE_EXPORTER (op->document))) {
+		/* Pages are exported one by one */
+	} else if (ev_document_is_thread_safe (op->document)) {
+		export->rendered_pages = g_hash_table_new_full (NULL, NULL, NULL,
+								(GDestroyNotify)export_render_job_free);
+		export->n_render_ahead = CLAMP (2 * ev_job_scheduler_get_n_threads (),
+						2, EXPORT_MAX_RENDER_AHEAD);
+	} else if (ev_document_supports_worker_copies (op->document) &&
+		   ev_job_scheduler_get_n_threads () > 1) {
+		guint n_copies, i;
+
+		n_copies = MIN (ev_job_scheduler_get_n_threads () - 1, EXPORT_MAX_WORKER_COPIES);
+		export->rendered_pages = g_hash_table_new_full (NULL, NULL, NULL,
+								(GDestroyNotify)export_render_job_free);
+		export->worker_copies = g_ptr_array_new_with_free_func ((GDestroyNotify)export_worker_copy_job_free);
+		for (i = 0; i < n_copies; i++) {
+			EvJob *job = ev_job_load_worker_copy_new (op->document);
+
+			g_signal_connect (job, "finished",
+					  G_CALLBACK (export_worker_copy_job_finished),
+					  export);
+			g_ptr_array_add (export->worker_copies, job);
+			ev_job_scheduler_push_job (job, EV_JOB_PRIORITY_NONE);
+		}
+	}
 
 	export->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
 					   (GSourceFunc)export_print_page,
@@ -1455,6 +1696,13 @@ ev_print_operation_export_finalize (GObject *object)
 		export->job_name = NULL;
 	}
 
+	if (export->rendered_pages) {
+		g_hash_table_destroy (export->rendered_pages);
+		export->rendered_pages = NULL;
+	}
+
+	export_clear_worker_copies (export);
+
 	if (export->job_export) {
 		if (!ev_job_is_finished (export->job_export))
 			ev_job_cancel (export->job_export);
@@ -1496,6 +1744,7 @@ ev_print_operation_export_init (EvPrintOperationExport *export)
 {
 	/* sheets are counted from 1 to be physical */
 	export->sheet = 1;
+	export->waiting_page = -1;
 }
 
 static GObject *
@@ -1758,7 +2007,7 @@ print_job_finished (EvJobPrint            *job,
 static gboolean
 draw_page_finish_idle (EvPrintOperationPrint *print)
 {
-        if (ev_job_scheduler_get_running_thread_job () == print->job_print)
+        if (ev_job_scheduler_is_job_running (print->job_print))
                 return TRUE;
 
         gtk_print_operation_draw_page_finish (print->op);
@@ -1775,7 +2024,7 @@ print_job_cancelled (EvJobPrint            *job,
          * print operation. If the job is still
          * running, wait until it finishes.
          */
-        if (ev_job_scheduler_get_running_thread_job () == print->job_print)
+        if (ev_job_scheduler_is_job_running (print->job_print))
                 g_idle_add ((GSourceFunc)draw_page_finish_idle, print);
         else
                 gtk_print_operation_draw_page_finish (print->op);
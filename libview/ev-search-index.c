@@ -0,0 +1,616 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "ev-search-index.h"
+
+/* The search index keeps an inverted index from the trigrams of the
+ * folded text of every page to the pages containing them. It doesn't
+ * find the matches itself, it only tells the pages that can't contain
+ * the text searched, the other ones are still searched by the backend.
+ *
+ * The text is folded so that the text the backend matches is folded to
+ * the same characters whatever the find options: the case, diacritics
+ * and compatibility forms like ligatures are folded, white space,
+ * punctuation and line breaks are dropped. A page whose folded text
+ * doesn't contain all the trigrams of the folded query can't match.
+ *
+ * The cache file is written in host byte order:
+ *
+ *   IndexHeader
+ *   IndexTrigramEntry   n_trigrams, sorted by key
+ *   guint32             n_postings, the pages of every trigram in order
+ */
+
+#define INDEX_MAGIC          "EvSIdx02"
+#define INDEX_BYTE_ORDER     0x01020304
+#define INDEX_CHECKSUM_SIZE  72
+#define INDEX_DATA_KEY       "ev-search-index"
+
+typedef struct {
+	gchar   magic[8];
+	guint32 byte_order;
+	guint32 n_pages;
+	gint64  mtime;
+	gchar   checksum[INDEX_CHECKSUM_SIZE];
+	guint32 n_trigrams;
+	guint32 n_postings;
+	guint64 trigrams_offset;
+	guint64 postings_offset;
+} IndexHeader;
+
+typedef struct {
+	guint32 key;
+	guint32 first;
+	guint32 n_pages;
+} IndexTrigramEntry;
+
+struct _EvSearchIndex {
+	volatile gint ref_count;
+
+	guint      n_pages;
+	gsize      size;
+
+	/* Index being built, protected by mutex */
+	GMutex      mutex;
+	gboolean   *indexed;
+	guint       n_indexed;
+	GHashTable *trigrams;
+
+	/* Index loaded from a cache file */
+	GMappedFile             *file;
+	const IndexTrigramEntry *trigram_table;
+	guint                    n_trigrams;
+	const guint32           *postings;
+};
+
+static inline guint32
+trigram_key (gunichar c1,
+	     gunichar c2,
+	     gunichar c3)
+{
+	return (c1 * 0x9e3779b1U) ^ (c2 * 0x85ebca77U) ^ (c3 * 0xc2b2ae3dU);
+}
+
+/* Returns the characters of text that can be part of a match, folded */
+static GArray *
+fold_text (const gchar *text)
+{
+	GArray      *chars;
+	const gchar *p;
+
+	chars = g_array_new (FALSE, FALSE, sizeof (gunichar));
+	for (p = text; *p; p = g_utf8_next_char (p)) {
+		gunichar decomposition[G_UNICHAR_MAX_DECOMPOSITION_LENGTH];
+		gsize    n_chars, i;
+
+		n_chars = g_unichar_fully_decompose (g_utf8_get_char (p), TRUE,
+						     decomposition,
+						     G_N_ELEMENTS (decomposition));
+		for (i = 0; i < n_chars; i++) {
+			gunichar c;
+
+			/* Combining marks are not alphanumeric either */
+			if (!g_unichar_isalnum (decomposition[i]))
+				continue;
+
+			c = g_unichar_tolower (decomposition[i]);
+			g_array_append_val (chars, c);
+		}
+	}
+
+	return chars;
+}
+
+EvSearchIndex *
+ev_search_index_new (guint n_pages)
+{
+	EvSearchIndex *index;
+
+	index = g_slice_new0 (EvSearchIndex);
+	index->ref_count = 1;
+	index->n_pages = n_pages;
+	index->indexed = g_new0 (gboolean, n_pages);
+	g_mutex_init (&index->mutex);
+	index->trigrams = g_hash_table_new_full (g_direct_hash,
+						 g_direct_equal,
+						 NULL,
+						 (GDestroyNotify)g_array_unref);
+
+	return index;
+}
+
+EvSearchIndex *
+ev_search_index_ref (EvSearchIndex *index)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+
+	g_atomic_int_inc (&index->ref_count);
+
+	return index;
+}
+
+void
+ev_search_index_unref (EvSearchIndex *index)
+{
+	g_return_if_fail (index != NULL);
+
+	if (!g_atomic_int_dec_and_test (&index->ref_count))
+		return;
+
+	if (index->file)
+		g_mapped_file_unref (index->file);
+
+	g_free (index->indexed);
+	if (index->trigrams)
+		g_hash_table_destroy (index->trigrams);
+	g_mutex_clear (&index->mutex);
+
+	g_slice_free (EvSearchIndex, index);
+}
+
+/* Appends page to the postings of key, keeping them sorted */
+static void
+ev_search_index_add_posting (EvSearchIndex *index,
+			     guint32        key,
+			     guint32        page)
+{
+	GArray *postings;
+	guint   i;
+
+	postings = g_hash_table_lookup (index->trigrams, GUINT_TO_POINTER (key));
+	if (!postings) {
+		postings = g_array_new (FALSE, FALSE, sizeof (guint32));
+		g_hash_table_insert (index->trigrams, GUINT_TO_POINTER (key), postings);
+		index->size += sizeof (IndexTrigramEntry);
+	}
+
+	i = postings->len;
+	while (i > 0 && g_array_index (postings, guint32, i - 1) > page)
+		i--;
+	g_array_insert_val (postings, i, page);
+	index->size += sizeof (guint32);
+}
+
+/**
+ * ev_search_index_add_page:
+ * @index: an #EvSearchIndex being built
+ * @page: the page index
+ * @text: the text of the page
+ *
+ * Adds the text of @page to @index. This can be called from any thread,
+ * the page can be looked up in @index as soon as it returns.
+ */
+void
+ev_search_index_add_page (EvSearchIndex *index,
+			  guint          page,
+			  const gchar   *text)
+{
+	GHashTable    *keys;
+	GHashTableIter iter;
+	gpointer       key;
+	GArray        *chars;
+	guint          i;
+
+	g_return_if_fail (index != NULL);
+	g_return_if_fail (index->file == NULL);
+	g_return_if_fail (page < index->n_pages);
+
+	/* Collect the trigrams of the page before taking the lock */
+	keys = g_hash_table_new (g_direct_hash, g_direct_equal);
+	chars = fold_text (text ? text : "");
+	for (i = 0; i + 2 < chars->len; i++) {
+		g_hash_table_add (keys, GUINT_TO_POINTER (trigram_key (g_array_index (chars, gunichar, i),
+								       g_array_index (chars, gunichar, i + 1),
+								       g_array_index (chars, gunichar, i + 2))));
+	}
+	g_array_unref (chars);
+
+	g_mutex_lock (&index->mutex);
+
+	if (!index->indexed[page]) {
+		g_hash_table_iter_init (&iter, keys);
+		while (g_hash_table_iter_next (&iter, &key, NULL))
+			ev_search_index_add_posting (index, GPOINTER_TO_UINT (key), page);
+
+		index->indexed[page] = TRUE;
+		index->n_indexed++;
+	}
+
+	g_mutex_unlock (&index->mutex);
+
+	g_hash_table_destroy (keys);
+}
+
+guint
+ev_search_index_get_n_pages (EvSearchIndex *index)
+{
+	g_return_val_if_fail (index != NULL, 0);
+
+	return index->n_pages;
+}
+
+gboolean
+ev_search_index_is_complete (EvSearchIndex *index)
+{
+	gboolean retval;
+
+	g_return_val_if_fail (index != NULL, FALSE);
+
+	if (index->file)
+		return TRUE;
+
+	g_mutex_lock (&index->mutex);
+	retval = index->n_indexed == index->n_pages;
+	g_mutex_unlock (&index->mutex);
+
+	return retval;
+}
+
+/**
+ * ev_search_index_get_size:
+ * @index: an #EvSearchIndex
+ *
+ * Returns: the size in bytes of the cache file of @index
+ */
+gsize
+ev_search_index_get_size (EvSearchIndex *index)
+{
+	gsize retval;
+
+	g_return_val_if_fail (index != NULL, 0);
+
+	if (index->file)
+		return g_mapped_file_get_length (index->file);
+
+	g_mutex_lock (&index->mutex);
+	retval = sizeof (IndexHeader) + index->size;
+	g_mutex_unlock (&index->mutex);
+
+	return retval;
+}
+
+static int
+cmp_trigram_entry (const void *a,
+		   const void *b)
+{
+	guint32 key_a = ((const IndexTrigramEntry *)a)->key;
+	guint32 key_b = ((const IndexTrigramEntry *)b)->key;
+
+	return key_a < key_b ? -1 : key_a > key_b;
+}
+
+static int
+cmp_page (const void *a,
+	  const void *b)
+{
+	guint32 page_a = *(const guint32 *)a;
+	guint32 page_b = *(const guint32 *)b;
+
+	return page_a < page_b ? -1 : page_a > page_b;
+}
+
+/* Must be called with the mutex held while the index is being built */
+static gboolean
+ev_search_index_has_trigram (EvSearchIndex *index,
+			     guint32        key,
+			     guint32        page)
+{
+	const guint32 *postings;
+	guint          n_postings;
+
+	if (index->file) {
+		IndexTrigramEntry        entry;
+		const IndexTrigramEntry *found;
+
+		entry.key = key;
+		found = bsearch (&entry, index->trigram_table, index->n_trigrams,
+				 sizeof (IndexTrigramEntry), cmp_trigram_entry);
+		if (!found)
+			return FALSE;
+
+		postings = index->postings + found->first;
+		n_postings = found->n_pages;
+	} else {
+		GArray *array;
+
+		array = g_hash_table_lookup (index->trigrams, GUINT_TO_POINTER (key));
+		if (!array)
+			return FALSE;
+
+		postings = (const guint32 *)array->data;
+		n_postings = array->len;
+	}
+
+	return bsearch (&page, postings, n_postings, sizeof (guint32), cmp_page) != NULL;
+}
+
+/**
+ * ev_search_index_page_may_contain:
+ * @index: an #EvSearchIndex
+ * @page: the page index
+ * @text: the text to find
+ *
+ * Tells whether ev_document_find_find_text_with_options() can find
+ * @text in @page with any #EvFindOptions. This can be called from any
+ * thread.
+ *
+ * Returns: %FALSE if @page is in @index and doesn't contain @text,
+ *     %TRUE if @page has to be searched
+ */
+gboolean
+ev_search_index_page_may_contain (EvSearchIndex *index,
+				  guint          page,
+				  const gchar   *text)
+{
+	GArray  *query;
+	guint    i;
+	gboolean retval = TRUE;
+
+	g_return_val_if_fail (index != NULL, TRUE);
+	g_return_val_if_fail (page < index->n_pages, TRUE);
+	g_return_val_if_fail (text != NULL, TRUE);
+
+	query = fold_text (text);
+
+	if (!index->file)
+		g_mutex_lock (&index->mutex);
+
+	if (index->file || index->indexed[page]) {
+		for (i = 0; retval && i + 2 < query->len; i++) {
+			retval = ev_search_index_has_trigram (index,
+							      trigram_key (g_array_index (query, gunichar, i),
+									   g_array_index (query, gunichar, i + 1),
+									   g_array_index (query, gunichar, i + 2)),
+							      page);
+		}
+	}
+
+	if (!index->file)
+		g_mutex_unlock (&index->mutex);
+
+	g_array_unref (query);
+
+	return retval;
+}
+
+/**
+ * ev_search_index_save:
+ * @index: a complete #EvSearchIndex
+ * @path: the cache file path
+ * @checksum: the checksum of the document contents
+ * @mtime: the modification time of the document
+ * @error: (allow-none): a #GError
+ *
+ * Writes @index to @path so that ev_search_index_load() can read it
+ * back while the document doesn't change.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+ev_search_index_save (EvSearchIndex *index,
+		      const gchar   *path,
+		      const gchar   *checksum,
+		      gint64         mtime,
+		      GError       **error)
+{
+	GByteArray        *data;
+	IndexHeader       *header;
+	IndexTrigramEntry *trigrams;
+	GHashTableIter     iter;
+	gpointer           key, value;
+	gchar             *dir;
+	guint              i, n_trigrams, n_postings;
+	gboolean           retval;
+
+	g_return_val_if_fail (index != NULL, FALSE);
+	g_return_val_if_fail (ev_search_index_is_complete (index), FALSE);
+	g_return_val_if_fail (index->file == NULL, FALSE);
+	g_return_val_if_fail (strlen (checksum) < INDEX_CHECKSUM_SIZE, FALSE);
+
+	n_trigrams = g_hash_table_size (index->trigrams);
+	trigrams = g_new (IndexTrigramEntry, n_trigrams);
+	i = 0;
+	g_hash_table_iter_init (&iter, index->trigrams);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		trigrams[i].key = GPOINTER_TO_UINT (key);
+		trigrams[i].n_pages = ((GArray *)value)->len;
+		i++;
+	}
+	qsort (trigrams, n_trigrams, sizeof (IndexTrigramEntry), cmp_trigram_entry);
+	n_postings = 0;
+	for (i = 0; i < n_trigrams; i++) {
+		trigrams[i].first = n_postings;
+		n_postings += trigrams[i].n_pages;
+	}
+
+	data = g_byte_array_sized_new (ev_search_index_get_size (index));
+	g_byte_array_set_size (data, sizeof (IndexHeader));
+	memset (data->data, 0, data->len);
+
+	header = (IndexHeader *)data->data;
+	memcpy (header->magic, INDEX_MAGIC, sizeof (header->magic));
+	header->byte_order = INDEX_BYTE_ORDER;
+	header->n_pages = index->n_pages;
+	header->mtime = mtime;
+	g_strlcpy (header->checksum, checksum, INDEX_CHECKSUM_SIZE);
+	header->n_trigrams = n_trigrams;
+	header->n_postings = n_postings;
+	header->trigrams_offset = sizeof (IndexHeader);
+	header->postings_offset = sizeof (IndexHeader) + n_trigrams * sizeof (IndexTrigramEntry);
+
+	g_byte_array_append (data, (const guint8 *)trigrams,
+			     n_trigrams * sizeof (IndexTrigramEntry));
+	for (i = 0; i < n_trigrams; i++) {
+		GArray *postings;
+
+		postings = g_hash_table_lookup (index->trigrams,
+						GUINT_TO_POINTER (trigrams[i].key));
+		g_byte_array_append (data, (const guint8 *)postings->data,
+				     postings->len * sizeof (guint32));
+	}
+	g_free (trigrams);
+
+	dir = g_path_get_dirname (path);
+	if (g_mkdir_with_parents (dir, 0700) == -1) {
+		int errsv = errno;
+
+		g_set_error (error, G_FILE_ERROR,
+			     g_file_error_from_errno (errsv),
+			     "Failed to create directory “%s”: %s",
+			     dir, g_strerror (errsv));
+		g_free (dir);
+		g_byte_array_unref (data);
+
+		return FALSE;
+	}
+	g_free (dir);
+
+	retval = g_file_set_contents (path, (const gchar *)data->data, data->len, error);
+	g_byte_array_unref (data);
+
+	return retval;
+}
+
+/**
+ * ev_search_index_load:
+ * @path: the cache file path
+ * @checksum: the checksum of the document contents
+ * @mtime: the modification time of the document
+ * @n_pages: the number of pages of the document
+ *
+ * Maps the index cache file at @path.
+ *
+ * Returns: the #EvSearchIndex, or %NULL if there isn't a valid cache
+ *     file for the document at @path
+ */
+EvSearchIndex *
+ev_search_index_load (const gchar *path,
+		      const gchar *checksum,
+		      gint64       mtime,
+		      guint        n_pages)
+{
+	EvSearchIndex           *index;
+	GMappedFile             *file;
+	const gchar             *data;
+	gsize                    size;
+	const IndexHeader       *header;
+	const IndexTrigramEntry *trigrams;
+	guint                    i;
+
+	file = g_mapped_file_new (path, FALSE, NULL);
+	if (!file)
+		return NULL;
+
+	data = g_mapped_file_get_contents (file);
+	size = g_mapped_file_get_length (file);
+	header = (const IndexHeader *)data;
+
+	if (size < sizeof (IndexHeader) ||
+	    memcmp (header->magic, INDEX_MAGIC, sizeof (header->magic)) != 0 ||
+	    header->byte_order != INDEX_BYTE_ORDER ||
+	    header->n_pages != n_pages ||
+	    header->mtime != mtime ||
+	    strncmp (header->checksum, checksum, INDEX_CHECKSUM_SIZE) != 0 ||
+	    header->trigrams_offset % 4 != 0 ||
+	    header->trigrams_offset > size ||
+	    (size - header->trigrams_offset) / sizeof (IndexTrigramEntry) < header->n_trigrams ||
+	    header->postings_offset % 4 != 0 ||
+	    header->postings_offset > size ||
+	    (size - header->postings_offset) / sizeof (guint32) < header->n_postings) {
+		g_mapped_file_unref (file);
+
+		return NULL;
+	}
+
+	trigrams = (const IndexTrigramEntry *)(data + header->trigrams_offset);
+	for (i = 0; i < header->n_trigrams; i++) {
+		if (trigrams[i].first > header->n_postings ||
+		    header->n_postings - trigrams[i].first < trigrams[i].n_pages) {
+			g_mapped_file_unref (file);
+
+			return NULL;
+		}
+	}
+
+	index = g_slice_new0 (EvSearchIndex);
+	index->ref_count = 1;
+	index->n_pages = n_pages;
+	index->n_indexed = n_pages;
+	g_mutex_init (&index->mutex);
+	index->file = file;
+	index->trigram_table = trigrams;
+	index->n_trigrams = header->n_trigrams;
+	index->postings = (const guint32 *)(data + header->postings_offset);
+	index->size = size;
+
+	return index;
+}
+
+/**
+ * ev_search_index_get_cache_path:
+ * @checksum: the checksum of the document contents
+ *
+ * Returns: the path of the index cache file of a document
+ */
+gchar *
+ev_search_index_get_cache_path (const gchar *checksum)
+{
+	return g_build_filename (g_get_user_cache_dir (), "evince",
+				 "search-index", checksum, NULL);
+}
+
+static gpointer
+search_index_dup (gpointer index,
+		  gpointer user_data)
+{
+	return index ? ev_search_index_ref (index) : NULL;
+}
+
+/**
+ * ev_search_index_get_for_document:
+ * @document: an #EvDocument
+ *
+ * Returns: (transfer full): the #EvSearchIndex of @document, or %NULL
+ */
+EvSearchIndex *
+ev_search_index_get_for_document (EvDocument *document)
+{
+	g_return_val_if_fail (EV_IS_DOCUMENT (document), NULL);
+
+	return g_object_dup_data (G_OBJECT (document), INDEX_DATA_KEY,
+				  search_index_dup, NULL);
+}
+
+void
+ev_search_index_set_for_document (EvDocument    *document,
+				  EvSearchIndex *index)
+{
+	g_return_if_fail (EV_IS_DOCUMENT (document));
+
+	g_object_set_data_full (G_OBJECT (document), INDEX_DATA_KEY,
+				index ? ev_search_index_ref (index) : NULL,
+				(GDestroyNotify)ev_search_index_unref);
+}
@@ -0,0 +1,63 @@
+/* this file is part of evince, a gnome document viewer
+ *
+ *  Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#if !defined (__EV_EVINCE_VIEW_H_INSIDE__) && !defined (EVINCE_COMPILATION)
+#error "Only <evince-view.h> can be included directly."
+#endif
+
+#ifndef EV_SEARCH_INDEX_H
+#define EV_SEARCH_INDEX_H
+
+#include <glib.h>
+#include <evince-document.h>
+
+G_BEGIN_DECLS
+
+typedef struct _EvSearchIndex EvSearchIndex;
+
+EvSearchIndex *ev_search_index_new              (guint              n_pages);
+EvSearchIndex *ev_search_index_load             (const gchar       *path,
+						 const gchar       *checksum,
+						 gint64             mtime,
+						 guint              n_pages);
+gboolean       ev_search_index_save             (EvSearchIndex     *index,
+						 const gchar       *path,
+						 const gchar       *checksum,
+						 gint64             mtime,
+						 GError           **error);
+EvSearchIndex *ev_search_index_ref              (EvSearchIndex     *index);
+void           ev_search_index_unref            (EvSearchIndex     *index);
+void           ev_search_index_add_page         (EvSearchIndex     *index,
+						 guint              page,
+						 const gchar       *text);
+guint          ev_search_index_get_n_pages      (EvSearchIndex     *index);
+gboolean       ev_search_index_is_complete      (EvSearchIndex     *index);
+gsize          ev_search_index_get_size         (EvSearchIndex     *index);
+gboolean       ev_search_index_page_may_contain (EvSearchIndex     *index,
+						 guint              page,
+						 const gchar       *text);
+
+gchar         *ev_search_index_get_cache_path   (const gchar       *checksum);
+EvSearchIndex *ev_search_index_get_for_document (EvDocument        *document);
+void           ev_search_index_set_for_document (EvDocument        *document,
+						 EvSearchIndex     *index);
+
+G_END_DECLS
+
+#endif /* EV_SEARCH_INDEX_H */
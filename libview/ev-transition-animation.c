@@ -19,6 +19,9 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include "config.h"
+
+#include <math.h>
 #include <cairo.h>
 #include <gdk/gdk.h>
 #include "ev-transition-animation.h"
@@ -26,6 +29,7 @@
 
 #define EV_TRANSITION_ANIMATION_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), EV_TYPE_TRANSITION_ANIMATION, EvTransitionAnimationPriv))
 #define N_BLINDS 6
+#define MIN_STEPS 8
 
 typedef struct EvTransitionAnimationPriv EvTransitionAnimationPriv;
 
@@ -33,6 +37,19 @@ struct EvTransitionAnimationPriv {
 	EvTransitionEffect *effect;
 	cairo_surface_t *origin_surface;
 	cairo_surface_t *dest_surface;
+
+	/* Number of distinct frames painted, lowered when painting a
+	 * frame takes longer than the frame interval */
+	guint n_steps;
+	gdouble painted_progress;
+
+	/* Intermediates of the last painted step */
+	GdkRectangle mask_area;
+	gdouble mask_progress;
+	cairo_region_t *dest_region;
+	cairo_region_t *origin_region;
+	gdouble blend_progress;
+	cairo_surface_t *blend_surface;
 };
 
 enum {
@@ -49,6 +66,26 @@ G_DEFINE_TYPE (EvTransitionAnimation, ev_transition_animation, EV_TYPE_TIMELINE)
 static void
 ev_transition_animation_init (EvTransitionAnimation *animation)
 {
+	EvTransitionAnimationPriv *priv;
+
+	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
+	priv->painted_progress = -1.;
+	priv->mask_progress = -1.;
+	priv->blend_progress = -1.;
+}
+
+static void
+ev_transition_animation_clear_intermediates (EvTransitionAnimation *animation)
+{
+	EvTransitionAnimationPriv *priv;
+
+	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
+
+	g_clear_pointer (&priv->dest_region, cairo_region_destroy);
+	g_clear_pointer (&priv->origin_region, cairo_region_destroy);
+	g_clear_pointer (&priv->blend_surface, cairo_surface_destroy);
+	priv->mask_progress = -1.;
+	priv->blend_progress = -1.;
 }
 
 static void
@@ -122,6 +159,8 @@ ev_transition_animation_finalize (GObject *object)
 	if (priv->dest_surface)
 		cairo_surface_destroy (priv->dest_surface);
 
+	ev_transition_animation_clear_intermediates (EV_TRANSITION_ANIMATION (object));
+
 	G_OBJECT_CLASS (ev_transition_animation_parent_class)->finalize (object);
 }
 
@@ -196,7 +235,8 @@ paint_surface (cairo_t         *cr,
 
 	gdk_cairo_rectangle (cr, &page_area);
 	cairo_clip (cr);
-	cairo_surface_set_device_offset (surface, x_offset, y_offset);
+	/* Whole pixels, so that the surface is copied and not resampled */
+	cairo_surface_set_device_offset (surface, round (x_offset), round (y_offset));
 	cairo_set_source_surface (cr, surface, 0, 0);
 
 	if (alpha == 1.)
@@ -207,226 +247,257 @@ paint_surface (cairo_t         *cr,
 	cairo_restore (cr);
 }
 
-/* animations */
+/* Adds the rectangle rounded to whole pixels, so that the slides are
+ * composited without an antialiased clip */
 static void
-ev_transition_animation_split (cairo_t               *cr,
-			       EvTransitionAnimation *animation,
-			       EvTransitionEffect    *effect,
-			       gdouble                progress,
-			       GdkRectangle           page_area)
+region_add_rectangle (cairo_region_t *region,
+		      GdkRectangle    page_area,
+		      gdouble         x,
+		      gdouble         y,
+		      gdouble         width,
+		      gdouble         height)
+{
+	cairo_rectangle_int_t rect;
+
+	rect.x = page_area.x + (gint) (x + 0.5);
+	rect.y = page_area.y + (gint) (y + 0.5);
+	rect.width = page_area.x + (gint) (x + width + 0.5) - rect.x;
+	rect.height = page_area.y + (gint) (y + height + 0.5) - rect.y;
+
+	if (rect.width > 0 && rect.height > 0)
+		cairo_region_union_rectangle (region, &rect);
+}
+
+static void
+paint_region (cairo_t              *cr,
+	      cairo_surface_t      *surface,
+	      const cairo_region_t *region)
+{
+	if (cairo_region_is_empty (region))
+		return;
+
+	cairo_save (cr);
+
+	gdk_cairo_region (cr, region);
+	cairo_clip (cr);
+	cairo_surface_set_device_offset (surface, 0, 0);
+	cairo_set_source_surface (cr, surface, 0, 0);
+	cairo_paint (cr);
+
+	cairo_restore (cr);
+}
+
+/* Computes the parts of the page showing the destination and the origin
+ * slides, so that every pixel is painted once. They are kept until the
+ * progress or the page area change.
+ */
+static void
+ev_transition_animation_update_masks (EvTransitionAnimation  *animation,
+				      EvTransitionEffectType  type,
+				      gdouble                 progress,
+				      GdkRectangle            page_area)
 {
 	EvTransitionAnimationPriv *priv;
 	EvTransitionEffectAlignment alignment;
 	EvTransitionEffectDirection direction;
-	gint width, height;
+	cairo_rectangle_int_t area;
+	cairo_region_t *region;
+	gboolean inward = FALSE;
+	gdouble width, height;
+	gint angle, i;
 
 	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
+
+	if (priv->dest_region && priv->mask_progress == progress &&
+	    priv->mask_area.x == page_area.x && priv->mask_area.y == page_area.y &&
+	    priv->mask_area.width == page_area.width && priv->mask_area.height == page_area.height)
+		return;
+
 	width = page_area.width;
 	height = page_area.height;
 
-	g_object_get (effect,
+	g_object_get (priv->effect,
 		      "alignment", &alignment,
 		      "direction", &direction,
+		      "angle", &angle,
 		      NULL);
 
-	if (direction == EV_TRANSITION_DIRECTION_INWARD) {
-		paint_surface (cr, priv->dest_surface, 0, 0, 1., page_area);
+	region = cairo_region_create ();
 
-		if (alignment == EV_TRANSITION_ALIGNMENT_HORIZONTAL) {
-			cairo_rectangle (cr,
-					 0,
-					 height * progress / 2,
-					 width,
-					 height * (1 - progress));
-		} else {
-			cairo_rectangle (cr,
-					 width * progress / 2,
-					 0,
-					 width * (1 - progress),
-					 height);
-		}
+	switch (type) {
+	case EV_TRANSITION_EFFECT_SPLIT:
+	case EV_TRANSITION_EFFECT_BOX: {
+		gdouble w = width, h = height;
+		gdouble p;
 
-		cairo_clip (cr);
+		/* Inward the origin slide shrinks to the center,
+		 * outward the destination one grows from it */
+		inward = direction == EV_TRANSITION_DIRECTION_INWARD;
+		p = inward ? 1 - progress : progress;
 
-		paint_surface (cr, priv->origin_surface, 0, 0, 1., page_area);
-	} else {
-		paint_surface (cr, priv->origin_surface, 0, 0, 1., page_area);
+		if (type == EV_TRANSITION_EFFECT_BOX || alignment == EV_TRANSITION_ALIGNMENT_VERTICAL)
+			w = width * p;
+		if (type == EV_TRANSITION_EFFECT_BOX || alignment == EV_TRANSITION_ALIGNMENT_HORIZONTAL)
+			h = height * p;
 
-		if (alignment == EV_TRANSITION_ALIGNMENT_HORIZONTAL) {
-			cairo_rectangle (cr,
-					 0,
-					 (height / 2) - (height * progress / 2),
-					 width,
-					 height * progress);
-		} else {
-			cairo_rectangle (cr,
-					 (width / 2) - (width * progress / 2),
-					 0,
-					 width * progress,
-					 height);
+		region_add_rectangle (region, page_area, (width - w) / 2, (height - h) / 2, w, h);
+	}
+		break;
+	case EV_TRANSITION_EFFECT_BLINDS:
+		for (i = 0; i < N_BLINDS; i++) {
+			if (alignment == EV_TRANSITION_ALIGNMENT_HORIZONTAL) {
+				region_add_rectangle (region, page_area,
+						      0,
+						      page_area.height / N_BLINDS * i,
+						      width,
+						      page_area.height / N_BLINDS * progress);
+			} else {
+				region_add_rectangle (region, page_area,
+						      page_area.width / N_BLINDS * i,
+						      0,
+						      page_area.width / N_BLINDS * progress,
+						      height);
+			}
+		}
+		break;
+	case EV_TRANSITION_EFFECT_WIPE:
+		if (angle == 0) {
+			/* left to right */
+			region_add_rectangle (region, page_area, 0, 0, width * progress, height);
+		} else if (angle <= 90) {
+			/* bottom to top */
+			region_add_rectangle (region, page_area,
+					      0, height * (1 - progress),
+					      width, height * progress);
+		} else if (angle <= 180) {
+			/* right to left */
+			region_add_rectangle (region, page_area,
+					      width * (1 - progress), 0,
+					      width * progress, height);
+		} else if (angle <= 270) {
+			/* top to bottom */
+			region_add_rectangle (region, page_area, 0, 0, width, height * progress);
 		}
+		break;
+	default:
+		g_assert_not_reached ();
+	}
 
-		cairo_clip (cr);
+	g_clear_pointer (&priv->dest_region, cairo_region_destroy);
+	g_clear_pointer (&priv->origin_region, cairo_region_destroy);
 
-		paint_surface (cr, priv->dest_surface, 0, 0, 1., page_area);
+	area.x = page_area.x;
+	area.y = page_area.y;
+	area.width = page_area.width;
+	area.height = page_area.height;
+
+	if (inward) {
+		priv->origin_region = region;
+		priv->dest_region = cairo_region_create_rectangle (&area);
+		cairo_region_subtract (priv->dest_region, region);
+	} else {
+		priv->dest_region = region;
+		priv->origin_region = cairo_region_create_rectangle (&area);
+		cairo_region_subtract (priv->origin_region, region);
 	}
+
+	priv->mask_area = page_area;
+	priv->mask_progress = progress;
 }
 
+/* animations */
 static void
-ev_transition_animation_blinds (cairo_t               *cr,
+ev_transition_animation_masked (cairo_t               *cr,
 				EvTransitionAnimation *animation,
-				EvTransitionEffect    *effect,
+				EvTransitionEffectType type,
 				gdouble                progress,
 				GdkRectangle           page_area)
 {
 	EvTransitionAnimationPriv *priv;
-	EvTransitionEffectAlignment alignment;
-	gint width, height, i;
 
 	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
-	width = page_area.width;
-	height = page_area.height;
 
-	g_object_get (effect,
-		      "alignment", &alignment,
-		      NULL);
+	ev_transition_animation_update_masks (animation, type, progress, page_area);
 
-	paint_surface (cr, priv->origin_surface, 0, 0, 1., page_area);
-
-	for (i = 0; i < N_BLINDS; i++) {
-		cairo_save (cr);
-
-		if (alignment == EV_TRANSITION_ALIGNMENT_HORIZONTAL) {
-			cairo_rectangle (cr,
-					 0,
-					 height / N_BLINDS * i,
-					 width,
-					 height / N_BLINDS * progress);
-		} else {
-			cairo_rectangle (cr,
-					 width / N_BLINDS * i,
-					 0,
-					 width / N_BLINDS * progress,
-					 height);
-		}
-
-		cairo_clip (cr);
-		paint_surface (cr, priv->dest_surface, 0, 0, 1., page_area);
-		cairo_restore (cr);
-	}
+	paint_region (cr, priv->origin_surface, priv->origin_region);
+	paint_region (cr, priv->dest_surface, priv->dest_region);
 }
 
-static void
-ev_transition_animation_box (cairo_t               *cr,
-			     EvTransitionAnimation *animation,
-			     EvTransitionEffect    *effect,
-			     gdouble                progress,
-			     GdkRectangle           page_area)
+static gboolean
+can_blend_surfaces (cairo_surface_t *origin,
+		    cairo_surface_t *dest)
 {
-	EvTransitionAnimationPriv *priv;
-	EvTransitionEffectDirection direction;
-	gint width, height;
+	cairo_format_t format;
 
-	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
-	width = page_area.width;
-	height = page_area.height;
-
-	g_object_get (effect,
-		      "direction", &direction,
-		      NULL);
+	if (cairo_surface_get_type (origin) != CAIRO_SURFACE_TYPE_IMAGE ||
+	    cairo_surface_get_type (dest) != CAIRO_SURFACE_TYPE_IMAGE)
+		return FALSE;
 
-	if (direction == EV_TRANSITION_DIRECTION_INWARD) {
-		paint_surface (cr, priv->dest_surface, 0, 0, 1., page_area);
-
-		cairo_rectangle (cr,
-				 width * progress / 2,
-				 height * progress / 2,
-				 width * (1 - progress),
-				 height * (1 - progress));
-		cairo_clip (cr);
-
-		paint_surface (cr, priv->origin_surface, 0, 0, 1., page_area);
-	} else {
-		paint_surface (cr, priv->origin_surface, 0, 0, 1., page_area);
+	format = cairo_image_surface_get_format (origin);
+	if (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24)
+		return FALSE;
 
-		cairo_rectangle (cr,
-				 (width / 2) - (width * progress / 2),
-				 (height / 2) - (height * progress / 2),
-				 width * progress,
-				 height * progress);
-		cairo_clip (cr);
-
-		paint_surface (cr, priv->dest_surface, 0, 0, 1., page_area);
-	}
+	return format == cairo_image_surface_get_format (dest) &&
+		cairo_image_surface_get_width (origin) == cairo_image_surface_get_width (dest) &&
+		cairo_image_surface_get_height (origin) == cairo_image_surface_get_height (dest);
 }
 
-static void
-ev_transition_animation_wipe (cairo_t               *cr,
-			      EvTransitionAnimation *animation,
-			      EvTransitionEffect    *effect,
-			      gdouble                progress,
-			      GdkRectangle           page_area)
+/* Blends the slides of image surfaces in a single pass into a frame
+ * that is kept while the progress doesn't change */
+static cairo_surface_t *
+ev_transition_animation_get_blend_surface (EvTransitionAnimation *animation,
+					   gdouble                progress)
 {
 	EvTransitionAnimationPriv *priv;
 	gint width, height;
-	gint angle;
 
 	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
-	width = page_area.width;
-	height = page_area.height;
 
-	g_object_get (effect,
-		      "angle", &angle,
-		      NULL);
+	if (priv->blend_surface && priv->blend_progress == progress)
+		return priv->blend_surface;
 
-	paint_surface (cr, priv->origin_surface, 0, 0, 1., page_area);
+	width = cairo_image_surface_get_width (priv->dest_surface);
+	height = cairo_image_surface_get_height (priv->dest_surface);
 
-	if (angle == 0) {
-		/* left to right */
-		cairo_rectangle (cr,
-				 0, 0,
-				 width * progress,
-				 height);
-	} else if (angle <= 90) {
-		/* bottom to top */
-		cairo_rectangle (cr,
-				 0,
-				 height * (1 - progress),
-				 width,
-				 height * progress);
-	} else if (angle <= 180) {
-		/* right to left */
-		cairo_rectangle (cr,
-				 width * (1 - progress),
-				 0,
-				 width * progress,
-				 height);
-	} else if (angle <= 270) {
-		/* top to bottom */
-		cairo_rectangle (cr,
-				 0, 0,
-				 width,
-				 height * progress);
+	if (!priv->blend_surface) {
+		priv->blend_surface = cairo_image_surface_create (cairo_image_surface_get_format (priv->dest_surface),
+								  width, height);
+#ifdef HAVE_HIDPI_SUPPORT
+		{
+			gdouble x_scale, y_scale;
+
+			cairo_surface_get_device_scale (priv->dest_surface, &x_scale, &y_scale);
+			cairo_surface_set_device_scale (priv->blend_surface, x_scale, y_scale);
+		}
+#endif
 	}
 
-	cairo_clip (cr);
+	ev_document_misc_blend_surfaces (priv->origin_surface, priv->dest_surface,
+					 priv->blend_surface, progress);
+	priv->blend_progress = progress;
 
-	paint_surface (cr, priv->dest_surface, 0, 0, 1., page_area);
+	return priv->blend_surface;
 }
 
+/* Dissolve is drawn as a cross-fade, like fade */
 static void
-ev_transition_animation_dissolve (cairo_t               *cr,
-				  EvTransitionAnimation *animation,
-				  EvTransitionEffect    *effect,
-				  gdouble                progress,
-				  GdkRectangle           page_area)
+ev_transition_animation_cross_fade (cairo_t               *cr,
+				    EvTransitionAnimation *animation,
+				    gdouble                progress,
+				    GdkRectangle           page_area)
 {
 	EvTransitionAnimationPriv *priv;
 
 	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
 
-	paint_surface (cr, priv->dest_surface, 0, 0, 1., page_area);
-	paint_surface (cr, priv->origin_surface, 0, 0, 1 - progress, page_area);
+	if (can_blend_surfaces (priv->origin_surface, priv->dest_surface)) {
+		paint_surface (cr, ev_transition_animation_get_blend_surface (animation, progress),
+			       0, 0, 1., page_area);
+		return;
+	}
+
+	paint_surface (cr, priv->origin_surface, 0, 0, 1., page_area);
+	paint_surface (cr, priv->dest_surface, 0, 0, progress, page_area);
 }
 
 static void
@@ -519,29 +590,61 @@ ev_transition_animation_uncover (cairo_t               *cr,
 	}
 }
 
+/* Progress of the timeline rounded down to the last step */
+static gdouble
+ev_transition_animation_get_step_progress (EvTransitionAnimation *animation)
+{
+	EvTransitionAnimationPriv *priv;
+	EvTimeline *timeline = EV_TIMELINE (animation);
+	gdouble progress;
+
+	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
+
+	if (priv->n_steps == 0) {
+		priv->n_steps = ev_timeline_get_duration (timeline) * ev_timeline_get_fps (timeline) / 1000;
+		priv->n_steps = MAX (priv->n_steps, MIN_STEPS);
+	}
+
+	progress = ev_timeline_get_progress (timeline);
+
+	return (gdouble) (guint) (progress * priv->n_steps) / priv->n_steps;
+}
+
+/* When painting a frame takes longer than the frame interval, paint
+ * fewer distinct frames so that the transition keeps its duration */
 static void
-ev_transition_animation_fade (cairo_t               *cr,
-			      EvTransitionAnimation *animation,
-			      EvTransitionEffect    *effect,
-			      gdouble                progress,
-			      GdkRectangle           page_area)
+ev_transition_animation_update_steps (EvTransitionAnimation *animation,
+				      gint64                 paint_time)
 {
 	EvTransitionAnimationPriv *priv;
+	gint64 interval;
 
 	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
 
-	paint_surface (cr, priv->origin_surface, 0, 0, 1., page_area);
-	paint_surface (cr, priv->dest_surface, 0, 0, progress, page_area);
+	interval = G_USEC_PER_SEC / ev_timeline_get_fps (EV_TIMELINE (animation));
+	if (paint_time <= interval || priv->n_steps <= MIN_STEPS)
+		return;
+
+	priv->n_steps = MAX (priv->n_steps * interval / paint_time, MIN_STEPS);
 }
 
+/**
+ * ev_transition_animation_paint_progress:
+ * @animation: a #EvTransitionAnimation
+ * @cr: a cairo context
+ * @page_area: the area of the slides
+ * @progress: the progress of the transition, from 0 to 1
+ *
+ * Paints the transition at @progress, regardless of the timeline.
+ */
 void
-ev_transition_animation_paint (EvTransitionAnimation *animation,
-			       cairo_t               *cr,
-			       GdkRectangle           page_area)
+ev_transition_animation_paint_progress (EvTransitionAnimation *animation,
+					cairo_t               *cr,
+					GdkRectangle           page_area,
+					gdouble                progress)
 {
 	EvTransitionAnimationPriv *priv;
 	EvTransitionEffectType type;
-	gdouble progress;
 
 	g_return_if_fail (EV_IS_TRANSITION_ANIMATION (animation));
 
@@ -554,7 +657,6 @@ ev_transition_animation_paint (EvTransitionAnimation *animation,
 	}
 
 	g_object_get (priv->effect, "type", &type, NULL);
-	progress = ev_timeline_get_progress (EV_TIMELINE (animation));
 
 	switch (type) {
 	case EV_TRANSITION_EFFECT_REPLACE:
@@ -562,19 +664,14 @@ ev_transition_animation_paint (EvTransitionAnimation *animation,
 		paint_surface (cr, priv->dest_surface, 0, 0, 1., page_area);
 		break;
 	case EV_TRANSITION_EFFECT_SPLIT:
-		ev_transition_animation_split (cr, animation, priv->effect, progress, page_area);
-		break;
 	case EV_TRANSITION_EFFECT_BLINDS:
-		ev_transition_animation_blinds (cr, animation, priv->effect, progress, page_area);
-		break;
 	case EV_TRANSITION_EFFECT_BOX:
-		ev_transition_animation_box (cr, animation, priv->effect, progress, page_area);
-		break;
 	case EV_TRANSITION_EFFECT_WIPE:
-		ev_transition_animation_wipe (cr, animation, priv->effect, progress, page_area);
+		ev_transition_animation_masked (cr, animation, type, progress, page_area);
 		break;
 	case EV_TRANSITION_EFFECT_DISSOLVE:
-		ev_transition_animation_dissolve (cr, animation, priv->effect, progress, page_area);
+	case EV_TRANSITION_EFFECT_FADE:
+		ev_transition_animation_cross_fade (cr, animation, progress, page_area);
 		break;
 	case EV_TRANSITION_EFFECT_PUSH:
 		ev_transition_animation_push (cr, animation, priv->effect, progress, page_area);
@@ -585,9 +682,6 @@ ev_transition_animation_paint (EvTransitionAnimation *animation,
 	case EV_TRANSITION_EFFECT_UNCOVER:
 		ev_transition_animation_uncover (cr, animation, priv->effect, progress, page_area);
 		break;
-	case EV_TRANSITION_EFFECT_FADE:
-		ev_transition_animation_fade (cr, animation, priv->effect, progress, page_area);
-		break;
 	default: {
 		GEnumValue *enum_value;
 
@@ -604,6 +698,53 @@ ev_transition_animation_paint (EvTransitionAnimation *animation,
 	}
 }
 
+void
+ev_transition_animation_paint (EvTransitionAnimation *animation,
+			       cairo_t               *cr,
+			       GdkRectangle           page_area)
+{
+	EvTransitionAnimationPriv *priv;
+	gdouble progress;
+	gint64 start;
+
+	g_return_if_fail (EV_IS_TRANSITION_ANIMATION (animation));
+
+	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
+
+	if (!priv->dest_surface) {
+		/* animation is still not ready, paint the origin surface */
+		paint_surface (cr, priv->origin_surface, 0, 0, 1., page_area);
+		return;
+	}
+
+	progress = ev_transition_animation_get_step_progress (animation);
+
+	start = g_get_monotonic_time ();
+	ev_transition_animation_paint_progress (animation, cr, page_area, progress);
+	if (ev_timeline_is_running (EV_TIMELINE (animation)))
+		ev_transition_animation_update_steps (animation, g_get_monotonic_time () - start);
+
+	priv->painted_progress = progress;
+}
+
+/**
+ * ev_transition_animation_needs_paint:
+ * @animation: a #EvTransitionAnimation
+ *
+ * Returns: whether the timeline moved to a step that was not painted yet
+ */
+gboolean
+ev_transition_animation_needs_paint (EvTransitionAnimation *animation)
+{
+	EvTransitionAnimationPriv *priv;
+
+	g_return_val_if_fail (EV_IS_TRANSITION_ANIMATION (animation), FALSE);
+
+	priv = EV_TRANSITION_ANIMATION_GET_PRIVATE (animation);
+
+	return ev_transition_animation_get_step_progress (animation) != priv->painted_progress;
+}
+
 EvTransitionAnimation *
 ev_transition_animation_new (EvTransitionEffect *effect)
 {
@@ -634,6 +775,7 @@ ev_transition_animation_set_origin_surface (EvTransitionAnimation *animation,
 		cairo_surface_destroy (priv->origin_surface);
 
 	priv->origin_surface = surface;
+	ev_transition_animation_clear_intermediates (animation);
 	g_object_notify (G_OBJECT (animation), "origin-surface");
 
 	if (priv->origin_surface && priv->dest_surface)
@@ -660,6 +802,7 @@ ev_transition_animation_set_dest_surface (EvTransitionAnimation *animation,
 		cairo_surface_destroy (priv->dest_surface);
 
 	priv->dest_surface = surface;
+	ev_transition_animation_clear_intermediates (animation);
 	g_object_notify (G_OBJECT (animation), "dest-surface");
 
 	if (priv->origin_surface && priv->dest_surface)
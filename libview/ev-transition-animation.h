@@ -65,6 +65,11 @@ gint                    ev_transition_animation_get_page_to        (EvTransition
 void                    ev_transition_animation_paint              (EvTransitionAnimation *animation,
 								    cairo_t               *cr,
 								    GdkRectangle           page_area);
+void                    ev_transition_animation_paint_progress     (EvTransitionAnimation *animation,
+								    cairo_t               *cr,
+								    GdkRectangle           page_area,
+								    gdouble                progress);
+gboolean                ev_transition_animation_needs_paint        (EvTransitionAnimation *animation);
 gboolean                ev_transition_animation_ready              (EvTransitionAnimation *animation);
 
 
@@ -634,3 +634,13 @@ ev_view_accessible_update_element_state (EvViewAccessible *accessible,
 	page = g_ptr_array_index (accessible->priv->children, element_page);
 	ev_page_accessible_update_element_state (page, element);
 }
+
+void
+ev_view_accessible_page_evicted (EvViewAccessible *accessible,
+				 gint              page)
+{
+	if (!accessible->priv->children || (guint) page >= accessible->priv->children->len)
+		return;
+
+	ev_page_accessible_page_evicted (g_ptr_array_index (accessible->priv->children, page));
+}
@@ -71,6 +71,8 @@ void       ev_view_accessible_set_focused_element (EvViewAccessible *accessible,
 void       ev_view_accessible_update_element_state (EvViewAccessible *accessible,
 						    EvMapping        *element,
 						    gint              element_page);
+void       ev_view_accessible_page_evicted (EvViewAccessible *accessible,
+					    gint              page);
 
 #endif  /* __EV_VIEW_ACCESSIBLE_H__ */
 
@@ -30,6 +30,10 @@
 #include "ev-transition-animation.h"
 #include "ev-view-cursor.h"
 #include "ev-page-cache.h"
+#include "ev-debug.h"
+
+#define DEFAULT_LOOK_AHEAD 3
+#define DEFAULT_CACHE_SIZE (256 * 1024 * 1024)
 
 enum {
 	PROP_0,
@@ -86,11 +90,25 @@ struct _EvViewPresentation
 	/* Links */
 	EvPageCache           *page_cache;
 
-	EvJob *prev_job;
-	EvJob *curr_job;
-	EvJob *next_job;
+	/* Pre-rendered slides, by page */
+	GHashTable            *slides;
+	guint                  look_ahead;
+	gsize                  cache_size;
+	gint                   direction;
+
+	/* Instrumentation */
+	guint                  n_slides_not_ready;
+	guint                  n_late_frames;
+	gint64                 frame_time;
 };
 
+typedef struct {
+	EvViewPresentation *pview;
+	guint               page;
+	EvJob              *job;     /* NULL once rendered */
+	cairo_surface_t    *surface; /* Similar to the widget window */
+} EvPresentationSlide;
+
 struct _EvViewPresentationClass
 {
 	GtkWidgetClass base_class;
@@ -274,6 +292,7 @@ ev_view_presentation_animation_cancel (EvViewPresentation *pview)
 		g_object_unref (pview->animation);
 		pview->animation = NULL;
 	}
+	pview->frame_time = 0;
 }
 
 static void
@@ -288,6 +307,12 @@ static void
 ev_view_presentation_transition_animation_frame (EvViewPresentation *pview,
 						 gdouble             progress)
 {
+	/* The animation paints fewer frames when they are slow */
+	if (!ev_transition_animation_needs_paint (pview->animation))
+		return;
+
+	if (pview->frame_time == 0)
+		pview->frame_time = g_get_monotonic_time ();
 	gtk_widget_queue_draw (GTK_WIDGET (pview));
 }
 
@@ -314,14 +339,62 @@ get_surface_from_job (EvViewPresentation *pview,
         return surface;
 }
 
+static EvPresentationSlide *
+ev_view_presentation_get_slide (EvViewPresentation *pview,
+				guint               page)
+{
+	return g_hash_table_lookup (pview->slides, GUINT_TO_POINTER (page));
+}
+
+static cairo_surface_t *
+ev_view_presentation_get_slide_surface (EvViewPresentation *pview,
+					guint               page)
+{
+	EvPresentationSlide *slide;
+
+	slide = ev_view_presentation_get_slide (pview, page);
+
+	return slide ? slide->surface : NULL;
+}
+
+/* Copies a rendered page to an opaque image surface, so that all the
+ * slides have the same format and transitions between them can be
+ * blended in a single pass. Surfaces similar to the widget window are
+ * not image surfaces on X11.
+ */
+static cairo_surface_t *
+ev_view_presentation_copy_surface (cairo_surface_t *surface)
+{
+	cairo_surface_t *copy;
+	cairo_t         *cr;
+	gint             width, height;
+
+	width = cairo_image_surface_get_width (surface);
+	height = cairo_image_surface_get_height (surface);
+	copy = cairo_image_surface_create (CAIRO_FORMAT_RGB24, width, height);
+#ifdef HAVE_HIDPI_SUPPORT
+	{
+		gdouble x_scale, y_scale;
+
+		cairo_surface_get_device_scale (surface, &x_scale, &y_scale);
+		cairo_surface_set_device_scale (copy, x_scale, y_scale);
+	}
+#endif
+	cr = cairo_create (copy);
+	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_surface (cr, surface, 0, 0);
+	cairo_paint (cr);
+	cairo_destroy (cr);
+
+	return copy;
+}
+
 static void
 ev_view_presentation_animation_start (EvViewPresentation *pview,
 				      gint                new_page)
 {
 	EvTransitionEffect *effect = NULL;
-	EvJob		   *job;
 	cairo_surface_t    *surface;
-	gint                jump;
 
 	if (!pview->enable_animations)
 		return;
@@ -336,19 +409,13 @@ ev_view_presentation_animation_start (EvViewPresentation *pview,
 
 	pview->animation = ev_transition_animation_new (effect);
 
-	surface = pview->curr_job ? EV_JOB_RENDER (pview->curr_job)->surface : NULL;
+	surface = ev_view_presentation_get_slide_surface (pview, pview->current_page);
 	ev_transition_animation_set_origin_surface (pview->animation,
 						    surface != NULL ?
 						    surface : pview->current_surface);
 
-	jump = new_page - pview->current_page;
-	if (jump == -1)
-		job = pview->prev_job;
-	else if (jump == 1)
-		job = pview->next_job;
-	else
-		job = NULL;
-	surface = get_surface_from_job (pview, job);
+	/* Any slide in the look-ahead window is already rendered */
+	surface = ev_view_presentation_get_slide_surface (pview, new_page);
 	if (surface)
 		ev_transition_animation_set_dest_surface (pview->animation, surface);
 
@@ -360,38 +427,63 @@ ev_view_presentation_animation_start (EvViewPresentation *pview,
 				  pview);
 }
 
+/* A frame is late when it's drawn more than a frame interval after the
+ * timeline asked for it */
+static void
+ev_view_presentation_animation_frame_drawn (EvViewPresentation *pview)
+{
+	gint64 now;
+	gint64 interval;
+
+	if (pview->frame_time == 0)
+		return;
+
+	now = g_get_monotonic_time ();
+	interval = G_USEC_PER_SEC / ev_timeline_get_fps (EV_TIMELINE (pview->animation));
+	if (now - pview->frame_time > interval) {
+		pview->n_late_frames++;
+		ev_debug_message (DEBUG_JOBS, "late transition frame: %" G_GINT64_FORMAT " ms",
+				  (now - pview->frame_time) / 1000);
+	}
+	pview->frame_time = 0;
+}
+
 /* Page Navigation */
 static void
-job_finished_cb (EvJob              *job,
-		 EvViewPresentation *pview)
+job_finished_cb (EvJob               *job,
+		 EvPresentationSlide *slide)
 {
-	EvJobRender *job_render = EV_JOB_RENDER (job);
+	EvViewPresentation *pview = slide->pview;
+	EvJobRender        *job_render = EV_JOB_RENDER (job);
+	cairo_surface_t    *surface;
 
 	if (pview->inverted_colors)
 		ev_document_misc_invert_surface (job_render->surface);
 
-	if (job != pview->curr_job)
+	surface = get_surface_from_job (pview, job);
+	if (surface)
+		slide->surface = ev_view_presentation_copy_surface (surface);
+
+	g_signal_handlers_disconnect_by_func (job, job_finished_cb, slide);
+	g_object_unref (job);
+	slide->job = NULL;
+
+	if (slide->page != pview->current_page || !slide->surface)
 		return;
 
 	if (pview->animation) {
-		ev_transition_animation_set_dest_surface (pview->animation,
-							  get_surface_from_job (pview, job));
+		ev_transition_animation_set_dest_surface (pview->animation, slide->surface);
 	} else {
 		ev_view_presentation_transition_start (pview);
 		gtk_widget_queue_draw (GTK_WIDGET (pview));
 	}
 }
 
-static EvJob *
-ev_view_presentation_schedule_new_job (EvViewPresentation *pview,
-				       gint                page,
-				       EvJobPriority       priority)
+static gsize
+ev_view_presentation_get_slide_size (EvViewPresentation *pview,
+				     guint               page)
 {
-	EvJob *job;
-        int    view_width, view_height;
-
-	if (page < 0 || page >= ev_document_get_n_pages (pview->document))
-		return NULL;
+        int view_width, view_height;
 
         ev_view_presentation_get_view_size (pview, page, &view_width, &view_height);
 #ifdef HAVE_HIDPI_SUPPORT
@@ -401,140 +493,153 @@ ev_view_presentation_schedule_new_job (EvViewPresentation *pview,
 		view_height *= device_scale;
 	}
 #endif
-        job = ev_job_render_new (pview->document, page, pview->rotation, 0.,
-                                 view_width, view_height);
-	g_signal_connect (job, "finished",
-			  G_CALLBACK (job_finished_cb),
-			  pview);
-	ev_job_scheduler_push_job (job, priority);
-
-	return job;
+	return (gsize) view_width * view_height * 4;
 }
 
 static void
-ev_view_presentation_delete_job (EvViewPresentation *pview,
-				 EvJob              *job)
+ev_view_presentation_schedule_new_job (EvPresentationSlide *slide,
+				       EvJobPriority        priority)
 {
-	if (!job)
-		return;
+	EvViewPresentation *pview = slide->pview;
+        int                 view_width, view_height;
 
-	g_signal_handlers_disconnect_by_func (job, job_finished_cb, pview);
-	ev_job_cancel (job);
-	g_object_unref (job);
+        ev_view_presentation_get_view_size (pview, slide->page, &view_width, &view_height);
+#ifdef HAVE_HIDPI_SUPPORT
+	{
+		gint device_scale = gtk_widget_get_scale_factor (GTK_WIDGET (pview));
+		view_width *= device_scale;
+		view_height *= device_scale;
+	}
+#endif
+        slide->job = ev_job_render_new (pview->document, slide->page, pview->rotation, 0.,
+                                        view_width, view_height);
+	g_signal_connect (slide->job, "finished",
+			  G_CALLBACK (job_finished_cb),
+			  slide);
+	ev_job_scheduler_push_job (slide->job, priority);
 }
 
 static void
-ev_view_presentation_reset_jobs (EvViewPresentation *pview)
+ev_view_presentation_slide_free (EvPresentationSlide *slide)
 {
-        if (pview->curr_job) {
-                ev_view_presentation_delete_job (pview, pview->curr_job);
-                pview->curr_job = NULL;
-        }
+	if (slide->job) {
+		g_signal_handlers_disconnect_by_func (slide->job, job_finished_cb, slide);
+		ev_job_cancel (slide->job);
+		g_object_unref (slide->job);
+	}
 
-        if (pview->prev_job) {
-                ev_view_presentation_delete_job (pview, pview->prev_job);
-                pview->prev_job = NULL;
-        }
+	if (slide->surface)
+		cairo_surface_destroy (slide->surface);
 
-        if (pview->next_job) {
-                ev_view_presentation_delete_job (pview, pview->next_job);
-                pview->next_job = NULL;
-        }
+	g_slice_free (EvPresentationSlide, slide);
 }
 
 static void
-ev_view_presentation_update_current_page (EvViewPresentation *pview,
-					  guint               page)
+ev_view_presentation_reset_jobs (EvViewPresentation *pview)
 {
-	gint jump;
+	g_hash_table_remove_all (pview->slides);
+}
 
-	if (page < 0 || page >= ev_document_get_n_pages (pview->document))
+/* Renders the current slide, the previous one, and as many of the next
+ * ones in the direction the presentation moves as the look-ahead window
+ * and the cache size allow. The slides outside of it are dropped.
+ */
+static void
+ev_view_presentation_update_slides (EvViewPresentation *pview)
+{
+	GHashTable          *window;
+	GHashTableIter       iter;
+	gpointer             key, value;
+	EvPresentationSlide *slide;
+	gint                 n_pages;
+	gint                 page = pview->current_page;
+	gint                 direction = pview->direction;
+	gsize                size = 0;
+	guint                i;
+
+	/* Slides are rendered at the monitor size */
+	if (pview->monitor_width == 0)
 		return;
 
-	ev_view_presentation_animation_cancel (pview);
-	ev_view_presentation_animation_start (pview, page);
+	n_pages = ev_document_get_n_pages (pview->document);
+	window = g_hash_table_new (NULL, NULL);
+
+	g_hash_table_insert (window, GUINT_TO_POINTER (page),
+			     GINT_TO_POINTER (EV_JOB_PRIORITY_URGENT));
+	size += ev_view_presentation_get_slide_size (pview, page);
+	if (page - direction >= 0 && page - direction < n_pages) {
+		g_hash_table_insert (window, GUINT_TO_POINTER (page - direction),
+				     GINT_TO_POINTER (EV_JOB_PRIORITY_LOW));
+		size += ev_view_presentation_get_slide_size (pview, page - direction);
+	}
+	for (i = 1; i <= MAX (pview->look_ahead, 1); i++) {
+		gint next = page + direction * (gint) i;
 
-	jump = page - pview->current_page;
+		if (next < 0 || next >= n_pages)
+			break;
 
-	switch (jump) {
-	case 0:
-		if (!pview->curr_job)
-			pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		if (!pview->next_job)
-			pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_HIGH);
-		if (!pview->prev_job)
-			pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_LOW);
-		break;
-	case -1:
-		ev_view_presentation_delete_job (pview, pview->next_job);
-		pview->next_job = pview->curr_job;
-		pview->curr_job = pview->prev_job;
+		/* The next slide is always rendered */
+		size += ev_view_presentation_get_slide_size (pview, next);
+		if (i > 1 && size > pview->cache_size)
+			break;
 
-		if (!pview->curr_job)
-			pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		else
-			ev_job_scheduler_update_job (pview->curr_job, EV_JOB_PRIORITY_URGENT);
-		pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_HIGH);
-		ev_job_scheduler_update_job (pview->next_job, EV_JOB_PRIORITY_LOW);
+		g_hash_table_insert (window, GUINT_TO_POINTER (next),
+				     GINT_TO_POINTER (i == 1 ? EV_JOB_PRIORITY_HIGH : EV_JOB_PRIORITY_LOW));
+	}
 
-		break;
-	case 1:
-		ev_view_presentation_delete_job (pview, pview->prev_job);
-		pview->prev_job = pview->curr_job;
-		pview->curr_job = pview->next_job;
+	g_hash_table_iter_init (&iter, pview->slides);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		if (!g_hash_table_contains (window, key))
+			g_hash_table_iter_remove (&iter);
+	}
 
-		if (!pview->curr_job)
-			pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		else
-			ev_job_scheduler_update_job (pview->curr_job, EV_JOB_PRIORITY_URGENT);
-		pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_HIGH);
-		ev_job_scheduler_update_job (pview->prev_job, EV_JOB_PRIORITY_LOW);
+	g_hash_table_iter_init (&iter, window);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		EvJobPriority priority = GPOINTER_TO_INT (value);
 
-		break;
-	case -2:
-		ev_view_presentation_delete_job (pview, pview->next_job);
-		ev_view_presentation_delete_job (pview, pview->curr_job);
-		pview->next_job = pview->prev_job;
-
-		pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_HIGH);
-		if (!pview->next_job)
-			pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_LOW);
-		else
-			ev_job_scheduler_update_job (pview->next_job, EV_JOB_PRIORITY_LOW);
-		break;
-	case 2:
-		ev_view_presentation_delete_job (pview, pview->prev_job);
-		ev_view_presentation_delete_job (pview, pview->curr_job);
-		pview->prev_job = pview->next_job;
-
-		pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_HIGH);
-		if (!pview->prev_job)
-			pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_LOW);
-		else
-			ev_job_scheduler_update_job (pview->prev_job, EV_JOB_PRIORITY_LOW);
-		break;
-	default:
-		ev_view_presentation_delete_job (pview, pview->prev_job);
-		ev_view_presentation_delete_job (pview, pview->curr_job);
-		ev_view_presentation_delete_job (pview, pview->next_job);
-
-		pview->curr_job = ev_view_presentation_schedule_new_job (pview, page, EV_JOB_PRIORITY_URGENT);
-		if (jump > 0) {
-			pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_HIGH);
-			pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_LOW);
-		} else {
-			pview->prev_job = ev_view_presentation_schedule_new_job (pview, page - 1, EV_JOB_PRIORITY_HIGH);
-			pview->next_job = ev_view_presentation_schedule_new_job (pview, page + 1, EV_JOB_PRIORITY_LOW);
+		slide = g_hash_table_lookup (pview->slides, key);
+		if (slide) {
+			if (slide->job)
+				ev_job_scheduler_update_job (slide->job, priority);
+			continue;
 		}
+
+		slide = g_slice_new0 (EvPresentationSlide);
+		slide->pview = pview;
+		slide->page = GPOINTER_TO_UINT (key);
+		g_hash_table_insert (pview->slides, key, slide);
+		ev_view_presentation_schedule_new_job (slide, priority);
 	}
 
-	if (pview->current_page != page) {
+	g_hash_table_destroy (window);
+}
+
+static void
+ev_view_presentation_update_current_page (EvViewPresentation *pview,
+					  guint               page)
+{
+	gboolean page_changed;
+
+	if (page < 0 || page >= ev_document_get_n_pages (pview->document))
+		return;
+
+	ev_view_presentation_animation_cancel (pview);
+	ev_view_presentation_animation_start (pview, page);
+
+	page_changed = pview->current_page != page;
+	if (page_changed) {
+		pview->direction = page > pview->current_page ? 1 : -1;
 		pview->current_page = page;
 		g_object_notify (G_OBJECT (pview), "current-page");
 	}
 
+	ev_view_presentation_update_slides (pview);
+
+	if (page_changed && !ev_view_presentation_get_slide_surface (pview, page)) {
+		pview->n_slides_not_ready++;
+		ev_debug_message (DEBUG_JOBS, "slide %u not ready", page);
+	}
+
 	if (pview->page_cache)
 		ev_page_cache_set_page_range (pview->page_cache, page, page);
 
@@ -545,7 +650,7 @@ ev_view_presentation_update_current_page (EvViewPresentation *pview,
 		ev_view_presentation_set_cursor_for_location (pview, x, y);
 	}
 
-	if (EV_JOB_RENDER (pview->curr_job)->surface)
+	if (ev_view_presentation_get_slide_surface (pview, page))
 		gtk_widget_queue_draw (GTK_WIDGET (pview));
 }
 
@@ -1007,7 +1112,14 @@ ev_view_presentation_dispose (GObject *object)
 	ev_view_presentation_animation_cancel (pview);
 	ev_view_presentation_transition_stop (pview);
 	ev_view_presentation_hide_cursor_timeout_stop (pview);
-        ev_view_presentation_reset_jobs (pview);
+
+	if (pview->slides) {
+		g_hash_table_destroy (pview->slides);
+		pview->slides = NULL;
+	}
+
+	ev_debug_message (DEBUG_JOBS, "%u slides not ready, %u late transition frames",
+			  pview->n_slides_not_ready, pview->n_late_frames);
 
 	if (pview->current_surface) {
 		cairo_surface_destroy (pview->current_surface);
@@ -1122,12 +1234,14 @@ ev_view_presentation_draw (GtkWidget *widget,
 			ev_transition_animation_paint (pview->animation, cr, page_area);
 
                         cairo_restore (cr);
+
+			ev_view_presentation_animation_frame_drawn (pview);
 		}
 
 		return TRUE;
 	}
 
-	surface = get_surface_from_job (pview, pview->curr_job);
+	surface = ev_view_presentation_get_slide_surface (pview, pview->current_page);
 	if (surface) {
 		ev_view_presentation_update_current_surface (pview, surface);
 	} else if (pview->current_surface) {
@@ -1282,17 +1396,23 @@ ev_view_presentation_motion_notify_event (GtkWidget      *widget,
 	return FALSE;
 }
 
-static void
+/* Returns whether the size of the monitor changed */
+static gboolean
 ev_view_presentation_update_monitor_geometry (EvViewPresentation *pview)
 {
 	GdkScreen          *screen = gtk_widget_get_screen (GTK_WIDGET (pview));
 	GdkRectangle        monitor;
 	gint                monitor_num;
+	gboolean            changed;
 
 	monitor_num = gdk_screen_get_monitor_at_window (screen, gtk_widget_get_window (GTK_WIDGET (pview)));
 	gdk_screen_get_monitor_geometry (screen, monitor_num, &monitor);
+	changed = pview->monitor_width != monitor.width ||
+		pview->monitor_height != monitor.height;
 	pview->monitor_width = monitor.width;
 	pview->monitor_height = monitor.height;
+
+	return changed;
 }
 
 static gboolean
@@ -1349,6 +1469,25 @@ ev_view_presentation_realize (GtkWidget *widget)
 	g_idle_add ((GSourceFunc)init_presentation, widget);
 }
 
+static void
+ev_view_presentation_size_allocate (GtkWidget     *widget,
+				    GtkAllocation *allocation)
+{
+	EvViewPresentation *pview = EV_VIEW_PRESENTATION (widget);
+
+	GTK_WIDGET_CLASS (ev_view_presentation_parent_class)->size_allocate (widget, allocation);
+
+	/* Slides are rendered at the monitor size, moving to another
+	 * monitor makes them useless */
+	if (!gtk_widget_get_realized (widget) || pview->monitor_width == 0)
+		return;
+
+	if (ev_view_presentation_update_monitor_geometry (pview)) {
+		ev_view_presentation_reset_jobs (pview);
+		ev_view_presentation_update_current_page (pview, pview->current_page);
+	}
+}
+
 static void
 ev_view_presentation_change_page (EvViewPresentation *pview,
 				  GtkScrollType       scroll)
@@ -1503,6 +1642,7 @@ ev_view_presentation_class_init (EvViewPresentationClass *klass)
 	widget_class->get_preferred_width = ev_view_presentation_get_preferred_width;
 	widget_class->get_preferred_height = ev_view_presentation_get_preferred_height;
 	widget_class->realize = ev_view_presentation_realize;
+	widget_class->size_allocate = ev_view_presentation_size_allocate;
         widget_class->draw = ev_view_presentation_draw;
 	widget_class->key_press_event = ev_view_presentation_key_press_event;
 	widget_class->button_release_event = ev_view_presentation_button_release_event;
@@ -1645,6 +1785,11 @@ ev_view_presentation_init (EvViewPresentation *pview)
 {
 	gtk_widget_set_can_focus (GTK_WIDGET (pview), TRUE);
         pview->is_constructing = TRUE;
+	pview->slides = g_hash_table_new_full (NULL, NULL, NULL,
+					       (GDestroyNotify) ev_view_presentation_slide_free);
+	pview->look_ahead = DEFAULT_LOOK_AHEAD;
+	pview->cache_size = DEFAULT_CACHE_SIZE;
+	pview->direction = 1;
 #if !GTK_CHECK_VERSION(3, 20, 0)
         ev_view_presentation_init_css();
 #endif
@@ -1699,3 +1844,84 @@ ev_view_presentation_get_rotation (EvViewPresentation *pview)
 {
         return pview->rotation;
 }
+
+/**
+ * ev_view_presentation_set_look_ahead:
+ * @pview: a #EvViewPresentation
+ * @look_ahead: the number of slides to render ahead of the current one
+ *
+ * Sets how many slides are rendered ahead of the current one, in the
+ * direction the presentation moves. The next slide is always rendered.
+ *
+ * Since: 3.30
+ */
+void
+ev_view_presentation_set_look_ahead (EvViewPresentation *pview,
+				     guint               look_ahead)
+{
+	g_return_if_fail (EV_IS_VIEW_PRESENTATION (pview));
+
+	look_ahead = MAX (look_ahead, 1);
+	if (pview->look_ahead == look_ahead)
+		return;
+
+	pview->look_ahead = look_ahead;
+	ev_view_presentation_update_slides (pview);
+}
+
+/**
+ * ev_view_presentation_set_cache_size:
+ * @pview: a #EvViewPresentation
+ * @cache_size: size of the slides cache in bytes
+ *
+ * Sets the maximum memory used by the slides rendered ahead. The current,
+ * next and previous slides are kept regardless of the cache size.
+ *
+ * Since: 3.30
+ */
+void
+ev_view_presentation_set_cache_size (EvViewPresentation *pview,
+				     gsize               cache_size)
+{
+	g_return_if_fail (EV_IS_VIEW_PRESENTATION (pview));
+
+	if (pview->cache_size == cache_size)
+		return;
+
+	pview->cache_size = cache_size;
+	ev_view_presentation_update_slides (pview);
+}
+
+/**
+ * ev_view_presentation_get_n_slides_not_ready:
+ * @pview: a #EvViewPresentation
+ *
+ * Returns: the number of times the presentation moved to a slide that
+ *   was not rendered yet
+ *
+ * Since: 3.30
+ */
+guint
+ev_view_presentation_get_n_slides_not_ready (EvViewPresentation *pview)
+{
+	g_return_val_if_fail (EV_IS_VIEW_PRESENTATION (pview), 0);
+
+	return pview->n_slides_not_ready;
+}
+
+/**
+ * ev_view_presentation_get_n_late_frames:
+ * @pview: a #EvViewPresentation
+ *
+ * Returns: the number of transition frames drawn later than the
+ *   transition frame rate
+ *
+ * Since: 3.30
+ */
+guint
+ev_view_presentation_get_n_late_frames (EvViewPresentation *pview)
+{
+	g_return_val_if_fail (EV_IS_VIEW_PRESENTATION (pview), 0);
+
+	return pview->n_late_frames;
+}
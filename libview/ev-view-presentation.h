@@ -53,6 +53,14 @@ void            ev_view_presentation_previous_page    (EvViewPresentation *pview
 void            ev_view_presentation_set_rotation     (EvViewPresentation *pview,
                                                        gint                rotation);
 guint           ev_view_presentation_get_rotation     (EvViewPresentation *pview);
+void            ev_view_presentation_set_look_ahead   (EvViewPresentation *pview,
+                                                       guint               look_ahead);
+void            ev_view_presentation_set_cache_size   (EvViewPresentation *pview,
+                                                       gsize               cache_size);
+guint           ev_view_presentation_get_n_slides_not_ready
+                                                      (EvViewPresentation *pview);
+guint           ev_view_presentation_get_n_late_frames
+                                                      (EvViewPresentation *pview);
 
 G_END_DECLS
 
@@ -103,6 +103,7 @@ typedef struct {
 } EvViewChild;
 
 #define MIN_SCALE 0.2
+#define MAX_TILED_SCALE 64.0
 #define ZOOM_IN_FACTOR  1.2
 #define ZOOM_OUT_FACTOR (1.0/ZOOM_IN_FACTOR)
 
@@ -128,6 +129,8 @@ static void       compute_border                             (EvView
 static void       get_page_y_offset                          (EvView             *view,
 							      int                 page,
 							      int                *y_offset);
+static gint       get_page_at_y_offset                       (EvView             *view,
+							      gint                y);
 static void       find_page_at_location                      (EvView             *view,
 							      gdouble             x,
 							      gdouble             y,
@@ -727,6 +730,7 @@ view_update_range_and_current_page (EvView *view)
 		gint area_max = -1, area;
 		gint best_current_page = -1;
 		int i, j = 0;
+		int first_page;
 
 		if (!(view->vadjustment && view->hadjustment))
 			return;
@@ -736,10 +740,19 @@ view_update_range_and_current_page (EvView *view)
 		current_area.y = gtk_adjustment_get_value (view->vadjustment);
 		current_area.height = gtk_adjustment_get_page_size (view->vadjustment);
 
-		for (i = 0; i < ev_document_get_n_pages (view->document); i++) {
+		/* Start from the row before the one at the top of the
+		 * visible area, earlier pages can't be visible */
+		first_page = get_page_at_y_offset (view, current_area.y);
+		first_page = MAX (first_page - (is_dual_page (view, NULL) ? 2 : 1), 0);
+
+		for (i = first_page; i < ev_document_get_n_pages (view->document); i++) {
 
 			ev_view_get_page_extents (view, i, &page_area, &border);
 
+			/* Neither this page nor the following ones are visible */
+			if (page_area.y >= current_area.y + current_area.height)
+				break;
+
 			if (gdk_rectangle_intersect (&current_area, &page_area, &unused)) {
 				area = unused.width * unused.height;
 
@@ -826,7 +839,8 @@ view_update_range_and_current_page (EvView *view)
 						   view->start_page,
 						   view->end_page);
 
-	if (ev_pixbuf_cache_get_surface (view->pixbuf_cache, view->current_page))
+	if (ev_pixbuf_cache_get_surface (view->pixbuf_cache, view->current_page) ||
+	    ev_pixbuf_cache_page_uses_tiles (view->pixbuf_cache, view->current_page))
 	    gtk_widget_queue_draw (GTK_WIDGET (view));
 }
 
@@ -942,11 +956,11 @@ compute_scroll_increment (EvView        *view,
 		doc_rect.x1 = doc_rect.x2 = rect.x + 0.5;
 		doc_rect.y1 = doc_rect.y2 = rect.y + 0.5;
 
-		ev_document_doc_mutex_lock ();
+		ev_document_lock (view->document);
 		sel_region = ev_selection_get_selection_region (EV_SELECTION (view->document),
 								rc, EV_SELECTION_STYLE_LINE,
 								&doc_rect);
-		ev_document_doc_mutex_unlock ();
+		ev_document_unlock (view->document);
 
 		g_object_unref (rc);
 
@@ -1250,6 +1264,30 @@ get_page_y_offset (EvView *view, int page, int *y_offset)
 	return;
 }
 
+/* Page offsets never decrease with the page index, so the last page
+ * starting at or above @y can be found with a binary search of the
+ * height to page cache instead of walking all the pages */
+static gint
+get_page_at_y_offset (EvView *view,
+		      gint    y)
+{
+	gint low = 0;
+	gint high = ev_document_get_n_pages (view->document) - 1;
+
+	while (low < high) {
+		gint mid = low + (high - low + 1) / 2;
+		gint offset;
+
+		get_page_y_offset (view, mid, &offset);
+		if (offset <= y)
+			low = mid;
+		else
+			high = mid - 1;
+	}
+
+	return MAX (low, 0);
+}
+
 gboolean
 ev_view_get_page_extents (EvView       *view,
 			  gint          page,
@@ -1520,13 +1558,20 @@ find_page_at_location (EvView  *view,
 	g_assert (x_offset);
 	g_assert (y_offset);
 
-	for (i = view->start_page; i >= 0 && i <= view->end_page; i++) {
+	i = view->start_page;
+	if (view->continuous && i >= 0)
+		i = MAX (i, get_page_at_y_offset (view, y) - (is_dual_page (view, NULL) ? 1 : 0));
+
+	for (; i >= 0 && i <= view->end_page; i++) {
 		GdkRectangle page_area;
 		GtkBorder border;
 
 		if (! ev_view_get_page_extents (view, i, &page_area, &border))
 			continue;
 
+		if (view->continuous && y < page_area.y)
+			break;
+
 		if ((x >= page_area.x + border.left) &&
 		    (x < page_area.x + page_area.width - border.right) &&
 		    (y >= page_area.y + border.top) &&
@@ -3115,10 +3160,10 @@ ev_view_annotation_save_contents (EvView       *view,
 	if (!view->document)
 		return;
 
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (view->document);
 	ev_document_annotations_save_annotation (EV_DOCUMENT_ANNOTATIONS (view->document),
 						 annot, EV_ANNOTATIONS_SAVE_CONTENTS);
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (view->document);
 }
 
 static GtkWidget *
@@ -3339,7 +3384,7 @@ ev_view_create_annotation_real (EvView *view,
 	GdkRectangle    view_rect;
 	cairo_region_t *region;
 
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (view->document);
 	page = ev_document_get_page (view->document, annot_page);
         switch (view->adding_annot_info.type) {
         case EV_ANNOTATION_TYPE_TEXT:
@@ -3359,7 +3404,7 @@ ev_view_create_annotation_real (EvView *view,
 	case EV_ANNOTATION_TYPE_ATTACHMENT:
 		/* TODO */
 		g_object_unref (page);
-		ev_document_doc_mutex_unlock ();
+		ev_document_unlock (view->document);
 		return;
 	default:
 		g_assert_not_reached ();
@@ -3386,7 +3431,7 @@ ev_view_create_annotation_real (EvView *view,
 						annot, &doc_rect);
 	/* Re-fetch area as eg. adding Text Markup annots updates area for its bounding box */
 	ev_annotation_get_area (annot, &doc_rect);
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (view->document);
 
 	/* If the page didn't have annots, mark the cache as dirty */
 	if (!ev_page_cache_get_annot_mapping (view->page_cache, annot_page))
@@ -3502,10 +3547,10 @@ ev_view_remove_annotation (EvView       *view,
 
         _ev_view_set_focused_element (view, NULL, -1);
 
-        ev_document_doc_mutex_lock ();
+        ev_document_lock (view->document);
         ev_document_annotations_remove_annotation (EV_DOCUMENT_ANNOTATIONS (view->document),
                                                    annot);
-        ev_document_doc_mutex_unlock ();
+        ev_document_unlock (view->document);
 
         ev_page_cache_mark_dirty (view->page_cache, page, EV_PAGE_DATA_INCLUDE_ANNOTS);
 
@@ -5209,10 +5254,10 @@ ev_view_drag_data_get (GtkWidget        *widget,
 			if (view->image_dnd_info.image) {
 				GdkPixbuf *pixbuf;
 
-				ev_document_doc_mutex_lock ();
+				ev_document_lock (view->document);
 				pixbuf = ev_document_images_get_image (EV_DOCUMENT_IMAGES (view->document),
 								       view->image_dnd_info.image);
-				ev_document_doc_mutex_unlock ();
+				ev_document_unlock (view->document);
 				
 				gtk_selection_data_set_pixbuf (selection_data, pixbuf);
 				g_object_unref (pixbuf);
@@ -5224,10 +5269,10 @@ ev_view_drag_data_get (GtkWidget        *widget,
 				const gchar *tmp_uri;
 				gchar       *uris[2];
 
-				ev_document_doc_mutex_lock ();
+				ev_document_lock (view->document);
 				pixbuf = ev_document_images_get_image (EV_DOCUMENT_IMAGES (view->document),
 								       view->image_dnd_info.image);
-				ev_document_doc_mutex_unlock ();
+				ev_document_unlock (view->document);
 				
 				tmp_uri = ev_image_save_tmp (view->image_dnd_info.image, pixbuf);
 				g_object_unref (pixbuf);
@@ -5497,13 +5542,13 @@ ev_view_motion_notify_event (GtkWidget      *widget,
 
 			/* Take the mutex before set_area, because the notify signal
 			 * updates the mappings in the backend */
-			ev_document_doc_mutex_lock ();
+			ev_document_lock (view->document);
 			if (ev_annotation_set_area (view->adding_annot_info.annot, &rect)) {
 				ev_document_annotations_save_annotation (EV_DOCUMENT_ANNOTATIONS (view->document),
 									 view->adding_annot_info.annot,
 									 EV_ANNOTATIONS_SAVE_AREA);
 			}
-			ev_document_doc_mutex_unlock ();
+			ev_document_unlock (view->document);
 
 
 			/* FIXME: reload only annotation area */
@@ -5561,13 +5606,13 @@ ev_view_motion_notify_event (GtkWidget      *widget,
 
 			/* Take the mutex before set_area, because the notify signal
 			 * updates the mappings in the backend */
-			ev_document_doc_mutex_lock ();
+			ev_document_lock (view->document);
 			if (ev_annotation_set_area (view->moving_annot_info.annot, &rect)) {
 				ev_document_annotations_save_annotation (EV_DOCUMENT_ANNOTATIONS (view->document),
 									 view->moving_annot_info.annot,
 									 EV_ANNOTATIONS_SAVE_AREA);
 			}
-			ev_document_doc_mutex_unlock ();
+			ev_document_unlock (view->document);
 
 			/* FIXME: reload only annotation area */
 			ev_view_reload_page (view, annot_page, NULL);
@@ -5822,10 +5867,10 @@ ev_view_button_release_event (GtkWidget      *widget,
 				/* Do not create empty annots */
 				annot_added = FALSE;
 
-				ev_document_doc_mutex_lock ();
+				ev_document_lock (view->document);
 				ev_document_annotations_remove_annotation (EV_DOCUMENT_ANNOTATIONS (view->document),
 									   view->adding_annot_info.annot);
-				ev_document_doc_mutex_unlock ();
+				ev_document_unlock (view->document);
 
 				ev_page_cache_mark_dirty (view->page_cache,
 							  ev_annotation_get_page_index (view->adding_annot_info.annot),
@@ -5838,11 +5883,11 @@ ev_view_button_release_event (GtkWidget      *widget,
 
 				if (ev_annotation_markup_set_rectangle (EV_ANNOTATION_MARKUP (view->adding_annot_info.annot),
 									&popup_rect)) {
-					ev_document_doc_mutex_lock ();
+					ev_document_lock (view->document);
 					ev_document_annotations_save_annotation (EV_DOCUMENT_ANNOTATIONS (view->document),
 										 view->adding_annot_info.annot,
 										 EV_ANNOTATIONS_SAVE_POPUP_RECT);
-					ev_document_doc_mutex_unlock ();
+					ev_document_unlock (view->document);
 				}
 				/* the annotation window might already exist */
 				window = get_window_for_annot (view, view->adding_annot_info.annot);
@@ -6850,6 +6895,76 @@ draw_selection_region (cairo_t        *cr,
 	cairo_restore (cr);
 }
 
+/* Draws the tiles of @page covering @overlap, returns whether all of
+ * them were ready.
+ */
+static gboolean
+draw_page_tiles (EvView       *view,
+		 cairo_t      *cr,
+		 gint          page,
+		 GdkRectangle *page_area,
+		 GdkRectangle *overlap)
+{
+	gint     width, height;
+	gint     first_x, first_y, last_x, last_y;
+	gint     tile_x, tile_y;
+	gboolean tiles_ready = TRUE;
+	GdkRectangle viewport, visible;
+
+	ev_view_get_page_size (view, page, &width, &height);
+
+	/* The exposed area can be just a part of the viewport */
+	viewport.x = viewport.y = 0;
+	viewport.width = gtk_widget_get_allocated_width (GTK_WIDGET (view));
+	viewport.height = gtk_widget_get_allocated_height (GTK_WIDGET (view));
+	if (gdk_rectangle_intersect (page_area, &viewport, &visible)) {
+		ev_pixbuf_cache_set_visible_tiles (view->pixbuf_cache, page,
+						   (visible.x - page_area->x) / EV_PIXBUF_CACHE_TILE_SIZE,
+						   (visible.y - page_area->y) / EV_PIXBUF_CACHE_TILE_SIZE,
+						   (visible.x + visible.width - 1 - page_area->x) / EV_PIXBUF_CACHE_TILE_SIZE,
+						   (visible.y + visible.height - 1 - page_area->y) / EV_PIXBUF_CACHE_TILE_SIZE);
+	}
+
+	first_x = (overlap->x - page_area->x) / EV_PIXBUF_CACHE_TILE_SIZE;
+	first_y = (overlap->y - page_area->y) / EV_PIXBUF_CACHE_TILE_SIZE;
+	last_x = (overlap->x + overlap->width - 1 - page_area->x) / EV_PIXBUF_CACHE_TILE_SIZE;
+	last_y = (overlap->y + overlap->height - 1 - page_area->y) / EV_PIXBUF_CACHE_TILE_SIZE;
+
+	cairo_save (cr);
+	gdk_cairo_rectangle (cr, overlap);
+	cairo_clip (cr);
+
+	for (tile_y = first_y; tile_y <= last_y; tile_y++) {
+		for (tile_x = first_x; tile_x <= last_x; tile_x++) {
+			cairo_surface_t *tile_surface;
+			gint             x, y;
+
+			tile_surface = ev_pixbuf_cache_get_tile_surface (view->pixbuf_cache,
+									 page, tile_x, tile_y);
+			if (!tile_surface) {
+				tiles_ready = FALSE;
+				continue;
+			}
+
+			x = tile_x * EV_PIXBUF_CACHE_TILE_SIZE;
+			y = tile_y * EV_PIXBUF_CACHE_TILE_SIZE;
+			draw_surface (cr, tile_surface,
+				      page_area->x + x, page_area->y + y, 0, 0,
+				      MIN (EV_PIXBUF_CACHE_TILE_SIZE, width - x),
+				      MIN (EV_PIXBUF_CACHE_TILE_SIZE, height - y));
+		}
+	}
+
+	cairo_restore (cr);
+
+	/* Render the tiles around the exposed area before they are scrolled in */
+	ev_pixbuf_cache_preload_tiles (view->pixbuf_cache, page,
+				       first_x - 1, first_y - 1,
+				       last_x + 1, last_y + 1);
+
+	return tiles_ready;
+}
+
 static void
 draw_one_page (EvView       *view,
 	       gint          page,
@@ -6899,10 +7014,12 @@ draw_one_page (EvView       *view,
 		cairo_surface_t *selection_surface = NULL;
 		gint offset_x, offset_y;
 		cairo_region_t *region = NULL;
+		gboolean         tiled;
 
+		tiled = ev_pixbuf_cache_page_uses_tiles (view->pixbuf_cache, page);
 		page_surface = ev_pixbuf_cache_get_surface (view->pixbuf_cache, page);
 
-		if (!page_surface) {
+		if (!page_surface && !tiled) {
 			if (page == current_page)
 				ev_view_set_loading (view, TRUE);
 
@@ -6911,14 +7028,24 @@ draw_one_page (EvView       *view,
 			return;
 		}
 
-		if (page == current_page)
-			ev_view_set_loading (view, FALSE);
-
 		ev_view_get_page_size (view, page, &width, &height);
 		offset_x = overlap.x - real_page_area.x;
 		offset_y = overlap.y - real_page_area.y;
 
-		draw_surface (cr, page_surface, overlap.x, overlap.y, offset_x, offset_y, width, height);
+		/* For tiled pages, the surface rendered at a previous
+		 * scale is drawn until the tiles are ready */
+		if (page_surface)
+			draw_surface (cr, page_surface, overlap.x, overlap.y, offset_x, offset_y, width, height);
+
+		if (tiled) {
+			*page_ready = draw_page_tiles (view, cr, page, &real_page_area, &overlap);
+			if (page == current_page)
+				ev_view_set_loading (view, !*page_ready && !page_surface);
+			if (!*page_ready)
+				return;
+		} else if (page == current_page) {
+			ev_view_set_loading (view, FALSE);
+		}
 
 		/* Get the selection pixbuf iff we have something to draw */
 		if (!find_selection_for_page (view, page))
@@ -6937,19 +7064,22 @@ draw_one_page (EvView       *view,
 							       page,
 							       view->scale);
 		if (region) {
-			double scale_x, scale_y;
+			double scale_x = 1, scale_y = 1;
 			GdkRGBA color;
 			double device_scale_x = 1, device_scale_y = 1;
 
-			scale_x = (gdouble)width / cairo_image_surface_get_width (page_surface);
-			scale_y = (gdouble)height / cairo_image_surface_get_height (page_surface);
+			/* The region of tiled pages is at the current scale */
+			if (!tiled) {
+				scale_x = (gdouble)width / cairo_image_surface_get_width (page_surface);
+				scale_y = (gdouble)height / cairo_image_surface_get_height (page_surface);
 
 #ifdef HAVE_HIDPI_SUPPORT
-			cairo_surface_get_device_scale (page_surface, &device_scale_x, &device_scale_y);
+				cairo_surface_get_device_scale (page_surface, &device_scale_x, &device_scale_y);
 #endif
 
-			scale_x *= device_scale_x;
-			scale_y *= device_scale_y;
+				scale_x *= device_scale_x;
+				scale_y *= device_scale_y;
+			}
 
 			_ev_view_get_selection_colors (view, &color, NULL);
 			draw_selection_region (cr, region, &color, real_page_area.x, real_page_area.y,
@@ -7211,6 +7341,9 @@ view_update_scale_limits (EvView *view)
 	width = (rotation == 0 || rotation == 180) ? min_width : min_height;
 	height = (rotation == 0 || rotation == 180) ? min_height : min_width;
 	max_scale = sqrt (view->pixbuf_cache_size / (width * dpi * 4 * height * dpi));
+	/* Pages that don't fit in the cache are rendered in tiles */
+	if (ev_document_supports_render_area (view->document))
+		max_scale = MAX (max_scale, MAX_TILED_SCALE);
 
 	ev_document_model_set_min_scale (view->model, MIN_SCALE * dpi);
 	ev_document_model_set_max_scale (view->model, max_scale * dpi);
@@ -7924,6 +8057,19 @@ job_finished_cb (EvPixbufCache  *pixbuf_cache,
 	}
 }
 
+static void
+page_evicted_cb (EvPageCache *page_cache,
+		 gint         page,
+		 EvView      *view)
+{
+	/* The mappings of the page are about to be freed */
+	if (view->focused_element && view->focused_element_page == page)
+		_ev_view_set_focused_element (view, NULL, -1);
+
+	if (view->accessible)
+		ev_view_accessible_page_evicted (EV_VIEW_ACCESSIBLE (view->accessible), page);
+}
+
 static void
 ev_view_page_changed_cb (EvDocumentModel *model,
 			 gint             old_page,
@@ -8065,6 +8211,7 @@ setup_caches (EvView *view)
 	inverted_colors = ev_document_model_get_inverted_colors (view->model);
 	ev_pixbuf_cache_set_inverted_colors (view->pixbuf_cache, inverted_colors);
 	g_signal_connect (view->pixbuf_cache, "job-finished", G_CALLBACK (job_finished_cb), view);
+	g_signal_connect (view->page_cache, "page-evicted", G_CALLBACK (page_evicted_cb), view);
 }
 
 static void
@@ -8182,14 +8329,24 @@ ev_view_document_changed_cb (EvDocumentModel *model,
 	EvDocument *document = ev_document_model_get_document (model);
 
 	if (document != view->document) {
-		gint current_page;
+		EvDocument    *old_document = view->document;
+		EvPixbufCache *old_pixbuf_cache = NULL;
+		EvPageCache   *old_page_cache = NULL;
+		gint           current_page;
 
 		ev_view_remove_all (view);
-		clear_caches (view);
 
-		if (view->document) {
-			g_object_unref (view->document);
-                }
+		/* Keep what's cached for the pages that didn't change
+		 * when the document is reloaded */
+		if (view->pixbuf_cache) {
+			g_signal_handlers_disconnect_by_func (view->pixbuf_cache,
+							      G_CALLBACK (job_finished_cb),
+							      view);
+			old_pixbuf_cache = g_object_ref (view->pixbuf_cache);
+		}
+		if (view->page_cache)
+			old_page_cache = g_object_ref (view->page_cache);
+		clear_caches (view);
 
 		view->document = document ? g_object_ref (document) : NULL;
 		view->find_page = -1;
@@ -8197,16 +8354,29 @@ ev_view_document_changed_cb (EvDocumentModel *model,
 
 		if (view->document) {
 			if (ev_document_get_n_pages (view->document) <= 0 ||
-			    !ev_document_check_dimensions (view->document))
+			    !ev_document_check_dimensions (view->document)) {
+				g_clear_object (&old_pixbuf_cache);
+				g_clear_object (&old_page_cache);
+				g_clear_object (&old_document);
 				return;
+			}
 
 			ev_view_set_loading (view, FALSE);
 			setup_caches (view);
 
+			if (old_pixbuf_cache)
+				ev_pixbuf_cache_reuse_surfaces (view->pixbuf_cache, old_pixbuf_cache);
+			if (old_page_cache)
+				ev_page_cache_reuse_data (view->page_cache, old_page_cache);
+
 			if (view->caret_enabled)
 				preload_pages_for_caret_navigation (view);
 		}
 
+		g_clear_object (&old_pixbuf_cache);
+		g_clear_object (&old_page_cache);
+		g_clear_object (&old_document);
+
 		current_page = ev_document_model_get_page (model);
 		if (view->current_page != current_page) {
 			ev_view_change_page (view, current_page);
@@ -8370,6 +8540,35 @@ ev_view_continuous_changed_cb (EvDocumentModel *model,
 	gtk_widget_queue_resize (GTK_WIDGET (view));
 }
 
+static void
+ev_view_page_sizes_changed_cb (EvDocumentModel *model,
+			       gint             first_page,
+			       gint             n_pages,
+			       EvView          *view)
+{
+	GdkPoint     view_point;
+	GdkRectangle page_area;
+	GtkBorder    border;
+
+	if (!view->document || !view->height_to_page_cache)
+		return;
+
+	/* Keep the same point of the current page visible while the
+	 * pages above it change their size */
+	view_point.x = view->scroll_x;
+	view_point.y = view->scroll_y;
+	ev_view_get_page_extents (view, view->current_page, &page_area, &border);
+	_ev_view_transform_view_point_to_doc_point (view, &view_point,
+						    &page_area, &border,
+						    &view->pending_point.x,
+						    &view->pending_point.y);
+
+	ev_view_build_height_to_page_cache (view, view->height_to_page_cache);
+
+	view->pending_scroll = SCROLL_TO_PAGE_POSITION;
+	gtk_widget_queue_resize (GTK_WIDGET (view));
+}
+
 static void
 ev_view_dual_odd_left_changed_cb (EvDocumentModel *model,
 				  GParamSpec      *pspec,
@@ -8452,6 +8651,9 @@ ev_view_set_model (EvView          *view,
 	g_signal_connect (view->model, "page-changed",
 			  G_CALLBACK (ev_view_page_changed_cb),
 			  view);
+	g_signal_connect (view->model, "page-sizes-changed",
+			  G_CALLBACK (ev_view_page_sizes_changed_cb),
+			  view);
 
 	if (view->accessible)
 		ev_view_accessible_set_model (EV_VIEW_ACCESSIBLE (view->accessible),
@@ -9455,7 +9657,7 @@ get_selected_text (EvView *view)
 
 	text = g_string_new (NULL);
 
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (view->document);
 
 	for (l = view->selection_info.selections; l != NULL; l = l->next) {
 		EvViewSelection *selection = (EvViewSelection *)l->data;
@@ -9471,7 +9673,7 @@ get_selected_text (EvView *view)
 		g_free (tmp);
 	}
 
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (view->document);
 	
 	normalized_text = g_utf8_normalize (text->str, text->len, G_NORMALIZE_NFKC);
 	g_string_free (text, TRUE);
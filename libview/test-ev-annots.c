@@ -0,0 +1,381 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "ev-init.h"
+#include "ev-jobs.h"
+#include "ev-job-scheduler.h"
+
+#define DEFAULT_N_PAGES  2000
+#define ANNOTATED_EVERY  20
+#define START_PAGE       500
+#define SCAN_TIME        1000        /* microseconds per page */
+#define RENDER_TIME      (5 * 1000)  /* microseconds */
+#define RENDER_INTERVAL  50          /* milliseconds */
+/* A render waits at most for a batch of pages to be scanned, well
+ * below the time the whole scan takes, with room for a loaded machine */
+#define MAX_LATENCY      (100 * 1000) /* microseconds */
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Checks the annotations job and times rendering while it runs\n");
+	g_print ("Usage: %s [N_PAGES]\n", prog);
+	g_print ("Scans a document of N_PAGES pages (default %d) taking %d ms per page\n"
+		 "for its annotations, while a page is rendered every %d ms, and reports\n"
+		 "the render latency when the document is locked for the whole scan and\n"
+		 "when it's locked by batches of pages, which must stay under %d ms\n",
+		 DEFAULT_N_PAGES, SCAN_TIME / 1000, RENDER_INTERVAL, MAX_LATENCY / 1000);
+}
+
+/* A document with an annotation every ANNOTATED_EVERY pages */
+typedef struct {
+	EvDocument parent;
+
+	gint n_pages;
+} TestDocument;
+
+typedef EvDocumentClass TestDocumentClass;
+
+static GType test_document_get_type (void);
+static void  test_document_annotations_iface_init (EvDocumentAnnotationsInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (TestDocument, test_document, EV_TYPE_DOCUMENT,
+			 G_IMPLEMENT_INTERFACE (EV_TYPE_DOCUMENT_ANNOTATIONS,
+						test_document_annotations_iface_init))
+
+static gboolean
+test_document_load_stream (EvDocument         *document,
+			   GInputStream       *stream,
+			   EvDocumentLoadFlags flags,
+			   GCancellable       *cancellable,
+			   GError            **error)
+{
+	return TRUE;
+}
+
+static gint
+test_document_get_n_pages (EvDocument *document)
+{
+	return ((TestDocument *) document)->n_pages;
+}
+
+static void
+test_document_get_page_size (EvDocument *document,
+			     EvPage     *page,
+			     double     *width,
+			     double     *height)
+{
+	*width = 595;
+	*height = 842;
+}
+
+static cairo_surface_t *
+test_document_render (EvDocument      *document,
+		      EvRenderContext *rc)
+{
+	g_usleep (RENDER_TIME);
+
+	return cairo_image_surface_create (CAIRO_FORMAT_RGB24, 60, 84);
+}
+
+static void
+test_document_init (TestDocument *document)
+{
+}
+
+static void
+test_document_class_init (TestDocumentClass *klass)
+{
+	klass->load_stream = test_document_load_stream;
+	klass->get_n_pages = test_document_get_n_pages;
+	klass->get_page_size = test_document_get_page_size;
+	klass->render = test_document_render;
+}
+
+static EvMappingList *
+test_document_annotations_get_annotations (EvDocumentAnnotations *document_annots,
+					   EvPage                *page)
+{
+	EvMapping *mapping;
+
+	g_usleep (SCAN_TIME);
+
+	if (page->index % ANNOTATED_EVERY != 0)
+		return NULL;
+
+	mapping = g_new (EvMapping, 1);
+	mapping->area.x1 = mapping->area.y1 = 10;
+	mapping->area.x2 = mapping->area.y2 = 34;
+	mapping->data = ev_annotation_text_new (page);
+
+	return ev_mapping_list_new (page->index, g_list_prepend (NULL, mapping),
+				    (GDestroyNotify) g_object_unref);
+}
+
+static void
+test_document_annotations_iface_init (EvDocumentAnnotationsInterface *iface)
+{
+	iface->get_annotations = test_document_annotations_get_annotations;
+}
+
+static EvDocument *
+test_document_new (gint n_pages)
+{
+	TestDocument *document;
+	GInputStream *stream;
+
+	document = g_object_new (test_document_get_type (), NULL);
+	document->n_pages = n_pages;
+
+	stream = g_memory_input_stream_new ();
+	ev_document_load_stream (EV_DOCUMENT (document), stream,
+				 EV_DOCUMENT_LOAD_FLAG_NONE, NULL, NULL);
+	g_object_unref (stream);
+
+	return EV_DOCUMENT (document);
+}
+
+typedef struct {
+	EvDocument *document;
+	gint        scanning;
+	gint        first_page;
+	gint        n_updated;
+	gboolean    ordered;
+
+	GArray     *latencies; /* gint64 microseconds */
+	gint        n_renders;
+	guint       render_id;
+} Bench;
+
+/* How annotations were scanned before: the whole document locked */
+static gpointer
+locked_scan_thread (Bench *bench)
+{
+	gint i;
+
+	ev_document_lock (bench->document);
+	for (i = 0; i < ev_document_get_n_pages (bench->document); i++) {
+		EvMappingList *mapping_list;
+		EvPage        *page;
+
+		page = ev_document_get_page (bench->document, i);
+		mapping_list = ev_document_annotations_get_annotations (EV_DOCUMENT_ANNOTATIONS (bench->document),
+									page);
+		g_object_unref (page);
+		if (mapping_list)
+			ev_mapping_list_unref (mapping_list);
+	}
+	ev_document_unlock (bench->document);
+
+	g_atomic_int_set (&bench->scanning, FALSE);
+	g_main_context_wakeup (NULL);
+
+	return NULL;
+}
+
+static void
+annots_updated_cb (EvJobAnnots   *job,
+		   EvMappingList *mapping_list,
+		   Bench         *bench)
+{
+	if (bench->n_updated++ == 0)
+		bench->first_page = ev_mapping_list_get_page (mapping_list);
+}
+
+static void
+annots_finished_cb (EvJob *job,
+		    Bench *bench)
+{
+	GList *l;
+	gint   n_annots = 0;
+	gint   last_page = -1;
+
+	for (l = EV_JOB_ANNOTS (job)->annots; l; l = g_list_next (l)) {
+		gint page = ev_mapping_list_get_page (l->data);
+
+		if (page <= last_page)
+			bench->ordered = FALSE;
+		last_page = page;
+		n_annots++;
+	}
+
+	if (n_annots != bench->n_updated)
+		bench->ordered = FALSE;
+
+	g_atomic_int_set (&bench->scanning, FALSE);
+}
+
+static void
+render_finished_cb (EvJob *job,
+		    Bench *bench)
+{
+	gint64 *pushed = g_object_get_data (G_OBJECT (job), "pushed");
+	gint64  latency = g_get_monotonic_time () - *pushed;
+
+	g_array_append_val (bench->latencies, latency);
+	g_object_unref (job);
+}
+
+static gboolean
+push_render_job (Bench *bench)
+{
+	EvJob  *job;
+	gint64 *pushed;
+
+	job = ev_job_render_new (bench->document, bench->n_renders++ % 10, 0, 0.1, 60, 84);
+	pushed = g_new (gint64, 1);
+	*pushed = g_get_monotonic_time ();
+	g_object_set_data_full (G_OBJECT (job), "pushed", pushed, g_free);
+	g_signal_connect (job, "finished",
+			  G_CALLBACK (render_finished_cb), bench);
+	ev_job_scheduler_push_job (job, EV_JOB_PRIORITY_URGENT);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gint
+compare_latencies (gconstpointer a,
+		   gconstpointer b)
+{
+	gint64 la = *(const gint64 *) a;
+	gint64 lb = *(const gint64 *) b;
+
+	return la < lb ? -1 : la > lb;
+}
+
+static gboolean
+time_scan (gint     n_pages,
+	   gboolean batched)
+{
+	Bench    bench = { NULL, };
+	GThread *thread = NULL;
+	EvJob   *job = NULL;
+	GTimer  *timer;
+	gdouble  elapsed;
+	gint64   median, max;
+	gboolean retval = TRUE;
+
+	bench.document = test_document_new (n_pages);
+	bench.latencies = g_array_new (FALSE, FALSE, sizeof (gint64));
+	bench.scanning = TRUE;
+	bench.ordered = TRUE;
+
+	timer = g_timer_new ();
+	if (batched) {
+		job = ev_job_annots_new (bench.document);
+		ev_job_annots_set_start_page (EV_JOB_ANNOTS (job), START_PAGE % n_pages);
+		g_signal_connect (job, "updated",
+				  G_CALLBACK (annots_updated_cb), &bench);
+		g_signal_connect (job, "finished",
+				  G_CALLBACK (annots_finished_cb), &bench);
+		ev_job_scheduler_push_job (job, EV_JOB_PRIORITY_NONE);
+	} else {
+		thread = g_thread_new ("locked-scan", (GThreadFunc) locked_scan_thread, &bench);
+	}
+
+	bench.render_id = g_timeout_add (RENDER_INTERVAL, (GSourceFunc) push_render_job, &bench);
+	while (g_atomic_int_get (&bench.scanning))
+		g_main_context_iteration (NULL, TRUE);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_source_remove (bench.render_id);
+
+	/* The renders still pending */
+	while (bench.latencies->len < (guint) bench.n_renders)
+		g_main_context_iteration (NULL, TRUE);
+
+	if (thread)
+		g_thread_join (thread);
+	if (job)
+		g_object_unref (job);
+
+	if (bench.latencies->len > 0) {
+		g_array_sort (bench.latencies, compare_latencies);
+		median = g_array_index (bench.latencies, gint64, bench.latencies->len / 2);
+		max = g_array_index (bench.latencies, gint64, bench.latencies->len - 1);
+	} else {
+		median = max = 0;
+	}
+
+	g_print ("%s\t\t%.2f\t\t%u\t%.1f\t\t%.1f\n",
+		 batched ? "batched" : "locked",
+		 elapsed, bench.latencies->len, median / 1000., max / 1000.);
+
+	if (batched) {
+		if (bench.n_updated != (n_pages + ANNOTATED_EVERY - 1) / ANNOTATED_EVERY) {
+			g_print ("%d pages with annotations reported, %d expected\n",
+				 bench.n_updated, (n_pages + ANNOTATED_EVERY - 1) / ANNOTATED_EVERY);
+			retval = FALSE;
+		}
+		if (bench.first_page != ((START_PAGE % n_pages + ANNOTATED_EVERY - 1) / ANNOTATED_EVERY * ANNOTATED_EVERY) % n_pages) {
+			g_print ("Page %d reported first, the start page was %d\n",
+				 bench.first_page, START_PAGE % n_pages);
+			retval = FALSE;
+		}
+		if (!bench.ordered) {
+			g_print ("The annotations are not in page order\n");
+			retval = FALSE;
+		}
+		if (bench.latencies->len == 0 || max > MAX_LATENCY) {
+			g_print ("Renders waited up to %.1f ms for the scan, %d ms allowed\n",
+				 max / 1000., MAX_LATENCY / 1000);
+			retval = FALSE;
+		}
+	}
+
+	g_array_free (bench.latencies, TRUE);
+	g_timer_destroy (timer);
+	g_object_unref (bench.document);
+
+	return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+	gint n_pages = DEFAULT_N_PAGES;
+	int  retval = 0;
+
+	if (argc > 2) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (argc > 1)
+		n_pages = MAX (atoi (argv[1]), 1);
+
+	if (!ev_init ()) {
+		g_warning ("Failed to initialize evince");
+		return 1;
+	}
+
+	g_print ("SCAN\t\tTIME (s)\tRENDERS\tMEDIAN (ms)\tMAX (ms)\n");
+
+	if (!time_scan (n_pages, FALSE))
+		retval = 1;
+	if (!time_scan (n_pages, TRUE))
+		retval = 1;
+
+	ev_shutdown ();
+
+	return retval;
+}
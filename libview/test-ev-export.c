@@ -0,0 +1,248 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "ev-init.h"
+#include "ev-document-factory.h"
+#include "ev-jobs.h"
+#include "ev-job-scheduler.h"
+
+#define RENDER_AHEAD 8
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Times exporting documents to PDF and PostScript\n");
+	g_print ("Usage: %s FILE...\n", prog);
+	g_print ("Exports every page of each document like printing does, one page\n"
+		 "after the other and with up to %d pages rendered ahead by the job\n"
+		 "scheduler, and reports the pages exported per second\n", RENDER_AHEAD);
+}
+
+static void
+export_begin (EvDocument          *document,
+	      EvFileExporterFormat format,
+	      const gchar         *filename)
+{
+	EvFileExporterContext fc;
+	gdouble               width, height;
+
+	ev_document_get_page_size (document, 0, &width, &height);
+
+	fc.format = format;
+	fc.filename = filename;
+	fc.first_page = 0;
+	fc.last_page = ev_document_get_n_pages (document) - 1;
+	fc.paper_width = width;
+	fc.paper_height = height;
+	fc.duplex = FALSE;
+	fc.pages_per_sheet = 1;
+
+	ev_document_lock (document);
+	ev_file_exporter_begin (EV_FILE_EXPORTER (document), &fc);
+	ev_document_unlock (document);
+}
+
+static void
+export_end (EvDocument *document)
+{
+	ev_document_lock (document);
+	ev_file_exporter_end (EV_FILE_EXPORTER (document));
+	ev_document_unlock (document);
+}
+
+/* What EvJobExport does for every page */
+static void
+export_serial (EvDocument *document)
+{
+	EvFileExporter *exporter = EV_FILE_EXPORTER (document);
+	gint            n_pages = ev_document_get_n_pages (document);
+	gint            i;
+
+	for (i = 0; i < n_pages; i++) {
+		EvPage          *page;
+		EvRenderContext *rc;
+
+		ev_document_lock (document);
+		page = ev_document_get_page (document, i);
+		rc = ev_render_context_new (page, 0, 1.0);
+		g_object_unref (page);
+
+		ev_file_exporter_begin_page (exporter);
+		ev_file_exporter_do_page (exporter, rc);
+		ev_file_exporter_end_page (exporter);
+		ev_document_unlock (document);
+
+		g_object_unref (rc);
+	}
+}
+
+/* What EvPrintOperationExport does when the pages can be rendered ahead */
+static void
+export_pipelined (EvDocument *document)
+{
+	EvFileExporter *exporter = EV_FILE_EXPORTER (document);
+	gint            n_pages = ev_document_get_n_pages (document);
+	EvJob         **jobs;
+	gint            i, next = 0;
+
+	jobs = g_new0 (EvJob *, n_pages);
+
+	for (i = 0; i < n_pages; i++) {
+		EvPage          *page;
+		EvRenderContext *rc;
+
+		for (; next < n_pages && next < i + RENDER_AHEAD; next++) {
+			jobs[next] = ev_job_export_render_new (document, next);
+			ev_job_scheduler_push_job (jobs[next], EV_JOB_PRIORITY_NONE);
+		}
+
+		while (!ev_job_is_finished (jobs[i]))
+			g_main_context_iteration (NULL, TRUE);
+
+		ev_document_render_lock (document);
+		page = ev_document_get_page (document, i);
+		rc = ev_render_context_new (page, 0, 1.0);
+		g_object_unref (page);
+
+		ev_file_exporter_begin_page (exporter);
+		if (EV_JOB_EXPORT_RENDER (jobs[i])->surface)
+			ev_file_exporter_do_rendered_page (exporter, rc, EV_JOB_EXPORT_RENDER (jobs[i])->surface);
+		else
+			ev_file_exporter_do_page (exporter, rc);
+		ev_file_exporter_end_page (exporter);
+		ev_document_render_unlock (document);
+
+		g_object_unref (rc);
+		g_clear_object (&jobs[i]);
+	}
+
+	g_free (jobs);
+}
+
+static gdouble
+time_export (EvDocument          *document,
+	     EvFileExporterFormat format,
+	     gboolean             pipelined)
+{
+	GTimer *timer;
+	gchar  *filename;
+	gdouble elapsed;
+	gint    fd;
+
+	fd = g_file_open_tmp ("test-ev-export-XXXXXX", &filename, NULL);
+	if (fd == -1)
+		return 0;
+	close (fd);
+
+	timer = g_timer_new ();
+	export_begin (document, format, filename);
+	if (pipelined)
+		export_pipelined (document);
+	else
+		export_serial (document);
+	export_end (document);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	g_unlink (filename);
+	g_free (filename);
+
+	return ev_document_get_n_pages (document) / elapsed;
+}
+
+int
+main (int argc, char **argv)
+{
+	gint i;
+
+	if (argc < 2) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (!ev_init ()) {
+		g_warning ("Failed to initialize evince");
+		return 1;
+	}
+
+	g_print ("FORMAT\tMODE\t\tPAGES/S\tFILE\n");
+	for (i = 1; i < argc; i++) {
+		EvDocument                *document;
+		EvFileExporterCapabilities capabilities;
+		GFile                     *file;
+		gchar                     *uri;
+		GError                    *error = NULL;
+		gboolean                   can_pipeline;
+		guint                      j;
+		struct {
+			const gchar         *name;
+			EvFileExporterFormat format;
+			guint                capability;
+		} formats[] = {
+			{ "PDF", EV_FILE_FORMAT_PDF, EV_FILE_EXPORTER_CAN_GENERATE_PDF },
+			{ "PS",  EV_FILE_FORMAT_PS,  EV_FILE_EXPORTER_CAN_GENERATE_PS }
+		};
+
+		file = g_file_new_for_commandline_arg (argv[i]);
+		uri = g_file_get_uri (file);
+		g_object_unref (file);
+
+		document = ev_document_factory_get_document (uri, &error);
+		g_free (uri);
+		if (!document) {
+			g_print ("%s: %s\n", argv[i], error->message);
+			g_error_free (error);
+			continue;
+		}
+
+		if (!EV_IS_FILE_EXPORTER (document) || ev_document_get_n_pages (document) == 0) {
+			g_print ("%s: can't be exported\n", argv[i]);
+			g_object_unref (document);
+			continue;
+		}
+
+		capabilities = ev_file_exporter_get_capabilities (EV_FILE_EXPORTER (document));
+		can_pipeline = ev_document_is_thread_safe (document) &&
+			ev_file_exporter_can_render_pages (EV_FILE_EXPORTER (document));
+
+		for (j = 0; j < G_N_ELEMENTS (formats); j++) {
+			if (!(capabilities & formats[j].capability))
+				continue;
+
+			g_print ("%s\tserial\t\t%.1f\t%s\n", formats[j].name,
+				 time_export (document, formats[j].format, FALSE), argv[i]);
+			if (can_pipeline) {
+				g_print ("%s\tpipelined\t%.1f\t%s\n", formats[j].name,
+					 time_export (document, formats[j].format, TRUE), argv[i]);
+			}
+		}
+
+		g_object_unref (document);
+	}
+
+	ev_shutdown ();
+
+	return 0;
+}
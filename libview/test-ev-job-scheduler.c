@@ -0,0 +1,169 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "ev-init.h"
+#include "ev-document-factory.h"
+#include "ev-jobs.h"
+#include "ev-job-scheduler.h"
+
+typedef struct {
+	GMainLoop *loop;
+	gint       n_pending;
+	gint       n_failed;
+} RenderBench;
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Renders every page of a document with a varying number of scheduler threads\n");
+	g_print ("Usage: %s filename [scale] [n-threads...]\n", prog);
+	g_print ("Reports the pages rendered per second for each number of threads\n");
+}
+
+static void
+render_job_finished (EvJob       *job,
+		     RenderBench *bench)
+{
+	if (ev_job_is_failed (job))
+		bench->n_failed++;
+
+	g_object_unref (job);
+
+	if (--bench->n_pending == 0)
+		g_main_loop_quit (bench->loop);
+}
+
+static gdouble
+render_document (EvDocument *document,
+		 gdouble     scale,
+		 guint       n_threads)
+{
+	RenderBench bench;
+	GTimer     *timer;
+	gdouble     elapsed;
+	gint        n_pages, i;
+
+	ev_job_scheduler_set_n_threads (n_threads);
+
+	n_pages = ev_document_get_n_pages (document);
+
+	bench.loop = g_main_loop_new (NULL, FALSE);
+	bench.n_pending = n_pages;
+	bench.n_failed = 0;
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < n_pages; i++) {
+		EvJob *job;
+
+		job = ev_job_render_new (document, i, 0, scale, -1, -1);
+		g_signal_connect (job, "finished",
+				  G_CALLBACK (render_job_finished),
+				  &bench);
+		ev_job_scheduler_push_job (job, EV_JOB_PRIORITY_URGENT);
+	}
+
+	if (n_pages > 0)
+		g_main_loop_run (bench.loop);
+
+	g_timer_stop (timer);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+	g_main_loop_unref (bench.loop);
+
+	if (bench.n_failed > 0)
+		g_warning ("%d pages failed to render", bench.n_failed);
+
+	return elapsed;
+}
+
+int
+main (int argc, char **argv)
+{
+	EvDocument *document;
+	GFile      *file;
+	gchar      *uri;
+	GError     *error = NULL;
+	gdouble     scale = 1.0;
+	guint       default_threads[] = { 1, 2, 4, 8 };
+	GArray     *threads;
+	gint        i;
+
+	if (argc < 2) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (!ev_init ()) {
+		g_warning ("No backends found");
+		return 1;
+	}
+
+	if (argc > 2)
+		scale = g_ascii_strtod (argv[2], NULL);
+	if (scale <= 0.0)
+		scale = 1.0;
+
+	threads = g_array_new (FALSE, FALSE, sizeof (guint));
+	for (i = 3; i < argc; i++) {
+		guint n_threads = atoi (argv[i]);
+
+		if (n_threads > 0)
+			g_array_append_val (threads, n_threads);
+	}
+	if (threads->len == 0)
+		g_array_append_vals (threads, default_threads, G_N_ELEMENTS (default_threads));
+
+	file = g_file_new_for_commandline_arg (argv[1]);
+	uri = g_file_get_uri (file);
+	g_object_unref (file);
+
+	document = ev_document_factory_get_document (uri, &error);
+	g_free (uri);
+	if (!document) {
+		g_warning ("Failed to load '%s': %s", argv[1], error->message);
+		g_error_free (error);
+		ev_shutdown ();
+		return 1;
+	}
+
+	g_print ("%d pages, scale %.2f, %s backend\n",
+		 ev_document_get_n_pages (document), scale,
+		 ev_document_is_thread_safe (document) ? "thread-safe" : "serialized");
+	g_print ("THREADS\tSECONDS\tPAGES/S\n");
+
+	for (i = 0; i < threads->len; i++) {
+		guint   n_threads = g_array_index (threads, guint, i);
+		gdouble elapsed;
+
+		elapsed = render_document (document, scale, n_threads);
+		g_print ("%u\t%.3f\t%.2f\n", n_threads, elapsed,
+			 elapsed > 0 ? ev_document_get_n_pages (document) / elapsed : 0);
+	}
+
+	g_array_free (threads, TRUE);
+	g_object_unref (document);
+	ev_shutdown ();
+
+	return 0;
+}
@@ -0,0 +1,238 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include "ev-init.h"
+#include "ev-jobs.h"
+#include "ev-job-scheduler.h"
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Checks the outline page index and times showing the outline\n");
+	g_print ("Usage: %s FILE\n", prog);
+	g_print ("Runs the links job for FILE, with the page sizes asked to the backend\n"
+		 "and with the page sizes cached, and reports the time the job takes,\n"
+		 "the time the sidebar used to take walking the whole outline in the\n"
+		 "main thread before showing it, and the time to find the outline row\n"
+		 "of every page with the job index and with the tree it replaces\n");
+}
+
+typedef struct {
+	EvDocument *document;
+	GTree      *page_link_tree;
+	gint        n_rows;
+} Walk;
+
+static gint
+page_link_tree_sort (gconstpointer a,
+		     gconstpointer b,
+		     gpointer      data)
+{
+	return GPOINTER_TO_INT (a) - GPOINTER_TO_INT (b);
+}
+
+/* What the sidebar did in the main thread for every row */
+static gboolean
+update_page_link_tree_foreach (GtkTreeModel *model,
+			       GtkTreePath  *path,
+			       GtkTreeIter  *iter,
+			       Walk         *walk)
+{
+	EvLink *link;
+	gint    page;
+
+	walk->n_rows++;
+	gtk_tree_model_get (model, iter,
+			    EV_DOCUMENT_LINKS_COLUMN_LINK, &link,
+			    -1);
+	if (!link)
+		return FALSE;
+
+	page = ev_document_links_get_link_page (EV_DOCUMENT_LINKS (walk->document), link);
+	g_object_unref (link);
+
+	if (page >= 0 && !g_tree_lookup (walk->page_link_tree, GINT_TO_POINTER (page)))
+		g_tree_insert (walk->page_link_tree, GINT_TO_POINTER (page), gtk_tree_path_copy (path));
+
+	return FALSE;
+}
+
+typedef struct {
+	gint page;
+	gint best_existing;
+} PageSearch;
+
+static gint
+page_link_tree_search_best_page (gpointer    page_ptr,
+				 PageSearch *data)
+{
+	gint page = GPOINTER_TO_INT (page_ptr);
+
+	if (page <= data->page && page > data->best_existing)
+		data->best_existing = page;
+
+	return data->page - page;
+}
+
+static GtkTreePath *
+page_link_tree_get_path (GTree *page_link_tree,
+			 gint   page)
+{
+	GtkTreePath *path;
+	PageSearch   search_data;
+
+	search_data.page = page;
+	search_data.best_existing = G_MININT;
+
+	path = g_tree_search (page_link_tree, (GCompareFunc) page_link_tree_search_best_page, &search_data);
+	if (!path)
+		path = g_tree_lookup (page_link_tree, GINT_TO_POINTER (search_data.best_existing));
+
+	return path;
+}
+
+static void
+job_finished_cb (EvJob    *job,
+		 gboolean *finished)
+{
+	*finished = TRUE;
+}
+
+static gboolean
+time_outline (const gchar        *uri,
+	      EvDocumentLoadFlags flags)
+{
+	EvDocument *document;
+	EvJob      *job;
+	Walk        walk;
+	GTimer     *timer;
+	GError     *error = NULL;
+	gdouble     job_time, walk_time, index_time, tree_time;
+	gboolean    finished = FALSE;
+	gboolean    retval = TRUE;
+	gint        n_pages, i;
+
+	document = ev_document_factory_get_document_full (uri, flags, &error);
+	if (!document) {
+		g_print ("Failed to load the document: %s\n", error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	if (!EV_IS_DOCUMENT_LINKS (document) ||
+	    !ev_document_links_has_document_links (EV_DOCUMENT_LINKS (document))) {
+		g_print ("The document has no outline\n");
+		g_object_unref (document);
+		return FALSE;
+	}
+
+	timer = g_timer_new ();
+
+	job = ev_job_links_new (document);
+	g_signal_connect (job, "finished",
+			  G_CALLBACK (job_finished_cb), &finished);
+	ev_job_scheduler_push_job (job, EV_JOB_PRIORITY_NONE);
+	while (!finished)
+		g_main_context_iteration (NULL, TRUE);
+	job_time = g_timer_elapsed (timer, NULL);
+
+	walk.document = document;
+	walk.n_rows = 0;
+	walk.page_link_tree = g_tree_new_full (page_link_tree_sort, NULL, NULL,
+					       (GDestroyNotify) gtk_tree_path_free);
+	g_timer_start (timer);
+	gtk_tree_model_foreach (EV_JOB_LINKS (job)->model,
+				(GtkTreeModelForeachFunc) update_page_link_tree_foreach,
+				&walk);
+	walk_time = g_timer_elapsed (timer, NULL);
+
+	n_pages = ev_document_get_n_pages (document);
+	g_timer_start (timer);
+	for (i = 0; i < n_pages; i++)
+		gtk_tree_path_free (ev_job_links_get_page_path (EV_JOB_LINKS (job), i));
+	index_time = g_timer_elapsed (timer, NULL);
+
+	g_timer_start (timer);
+	for (i = 0; i < n_pages; i++)
+		page_link_tree_get_path (walk.page_link_tree, i);
+	tree_time = g_timer_elapsed (timer, NULL);
+
+	/* Both find the same row for every page */
+	for (i = 0; i < n_pages && retval; i++) {
+		GtkTreePath *path, *expected;
+
+		path = ev_job_links_get_page_path (EV_JOB_LINKS (job), i);
+		expected = page_link_tree_get_path (walk.page_link_tree, i);
+		if ((path == NULL) != (expected == NULL) ||
+		    (path && gtk_tree_path_compare (path, expected) != 0)) {
+			g_print ("Wrong outline row for page %d\n", i);
+			retval = FALSE;
+		}
+		if (path)
+			gtk_tree_path_free (path);
+	}
+
+	g_print ("%s\t\t%d\t%.3f\t\t%.3f\t\t%.3f\t\t%.3f\n",
+		 flags & EV_DOCUMENT_LOAD_FLAG_NO_CACHE ? "backend" : "cache",
+		 walk.n_rows, job_time, walk_time,
+		 index_time * 1000, tree_time * 1000);
+
+	g_tree_unref (walk.page_link_tree);
+	g_timer_destroy (timer);
+	g_object_unref (job);
+	g_object_unref (document);
+
+	return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+	GFile *file;
+	gchar *uri;
+	int    retval = 0;
+
+	if (argc != 2) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (!ev_init ()) {
+		g_warning ("No backends found");
+		return 1;
+	}
+
+	file = g_file_new_for_commandline_arg (argv[1]);
+	uri = g_file_get_uri (file);
+	g_object_unref (file);
+
+	g_print ("PAGE SIZES\tROWS\tJOB (s)\t\tWALK (s)\tINDEX (ms)\tTREE (ms)\n");
+
+	if (!time_outline (uri, EV_DOCUMENT_LOAD_FLAG_NO_CACHE))
+		retval = 1;
+	if (!time_outline (uri, EV_DOCUMENT_LOAD_FLAG_NONE))
+		retval = 1;
+
+	g_free (uri);
+	ev_shutdown ();
+
+	return retval;
+}
@@ -0,0 +1,163 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+
+#include "ev-init.h"
+#include "ev-document-factory.h"
+
+#define N_RUNS 3
+
+typedef struct {
+	gdouble load;
+	gdouble first_page;
+	gdouble page_sizes;
+} Times;
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Times opening a document with and without lazy page sizes\n");
+	g_print ("Usage: %s FILE...\n", prog);
+	g_print ("Reports the time to load each document, the time until its first page\n"
+		 "is rendered and the time until the sizes and labels of all its pages\n"
+		 "are known. The best of %d runs is reported\n", N_RUNS);
+}
+
+static void
+render_first_page (EvDocument *document)
+{
+	EvPage          *page;
+	EvRenderContext *rc;
+	cairo_surface_t *surface;
+
+	page = ev_document_get_page (document, 0);
+	rc = ev_render_context_new (page, 0, 1.0);
+	g_object_unref (page);
+
+	ev_document_lock (document);
+	surface = ev_document_render (document, rc);
+	ev_document_unlock (document);
+
+	if (surface)
+		cairo_surface_destroy (surface);
+	g_object_unref (rc);
+}
+
+static gboolean
+time_load (const gchar        *uri,
+	   EvDocumentLoadFlags flags,
+	   Times              *times)
+{
+	EvDocument *document;
+	GTimer     *timer;
+	GError     *error = NULL;
+
+	timer = g_timer_new ();
+
+	document = ev_document_factory_get_document_full (uri, flags, &error);
+	if (!document) {
+		g_print ("%s: %s\n", uri, error->message);
+		g_error_free (error);
+		g_timer_destroy (timer);
+
+		return FALSE;
+	}
+	times->load = g_timer_elapsed (timer, NULL);
+
+	if (ev_document_get_n_pages (document) > 0)
+		render_first_page (document);
+	times->first_page = g_timer_elapsed (timer, NULL);
+
+	/* What EvJobPageSizes does in the background */
+	while (!ev_document_fill_cache (document, 64, NULL, NULL));
+	times->page_sizes = g_timer_elapsed (timer, NULL);
+
+	g_timer_destroy (timer);
+	g_object_unref (document);
+
+	return TRUE;
+}
+
+static gboolean
+time_best_load (const gchar        *uri,
+		EvDocumentLoadFlags flags,
+		Times              *best)
+{
+	guint i;
+
+	best->load = best->first_page = best->page_sizes = G_MAXDOUBLE;
+
+	for (i = 0; i < N_RUNS; i++) {
+		Times times;
+
+		if (!time_load (uri, flags, &times))
+			return FALSE;
+
+		best->load = MIN (best->load, times.load);
+		best->first_page = MIN (best->first_page, times.first_page);
+		best->page_sizes = MIN (best->page_sizes, times.page_sizes);
+	}
+
+	return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+	gint i;
+
+	if (argc < 2) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (!ev_init ()) {
+		g_warning ("Failed to initialize evince");
+		return 1;
+	}
+
+	g_print ("MODE\tLOAD\tFIRST\tSIZES (ms)\tFILE\n");
+	for (i = 1; i < argc; i++) {
+		GFile *file;
+		gchar *uri;
+		Times  eager, lazy;
+
+		file = g_file_new_for_commandline_arg (argv[i]);
+		uri = g_file_get_uri (file);
+		g_object_unref (file);
+
+		if (time_best_load (uri, EV_DOCUMENT_LOAD_FLAG_NONE, &eager) &&
+		    time_best_load (uri, EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE, &lazy)) {
+			g_print ("eager\t%.1f\t%.1f\t%.1f\t\t%s\n",
+				 eager.load * 1000, eager.first_page * 1000,
+				 eager.page_sizes * 1000, argv[i]);
+			g_print ("lazy\t%.1f\t%.1f\t%.1f\t\t%s\n",
+				 lazy.load * 1000, lazy.first_page * 1000,
+				 lazy.page_sizes * 1000, argv[i]);
+		}
+		g_free (uri);
+	}
+
+	ev_shutdown ();
+
+	return 0;
+}
@@ -0,0 +1,338 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "ev-init.h"
+#include "ev-page-cache.h"
+
+#define DEFAULT_N_PAGES 1000
+#define CHARS_PER_LINE  80
+#define LINES_PER_PAGE  50
+#define BUDGET          (8 * 1024 * 1024)
+
+#define TEXT_FLAGS (EV_PAGE_DATA_INCLUDE_TEXT_MAPPING | \
+		    EV_PAGE_DATA_INCLUDE_TEXT        | \
+		    EV_PAGE_DATA_INCLUDE_TEXT_LAYOUT | \
+		    EV_PAGE_DATA_INCLUDE_TEXT_LOG_ATTRS)
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Checks the memory used by the page cache\n");
+	g_print ("Usage: %s [N_PAGES]\n", prog);
+	g_print ("Reads a document of N_PAGES pages (default %d) of %d lines of %d\n"
+		 "characters from the first page to the last one, like a screen reader\n"
+		 "does, and reports the memory used by the page cache without and with\n"
+		 "a budget of %d kB\n",
+		 DEFAULT_N_PAGES, LINES_PER_PAGE, CHARS_PER_LINE, BUDGET / 1024);
+}
+
+/* A document with a line of text every 16 points */
+typedef struct {
+	EvDocument parent;
+
+	gint n_pages;
+} TestDocument;
+
+typedef EvDocumentClass TestDocumentClass;
+
+static GType test_document_get_type (void);
+static void  test_document_text_iface_init (EvDocumentTextInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (TestDocument, test_document, EV_TYPE_DOCUMENT,
+			 G_IMPLEMENT_INTERFACE (EV_TYPE_DOCUMENT_TEXT,
+						test_document_text_iface_init))
+
+static GMutex n_fetches_mutex;
+static guint  n_fetches;
+
+static gboolean
+test_document_load_stream (EvDocument         *document,
+			   GInputStream       *stream,
+			   EvDocumentLoadFlags flags,
+			   GCancellable       *cancellable,
+			   GError            **error)
+{
+	return TRUE;
+}
+
+static gint
+test_document_get_n_pages (EvDocument *document)
+{
+	return ((TestDocument *) document)->n_pages;
+}
+
+static void
+test_document_get_page_size (EvDocument *document,
+			     EvPage     *page,
+			     double     *width,
+			     double     *height)
+{
+	*width = 595;
+	*height = 842;
+}
+
+static void
+test_document_init (TestDocument *document)
+{
+}
+
+static void
+test_document_class_init (TestDocumentClass *klass)
+{
+	klass->load_stream = test_document_load_stream;
+	klass->get_n_pages = test_document_get_n_pages;
+	klass->get_page_size = test_document_get_page_size;
+}
+
+static gchar *
+test_document_text_get_text (EvDocumentText *document_text,
+			     EvPage         *page)
+{
+	GString *text;
+	gint     i, j;
+
+	g_mutex_lock (&n_fetches_mutex);
+	n_fetches++;
+	g_mutex_unlock (&n_fetches_mutex);
+
+	text = g_string_sized_new (LINES_PER_PAGE * (CHARS_PER_LINE + 1));
+	for (i = 0; i < LINES_PER_PAGE; i++) {
+		for (j = 0; j < CHARS_PER_LINE; j++)
+			g_string_append_c (text, (j + 1) % 6 == 0 ? ' ' : 'a' + (page->index + i + j) % 26);
+		g_string_append_c (text, '\n');
+	}
+
+	return g_string_free (text, FALSE);
+}
+
+static void
+get_glyph_box (gint         page,
+	       gint         line,
+	       gint         column,
+	       EvRectangle *area)
+{
+	/* Something not exactly representable */
+	area->x1 = 36 + column * 6.3 + page / 7.0;
+	area->x2 = area->x1 + 6.1;
+	area->y1 = 36 + line * 15.7;
+	area->y2 = area->y1 + 12.9;
+}
+
+static gboolean
+test_document_text_get_text_layout (EvDocumentText *document_text,
+				    EvPage         *page,
+				    EvRectangle   **areas,
+				    guint          *n_areas)
+{
+	gint i, j;
+
+	*n_areas = LINES_PER_PAGE * (CHARS_PER_LINE + 1);
+	*areas = g_new (EvRectangle, *n_areas);
+	for (i = 0; i < LINES_PER_PAGE; i++) {
+		for (j = 0; j <= CHARS_PER_LINE; j++)
+			get_glyph_box (page->index, i, j, &(*areas)[i * (CHARS_PER_LINE + 1) + j]);
+	}
+
+	return TRUE;
+}
+
+static cairo_region_t *
+test_document_text_get_text_mapping (EvDocumentText *document_text,
+				     EvPage         *page)
+{
+	cairo_region_t *region = cairo_region_create ();
+	gint            i;
+
+	for (i = 0; i < LINES_PER_PAGE; i++) {
+		cairo_rectangle_int_t rect = { 36, 36 + i * 16, CHARS_PER_LINE * 6, 13 };
+
+		cairo_region_union_rectangle (region, &rect);
+	}
+
+	return region;
+}
+
+static void
+test_document_text_iface_init (EvDocumentTextInterface *iface)
+{
+	iface->get_text = test_document_text_get_text;
+	iface->get_text_layout = test_document_text_get_text_layout;
+	iface->get_text_mapping = test_document_text_get_text_mapping;
+}
+
+static EvDocument *
+test_document_new (gint n_pages)
+{
+	TestDocument *document;
+	GInputStream *stream;
+
+	document = g_object_new (test_document_get_type (), NULL);
+	document->n_pages = n_pages;
+
+	stream = g_memory_input_stream_new ();
+	ev_document_load_stream (EV_DOCUMENT (document), stream,
+				 EV_DOCUMENT_LOAD_FLAG_NONE, NULL, NULL);
+	g_object_unref (stream);
+
+	return EV_DOCUMENT (document);
+}
+
+static void
+wait_for_page (EvPageCache *cache,
+	       gint         page)
+{
+	while (!ev_page_cache_is_page_cached (cache, page))
+		g_main_context_iteration (NULL, TRUE);
+}
+
+static gboolean
+check_text_layout (EvPageCache *cache,
+		   gint         page)
+{
+	EvRectangle *areas = NULL;
+	guint        n_areas = 0;
+	guint        i;
+
+	if (!ev_page_cache_get_text_layout (cache, page, &areas, &n_areas) ||
+	    n_areas != LINES_PER_PAGE * (CHARS_PER_LINE + 1)) {
+		g_print ("Missing text layout for page %d\n", page);
+		return FALSE;
+	}
+
+	for (i = 0; i < n_areas; i++) {
+		EvRectangle area;
+
+		get_glyph_box (page, i / (CHARS_PER_LINE + 1), i % (CHARS_PER_LINE + 1), &area);
+		if (fabs (areas[i].x1 - area.x1) > 0.001 || fabs (areas[i].y1 - area.y1) > 0.001 ||
+		    fabs (areas[i].x2 - area.x2) > 0.001 || fabs (areas[i].y2 - area.y2) > 0.001) {
+			g_print ("Glyph %u of page %d is wrong\n", i, page);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* The view drops what it got from a page when it's evicted, so its
+ * data must still be there */
+static void
+page_evicted_cb (EvPageCache *cache,
+		 gint         page,
+		 gboolean    *evicted_ok)
+{
+	if (!ev_page_cache_get_text (cache, page)) {
+		g_print ("The data of page %d was freed before its eviction was notified\n", page);
+		*evicted_ok = FALSE;
+	}
+}
+
+static gboolean
+read_document (gint   n_pages,
+	       gsize  max_size)
+{
+	EvDocument  *document;
+	EvPageCache *cache;
+	gsize        peak = 0;
+	guint        n_refetches;
+	gboolean     evicted_ok = TRUE;
+	gboolean     retval = TRUE;
+	gint         i;
+
+	document = test_document_new (n_pages);
+	cache = ev_page_cache_new (document);
+	g_object_unref (document);
+	ev_page_cache_set_flags (cache, TEXT_FLAGS);
+	ev_page_cache_set_max_size (cache, max_size);
+	g_signal_connect (cache, "page-evicted", G_CALLBACK (page_evicted_cb), &evicted_ok);
+
+	for (i = 0; i < n_pages && retval; i++) {
+		ev_page_cache_set_page_range (cache, i, i);
+		wait_for_page (cache, i);
+		retval = check_text_layout (cache, i);
+		peak = MAX (peak, ev_page_cache_get_size (cache));
+	}
+
+	/* Back to the first pages, evicted ones are got again */
+	g_mutex_lock (&n_fetches_mutex);
+	n_fetches = 0;
+	g_mutex_unlock (&n_fetches_mutex);
+	for (i = 0; i < MIN (n_pages, 10) && retval; i++) {
+		ev_page_cache_set_page_range (cache, i, i);
+		wait_for_page (cache, i);
+		retval = check_text_layout (cache, i);
+	}
+	g_mutex_lock (&n_fetches_mutex);
+	n_refetches = n_fetches;
+	g_mutex_unlock (&n_fetches_mutex);
+
+	if (max_size == G_MAXSIZE)
+		g_print ("none\t\t");
+	else
+		g_print ("%" G_GSIZE_FORMAT "\t\t", max_size / 1024);
+	g_print ("%" G_GSIZE_FORMAT "\t\t%" G_GSIZE_FORMAT "\t\t%u\n",
+		 peak / 1024, ev_page_cache_get_size (cache) / 1024, n_refetches);
+
+	if (max_size != G_MAXSIZE && peak > max_size + max_size / 10) {
+		g_print ("The cache grew over its budget\n");
+		retval = FALSE;
+	}
+	if (!evicted_ok)
+		retval = FALSE;
+
+	g_object_unref (cache);
+
+	return retval;
+}
+
+int
+main (int argc, char **argv)
+{
+	gint n_pages = DEFAULT_N_PAGES;
+	int  retval = 0;
+
+	if (argc > 2) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (argc > 1)
+		n_pages = MAX (atoi (argv[1]), 1);
+
+	if (!ev_init ()) {
+		g_warning ("Failed to initialize evince");
+		return 1;
+	}
+
+	g_print ("BUDGET (kB)\tPEAK (kB)\tFINAL (kB)\tREFETCHED\n");
+
+	if (!read_document (n_pages, G_MAXSIZE))
+		retval = 1;
+	if (!read_document (n_pages, BUDGET))
+		retval = 1;
+
+	ev_shutdown ();
+
+	return retval;
+}
@@ -0,0 +1,278 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+
+#include "ev-init.h"
+#include "ev-jobs.h"
+#include "ev-job-scheduler.h"
+
+#define THUMBNAIL_SIZE 128
+#define MAX_LOADS      2
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Times starting with recent documents without cached thumbnails\n");
+	g_print ("Usage: %s FILE RECENT_FILE...\n", prog);
+	g_print ("Thumbnails the RECENT_FILEs like the recent documents view did, loading\n"
+		 "them all at once at a high priority, and like it does now, loading %d\n"
+		 "at once with EV_DOCUMENT_LOAD_FLAG_PROBE at the lowest priority. Reports\n"
+		 "the time until the first page of FILE, opened meanwhile, is rendered,\n"
+		 "and the time to thumbnail all the RECENT_FILEs when nothing is opened\n",
+		 MAX_LOADS);
+}
+
+/* What EvRecentView does for the documents missing in the thumbnail cache */
+typedef struct {
+	gboolean probe;
+	GQueue   pending;
+	GList   *jobs;
+	guint    n_loads;
+	guint    n_remaining;
+	guint    n_thumbnails;
+} Loader;
+
+static void loader_start (Loader *loader);
+
+static void
+loader_job_done (Loader *loader,
+		 EvJob  *job)
+{
+	loader->jobs = g_list_remove (loader->jobs, job);
+	g_object_unref (job);
+
+	loader->n_remaining--;
+	loader->n_loads--;
+	loader_start (loader);
+}
+
+static void
+thumbnail_finished_cb (EvJob  *job,
+		       Loader *loader)
+{
+	if (!ev_job_is_failed (job))
+		loader->n_thumbnails++;
+	loader_job_done (loader, job);
+}
+
+static void
+load_finished_cb (EvJob  *job,
+		  Loader *loader)
+{
+	EvJob  *thumbnail;
+	gdouble width, height;
+
+	if (ev_job_is_failed (job)) {
+		loader_job_done (loader, job);
+		return;
+	}
+
+	ev_document_get_page_size (job->document, 0, &width, &height);
+	thumbnail = ev_job_thumbnail_new_with_target_size (job->document, 0, 0,
+							   width > height ? THUMBNAIL_SIZE : THUMBNAIL_SIZE * width / height,
+							   width > height ? THUMBNAIL_SIZE * height / width : THUMBNAIL_SIZE);
+	ev_job_thumbnail_set_output_format (EV_JOB_THUMBNAIL (thumbnail), EV_JOB_THUMBNAIL_SURFACE);
+	g_signal_connect (thumbnail, "finished",
+			  G_CALLBACK (thumbnail_finished_cb), loader);
+	loader->jobs = g_list_prepend (loader->jobs, thumbnail);
+	ev_job_scheduler_push_job (thumbnail, loader->probe ? EV_JOB_PRIORITY_NONE : EV_JOB_PRIORITY_HIGH);
+
+	loader->jobs = g_list_remove (loader->jobs, job);
+	g_object_unref (job);
+}
+
+static void
+loader_start (Loader *loader)
+{
+	gchar *uri;
+
+	while ((!loader->probe || loader->n_loads < MAX_LOADS) &&
+	       (uri = g_queue_pop_head (&loader->pending))) {
+		EvJob *job;
+
+		job = ev_job_load_new (uri);
+		if (loader->probe)
+			ev_job_load_set_load_flags (EV_JOB_LOAD (job), EV_DOCUMENT_LOAD_FLAG_PROBE);
+		g_signal_connect (job, "finished",
+				  G_CALLBACK (load_finished_cb), loader);
+		loader->jobs = g_list_prepend (loader->jobs, job);
+		loader->n_loads++;
+		ev_job_scheduler_push_job (job, loader->probe ? EV_JOB_PRIORITY_NONE : EV_JOB_PRIORITY_HIGH);
+	}
+}
+
+/* What ev_window_open_uri() does now */
+static void
+loader_cancel (Loader *loader)
+{
+	GList *l;
+
+	loader->n_remaining -= g_queue_get_length (&loader->pending);
+	g_queue_clear (&loader->pending);
+
+	for (l = loader->jobs; l; l = g_list_next (l)) {
+		EvJob *job = l->data;
+
+		g_signal_handlers_disconnect_by_data (job, loader);
+		ev_job_cancel (job);
+		g_object_unref (job);
+		loader->n_remaining--;
+	}
+	g_list_free (loader->jobs);
+	loader->jobs = NULL;
+	loader->n_loads = 0;
+}
+
+typedef struct {
+	GTimer *timer;
+	gdouble opened; /* seconds, 0 if it failed */
+} Opening;
+
+static void
+render_finished_cb (EvJob   *job,
+		    Opening *opening)
+{
+	opening->opened = g_timer_elapsed (opening->timer, NULL);
+	g_object_unref (job);
+}
+
+static void
+open_finished_cb (EvJob   *job,
+		  Opening *opening)
+{
+	EvJob  *render;
+	gdouble width, height;
+
+	if (ev_job_is_failed (job)) {
+		g_print ("Failed to load the document: %s\n", job->error->message);
+		opening->opened = 0;
+		g_object_unref (job);
+		return;
+	}
+
+	ev_document_get_page_size (job->document, 0, &width, &height);
+	render = ev_job_render_new (job->document, 0, 0, 1.0, (gint) width, (gint) height);
+	g_signal_connect (render, "finished",
+			  G_CALLBACK (render_finished_cb), opening);
+	ev_job_scheduler_push_job (render, EV_JOB_PRIORITY_URGENT);
+	g_object_unref (job);
+}
+
+static gboolean
+time_startup (const gchar  *uri,
+	      gchar       **recent_uris,
+	      gboolean      probe,
+	      gdouble      *elapsed,
+	      guint        *n_thumbnails)
+{
+	Loader  loader = { probe, G_QUEUE_INIT, NULL, 0, 0, 0 };
+	Opening opening = { NULL, -1 };
+	gint    i;
+
+	for (i = 0; recent_uris[i]; i++)
+		g_queue_push_tail (&loader.pending, recent_uris[i]);
+	loader.n_remaining = g_queue_get_length (&loader.pending);
+
+	opening.timer = g_timer_new ();
+	loader_start (&loader);
+
+	if (uri) {
+		EvJob *job;
+
+		/* Like the window opening a document */
+		if (probe)
+			loader_cancel (&loader);
+		job = ev_job_load_new (uri);
+		ev_job_load_set_load_flags (EV_JOB_LOAD (job), EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE);
+		g_signal_connect (job, "finished",
+				  G_CALLBACK (open_finished_cb), &opening);
+		ev_job_scheduler_push_job (job, EV_JOB_PRIORITY_NONE);
+
+		while (opening.opened < 0)
+			g_main_context_iteration (NULL, TRUE);
+		*elapsed = opening.opened;
+	}
+
+	while (loader.n_remaining > 0)
+		g_main_context_iteration (NULL, TRUE);
+	if (!uri)
+		*elapsed = g_timer_elapsed (opening.timer, NULL);
+	*n_thumbnails = loader.n_thumbnails;
+
+	g_timer_destroy (opening.timer);
+
+	return !uri || opening.opened > 0;
+}
+
+int
+main (int argc, char **argv)
+{
+	gchar  *uri;
+	gchar **recent_uris;
+	GFile  *file;
+	int     retval = 0;
+	gint    i;
+
+	if (argc < 3) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (!ev_init ()) {
+		g_warning ("Failed to initialize evince");
+		return 1;
+	}
+
+	file = g_file_new_for_commandline_arg (argv[1]);
+	uri = g_file_get_uri (file);
+	g_object_unref (file);
+
+	recent_uris = g_new0 (gchar *, argc - 1);
+	for (i = 2; i < argc; i++) {
+		file = g_file_new_for_commandline_arg (argv[i]);
+		recent_uris[i - 2] = g_file_get_uri (file);
+		g_object_unref (file);
+	}
+
+	g_print ("MODE\tOPENED (s)\tTHUMBNAILS (s)\tTHUMBNAILED\n");
+	for (i = 0; i < 2; i++) {
+		gboolean probe = i == 1;
+		gdouble  opened, thumbnails;
+		guint    n_opened, n_thumbnails;
+
+		if (!time_startup (uri, recent_uris, probe, &opened, &n_opened) ||
+		    !time_startup (NULL, recent_uris, probe, &thumbnails, &n_thumbnails)) {
+			retval = 1;
+			continue;
+		}
+
+		g_print ("%s\t%.2f\t\t%.2f\t\t%u/%d\n",
+			 probe ? "probe" : "full",
+			 opened, thumbnails, n_thumbnails, argc - 2);
+	}
+
+	g_strfreev (recent_uris);
+	g_free (uri);
+	ev_shutdown ();
+
+	return retval;
+}
@@ -0,0 +1,269 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+#include "ev-init.h"
+#include "ev-document-model.h"
+#include "ev-view.h"
+
+#define N_PAGES      400
+#define EDITED_PAGE  200
+#define RENDER_TIME  (30 * 1000)  /* microseconds */
+#define QUIET_TIME   (300 * 1000) /* microseconds */
+
+/* A document whose pages take RENDER_TIME to render, and whose page
+ * fingerprints are the version of their contents */
+typedef struct {
+	EvDocument parent;
+
+	gint     *versions;
+	gboolean  fingerprints;
+} TestDocument;
+
+typedef EvDocumentClass TestDocumentClass;
+
+static GType test_document_get_type (void);
+
+G_DEFINE_TYPE (TestDocument, test_document, EV_TYPE_DOCUMENT)
+
+static GMutex  render_mutex;
+static guint   n_renders;
+static gint64  last_render_time;
+
+static gboolean
+test_document_load_stream (EvDocument         *document,
+			   GInputStream       *stream,
+			   EvDocumentLoadFlags flags,
+			   GCancellable       *cancellable,
+			   GError            **error)
+{
+	return TRUE;
+}
+
+static gint
+test_document_get_n_pages (EvDocument *document)
+{
+	return N_PAGES;
+}
+
+static void
+test_document_get_page_size (EvDocument *document,
+			     EvPage     *page,
+			     double     *width,
+			     double     *height)
+{
+	*width = 595;
+	*height = 842;
+}
+
+static cairo_surface_t *
+test_document_render (EvDocument      *document,
+		      EvRenderContext *rc)
+{
+	gint width, height;
+
+	ev_render_context_compute_scaled_size (rc, 595, 842, &width, &height);
+	g_usleep (RENDER_TIME);
+
+	g_mutex_lock (&render_mutex);
+	n_renders++;
+	last_render_time = g_get_monotonic_time ();
+	g_mutex_unlock (&render_mutex);
+
+	return cairo_image_surface_create (CAIRO_FORMAT_RGB24, MAX (width, 1), MAX (height, 1));
+}
+
+static gchar *
+test_document_get_page_fingerprint (EvDocument *document,
+				    EvPage     *page)
+{
+	TestDocument *test_document = (TestDocument *) document;
+
+	if (!test_document->fingerprints)
+		return NULL;
+
+	return g_strdup_printf ("%d-%d", page->index, test_document->versions[page->index]);
+}
+
+static void
+test_document_finalize (GObject *object)
+{
+	g_free (((TestDocument *) object)->versions);
+
+	G_OBJECT_CLASS (test_document_parent_class)->finalize (object);
+}
+
+static void
+test_document_init (TestDocument *document)
+{
+}
+
+static void
+test_document_class_init (TestDocumentClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = test_document_finalize;
+
+	klass->load_stream = test_document_load_stream;
+	klass->get_n_pages = test_document_get_n_pages;
+	klass->get_page_size = test_document_get_page_size;
+	klass->render = test_document_render;
+	klass->get_page_fingerprint = test_document_get_page_fingerprint;
+}
+
+static EvDocument *
+test_document_new (gint     edited_page,
+		   gboolean fingerprints)
+{
+	TestDocument *document;
+	GInputStream *stream;
+
+	document = g_object_new (test_document_get_type (), NULL);
+	document->versions = g_new0 (gint, N_PAGES);
+	document->fingerprints = fingerprints;
+	if (edited_page >= 0)
+		document->versions[edited_page]++;
+
+	stream = g_memory_input_stream_new ();
+	ev_document_load_stream (EV_DOCUMENT (document), stream,
+				 EV_DOCUMENT_LOAD_FLAG_NONE, NULL, NULL);
+	g_object_unref (stream);
+
+	return EV_DOCUMENT (document);
+}
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Times reloading a document after a one page edit\n");
+	g_print ("Usage: %s\n", prog);
+	g_print ("Opens a document of %d pages at page %d, reloads it with that page\n"
+		 "changed and reports the time until the view is rendered again, with\n"
+		 "and without page fingerprints. Rendering a page takes %d ms\n",
+		 N_PAGES, EDITED_PAGE + 1, RENDER_TIME / 1000);
+}
+
+/* Waits until nothing has been rendered for QUIET_TIME, and returns
+ * the time the last page was rendered at */
+static gint64
+wait_for_stable_display (gint64 start_time)
+{
+	gint64 last = start_time;
+
+	while (TRUE) {
+		gint64 now;
+
+		while (gtk_events_pending ())
+			gtk_main_iteration ();
+
+		g_mutex_lock (&render_mutex);
+		last = MAX (last, last_render_time);
+		g_mutex_unlock (&render_mutex);
+
+		now = g_get_monotonic_time ();
+		if (now - last > QUIET_TIME)
+			break;
+
+		g_usleep (1000);
+	}
+
+	return last;
+}
+
+static void
+time_reload (gboolean fingerprints,
+	     gdouble *elapsed,
+	     guint   *renders)
+{
+	EvDocumentModel *model;
+	EvDocument      *document;
+	GtkWidget       *window, *swindow, *view;
+	gint64           start;
+
+	document = test_document_new (-1, fingerprints);
+	model = ev_document_model_new_with_document (document);
+	g_object_unref (document);
+	ev_document_model_set_continuous (model, TRUE);
+	ev_document_model_set_sizing_mode (model, EV_SIZING_FIT_WIDTH);
+
+	window = gtk_offscreen_window_new ();
+	gtk_window_set_default_size (GTK_WINDOW (window), 800, 1000);
+	swindow = gtk_scrolled_window_new (NULL, NULL);
+	gtk_container_add (GTK_CONTAINER (window), swindow);
+	view = ev_view_new ();
+	ev_view_set_model (EV_VIEW (view), model);
+	gtk_container_add (GTK_CONTAINER (swindow), view);
+	gtk_widget_show_all (window);
+
+	ev_document_model_set_page (model, EDITED_PAGE);
+	wait_for_stable_display (g_get_monotonic_time ());
+
+	/* What EvWindow does when the file changes */
+	document = test_document_new (EDITED_PAGE, fingerprints);
+	g_mutex_lock (&render_mutex);
+	n_renders = 0;
+	g_mutex_unlock (&render_mutex);
+
+	start = g_get_monotonic_time ();
+	ev_document_model_set_document (model, document);
+	g_object_unref (document);
+	*elapsed = (gdouble) (wait_for_stable_display (start) - start) / G_USEC_PER_SEC;
+	*renders = n_renders;
+
+	gtk_widget_destroy (window);
+	while (gtk_events_pending ())
+		gtk_main_iteration ();
+	g_object_unref (model);
+}
+
+int
+main (int argc, char **argv)
+{
+	gdouble elapsed;
+	guint   renders;
+
+	gtk_init (&argc, &argv);
+
+	if (argc != 1) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	if (!ev_init ()) {
+		g_warning ("Failed to initialize evince");
+		return 1;
+	}
+
+	g_print ("MODE\t\tRELOAD (ms)\tRENDERS\n");
+
+	time_reload (FALSE, &elapsed, &renders);
+	g_print ("full\t\t%.1f\t\t%u\n", elapsed * 1000, renders);
+
+	time_reload (TRUE, &elapsed, &renders);
+	g_print ("incremental\t%.1f\t\t%u\n", elapsed * 1000, renders);
+
+	ev_shutdown ();
+
+	return 0;
+}
@@ -0,0 +1,173 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <cairo.h>
+
+#include "ev-transition-animation.h"
+
+#define N_FRAMES 60
+#define FPS      60
+
+static const struct {
+	const gchar *name;
+	gint         width;
+	gint         height;
+} sizes[] = {
+	{ "1080p", 1920, 1080 },
+	{ "4K",    3840, 2160 }
+};
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Times painting the slide transitions\n");
+	g_print ("Usage: %s\n", prog);
+	g_print ("Paints %d frames of every transition effect at 1080p and 4K into\n"
+		 "image surfaces and reports the average and worst frame times, and\n"
+		 "the frames that took longer than the %d fps frame interval\n",
+		 N_FRAMES, FPS);
+}
+
+static cairo_surface_t *
+create_slide (gint    width,
+	      gint    height,
+	      gdouble r,
+	      gdouble g,
+	      gdouble b)
+{
+	cairo_surface_t *surface;
+	cairo_t         *cr;
+	gint             y;
+
+	surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24, width, height);
+	cr = cairo_create (surface);
+	cairo_set_source_rgb (cr, 1., 1., 1.);
+	cairo_paint (cr);
+
+	/* Lines of text, more or less */
+	cairo_set_source_rgb (cr, r, g, b);
+	for (y = height / 10; y < height - height / 10; y += height / 40)
+		cairo_rectangle (cr, width / 10, y, width * 8 / 10, height / 80);
+	cairo_fill (cr);
+	cairo_destroy (cr);
+
+	return surface;
+}
+
+static void
+time_effect (EvTransitionEffectType  type,
+	     cairo_surface_t        *origin,
+	     cairo_surface_t        *dest,
+	     cairo_surface_t        *target,
+	     gdouble                *average,
+	     gdouble                *worst,
+	     guint                  *n_late)
+{
+	EvTransitionEffect    *effect;
+	EvTransitionAnimation *animation;
+	GdkRectangle           page_area;
+	cairo_t               *cr;
+	gint64                 total = 0;
+	gint                   i;
+
+	effect = ev_transition_effect_new (type, "duration", 1, NULL);
+	animation = ev_transition_animation_new (effect);
+	g_object_unref (effect);
+	ev_transition_animation_set_origin_surface (animation, origin);
+	ev_transition_animation_set_dest_surface (animation, dest);
+	/* Setting both surfaces starts the timeline */
+	ev_timeline_pause (EV_TIMELINE (animation));
+
+	page_area.x = page_area.y = 0;
+	page_area.width = cairo_image_surface_get_width (target);
+	page_area.height = cairo_image_surface_get_height (target);
+
+	*worst = 0;
+	*n_late = 0;
+	cr = cairo_create (target);
+	for (i = 0; i < N_FRAMES; i++) {
+		gint64 start, elapsed;
+
+		start = g_get_monotonic_time ();
+		ev_transition_animation_paint_progress (animation, cr, page_area,
+							(gdouble) i / (N_FRAMES - 1));
+		cairo_surface_flush (target);
+		elapsed = g_get_monotonic_time () - start;
+
+		total += elapsed;
+		*worst = MAX (*worst, (gdouble) elapsed / 1000);
+		if (elapsed > G_USEC_PER_SEC / FPS)
+			(*n_late)++;
+	}
+	cairo_destroy (cr);
+	*average = (gdouble) total / N_FRAMES / 1000;
+
+	g_object_unref (animation);
+}
+
+int
+main (int argc, char **argv)
+{
+	GEnumClass *enum_class;
+	guint       i, j;
+
+	if (argc != 1) {
+		usage (argv[0]);
+		return 1;
+	}
+
+	enum_class = g_type_class_ref (EV_TYPE_TRANSITION_EFFECT_TYPE);
+
+	g_print ("EFFECT\t\tSIZE\tAVERAGE\tWORST (ms)\tLATE\n");
+	for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+		cairo_surface_t *origin, *dest, *target;
+
+		origin = create_slide (sizes[i].width, sizes[i].height, 0.2, 0.2, 0.6);
+		dest = create_slide (sizes[i].width, sizes[i].height, 0.6, 0.2, 0.2);
+		target = cairo_image_surface_create (CAIRO_FORMAT_RGB24,
+						     sizes[i].width, sizes[i].height);
+
+		for (j = 0; j < enum_class->n_values; j++) {
+			GEnumValue *value = &enum_class->values[j];
+			gdouble     average, worst;
+			guint       n_late;
+
+			/* Not implemented */
+			if (value->value == EV_TRANSITION_EFFECT_GLITTER ||
+			    value->value == EV_TRANSITION_EFFECT_FLY)
+				continue;
+
+			time_effect (value->value, origin, dest, target,
+				     &average, &worst, &n_late);
+			g_print ("%-15s\t%s\t%.2f\t%.2f\t\t%u/%d\n",
+				 value->value_nick, sizes[i].name,
+				 average, worst, n_late, N_FRAMES);
+		}
+
+		cairo_surface_destroy (origin);
+		cairo_surface_destroy (dest);
+		cairo_surface_destroy (target);
+	}
+
+	g_type_class_unref (enum_class);
+
+	return 0;
+}
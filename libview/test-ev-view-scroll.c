@@ -0,0 +1,236 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+#include "ev-init.h"
+#include "ev-document-model.h"
+#include "ev-view.h"
+
+#define N_SCROLLS 2000
+
+/* A document with pages of a few different sizes that renders blank
+ * pages, so that only the view is measured */
+typedef struct {
+	EvDocument parent;
+
+	gint n_pages;
+} TestDocument;
+
+typedef EvDocumentClass TestDocumentClass;
+
+static GType test_document_get_type (void);
+
+G_DEFINE_TYPE (TestDocument, test_document, EV_TYPE_DOCUMENT)
+
+static gboolean
+test_document_load_stream (EvDocument         *document,
+			   GInputStream       *stream,
+			   EvDocumentLoadFlags flags,
+			   GCancellable       *cancellable,
+			   GError            **error)
+{
+	return TRUE;
+}
+
+static gint
+test_document_get_n_pages (EvDocument *document)
+{
+	return ((TestDocument *) document)->n_pages;
+}
+
+static void
+test_document_get_page_size (EvDocument *document,
+			     EvPage     *page,
+			     double     *width,
+			     double     *height)
+{
+	if (page->index % 7 == 6) {
+		*width = 842;
+		*height = 595;
+	} else if (page->index % 2) {
+		*width = 595;
+		*height = 842;
+	} else {
+		*width = 612;
+		*height = 792;
+	}
+}
+
+static cairo_surface_t *
+test_document_render (EvDocument      *document,
+		      EvRenderContext *rc)
+{
+	double page_width, page_height;
+	gint   width, height;
+
+	test_document_get_page_size (document, rc->page, &page_width, &page_height);
+	ev_render_context_compute_scaled_size (rc, page_width, page_height, &width, &height);
+
+	return cairo_image_surface_create (CAIRO_FORMAT_RGB24, MAX (width, 1), MAX (height, 1));
+}
+
+static void
+test_document_init (TestDocument *document)
+{
+}
+
+static void
+test_document_class_init (TestDocumentClass *klass)
+{
+	klass->load_stream = test_document_load_stream;
+	klass->get_n_pages = test_document_get_n_pages;
+	klass->get_page_size = test_document_get_page_size;
+	klass->render = test_document_render;
+}
+
+static EvDocument *
+test_document_new (gint n_pages)
+{
+	EvDocument   *document;
+	GInputStream *stream;
+	GError       *error = NULL;
+
+	document = g_object_new (test_document_get_type (), NULL);
+	((TestDocument *) document)->n_pages = n_pages;
+
+	stream = g_memory_input_stream_new ();
+	if (!ev_document_load_stream (document, stream, EV_DOCUMENT_LOAD_FLAG_NONE, NULL, &error)) {
+		g_warning ("Failed to load test document: %s", error->message);
+		g_error_free (error);
+		g_clear_object (&document);
+	}
+	g_object_unref (stream);
+
+	return document;
+}
+
+static void
+usage (const char *prog)
+{
+	g_print ("- Times scrolling through a document in continuous mode\n");
+	g_print ("Usage: %s [n-pages...]\n", prog);
+	g_print ("Scrolls %d times from the first to the last page of generated documents\n"
+		 "and reports the time per scroll. Scroll times should not depend on the\n"
+		 "number of pages\n", N_SCROLLS);
+}
+
+static void
+flush_events (void)
+{
+	while (gtk_events_pending ())
+		gtk_main_iteration ();
+}
+
+static gdouble
+time_scrolling (EvDocument  *document,
+		EvPageLayout layout)
+{
+	EvDocumentModel *model;
+	GtkWidget       *window, *swindow, *view;
+	GtkAdjustment   *vadjustment;
+	GTimer          *timer;
+	gdouble          upper, elapsed;
+	guint            i;
+
+	model = ev_document_model_new_with_document (document);
+	ev_document_model_set_continuous (model, TRUE);
+	ev_document_model_set_page_layout (model, layout);
+	ev_document_model_set_sizing_mode (model, EV_SIZING_FIT_WIDTH);
+
+	window = gtk_offscreen_window_new ();
+	gtk_window_set_default_size (GTK_WINDOW (window), 800, 1000);
+	swindow = gtk_scrolled_window_new (NULL, NULL);
+	gtk_container_add (GTK_CONTAINER (window), swindow);
+	view = ev_view_new ();
+	ev_view_set_model (EV_VIEW (view), model);
+	gtk_container_add (GTK_CONTAINER (swindow), view);
+	gtk_widget_show_all (window);
+	flush_events ();
+
+	vadjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (swindow));
+	upper = gtk_adjustment_get_upper (vadjustment) - gtk_adjustment_get_page_size (vadjustment);
+
+	timer = g_timer_new ();
+	for (i = 0; i < N_SCROLLS; i++)
+		gtk_adjustment_set_value (vadjustment, upper * i / (N_SCROLLS - 1));
+	g_timer_stop (timer);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	gtk_widget_destroy (window);
+	flush_events ();
+	g_object_unref (model);
+
+	return elapsed / N_SCROLLS;
+}
+
+int
+main (int argc, char **argv)
+{
+	const gint default_n_pages[] = { 100, 1000, 10000, 20000 };
+	gint      *n_pages;
+	gint       n_documents, i;
+
+	gtk_init (&argc, &argv);
+
+	if (!ev_init ()) {
+		g_warning ("Failed to initialize evince");
+		return 1;
+	}
+
+	if (argc > 1) {
+		n_documents = argc - 1;
+		n_pages = g_new (gint, n_documents);
+		for (i = 0; i < n_documents; i++) {
+			n_pages[i] = atoi (argv[i + 1]);
+			if (n_pages[i] <= 0) {
+				usage (argv[0]);
+				g_free (n_pages);
+				ev_shutdown ();
+				return 1;
+			}
+		}
+	} else {
+		n_documents = G_N_ELEMENTS (default_n_pages);
+		n_pages = g_memdup (default_n_pages, sizeof (default_n_pages));
+	}
+
+	g_print ("PAGES\tSINGLE\tDUAL (microseconds per scroll)\n");
+	for (i = 0; i < n_documents; i++) {
+		EvDocument *document;
+
+		document = test_document_new (n_pages[i]);
+		if (!document)
+			continue;
+
+		g_print ("%d\t%.1f\t%.1f\n", n_pages[i],
+			 time_scrolling (document, EV_PAGE_LAYOUT_SINGLE) * G_USEC_PER_SEC,
+			 time_scrolling (document, EV_PAGE_LAYOUT_DUAL) * G_USEC_PER_SEC);
+		g_object_unref (document);
+	}
+
+	g_free (n_pages);
+	ev_shutdown ();
+
+	return 0;
+}
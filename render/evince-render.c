@@ -0,0 +1,833 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8; c-indent-level: 8 -*- */
+/*
+ * Copyright (C) 2018 Evince Developers
+ *
+ * Evince is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Evince is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <evince-document.h>
+#include <evince-view.h>
+
+/* Pages rendered and not written yet, per worker thread */
+#define PAGES_PER_THREAD 2
+
+typedef enum {
+	OUTPUT_FORMAT_PNG,
+	OUTPUT_FORMAT_RAW
+} OutputFormat;
+
+static const gchar  *page_ranges = NULL;
+static gdouble       scale = 1.0;
+static gdouble       dpi = 0;
+static gint          rotation = 0;
+static const gchar  *output_dir = ".";
+static const gchar  *format_name = "png";
+static gint          n_jobs = 0;
+static const gchar **file_arguments;
+
+static OutputFormat  output_format;
+static gboolean      streaming;
+static FILE         *report;
+
+static const GOptionEntry goption_options[] = {
+	{ "pages", 'p', 0, G_OPTION_ARG_STRING, &page_ranges, "Pages to render, like 1-3,7,10- (default: all)", "RANGES" },
+	{ "scale", 's', 0, G_OPTION_ARG_DOUBLE, &scale, "Scale of the rendered pages (default: 1.0, 72 DPI)", "SCALE" },
+	{ "dpi", 'r', 0, G_OPTION_ARG_DOUBLE, &dpi, "Resolution of the rendered pages, instead of the scale", "DPI" },
+	{ "rotation", 0, 0, G_OPTION_ARG_INT, &rotation, "Rotation of the rendered pages: 0, 90, 180 or 270", "DEGREES" },
+	{ "output-dir", 'o', 0, G_OPTION_ARG_FILENAME, &output_dir, "Directory the pages are written to, or - to stream them to the standard output", "DIR" },
+	{ "format", 'f', 0, G_OPTION_ARG_STRING, &format_name, "Format of the pages: png, or raw for uncompressed PAM images (default: png)", "FORMAT" },
+	{ "jobs", 'j', 0, G_OPTION_ARG_INT, &n_jobs, "Number of pages rendered at the same time (default: number of processors)", "N" },
+	{ G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &file_arguments, NULL, "FILE..." },
+	{ NULL }
+};
+
+/* ru_maxrss is in kilobytes on Linux and the BSDs */
+static glong
+get_peak_memory (void)
+{
+#ifdef HAVE_SYS_RESOURCE_H
+	struct rusage usage;
+
+	if (getrusage (RUSAGE_SELF, &usage) == 0)
+		return usage.ru_maxrss;
+#endif
+	return -1;
+}
+
+/* RenderJob: renders a page in the scheduler threads. Once it has
+ * finished, a second RenderJob without a document encodes the page,
+ * so that the next page of a document that is not thread-safe can be
+ * rendered meanwhile. Only writing to the standard output is left to
+ * the main thread. */
+typedef struct {
+	EvJob parent;
+
+	gint             page;
+	gchar           *filename;
+
+	/* Rendered and not encoded yet */
+	cairo_surface_t *surface;
+
+	GByteArray      *data;
+	gint             width;
+	gint             height;
+	gint64           render_time;
+	gint64           encode_time;
+
+	/* Set in the main thread, once finished has been emitted */
+	gboolean         done;
+} RenderJob;
+
+typedef EvJobClass RenderJobClass;
+
+static GType render_job_get_type (void);
+
+G_DEFINE_TYPE (RenderJob, render_job, EV_TYPE_JOB)
+
+static cairo_status_t
+write_to_byte_array (void                *closure,
+		     const unsigned char *data,
+		     unsigned int         length)
+{
+	g_byte_array_append ((GByteArray *) closure, data, length);
+
+	return CAIRO_STATUS_SUCCESS;
+}
+
+/* Portable Arbitrary Map, a header and the pixels as they are */
+static void
+encode_raw (cairo_surface_t *surface,
+	    GByteArray      *data)
+{
+	GdkPixbuf *pixbuf;
+	gchar     *header;
+	guchar    *pixels;
+	gint       width, height, n_channels, rowstride, y;
+
+	pixbuf = ev_document_misc_pixbuf_from_surface (surface);
+	width = gdk_pixbuf_get_width (pixbuf);
+	height = gdk_pixbuf_get_height (pixbuf);
+	n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+	rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+	pixels = gdk_pixbuf_get_pixels (pixbuf);
+
+	header = g_strdup_printf ("P7\nWIDTH %d\nHEIGHT %d\nDEPTH %d\nMAXVAL 255\nTUPLTYPE %s\nENDHDR\n",
+				  width, height, n_channels,
+				  n_channels == 4 ? "RGB_ALPHA" : "RGB");
+	g_byte_array_set_size (data, 0);
+	g_byte_array_append (data, (guint8 *) header, strlen (header));
+	g_free (header);
+
+	for (y = 0; y < height; y++)
+		g_byte_array_append (data, pixels + y * rowstride, width * n_channels);
+
+	g_object_unref (pixbuf);
+}
+
+static gboolean
+render_job_render (RenderJob *render_job)
+{
+	EvJob           *job = EV_JOB (render_job);
+	EvPage          *page;
+	EvRenderContext *rc;
+	cairo_surface_t *surface;
+	gboolean         thread_safe;
+	gint64           start;
+
+	start = g_get_monotonic_time ();
+
+	ev_document_render_lock (job->document);
+	thread_safe = ev_document_is_thread_safe (job->document);
+	if (!thread_safe)
+		ev_document_fc_mutex_lock ();
+
+	page = ev_document_get_page (job->document, render_job->page);
+	rc = ev_render_context_new (page, rotation, scale);
+	g_object_unref (page);
+	surface = ev_document_render (job->document, rc);
+	g_object_unref (rc);
+
+	if (!thread_safe)
+		ev_document_fc_mutex_unlock ();
+	ev_document_render_unlock (job->document);
+
+	render_job->render_time = g_get_monotonic_time () - start;
+
+	if (!surface || cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS) {
+		if (surface)
+			cairo_surface_destroy (surface);
+		ev_job_failed (job, EV_DOCUMENT_ERROR, EV_DOCUMENT_ERROR_INVALID,
+			       "Failed to render page %d", render_job->page + 1);
+
+		return FALSE;
+	}
+
+	render_job->surface = surface;
+	render_job->width = cairo_image_surface_get_width (surface);
+	render_job->height = cairo_image_surface_get_height (surface);
+
+	ev_job_succeeded (job);
+
+	return FALSE;
+}
+
+static gboolean
+render_job_encode (RenderJob *render_job)
+{
+	EvJob  *job = EV_JOB (render_job);
+	gint64  start;
+	GError *error = NULL;
+
+	start = g_get_monotonic_time ();
+
+	render_job->data = g_byte_array_new ();
+	if (output_format == OUTPUT_FORMAT_RAW)
+		encode_raw (render_job->surface, render_job->data);
+	else
+		cairo_surface_write_to_png_stream (render_job->surface, write_to_byte_array, render_job->data);
+	g_clear_pointer (&render_job->surface, cairo_surface_destroy);
+
+	/* Files are written here, only the standard output is in order */
+	if (render_job->filename) {
+		if (!g_file_set_contents (render_job->filename,
+					  (const gchar *) render_job->data->data,
+					  render_job->data->len, &error)) {
+			ev_job_failed_from_error (job, error);
+			g_error_free (error);
+
+			return FALSE;
+		}
+		g_byte_array_set_size (render_job->data, 0);
+	}
+
+	render_job->encode_time = g_get_monotonic_time () - start;
+
+	ev_job_succeeded (job);
+
+	return FALSE;
+}
+
+static gboolean
+render_job_run (EvJob *job)
+{
+	RenderJob *render_job = (RenderJob *) job;
+
+	return job->document ? render_job_render (render_job) : render_job_encode (render_job);
+}
+
+static void
+render_job_finalize (GObject *object)
+{
+	RenderJob *job = (RenderJob *) object;
+
+	g_free (job->filename);
+	if (job->surface)
+		cairo_surface_destroy (job->surface);
+	if (job->data)
+		g_byte_array_unref (job->data);
+
+	G_OBJECT_CLASS (render_job_parent_class)->finalize (object);
+}
+
+static void
+render_job_init (RenderJob *job)
+{
+	EV_JOB (job)->run_mode = EV_JOB_RUN_THREAD;
+}
+
+static void
+render_job_class_init (RenderJobClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = render_job_finalize;
+	klass->run = render_job_run;
+}
+
+static EvJob *
+render_job_new (EvDocument  *document,
+		gint         page,
+		const gchar *filename)
+{
+	RenderJob *job;
+
+	job = g_object_new (render_job_get_type (), NULL);
+	EV_JOB (job)->document = g_object_ref (document);
+	job->page = page;
+	job->filename = g_strdup (filename);
+
+	return EV_JOB (job);
+}
+
+/* Takes the surface of a finished render job */
+static EvJob *
+render_job_new_encode (RenderJob *rendered)
+{
+	RenderJob *job;
+
+	job = g_object_new (render_job_get_type (), NULL);
+	job->page = rendered->page;
+	job->filename = g_strdup (rendered->filename);
+	job->surface = rendered->surface;
+	rendered->surface = NULL;
+	job->width = rendered->width;
+	job->height = rendered->height;
+	job->render_time = rendered->render_time;
+
+	return EV_JOB (job);
+}
+
+/* Several documents are open at the same time, so that the pages of
+ * documents that are not thread-safe are rendered in parallel too.
+ * Every document has up to PAGES_PER_THREAD pages per thread, shared
+ * by the open documents, ahead of the page written next. */
+typedef struct _RenderQueue RenderQueue;
+
+typedef struct {
+	RenderQueue *queue;
+	EvJob       *load_job;
+	EvDocument  *document;
+	const gchar *input;
+	const gchar *basename;
+	GArray      *pages;
+	EvJob      **jobs;
+	guint        next_push;
+	guint        next_write;
+	gint         n_failed;
+	gboolean     finished;
+	GTimer      *timer;
+	gdouble      load_time;
+} RenderTask;
+
+struct _RenderQueue {
+	RenderTask *tasks;
+	guint       n_tasks;
+	guint       next_start;
+	guint       n_running;
+	guint       max_running;
+	GMainLoop  *loop;
+};
+
+static void render_task_job_finished (RenderJob  *job,
+				      RenderTask *task);
+static void render_task_write_pages  (RenderTask *task);
+static void render_queue_start_tasks (RenderQueue *queue);
+
+static gchar *
+get_page_filename (RenderTask *task,
+		   gint        page)
+{
+	gchar *name, *filename;
+	gint   n_digits, n;
+
+	if (streaming)
+		return NULL;
+
+	/* Zero padded, so that the files sort like the pages */
+	for (n_digits = 1, n = ev_document_get_n_pages (task->document); n >= 10; n /= 10)
+		n_digits++;
+	name = g_strdup_printf ("%s-%0*d.%s", task->basename, n_digits, page + 1,
+				output_format == OUTPUT_FORMAT_RAW ? "pam" : "png");
+	filename = g_build_filename (output_dir, name, NULL);
+	g_free (name);
+
+	return filename;
+}
+
+static void
+render_task_push_jobs (RenderTask *task)
+{
+	guint window;
+
+	window = PAGES_PER_THREAD * ev_job_scheduler_get_n_threads () /
+		MAX (task->queue->n_running, 1);
+	window = MAX (window, PAGES_PER_THREAD);
+
+	while (task->next_push < task->pages->len &&
+	       task->next_push - task->next_write < window) {
+		gint   page = g_array_index (task->pages, gint, task->next_push);
+		gchar *filename;
+		EvJob *job;
+
+		filename = get_page_filename (task, page);
+		job = render_job_new (task->document, page, filename);
+		g_free (filename);
+
+		g_signal_connect (job, "finished",
+				  G_CALLBACK (render_task_job_finished),
+				  task);
+		task->jobs[task->next_push++] = job;
+		ev_job_scheduler_push_job (job, EV_JOB_PRIORITY_NONE);
+	}
+}
+
+static void
+render_task_job_finished (RenderJob  *finished,
+			  RenderTask *task)
+{
+	EvJob *job = EV_JOB (finished);
+	guint  i;
+
+	if (job->document && !ev_job_is_failed (job)) {
+		EvJob *encode_job = render_job_new_encode (finished);
+
+		for (i = task->next_write; task->jobs[i] != job; i++);
+		g_signal_handlers_disconnect_by_func (job, render_task_job_finished, task);
+		g_object_unref (job);
+
+		g_signal_connect (encode_job, "finished",
+				  G_CALLBACK (render_task_job_finished),
+				  task);
+		task->jobs[i] = encode_job;
+		ev_job_scheduler_push_job (encode_job, EV_JOB_PRIORITY_NONE);
+
+		return;
+	}
+
+	finished->done = TRUE;
+	render_task_write_pages (task);
+}
+
+static void
+render_task_finish (RenderTask *task)
+{
+	RenderQueue *queue = task->queue;
+	guint        i;
+
+	if (task->jobs) {
+		gdouble elapsed = g_timer_elapsed (task->timer, NULL);
+
+		fprintf (report, "# %s: loaded in %.2f ms, %u pages in %.2f s, %.1f pages/s\n",
+			 task->input, task->load_time * 1000, task->pages->len, elapsed,
+			 task->pages->len / elapsed);
+		g_clear_pointer (&task->jobs, g_free);
+	}
+
+	g_clear_pointer (&task->pages, g_array_unref);
+	g_clear_object (&task->document);
+	g_clear_pointer (&task->timer, g_timer_destroy);
+	task->finished = TRUE;
+	queue->n_running--;
+
+	/* The next document may have been waiting to stream its pages */
+	for (i = 0; i < queue->n_tasks; i++) {
+		if (!queue->tasks[i].finished) {
+			if (streaming && queue->tasks[i].jobs)
+				render_task_write_pages (&queue->tasks[i]);
+			break;
+		}
+	}
+
+	render_queue_start_tasks (queue);
+
+	if (queue->n_running == 0 && queue->next_start == queue->n_tasks)
+		g_main_loop_quit (queue->loop);
+}
+
+/* Pages streamed to the standard output are written in the order of
+ * the documents too, only by the first document not finished yet */
+static gboolean
+render_task_can_write (RenderTask *task)
+{
+	RenderQueue *queue = task->queue;
+	guint        i;
+
+	if (!streaming)
+		return TRUE;
+
+	for (i = 0; i < queue->n_tasks && queue->tasks[i].finished; i++);
+
+	return &queue->tasks[i] == task;
+}
+
+static void
+render_task_write_pages (RenderTask *task)
+{
+	while (task->next_write < task->pages->len && render_task_can_write (task)) {
+		EvJob     *job = task->jobs[task->next_write];
+		RenderJob *render_job = (RenderJob *) job;
+
+		if (!job || !render_job->done)
+			break;
+
+		if (ev_job_is_failed (job)) {
+			g_printerr ("%s: %s\n", task->input, job->error->message);
+			task->n_failed++;
+		} else {
+			if (streaming &&
+			    fwrite (render_job->data->data, 1, render_job->data->len, stdout) != render_job->data->len) {
+				g_printerr ("%s: Error writing page %d: %s\n", task->input,
+					    render_job->page + 1, g_strerror (errno));
+				task->n_failed++;
+			}
+
+			fprintf (report, "%s\t%d\t%d\t%d\t%.2f\t%.2f\t%ld\n",
+				 task->input, render_job->page + 1,
+				 render_job->width, render_job->height,
+				 render_job->render_time / 1000.,
+				 render_job->encode_time / 1000.,
+				 get_peak_memory ());
+		}
+
+		g_signal_handlers_disconnect_by_func (job, render_task_job_finished, task);
+		g_clear_object (&task->jobs[task->next_write]);
+		task->next_write++;
+	}
+
+	render_task_push_jobs (task);
+
+	if (task->next_write == task->pages->len)
+		render_task_finish (task);
+}
+
+static gboolean
+parse_page_ranges (const gchar *ranges,
+		   gint         n_pages,
+		   GArray      *pages,
+		   GError     **error)
+{
+	gchar **items;
+	gint    i, page;
+
+	if (!ranges) {
+		for (page = 0; page < n_pages; page++)
+			g_array_append_val (pages, page);
+
+		return TRUE;
+	}
+
+	items = g_strsplit (ranges, ",", -1);
+	for (i = 0; items[i]; i++) {
+		gchar  *item = g_strstrip (items[i]);
+		gchar  *dash, *end;
+		gint64  first, last;
+
+		if (*item == '\0')
+			continue;
+
+		dash = strchr (item, '-');
+		if (dash)
+			*dash = '\0';
+
+		first = *item ? g_ascii_strtoll (item, &end, 10) : 1;
+		if (*item && (*end != '\0' || first < 1))
+			goto invalid;
+
+		if (!dash) {
+			last = first;
+		} else if (dash[1] == '\0') {
+			last = n_pages;
+		} else {
+			last = g_ascii_strtoll (dash + 1, &end, 10);
+			if (*end != '\0' || last < first)
+				goto invalid;
+		}
+
+		/* Like the print dialog, pages after the last one are ignored */
+		for (page = first - 1; page < MIN (last, n_pages); page++)
+			g_array_append_val (pages, page);
+	}
+	g_strfreev (items);
+
+	return TRUE;
+
+invalid:
+	g_set_error (error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+		     "Invalid page range '%s'", ranges);
+	g_strfreev (items);
+
+	return FALSE;
+}
+
+static gchar *
+get_basename (GFile *file)
+{
+	gchar *basename, *dot;
+
+	basename = g_file_get_basename (file);
+	dot = strrchr (basename, '.');
+	if (dot && dot != basename)
+		*dot = '\0';
+
+	return basename;
+}
+
+/* Inputs with the same name, like a/doc.pdf and b/doc.pdf, get their
+ * position in the command line appended, so that their pages don't
+ * overwrite each other */
+static gchar **
+get_output_basenames (const gchar **inputs)
+{
+	GHashTable *counts, *used;
+	gchar     **basenames;
+	gchar     **retval;
+	guint       n_inputs, i;
+
+	n_inputs = g_strv_length ((gchar **) inputs);
+	basenames = g_new0 (gchar *, n_inputs + 1);
+	counts = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < n_inputs; i++) {
+		GFile *file = g_file_new_for_commandline_arg (inputs[i]);
+		guint  count;
+
+		basenames[i] = get_basename (file);
+		g_object_unref (file);
+
+		count = GPOINTER_TO_UINT (g_hash_table_lookup (counts, basenames[i]));
+		g_hash_table_insert (counts, basenames[i], GUINT_TO_POINTER (count + 1));
+	}
+
+	retval = g_new0 (gchar *, n_inputs + 1);
+	for (i = 0; i < n_inputs; i++) {
+		if (GPOINTER_TO_UINT (g_hash_table_lookup (counts, basenames[i])) > 1)
+			retval[i] = g_strdup_printf ("%s-%u", basenames[i], i + 1);
+		else
+			retval[i] = g_strdup (basenames[i]);
+	}
+	g_hash_table_destroy (counts);
+	g_strfreev (basenames);
+
+	/* An input could still be named like another one disambiguated */
+	used = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < n_inputs && !streaming; i++) {
+		if (g_hash_table_contains (used, retval[i])) {
+			g_printerr ("The pages of '%s' would overwrite the pages of another file\n",
+				    inputs[i]);
+			g_clear_pointer (&retval, g_strfreev);
+			break;
+		}
+		g_hash_table_add (used, retval[i]);
+	}
+	g_hash_table_destroy (used);
+
+	return retval;
+}
+
+static void
+render_task_loaded (EvJob      *job,
+		    RenderTask *task)
+{
+	GError *error = NULL;
+
+	task->load_time = g_timer_elapsed (task->timer, NULL);
+	g_signal_handlers_disconnect_by_func (job, render_task_loaded, task);
+	task->load_job = NULL;
+
+	if (ev_job_is_failed (job)) {
+		g_printerr ("%s: %s\n", task->input, job->error->message);
+		g_object_unref (job);
+		task->n_failed++;
+		render_task_finish (task);
+
+		return;
+	}
+
+	task->document = g_object_ref (job->document);
+	g_object_unref (job);
+
+	task->pages = g_array_new (FALSE, FALSE, sizeof (gint));
+	if (!parse_page_ranges (page_ranges, ev_document_get_n_pages (task->document),
+				task->pages, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		task->n_failed++;
+	}
+
+	if (task->pages->len == 0) {
+		render_task_finish (task);
+
+		return;
+	}
+
+	task->jobs = g_new0 (EvJob *, task->pages->len);
+	g_timer_start (task->timer);
+	render_task_push_jobs (task);
+}
+
+/* Documents are loaded in the scheduler threads too, while the pages
+ * of the previous ones are rendered */
+static void
+render_task_start (RenderTask *task)
+{
+	GFile *file;
+	gchar *uri;
+
+	file = g_file_new_for_commandline_arg (task->input);
+	uri = g_file_get_uri (file);
+	g_object_unref (file);
+
+	task->timer = g_timer_new ();
+	task->load_job = ev_job_load_new (uri);
+	g_free (uri);
+	ev_job_load_set_load_flags (EV_JOB_LOAD (task->load_job), EV_DOCUMENT_LOAD_FLAG_NO_CACHE);
+	g_signal_connect (task->load_job, "finished",
+			  G_CALLBACK (render_task_loaded),
+			  task);
+	ev_job_scheduler_push_job (task->load_job, EV_JOB_PRIORITY_NONE);
+}
+
+static void
+render_queue_start_tasks (RenderQueue *queue)
+{
+	while (queue->next_start < queue->n_tasks &&
+	       queue->n_running < queue->max_running) {
+		queue->n_running++;
+		render_task_start (&queue->tasks[queue->next_start++]);
+	}
+}
+
+static gboolean
+render_documents (const gchar **inputs,
+		  gchar       **basenames)
+{
+	RenderQueue queue;
+	gboolean    success = TRUE;
+	guint       i;
+
+	memset (&queue, 0, sizeof (RenderQueue));
+	queue.n_tasks = g_strv_length ((gchar **) inputs);
+	queue.tasks = g_new0 (RenderTask, queue.n_tasks);
+	queue.max_running = ev_job_scheduler_get_n_threads ();
+	queue.loop = g_main_loop_new (NULL, FALSE);
+
+	for (i = 0; i < queue.n_tasks; i++) {
+		queue.tasks[i].queue = &queue;
+		queue.tasks[i].input = inputs[i];
+		queue.tasks[i].basename = basenames[i];
+	}
+
+	render_queue_start_tasks (&queue);
+	g_main_loop_run (queue.loop);
+
+	for (i = 0; i < queue.n_tasks; i++)
+		success &= queue.tasks[i].n_failed == 0;
+
+	g_main_loop_unref (queue.loop);
+	g_free (queue.tasks);
+
+	return success;
+}
+
+static void
+print_usage (GOptionContext *context)
+{
+	gchar *help;
+
+	help = g_option_context_get_help (context, TRUE, NULL);
+	g_print ("%s", help);
+	g_free (help);
+}
+
+int
+main (int argc, char *argv[])
+{
+	GOptionContext *context;
+	GError         *error = NULL;
+	gchar         **basenames;
+	gboolean        success;
+
+	setlocale (LC_ALL, "");
+
+	context = g_option_context_new ("- Render document pages to images");
+	g_option_context_set_description (context,
+		"Every page is reported on a line with the file, the page, its width and\n"
+		"height, the milliseconds it took to render and to encode it, and the\n"
+		"peak memory use of the process in kilobytes so far.\n");
+	g_option_context_add_main_entries (context, goption_options, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		print_usage (context);
+		g_option_context_free (context);
+
+		return -1;
+	}
+
+	if (!file_arguments) {
+		print_usage (context);
+		g_option_context_free (context);
+
+		return -1;
+	}
+
+	g_option_context_free (context);
+
+	if (g_strcmp0 (format_name, "png") == 0) {
+		output_format = OUTPUT_FORMAT_PNG;
+	} else if (g_strcmp0 (format_name, "raw") == 0) {
+		output_format = OUTPUT_FORMAT_RAW;
+	} else {
+		g_printerr ("Unknown format '%s', expected png or raw\n", format_name);
+		return -1;
+	}
+
+	if (dpi > 0)
+		scale = dpi / 72.;
+	if (scale <= 0) {
+		g_printerr ("The scale must be greater than 0\n");
+		return -1;
+	}
+
+	if (rotation % 90 != 0) {
+		g_printerr ("The rotation must be 0, 90, 180 or 270 degrees\n");
+		return -1;
+	}
+	rotation = ((rotation % 360) + 360) % 360;
+
+	/* Pages streamed to the standard output are written in order,
+	 * one after the other, and the report goes to the standard error */
+	streaming = g_strcmp0 (output_dir, "-") == 0;
+	report = streaming ? stderr : stdout;
+	if (!streaming && g_mkdir_with_parents (output_dir, 0755) != 0) {
+		g_printerr ("Error creating '%s': %s\n", output_dir, g_strerror (errno));
+		return -1;
+	}
+
+	basenames = get_output_basenames (file_arguments);
+	if (!basenames)
+		return -1;
+
+	if (!ev_init ()) {
+		g_strfreev (basenames);
+		return -1;
+	}
+
+	if (n_jobs > 0)
+		ev_job_scheduler_set_n_threads (n_jobs);
+
+	fprintf (report, "FILE\tPAGE\tWIDTH\tHEIGHT\tRENDER (ms)\tENCODE (ms)\tPEAK (kB)\n");
+	success = render_documents (file_arguments, basenames);
+	g_strfreev (basenames);
+
+	fflush (stdout);
+	ev_shutdown ();
+
+	return success ? 0 : -2;
+}
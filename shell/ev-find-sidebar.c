@@ -395,10 +395,10 @@ get_page_text (EvDocument   *document,
         gchar   *text;
         gboolean success;
 
-        ev_document_doc_mutex_lock ();
+        ev_document_lock (document);
         text = ev_document_text_get_text (EV_DOCUMENT_TEXT (document), page);
         success = ev_document_text_get_text_layout (EV_DOCUMENT_TEXT (document), page, areas, n_areas);
-        ev_document_doc_mutex_unlock ();
+        ev_document_unlock (document);
 
         if (!success) {
                 g_free (text);
@@ -54,6 +54,10 @@ struct _EvRecentViewPrivate {
         GtkTreePath      *pressed_item_tree_path;
         guint             recent_manager_changed_handler_id;
 
+        /* Documents waiting to be loaded for their thumbnail or info */
+        GQueue            pending_loads;
+        guint             n_loads;
+
 #ifdef HAVE_LIBGNOME_DESKTOP
         GnomeDesktopThumbnailFactory *thumbnail_factory;
 #endif
@@ -70,6 +74,8 @@ G_DEFINE_TYPE (EvRecentView, ev_recent_view, GTK_TYPE_SCROLLED_WINDOW)
 
 #define ICON_VIEW_SIZE 128
 #define MAX_RECENT_VIEW_ITEMS 20
+/* Documents loaded at once, so that they don't delay the one opened */
+#define MAX_LOADS 2
 
 typedef struct {
         EvRecentView        *ev_recent_view;
@@ -80,16 +86,21 @@ typedef struct {
         EvJob               *job;
         guint                needs_metadata : 1;
         guint                needs_thumbnail : 1;
+        guint                loading : 1;
 } GetDocumentInfoAsyncData;
 
+static void ev_recent_view_load_finished (GetDocumentInfoAsyncData *data);
+
 static void
 get_document_info_async_data_free (GetDocumentInfoAsyncData *data)
 {
         GtkTreePath *path;
         GtkTreeIter  iter;
 
+        ev_recent_view_load_finished (data);
+
         if (data->job) {
-                g_signal_handlers_disconnect_by_data (data->job, data->ev_recent_view);
+                g_signal_handlers_disconnect_by_data (data->job, data);
                 ev_job_cancel (data->job);
                 g_object_unref (data->job);
         }
@@ -131,6 +142,7 @@ ev_recent_view_clear_model (EvRecentView *ev_recent_view)
 {
         EvRecentViewPrivate *priv = ev_recent_view->priv;
 
+        ev_recent_view_cancel_loads (ev_recent_view);
         gtk_tree_model_foreach (GTK_TREE_MODEL (priv->model),
                                 (GtkTreeModelForeachFunc)ev_recent_view_clear_async_data,
                                 ev_recent_view);
@@ -286,6 +298,7 @@ on_icon_view_item_activated (GtkIconView  *iconview,
         gtk_tree_model_get (GTK_TREE_MODEL (priv->model), &iter,
                             EV_RECENT_VIEW_COLUMN_URI, &uri,
                             -1);
+        ev_recent_view_cancel_loads (ev_recent_view);
         g_signal_emit (ev_recent_view, signals[ITEM_ACTIVATED], 0, uri);
         g_free (uri);
 }
@@ -390,6 +403,7 @@ thumbnail_job_completed_callback (EvJobThumbnail           *job,
                 return;
         }
 
+        ev_recent_view_load_finished (data);
         add_thumbnail_to_model (data, job->thumbnail_surface);
         save_document_thumbnail_in_cache (data);
 }
@@ -428,7 +442,7 @@ document_load_job_completed_callback (EvJobLoad                *job_load,
                 g_signal_connect (data->job, "finished",
                                   G_CALLBACK (thumbnail_job_completed_callback),
                                   data);
-                ev_job_scheduler_push_job (data->job, EV_JOB_PRIORITY_HIGH);
+                ev_job_scheduler_push_job (data->job, EV_JOB_PRIORITY_NONE);
         }
 
         if (data->needs_metadata) {
@@ -475,14 +489,96 @@ document_load_job_completed_callback (EvJobLoad                *job_load,
                 get_document_info_async_data_free (data);
 }
 
+static void
+ev_recent_view_start_loads (EvRecentView *ev_recent_view)
+{
+        EvRecentViewPrivate      *priv = ev_recent_view->priv;
+        GetDocumentInfoAsyncData *data;
+
+        while (priv->n_loads < MAX_LOADS &&
+               (data = g_queue_pop_head (&priv->pending_loads))) {
+                data->loading = TRUE;
+                priv->n_loads++;
+
+                /* Only the first page is needed */
+                data->job = EV_JOB (ev_job_load_new (data->uri));
+                ev_job_load_set_load_flags (EV_JOB_LOAD (data->job),
+                                            EV_DOCUMENT_LOAD_FLAG_PROBE);
+                g_signal_connect (data->job, "finished",
+                                  G_CALLBACK (document_load_job_completed_callback),
+                                  data);
+                ev_job_scheduler_push_job (data->job, EV_JOB_PRIORITY_NONE);
+        }
+}
+
+/* Called once the thumbnail has been rendered, or the load has failed */
+static void
+ev_recent_view_load_finished (GetDocumentInfoAsyncData *data)
+{
+        EvRecentView *ev_recent_view = data->ev_recent_view;
+
+        if (!data->loading)
+                return;
+
+        data->loading = FALSE;
+        ev_recent_view->priv->n_loads--;
+        ev_recent_view_start_loads (ev_recent_view);
+}
+
 static void
 load_document_and_get_document_info (GetDocumentInfoAsyncData *data)
 {
-        data->job = EV_JOB (ev_job_load_new (data->uri));
-        g_signal_connect (data->job, "finished",
-                          G_CALLBACK (document_load_job_completed_callback),
-                          data);
-        ev_job_scheduler_push_job (data->job, EV_JOB_PRIORITY_HIGH);
+        EvRecentView *ev_recent_view = data->ev_recent_view;
+
+        g_queue_push_tail (&ev_recent_view->priv->pending_loads, data);
+        ev_recent_view_start_loads (ev_recent_view);
+}
+
+static gboolean
+ev_recent_view_cancel_load (GtkTreeModel *model,
+                            GtkTreePath  *path,
+                            GtkTreeIter  *iter,
+                            EvRecentView *ev_recent_view)
+{
+        GetDocumentInfoAsyncData *data;
+
+        gtk_tree_model_get (model, iter, EV_RECENT_VIEW_COLUMN_ASYNC_DATA, &data, -1);
+
+        /* The cancelled jobs are not finished, so nothing else frees them */
+        if (data != NULL && data->loading) {
+                g_cancellable_cancel (data->cancellable);
+                get_document_info_async_data_free (data);
+        }
+
+        return FALSE;
+}
+
+/**
+ * ev_recent_view_cancel_loads:
+ * @ev_recent_view: a #EvRecentView
+ *
+ * Cancels loading the recent documents that have no thumbnail in the
+ * thumbnail cache, so that they don't delay the document being opened.
+ */
+void
+ev_recent_view_cancel_loads (EvRecentView *ev_recent_view)
+{
+        EvRecentViewPrivate      *priv;
+        GetDocumentInfoAsyncData *data;
+
+        g_return_if_fail (EV_IS_RECENT_VIEW (ev_recent_view));
+
+        priv = ev_recent_view->priv;
+
+        /* The pending ones first, so that none is started meanwhile */
+        while ((data = g_queue_pop_head (&priv->pending_loads))) {
+                g_cancellable_cancel (data->cancellable);
+                get_document_info_async_data_free (data);
+        }
+
+        gtk_tree_model_foreach (GTK_TREE_MODEL (priv->model),
+                                (GtkTreeModelForeachFunc)ev_recent_view_cancel_load,
+                                ev_recent_view);
 }
 
 #ifdef HAVE_LIBGNOME_DESKTOP
@@ -736,7 +832,7 @@ ev_recent_view_refresh (EvRecentView *ev_recent_view)
         items = gtk_recent_manager_get_items (priv->recent_manager);
         items = g_list_sort (items, (GCompareFunc) compare_recent_items);
 
-        gtk_list_store_clear (priv->model);
+        ev_recent_view_clear_model (ev_recent_view);
 
         for (l = items; l && l->data; l = g_list_next (l)) {
                 GetDocumentInfoAsyncData *data;
@@ -852,6 +948,7 @@ ev_recent_view_init (EvRecentView *ev_recent_view)
         ev_recent_view->priv = G_TYPE_INSTANCE_GET_PRIVATE (ev_recent_view, EV_TYPE_RECENT_VIEW, EvRecentViewPrivate);
 
         priv = ev_recent_view->priv;
+        g_queue_init (&priv->pending_loads);
         priv->recent_manager = gtk_recent_manager_get_default ();
         priv->model = gtk_list_store_new (NUM_COLUMNS,
                                           G_TYPE_STRING,
@@ -50,6 +50,7 @@ struct _EvRecentViewClass
 
 GType      ev_recent_view_get_type (void) G_GNUC_CONST;
 GtkWidget *ev_recent_view_new      (void);
+void       ev_recent_view_cancel_loads (EvRecentView *ev_recent_view);
 
 G_END_DECLS
 
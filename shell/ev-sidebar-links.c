@@ -48,7 +48,8 @@ struct _EvSidebarLinksPrivate {
 	EvDocument *document;
 	EvDocumentModel *doc_model;
 
-	GTree *page_link_tree;
+	/* The finished job the model comes from, to find the row of a page */
+	EvJobLinks *links_job;
 };
 
 enum {
@@ -154,9 +155,9 @@ ev_sidebar_links_dispose (GObject *object)
 		sidebar->priv->model = NULL;
 	}
 
-	if (sidebar->priv->page_link_tree) {
-		g_tree_unref (sidebar->priv->page_link_tree);
-		sidebar->priv->page_link_tree = NULL;
+	if (sidebar->priv->links_job) {
+		g_object_unref (sidebar->priv->links_job);
+		sidebar->priv->links_job = NULL;
 	}
 
 	if (sidebar->priv->document) {
@@ -478,43 +479,21 @@ ev_sidebar_links_new (void)
 	return ev_sidebar_links;
 }
 
-typedef struct EvSidebarLinkPageSearch {
-	gint page;
-	gint best_existing;
-} EvSidebarLinkPageSearch;
-
-static gint
-page_link_tree_search_best_page (gpointer page_ptr, EvSidebarLinkPageSearch* data)
-{
-	gint page = GPOINTER_TO_INT (page_ptr);
-
-	if (page <= data->page && page > data->best_existing)
-		data->best_existing = page;
-
-	return data->page - page;
-}
-
 static void
 ev_sidebar_links_set_current_page (EvSidebarLinks *sidebar_links,
 				   gint            current_page)
 {
 	GtkTreeSelection *selection;
 	GtkTreePath *path;
-	EvSidebarLinkPageSearch search_data;
 
 	/* Widget is not currently visible */
 	if (!gtk_widget_is_visible (GTK_WIDGET (sidebar_links)))
 		return;
 
-	search_data.page = current_page;
-	search_data.best_existing = G_MININT;
-
-	path = g_tree_search (sidebar_links->priv->page_link_tree, (GCompareFunc) page_link_tree_search_best_page, &search_data);
-	/* No direct hit, try a lookup on the best match. */
-	if (!path)
-		path = g_tree_lookup (sidebar_links->priv->page_link_tree, GINT_TO_POINTER (search_data.best_existing));
+	if (!sidebar_links->priv->links_job)
+		return;
 
-	/* Still no hit, give up. */
+	path = ev_job_links_get_page_path (sidebar_links->priv->links_job, current_page);
 	if (!path)
 		return;
 
@@ -530,6 +509,8 @@ ev_sidebar_links_set_current_page (EvSidebarLinks *sidebar_links,
 
 	g_signal_handler_unblock (selection, sidebar_links->priv->selection_id);
 	g_signal_handler_unblock (sidebar_links->priv->tree_view, sidebar_links->priv->row_activated_id);
+
+	gtk_tree_path_free (path);
 }
 
 static void
@@ -570,54 +551,21 @@ expand_open_links (GtkTreeView *tree_view, GtkTreeModel *model, GtkTreeIter *par
 				path = gtk_tree_model_get_path (model, &iter);
 				gtk_tree_view_expand_row (tree_view, path, FALSE);
 				gtk_tree_path_free (path);
-			}
 
-			expand_open_links (tree_view, model, &iter);
+				/* The children of collapsed rows can't be expanded */
+				expand_open_links (tree_view, model, &iter);
+			}
 		} while (gtk_tree_model_iter_next (model, &iter));
 	}
 }
 
 
-static gint
-page_link_tree_sort (gconstpointer a, gconstpointer b, void *data)
-{
-	return GPOINTER_TO_INT (a) - GPOINTER_TO_INT (b);
-}
-
-static gboolean
-update_page_link_tree_foreach (GtkTreeModel *model,
-			       GtkTreePath  *path,
-			       GtkTreeIter  *iter,
-			       gpointer      data)
-{
-	EvSidebarLinks *sidebar_links = data;
-	EvSidebarLinksPrivate *priv = sidebar_links->priv;
-	EvDocumentLinks *document_links = EV_DOCUMENT_LINKS (priv->document);
-	EvLink *link;
-	int page;
-
-	gtk_tree_model_get (model, iter,
-			    EV_DOCUMENT_LINKS_COLUMN_LINK, &link,
-			    -1);
-
-	if (!link)
-		return FALSE;
-
-	page = ev_document_links_get_link_page (document_links, link);
-	g_object_unref (link);
-
-	/* Only save the first link we find per page. */
-	if (!g_tree_lookup (priv->page_link_tree, GINT_TO_POINTER (page)))
-		g_tree_insert (priv->page_link_tree, GINT_TO_POINTER (page), gtk_tree_path_copy (path));
-
-	return FALSE;
-}
-
 static void
 ev_sidebar_links_set_links_model (EvSidebarLinks *sidebar_links,
-				  GtkTreeModel   *model)
+				  EvJobLinks     *job)
 {
 	EvSidebarLinksPrivate *priv = sidebar_links->priv;
+	GtkTreeModel *model = ev_job_links_get_model (job);
 
 	if (priv->model == model)
 		return;
@@ -626,14 +574,10 @@ ev_sidebar_links_set_links_model (EvSidebarLinks *sidebar_links,
 		g_object_unref (priv->model);
 	priv->model = g_object_ref (model);
 
-	/* Rebuild the binary search tree for finding links on pages. */
-	if (priv->page_link_tree)
-		g_tree_unref (priv->page_link_tree);
-	priv->page_link_tree = g_tree_new_full (page_link_tree_sort, NULL, NULL, (GDestroyNotify) gtk_tree_path_free);
-
-	gtk_tree_model_foreach (model,
-				update_page_link_tree_foreach,
-				sidebar_links);
+	/* The job has indexed the rows by page already */
+	if (priv->links_job)
+		g_object_unref (priv->links_job);
+	priv->links_job = g_object_ref (job);
 
 	g_object_notify (G_OBJECT (sidebar_links), "model");
 }
@@ -645,7 +589,7 @@ job_finished_callback (EvJobLinks     *job,
 	EvSidebarLinksPrivate *priv = sidebar_links->priv;
 	GtkTreeSelection *selection;
 
-	ev_sidebar_links_set_links_model (sidebar_links, job->model);
+	ev_sidebar_links_set_links_model (sidebar_links, job);
 
 	gtk_tree_view_set_model (GTK_TREE_VIEW (priv->tree_view), job->model);
 	
@@ -94,6 +94,10 @@ enum {
 };
 
 static void         ev_sidebar_thumbnails_clear_model      (EvSidebarThumbnails     *sidebar);
+static gboolean     ev_sidebar_thumbnails_clear_job        (GtkTreeModel            *model,
+							    GtkTreePath             *path,
+							    GtkTreeIter             *iter,
+							    gpointer                 data);
 static gboolean     ev_sidebar_thumbnails_support_document (EvSidebarPage           *sidebar_page,
 							    EvDocument              *document);
 static void         ev_sidebar_thumbnails_page_iface_init  (EvSidebarPageInterface  *iface);
@@ -194,6 +198,37 @@ ev_thumbnails_size_cache_get_size (EvThumbsSizeCache *cache,
 	}
 }
 
+/* Updates the cache for pages whose real size was not known when it was
+ * created, see EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE */
+static void
+ev_thumbnails_size_cache_update (EvThumbsSizeCache *cache,
+				 EvDocument        *document,
+				 gint               first_page,
+				 gint               n_pages)
+{
+	gint i;
+
+	if (cache->uniform) {
+		if (ev_document_is_page_size_uniform (document)) {
+			get_thumbnail_size_for_page (document, 0,
+						     &cache->uniform_width,
+						     &cache->uniform_height);
+			return;
+		}
+
+		cache->uniform = FALSE;
+		first_page = 0;
+		n_pages = ev_document_get_n_pages (document);
+		cache->sizes = g_new0 (EvThumbsSize, n_pages);
+	}
+
+	for (i = first_page; i < first_page + n_pages; i++) {
+		get_thumbnail_size_for_page (document, i,
+					     &cache->sizes[i].width,
+					     &cache->sizes[i].height);
+	}
+}
+
 static void
 ev_thumbnails_size_cache_free (EvThumbsSizeCache *cache)
 {
@@ -286,6 +321,8 @@ ev_sidebar_thumbnails_dispose (GObject *object)
 		sidebar_thumbnails->priv->list_store = NULL;
 	}
 
+	g_clear_object (&sidebar_thumbnails->priv->document);
+
 	G_OBJECT_CLASS (ev_sidebar_thumbnails_parent_class)->dispose (object);
 }
 
@@ -965,6 +1002,74 @@ ev_sidebar_thumbnails_inverted_colors_changed_cb (EvDocumentModel     *model,
 	ev_sidebar_thumbnails_reload (sidebar_thumbnails);
 }
 
+static void
+ev_sidebar_thumbnails_page_sizes_changed_cb (EvDocumentModel     *model,
+					     gint                 first_page,
+					     gint                 n_pages,
+					     EvSidebarThumbnails *sidebar_thumbnails)
+{
+	EvSidebarThumbnailsPrivate *priv = sidebar_thumbnails->priv;
+	GtkTreeIter                 iter;
+	gint                       *old_sizes;
+	gboolean                    result;
+	gboolean                    resized = FALSE;
+	gint                        i;
+
+	if (priv->document == NULL || priv->document != ev_document_model_get_document (model))
+		return;
+
+	old_sizes = g_new (gint, n_pages * 2);
+	for (i = 0; i < n_pages; i++) {
+		ev_thumbnails_size_cache_get_size (priv->size_cache, first_page + i,
+						   priv->rotation,
+						   &old_sizes[i * 2], &old_sizes[i * 2 + 1]);
+	}
+	ev_thumbnails_size_cache_update (priv->size_cache, priv->document,
+					 first_page, n_pages);
+
+	for (result = gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (priv->list_store), &iter, NULL, first_page), i = 0;
+	     result && i < n_pages;
+	     result = gtk_tree_model_iter_next (GTK_TREE_MODEL (priv->list_store), &iter), i++) {
+		gchar *page_label;
+		gchar *page_string;
+		gint   width, height;
+
+		page_label = ev_document_get_page_label (priv->document, first_page + i);
+		page_string = g_markup_printf_escaped ("<i>%s</i>", page_label);
+		gtk_list_store_set (priv->list_store, &iter,
+				    COLUMN_PAGE_STRING, page_string,
+				    -1);
+		g_free (page_label);
+		g_free (page_string);
+
+		ev_thumbnails_size_cache_get_size (priv->size_cache, first_page + i,
+						   priv->rotation,
+						   &width, &height);
+		if (width == old_sizes[i * 2] && height == old_sizes[i * 2 + 1])
+			continue;
+
+		/* Thumbnails rendered or being rendered with the
+		 * provisional size have to be rendered again */
+		ev_sidebar_thumbnails_clear_job (GTK_TREE_MODEL (priv->list_store), NULL,
+						 &iter, sidebar_thumbnails);
+		gtk_list_store_set (priv->list_store, &iter,
+				    COLUMN_SURFACE,
+				    ev_sidebar_thumbnails_get_loading_icon (sidebar_thumbnails,
+									    width, height),
+				    COLUMN_THUMBNAIL_SET, FALSE,
+				    COLUMN_JOB, NULL,
+				    -1);
+		resized = TRUE;
+	}
+	g_free (old_sizes);
+
+	if (resized) {
+		priv->start_page = -1;
+		priv->end_page = -1;
+		adjustment_changed_cb (sidebar_thumbnails);
+	}
+}
+
 static void
 thumbnail_job_completed_callback (EvJobThumbnail      *job,
 				  EvSidebarThumbnails *sidebar_thumbnails)
@@ -1003,6 +1108,78 @@ thumbnail_job_completed_callback (EvJobThumbnail      *job,
         gtk_widget_queue_draw (priv->icon_view);
 }
 
+/* Gets the thumbnails rendered for the pages of @old_document whose
+ * fingerprint is the same as that of some page of the current document */
+static GHashTable *
+ev_sidebar_thumbnails_get_reused_thumbnails (EvSidebarThumbnails *sidebar_thumbnails,
+					     EvDocument          *old_document)
+{
+	EvSidebarThumbnailsPrivate *priv = sidebar_thumbnails->priv;
+	GHashTable                 *thumbnails;
+	GtkTreeIter                 iter;
+	gboolean                    result;
+	gint                        old_page = 0;
+
+	thumbnails = g_hash_table_new_full (NULL, NULL, NULL,
+					    (GDestroyNotify) cairo_surface_destroy);
+
+	for (result = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (priv->list_store), &iter);
+	     result;
+	     result = gtk_tree_model_iter_next (GTK_TREE_MODEL (priv->list_store), &iter), old_page++) {
+		cairo_surface_t *surface;
+		gboolean         thumbnail_set;
+		gchar           *fingerprint;
+		gint             page;
+
+		gtk_tree_model_get (GTK_TREE_MODEL (priv->list_store), &iter,
+				    COLUMN_THUMBNAIL_SET, &thumbnail_set,
+				    -1);
+		if (!thumbnail_set)
+			continue;
+
+		fingerprint = ev_document_lookup_page_fingerprint (old_document, old_page);
+		if (!fingerprint)
+			continue;
+
+		page = ev_document_find_page_by_fingerprint (priv->document, fingerprint);
+		g_free (fingerprint);
+		if (page < 0 || g_hash_table_contains (thumbnails, GINT_TO_POINTER (page)))
+			continue;
+
+		gtk_tree_model_get (GTK_TREE_MODEL (priv->list_store), &iter,
+				    COLUMN_SURFACE, &surface,
+				    -1);
+		g_hash_table_insert (thumbnails, GINT_TO_POINTER (page), surface);
+	}
+
+	return thumbnails;
+}
+
+static void
+ev_sidebar_thumbnails_set_reused_thumbnails (EvSidebarThumbnails *sidebar_thumbnails,
+					     GHashTable          *thumbnails)
+{
+	EvSidebarThumbnailsPrivate *priv = sidebar_thumbnails->priv;
+	GHashTableIter              iter;
+	gpointer                    page;
+	cairo_surface_t            *surface;
+
+	g_hash_table_iter_init (&iter, thumbnails);
+	while (g_hash_table_iter_next (&iter, &page, (gpointer *) &surface)) {
+		GtkTreeIter tree_iter;
+
+		if (!gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (priv->list_store),
+						    &tree_iter, NULL,
+						    GPOINTER_TO_INT (page)))
+			continue;
+
+		gtk_list_store_set (priv->list_store, &tree_iter,
+				    COLUMN_SURFACE, surface,
+				    COLUMN_THUMBNAIL_SET, TRUE,
+				    -1);
+	}
+}
+
 static void
 ev_sidebar_thumbnails_document_changed_cb (EvDocumentModel     *model,
 					   GParamSpec          *pspec,
@@ -1010,15 +1187,29 @@ ev_sidebar_thumbnails_document_changed_cb (EvDocumentModel     *model,
 {
 	EvDocument *document = ev_document_model_get_document (model);
 	EvSidebarThumbnailsPrivate *priv = sidebar_thumbnails->priv;
+	EvDocument *old_document;
+	GHashTable *reused_thumbnails = NULL;
 
 	if (ev_document_get_n_pages (document) <= 0 ||
 	    !ev_document_check_dimensions (document)) {
 		return;
 	}
 
+	old_document = priv->document;
 	priv->size_cache = ev_thumbnails_size_cache_get (document);
-	priv->document = document;
+	priv->document = g_object_ref (document);
 	priv->n_pages = ev_document_get_n_pages (document);
+
+	/* Keep the thumbnails of the pages that didn't change
+	 * when the document is reloaded */
+	if (old_document &&
+	    priv->rotation == ev_document_model_get_rotation (model) &&
+	    priv->inverted_colors == ev_document_model_get_inverted_colors (model)) {
+		reused_thumbnails = ev_sidebar_thumbnails_get_reused_thumbnails (sidebar_thumbnails,
+										 old_document);
+	}
+	g_clear_object (&old_document);
+
 	priv->rotation = ev_document_model_get_rotation (model);
 	priv->inverted_colors = ev_document_model_get_inverted_colors (model);
 	if (priv->loading_icons) {
@@ -1032,6 +1223,10 @@ ev_sidebar_thumbnails_document_changed_cb (EvDocumentModel     *model,
 
 	ev_sidebar_thumbnails_clear_model (sidebar_thumbnails);
 	ev_sidebar_thumbnails_fill_model (sidebar_thumbnails);
+	if (reused_thumbnails) {
+		ev_sidebar_thumbnails_set_reused_thumbnails (sidebar_thumbnails, reused_thumbnails);
+		g_hash_table_destroy (reused_thumbnails);
+	}
 
 	/* Create the view widget, and remove the old one, if needed */
 	if (ev_sidebar_thumbnails_use_icon_view (sidebar_thumbnails)) {
@@ -1071,6 +1266,9 @@ ev_sidebar_thumbnails_document_changed_cb (EvDocumentModel     *model,
 	g_signal_connect_swapped (priv->model, "notify::fullscreen",
 			          G_CALLBACK (ev_sidebar_fullscreen_cb),
 			          sidebar_thumbnails);
+	g_signal_connect (priv->model, "page-sizes-changed",
+			  G_CALLBACK (ev_sidebar_thumbnails_page_sizes_changed_cb),
+			  sidebar_thumbnails);
 	sidebar_thumbnails->priv->start_page = -1;
 	sidebar_thumbnails->priv->end_page = -1;
 	ev_sidebar_thumbnails_set_current_page (sidebar_thumbnails,
@@ -50,6 +50,7 @@
 #include "ev-document-images.h"
 #include "ev-document-links.h"
 #include "ev-document-annotations.h"
+#include "ev-document-text.h"
 #include "ev-document-misc.h"
 #include "ev-file-exporter.h"
 #include "ev-file-helpers.h"
@@ -222,6 +223,7 @@ struct _EvWindowPrivate {
 	EvJob            *load_job;
 	EvJob            *reload_job;
 	EvJob            *save_job;
+	EvJob            *search_index_job;
 
 	/* Printing */
 	GQueue           *print_queue;
@@ -266,6 +268,10 @@ struct _EvWindowPrivate {
 #define GS_LAST_DOCUMENT_DIRECTORY "document-directory"
 #define GS_LAST_PICTURES_DIRECTORY "pictures-directory"
 #define GS_ALLOW_LINKS_CHANGE_ZOOM "allow-links-change-zoom"
+#define GS_ENABLE_SEARCH_INDEX   "enable-search-index"
+#define GS_LAZY_PAGE_SIZES       "lazy-page-sizes"
+#define GS_PRESENTATION_LOOK_AHEAD "presentation-look-ahead"
+#define GS_PRESENTATION_CACHE_SIZE "presentation-cache-size"
 
 #define SIDEBAR_DEFAULT_SIZE    132
 #define LINKS_SIDEBAR_ID "links"
@@ -1551,6 +1557,46 @@ ev_window_set_document_metadata (EvWindow *window)
 		ev_metadata_set_string (window->priv->metadata, "author", "");
 }
 
+static void
+ev_window_clear_search_index_job (EvWindow *ev_window)
+{
+	if (ev_window->priv->search_index_job != NULL) {
+		if (!ev_job_is_finished (ev_window->priv->search_index_job))
+			ev_job_cancel (ev_window->priv->search_index_job);
+
+		g_object_unref (ev_window->priv->search_index_job);
+		ev_window->priv->search_index_job = NULL;
+	}
+}
+
+static void
+ev_window_index_document (EvWindow *ev_window)
+{
+	EvDocument *document = ev_window->priv->document;
+
+	ev_window_clear_search_index_job (ev_window);
+
+	if (!ev_window->priv->settings ||
+	    !g_settings_get_boolean (ev_window->priv->settings, GS_ENABLE_SEARCH_INDEX))
+		return;
+
+	if (!EV_IS_DOCUMENT_FIND (document) || !EV_IS_DOCUMENT_TEXT (document) ||
+	    ev_document_get_n_pages (document) <= 0)
+		return;
+
+	ev_window->priv->search_index_job = ev_job_search_index_new (document);
+	ev_job_scheduler_push_job (ev_window->priv->search_index_job, EV_JOB_PRIORITY_NONE);
+}
+
+static EvDocumentLoadFlags
+ev_window_get_load_flags (EvWindow *ev_window)
+{
+	if (g_settings_get_boolean (ev_window_ensure_settings (ev_window), GS_LAZY_PAGE_SIZES))
+		return EV_DOCUMENT_LOAD_FLAG_LAZY_CACHE;
+
+	return EV_DOCUMENT_LOAD_FLAG_NONE;
+}
+
 static void
 ev_window_set_document (EvWindow *ev_window, EvDocument *document)
 {
@@ -1564,6 +1610,7 @@ ev_window_set_document (EvWindow *ev_window, EvDocument *document)
 	ev_window_set_message_area (ev_window, NULL);
 
 	ev_window_set_document_metadata (ev_window);
+	ev_window_index_document (ev_window);
 
 	if (ev_document_get_n_pages (document) <= 0) {
 		ev_window_warning_message (ev_window, "%s",
@@ -1633,6 +1680,30 @@ ev_window_clear_load_job (EvWindow *ev_window)
 	}
 }
 
+static gboolean
+ev_is_native_uri (const gchar *uri)
+{
+	GFile   *file = g_file_new_for_uri (uri);
+	gboolean native = g_file_is_native (file);
+
+	g_object_unref (file);
+
+	return native;
+}
+
+static void
+ev_window_create_load_job (EvWindow    *ev_window,
+			   const gchar *uri)
+{
+	ev_window->priv->load_job = ev_job_load_new (uri);
+	ev_job_load_set_load_flags (EV_JOB_LOAD (ev_window->priv->load_job),
+				    ev_window_get_load_flags (ev_window));
+	g_signal_connect (ev_window->priv->load_job,
+			  "finished",
+			  G_CALLBACK (ev_window_load_job_cb),
+			  ev_window);
+}
+
 static void
 ev_window_clear_reload_job (EvWindow *ev_window)
 {
@@ -1779,6 +1850,13 @@ ev_window_load_job_cb (EvJob *job,
 
 		ev_job_load_set_password (job_load, NULL);
 		ev_password_view_ask_password (EV_PASSWORD_VIEW (ev_window->priv->password_view));
+	} else if (!ev_window->priv->local_uri && !ev_is_native_uri (job_load->uri)) {
+		/* The remote file couldn't be read progressively,
+		 * the backend may only load local files */
+		ev_window_clear_load_job (ev_window);
+		ev_window_create_load_job (ev_window, ev_window->priv->uri);
+		ev_window_load_file_remote (ev_window,
+					    g_file_new_for_uri (ev_window->priv->uri));
 	} else {
 		text = g_uri_unescape_string (job_load->uri, NULL);
 		display_name = g_markup_escape_text (text, -1);
@@ -2187,6 +2265,10 @@ ev_window_open_uri (EvWindow       *ev_window,
 	ev_window_clear_load_job (ev_window);
 	ev_window_clear_local_uri (ev_window);
 
+	/* The recent documents would compete with this one */
+	if (ev_window->priv->recent_view)
+		ev_recent_view_cancel_loads (ev_window->priv->recent_view);
+
 	ev_window->priv->window_mode = mode;
 
 	if (ev_window->priv->uri)
@@ -2226,19 +2308,14 @@ ev_window_open_uri (EvWindow       *ev_window,
 	setup_size_from_metadata (ev_window);
 	setup_model_from_metadata (ev_window);
 
-	ev_window->priv->load_job = ev_job_load_new (uri);
-	g_signal_connect (ev_window->priv->load_job,
-			  "finished",
-			  G_CALLBACK (ev_window_load_job_cb),
-			  ev_window);
+	ev_window_create_load_job (ev_window, uri);
 
-	if (!g_file_is_native (source_file) && !ev_window->priv->local_uri) {
-		ev_window_load_file_remote (ev_window, source_file);
-	} else {
-		ev_window_show_loading_message (ev_window);
-		g_object_unref (source_file);
-		ev_job_scheduler_push_job (ev_window->priv->load_job, EV_JOB_PRIORITY_NONE);
-	}
+	/* Remote files are first read progressively, only the parts
+	 * needed to show the document are fetched. They're downloaded
+	 * when that fails, see ev_window_load_job_cb() */
+	ev_window_show_loading_message (ev_window);
+	g_object_unref (source_file);
+	ev_job_scheduler_push_job (ev_window->priv->load_job, EV_JOB_PRIORITY_NONE);
 }
 
 void
@@ -2353,6 +2430,8 @@ ev_window_reload_local (EvWindow *ev_window)
 	
 	uri = ev_window->priv->local_uri ? ev_window->priv->local_uri : ev_window->priv->uri;
 	ev_window->priv->reload_job = ev_job_load_new (uri);
+	ev_job_load_set_load_flags (EV_JOB_LOAD (ev_window->priv->reload_job),
+				    ev_window_get_load_flags (ev_window));
 	g_signal_connect (ev_window->priv->reload_job, "finished",
 			  G_CALLBACK (ev_window_reload_job_cb),
 			  ev_window);
@@ -4379,10 +4458,11 @@ ev_window_view_presentation_focus_out (EvWindow *window)
 static void
 ev_window_run_presentation (EvWindow *window)
 {
-	gboolean fullscreen_window = TRUE;
-	guint    current_page;
-	guint    rotation;
-	gboolean inverted_colors;
+	GSettings *settings;
+	gboolean   fullscreen_window = TRUE;
+	guint      current_page;
+	guint      rotation;
+	gboolean   inverted_colors;
 
 	if (EV_WINDOW_IS_PRESENTATION (window))
 		return;
@@ -4401,6 +4481,11 @@ ev_window_run_presentation (EvWindow *window)
 								    current_page,
 								    rotation,
 								    inverted_colors);
+	settings = ev_window_ensure_settings (window);
+	ev_view_presentation_set_look_ahead (EV_VIEW_PRESENTATION (window->priv->presentation_view),
+					     g_settings_get_uint (settings, GS_PRESENTATION_LOOK_AHEAD));
+	ev_view_presentation_set_cache_size (EV_VIEW_PRESENTATION (window->priv->presentation_view),
+					     (gsize) g_settings_get_uint (settings, GS_PRESENTATION_CACHE_SIZE) * 1024 * 1024);
 	g_signal_connect_swapped (window->priv->presentation_view, "finished",
 				  G_CALLBACK (ev_window_view_presentation_finished),
 				  window);
@@ -5708,6 +5793,10 @@ ev_window_dispose (GObject *object)
 		ev_window_clear_save_job (window);
 	}
 
+	if (priv->search_index_job) {
+		ev_window_clear_search_index_job (window);
+	}
+
 	if (priv->local_uri) {
 		ev_window_clear_local_uri (window);
 		priv->local_uri = NULL;
@@ -6413,10 +6502,10 @@ image_save_dialog_response_cb (GtkWidget *fc,
                         goto has_error;
 	}
 
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (ev_window->priv->document);
 	pixbuf = ev_document_images_get_image (EV_DOCUMENT_IMAGES (ev_window->priv->document),
 					       ev_window->priv->image);
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (ev_window->priv->document);
 
 	file_format = gdk_pixbuf_format_get_name (format);
 	gdk_pixbuf_save (pixbuf, filename, file_format, &error, NULL);
@@ -6504,10 +6593,10 @@ ev_window_popup_cmd_copy_image (GSimpleAction *action,
 	
 	clipboard = gtk_widget_get_clipboard (GTK_WIDGET (window),
 					      GDK_SELECTION_CLIPBOARD);
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (window->priv->document);
 	pixbuf = ev_document_images_get_image (EV_DOCUMENT_IMAGES (window->priv->document),
 					       window->priv->image);
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (window->priv->document);
 	
 	gtk_clipboard_set_image (clipboard, pixbuf);
 	g_object_unref (pixbuf);
@@ -6572,11 +6661,11 @@ ev_window_popup_cmd_annot_properties (GSimpleAction *action,
 	}
 
 	if (mask != EV_ANNOTATIONS_SAVE_NONE) {
-		ev_document_doc_mutex_lock ();
+		ev_document_lock (window->priv->document);
 		ev_document_annotations_save_annotation (EV_DOCUMENT_ANNOTATIONS (window->priv->document),
 							 window->priv->annot,
 							 mask);
-		ev_document_doc_mutex_unlock ();
+		ev_document_unlock (window->priv->document);
 
 		/* FIXME: update annot region only */
 		ev_view_reload (EV_VIEW (window->priv->view));
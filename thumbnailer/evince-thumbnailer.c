@@ -22,7 +22,10 @@
 
 #include <gio/gio.h>
 
+#include <glib/gstdio.h>
+#include <errno.h>
 #include <locale.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -42,12 +45,16 @@ static gboolean finished = TRUE;
 
 static gint size = THUMBNAIL_SIZE;
 static gboolean time_limit = TRUE;
+static gboolean batch_mode = FALSE;
+static gint n_jobs = 0;
 static const gchar **file_arguments;
 
 static const GOptionEntry goption_options[] = {
 	{ "size", 's', 0, G_OPTION_ARG_INT, &size, NULL, "SIZE" },
         { "no-limit", 'l', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &time_limit, "Don't limit the thumbnailing time to 15 seconds", NULL },
-	{ G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &file_arguments, NULL, "<input> <ouput>" },
+	{ "batch", 'b', 0, G_OPTION_ARG_NONE, &batch_mode, "Read tab separated <input> <output> lines from the manifest, or from the standard input", NULL },
+	{ "jobs", 'j', 0, G_OPTION_ARG_INT, &n_jobs, "Number of files thumbnailed at the same time in batch mode, while their backends are thread-safe", "N" },
+	{ G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &file_arguments, NULL, "<input> <ouput> | --batch [manifest]" },
 	{ NULL }
 };
 
@@ -194,8 +201,8 @@ evince_thumbnailer_get_document (GFile *file)
 	return document;
 }
 
-static gboolean
-evince_thumbnail_pngenc_get (EvDocument *document, const char *thumbnail, int size)
+static GdkPixbuf *
+evince_thumbnail_get (EvDocument *document, int size)
 {
 	EvRenderContext *rc;
 	double width, height;
@@ -210,7 +217,16 @@ evince_thumbnail_pngenc_get (EvDocument *document, const char *thumbnail, int si
 	pixbuf = ev_document_get_thumbnail (document, rc);
 	g_object_unref (rc);
 	g_object_unref (page);
-	
+
+	return pixbuf;
+}
+
+static gboolean
+evince_thumbnail_pngenc_get (EvDocument *document, const char *thumbnail, int size)
+{
+	GdkPixbuf *pixbuf;
+
+	pixbuf = evince_thumbnail_get (document, size);
 	if (pixbuf != NULL) {
 		if (gdk_pixbuf_save (pixbuf, thumbnail, "png", NULL, NULL)) {
 			g_object_unref  (pixbuf);
@@ -226,17 +242,345 @@ evince_thumbnail_pngenc_get (EvDocument *document, const char *thumbnail, int si
 static gpointer
 evince_thumbnail_pngenc_get_async (struct AsyncData *data)
 {
-	ev_document_doc_mutex_lock ();
+	ev_document_lock (data->document);
 	data->success = evince_thumbnail_pngenc_get (data->document,
 						     data->output,
 						     data->size);
-	ev_document_doc_mutex_unlock ();
+	ev_document_unlock (data->document);
 	
 	g_idle_add ((GSourceFunc)gtk_main_quit, NULL);
 	
 	return NULL;
 }
 
+/* Batch mode: the files are thumbnailed on a pool of worker threads,
+ * sharing the backends loaded once. Whether the backend of a file is
+ * thread-safe is found out from its MIME type before loading it, and
+ * the files of backends that are not are thumbnailed one at a time,
+ * while the other files go on in parallel.
+ * A file that takes too long can't be interrupted, so it's reported as
+ * timed out and left running on its thread, while another thread takes
+ * its place in the pool. A file left running with a backend that is
+ * not thread-safe keeps it busy for good: no thread takes its place,
+ * and the next files that need such a backend fail.
+ */
+typedef struct _BatchTask BatchTask;
+
+typedef struct {
+	GThreadPool *pool;
+	GThread     *watchdog;
+	gint         n_jobs;
+
+	GMutex       mutex;
+	GCond        cond;
+	GList       *active;
+	GHashTable  *backends;
+	BatchTask   *serial_task;
+	gint         n_pending;
+	gint         n_stuck;
+	gint         n_failed;
+	gboolean     done;
+} Batch;
+
+struct _BatchTask {
+	gchar   *input;
+	gchar   *output;
+	gint64   start_time;
+	gboolean timed_out;
+};
+
+static void
+batch_task_free (BatchTask *task)
+{
+	g_free (task->input);
+	g_free (task->output);
+	g_slice_free (BatchTask, task);
+}
+
+/* Must be called with the batch mutex held */
+static void
+batch_update_max_threads (Batch *batch)
+{
+	gint n_extra;
+
+	/* Don't let files that never finish grow the pool forever, nor
+	 * at all while one of them holds a backend that is not
+	 * thread-safe */
+	if (batch->serial_task && batch->serial_task->timed_out)
+		n_extra = 0;
+	else
+		n_extra = MIN (batch->n_stuck, batch->n_jobs);
+
+	g_thread_pool_set_max_threads (batch->pool, batch->n_jobs + n_extra, NULL);
+}
+
+static gboolean
+batch_task_is_thread_safe (GFile *file)
+{
+	gchar   *uri, *mime_type;
+	gboolean thread_safe;
+
+	uri = g_file_get_uri (file);
+	mime_type = ev_file_get_mime_type (uri, FALSE, NULL);
+	g_free (uri);
+
+	/* Files of an unknown type fail to load one at a time */
+	thread_safe = mime_type && ev_document_factory_mime_type_is_thread_safe (mime_type);
+	g_free (mime_type);
+
+	return thread_safe;
+}
+
+static void
+batch_task_finish (Batch    *batch,
+		   gboolean  success)
+{
+	if (!success)
+		batch->n_failed++;
+	batch->n_pending--;
+	g_cond_broadcast (&batch->cond);
+}
+
+static void
+batch_thumbnail (BatchTask *task,
+		 Batch     *batch)
+{
+	EvDocument *document;
+	GdkPixbuf  *pixbuf = NULL;
+	GFile      *file;
+	gint64      load_time, render_time;
+	gboolean    thread_safe;
+	gboolean    timed_out;
+	gboolean    success = FALSE;
+
+	file = g_file_new_for_commandline_arg (task->input);
+	thread_safe = batch_task_is_thread_safe (file);
+
+	g_mutex_lock (&batch->mutex);
+	if (!thread_safe) {
+		while (batch->serial_task && !batch->serial_task->timed_out)
+			g_cond_wait (&batch->cond, &batch->mutex);
+
+		if (batch->serial_task) {
+			g_printerr ("Not thumbnailing '%s', the file '%s' is still using a backend that is not thread-safe\n",
+				    task->input, batch->serial_task->input);
+			g_print ("failed\t-\t-\t%s\n", task->input);
+			batch_task_finish (batch, FALSE);
+			g_mutex_unlock (&batch->mutex);
+
+			g_object_unref (file);
+			batch_task_free (task);
+
+			return;
+		}
+
+		batch->serial_task = task;
+	}
+	task->start_time = g_get_monotonic_time ();
+	batch->active = g_list_prepend (batch->active, task);
+	g_mutex_unlock (&batch->mutex);
+
+	document = evince_thumbnailer_get_document (file);
+	g_object_unref (file);
+
+	load_time = g_get_monotonic_time ();
+	if (document) {
+		GType type = G_OBJECT_TYPE (document);
+
+		/* Keep the backend module loaded for the next files */
+		g_mutex_lock (&batch->mutex);
+		if (!g_hash_table_contains (batch->backends, GSIZE_TO_POINTER (type))) {
+			g_hash_table_add (batch->backends, GSIZE_TO_POINTER (type));
+			g_type_class_ref (type);
+		}
+		g_mutex_unlock (&batch->mutex);
+
+		ev_document_lock (document);
+		pixbuf = evince_thumbnail_get (document, size);
+		ev_document_unlock (document);
+		g_object_unref (document);
+	}
+	render_time = g_get_monotonic_time ();
+
+	g_mutex_lock (&batch->mutex);
+	batch->active = g_list_remove (batch->active, task);
+	if (batch->serial_task == task) {
+		batch->serial_task = NULL;
+		g_cond_broadcast (&batch->cond);
+	}
+	timed_out = task->timed_out;
+	if (timed_out) {
+		/* Already reported, give the place back */
+		batch->n_stuck--;
+		batch_update_max_threads (batch);
+	}
+	g_mutex_unlock (&batch->mutex);
+
+	if (!timed_out) {
+		if (pixbuf)
+			success = gdk_pixbuf_save (pixbuf, task->output, "png", NULL, NULL);
+
+		g_print ("%s\t%.3f\t%.3f\t%s\n",
+			 success ? "ok" : "failed",
+			 (load_time - task->start_time) / (gdouble) G_USEC_PER_SEC,
+			 (render_time - load_time) / (gdouble) G_USEC_PER_SEC,
+			 task->input);
+
+		g_mutex_lock (&batch->mutex);
+		batch_task_finish (batch, success);
+		g_mutex_unlock (&batch->mutex);
+	}
+
+	if (pixbuf)
+		g_object_unref (pixbuf);
+	batch_task_free (task);
+}
+
+static gpointer
+batch_watchdog (Batch *batch)
+{
+	g_mutex_lock (&batch->mutex);
+	while (!batch->done) {
+		gint64 now = g_get_monotonic_time ();
+		GList *l;
+
+		for (l = batch->active; l; l = g_list_next (l)) {
+			BatchTask *task = l->data;
+
+			if (task->timed_out || now - task->start_time < DEFAULT_SLEEP_TIME)
+				continue;
+
+			task->timed_out = TRUE;
+			g_print ("timeout\t%.3f\t-\t%s\n",
+				 (now - task->start_time) / (gdouble) G_USEC_PER_SEC,
+				 task->input);
+
+			batch->n_stuck++;
+			batch_update_max_threads (batch);
+			batch_task_finish (batch, FALSE);
+		}
+
+		g_cond_wait_until (&batch->cond, &batch->mutex, now + G_USEC_PER_SEC);
+	}
+	g_mutex_unlock (&batch->mutex);
+
+	return NULL;
+}
+
+static void
+batch_push (Batch       *batch,
+	    const gchar *line)
+{
+	BatchTask   *task;
+	const gchar *tab;
+
+	tab = strchr (line, '\t');
+	if (!tab || tab == line || tab[1] == '\0') {
+		g_printerr ("Invalid line, expected <input>\\t<output>: '%s'\n", line);
+		g_mutex_lock (&batch->mutex);
+		batch->n_failed++;
+		g_mutex_unlock (&batch->mutex);
+
+		return;
+	}
+
+	task = g_slice_new0 (BatchTask);
+	task->input = g_strndup (line, tab - line);
+	task->output = g_strdup (tab + 1);
+
+	g_mutex_lock (&batch->mutex);
+	batch->n_pending++;
+	g_mutex_unlock (&batch->mutex);
+
+	g_thread_pool_push (batch->pool, task, NULL);
+}
+
+static gboolean
+read_line (FILE    *stream,
+	   GString *line)
+{
+	int c;
+
+	g_string_truncate (line, 0);
+	while ((c = getc (stream)) != EOF && c != '\n')
+		g_string_append_c (line, c);
+
+	if (line->len > 0 && line->str[line->len - 1] == '\r')
+		g_string_truncate (line, line->len - 1);
+
+	return c != EOF || line->len > 0;
+}
+
+static int
+evince_thumbnailer_run_batch (const gchar *manifest)
+{
+	/* Static, threads of timed out files may outlive this function */
+	static Batch batch;
+	FILE        *stream = stdin;
+	GString     *line;
+	gboolean     stuck;
+
+	if (manifest && g_strcmp0 (manifest, "-") != 0) {
+		stream = g_fopen (manifest, "r");
+		if (!stream) {
+			g_printerr ("Error opening manifest '%s': %s\n",
+				    manifest, g_strerror (errno));
+			return -1;
+		}
+	}
+
+	memset (&batch, 0, sizeof (Batch));
+	g_mutex_init (&batch.mutex);
+	g_cond_init (&batch.cond);
+	batch.n_jobs = n_jobs > 0 ? n_jobs : (gint) g_get_num_processors ();
+	batch.backends = g_hash_table_new (NULL, NULL);
+	batch.pool = g_thread_pool_new ((GFunc)batch_thumbnail, &batch,
+					batch.n_jobs, FALSE, NULL);
+	if (time_limit)
+		batch.watchdog = g_thread_new ("ThumbnailerTimer",
+					       (GThreadFunc)batch_watchdog,
+					       &batch);
+
+	/* Lines are thumbnailed as they are read, so that the thumbnailer
+	 * can be kept running as a daemon fed through a pipe */
+	line = g_string_new (NULL);
+	while (read_line (stream, line)) {
+		if (line->len == 0 || line->str[0] == '#')
+			continue;
+
+		batch_push (&batch, line->str);
+	}
+	g_string_free (line, TRUE);
+
+	if (stream != stdin)
+		fclose (stream);
+
+	g_mutex_lock (&batch.mutex);
+	while (batch.n_pending > 0)
+		g_cond_wait (&batch.cond, &batch.mutex);
+	batch.done = TRUE;
+	stuck = batch.n_stuck > 0;
+	g_cond_broadcast (&batch.cond);
+	g_mutex_unlock (&batch.mutex);
+
+	if (batch.watchdog)
+		g_thread_join (batch.watchdog);
+
+	/* Threads still running a file that timed out can't be waited
+	 * for, and still use the backends */
+	if (stuck)
+		return -2;
+
+	g_thread_pool_free (batch.pool, FALSE, TRUE);
+	g_hash_table_destroy (batch.backends);
+	g_cond_clear (&batch.cond);
+	g_mutex_clear (&batch.mutex);
+
+	ev_shutdown ();
+
+	return batch.n_failed > 0 ? -2 : 0;
+}
+
 static void
 print_usage (GOptionContext *context)
 {
@@ -273,7 +617,7 @@ main (int argc, char *argv[])
 
 	input = file_arguments ? file_arguments[0] : NULL;
 	output = input ? file_arguments[1] : NULL;
-	if (!input || !output) {
+	if (batch_mode ? output != NULL : (!input || !output)) {
 		print_usage (context);
 		g_option_context_free (context);
 
@@ -287,6 +631,13 @@ main (int argc, char *argv[])
 		return -1;
 	}
 
+	if (batch_mode) {
+		if (!ev_init ())
+			return -1;
+
+		return evince_thumbnailer_run_batch (input);
+	}
+
 	input = file_arguments[0];
 	output = file_arguments[1];
 